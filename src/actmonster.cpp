@@ -1671,6 +1671,7 @@ bool makeFollower(int monsterclicked, bool ringconflict, char namesays[64],
 			auto name = names[choice].c_str();
 			size_t len = names[choice].size();
 			stringCopy(myStats->name, name, sizeof(Stat::name), len);
+			myStats->updateAllegianceTags();
 		}
         
         // ... and a nametag
@@ -2050,6 +2051,170 @@ void sentrybotPickSpotNoise(Entity* my, Stat* myStats)
 	}
 }
 
+/*-------------------------------------------------------------------------------
+
+	monsterPoseStateSignature
+
+	Hashes the state the *MoveBodyparts functions read outside of the limb
+	transforms themselves: effects, equipment, invisibility, sleeping height
+	and the bodypart sprites/flags they write. If it is unchanged since the
+	last pose, skipping the call only skips limb transforms.
+
+-------------------------------------------------------------------------------*/
+
+static Uint32 monsterPoseStateSignature(Entity* my, Stat* myStats)
+{
+	Uint32 hash = 2166136261u;
+	auto mix = [&hash](Uint32 value) {
+		hash = (hash ^ value) * 16777619u;
+	};
+	auto mixReal = [&mix](real_t value) {
+		float f = (float)value;
+		Uint32 bits;
+		memcpy(&bits, &f, sizeof(bits));
+		mix(bits);
+	};
+
+	mix(my->sprite);
+	mix(my->monsterState);
+	mix(my->monsterAttack);
+	mix(my->flags[INVISIBLE]);
+	mix(my->flags[BLOCKSIGHT]);
+	mixReal(my->z);
+	mixReal(my->pitch);
+	if ( myStats )
+	{
+		mix(myStats->EFFECTS[EFF_ASLEEP]);
+		mix(myStats->EFFECTS[EFF_INVISIBLE]);
+		mix(isLevitating(myStats));
+		Item* equipment[] = {
+			myStats->helmet, myStats->breastplate, myStats->gloves, myStats->shoes, myStats->shield,
+			myStats->weapon, myStats->cloak, myStats->amulet, myStats->ring, myStats->mask
+		};
+		for ( auto item : equipment )
+		{
+			mix(item ? (Uint32)item->type + 1 : 0);
+			mix(item ? (Uint32)item->appearance : 0);
+		}
+	}
+	for ( auto bodypart : my->bodyparts )
+	{
+		if ( bodypart )
+		{
+			mix(bodypart->sprite);
+			mix(bodypart->flags[INVISIBLE]);
+		}
+	}
+	return hash;
+}
+
+/*-------------------------------------------------------------------------------
+
+	monsterBodypartPoseCulled
+
+	Returns true if the limb transforms of the given monster can be skipped
+	this tick because no local camera can see it. Only monsters standing
+	idle in MONSTER_STATE_WAIT are culled, and only while the state hashed by
+	monsterPoseStateSignature is unchanged since their last pose, so flags,
+	sleeping height and bodypart updates are never delayed. Culled monsters
+	are still posed a couple of times a second.
+
+-------------------------------------------------------------------------------*/
+
+static ConsoleVariable<bool> cvar_monster_pose_culling("/monster_pose_culling", true);
+
+static bool monsterBodypartPoseCulled(Entity* my, Stat* myStats, double dist)
+{
+	if ( !*cvar_monster_pose_culling || intro )
+	{
+		return false;
+	}
+	if ( multiplayer == SERVER )
+	{
+		return false; // remote clients may be looking at it
+	}
+	if ( MONSTER_ATTACK != 0 || my->monsterSpecialState != 0 )
+	{
+		return false;
+	}
+	if ( dist > 0.001 )
+	{
+		return false; // walking, chasing or being knocked back
+	}
+	if ( multiplayer != CLIENT && my->monsterState != MONSTER_STATE_WAIT )
+	{
+		return false;
+	}
+	if ( my->monsterEntityRenderAsTelepath == 1 )
+	{
+		return false; // drawn through walls
+	}
+	if ( my->ticks < TICKS_PER_SECOND
+		|| (my->ticks + my->getUID()) % (TICKS_PER_SECOND / 2) == 0 )
+	{
+		return false;
+	}
+	switch ( my->getMonsterTypeFromSprite() )
+	{
+		case DEMON:
+		case MINOTAUR:
+		case DEVIL:
+		case LICH:
+		case LICH_FIRE:
+		case LICH_ICE:
+			return false; // ceiling busters and boss scripting
+		default:
+			break;
+	}
+	if ( my->light || my->flags[OVERDRAW] || my->flags[GENIUS] )
+	{
+		return false;
+	}
+	for ( auto bodypart : my->bodyparts )
+	{
+		if ( bodypart && bodypart->light )
+		{
+			return false;
+		}
+	}
+	if ( monsterPoseStateSignature(my, myStats) != my->monsterPoseSignature )
+	{
+		return false;
+	}
+
+	// vismap is already expanded one tile around visible tiles, check one
+	// more so creatures straddling the edge are posed before they appear
+	const int cx = my->x / 16.0;
+	const int cy = my->y / 16.0;
+	for ( int i = 0; i < MAXPLAYERS; ++i )
+	{
+		if ( client_disconnected[i] || !players[i]->isLocalPlayer() )
+		{
+			continue;
+		}
+		if ( !cameras[i].vismap )
+		{
+			return false;
+		}
+		auto dither = my->dithering.find(&cameras[i]);
+		if ( dither != my->dithering.end() && dither->second.value > 0 )
+		{
+			return false; // still fading out
+		}
+		for ( int x = std::max(0, cx - 1); x <= std::min((int)map.width - 1, cx + 1); ++x )
+		{
+			for ( int y = std::max(0, cy - 1); y <= std::min((int)map.height - 1, cy + 1); ++y )
+			{
+				if ( cameras[i].vismap[y + x * map.height] )
+				{
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
 void actMonster(Entity* my)
 {
 	if (!my)
@@ -2141,41 +2306,45 @@ void actMonster(Entity* my)
 		else if (MONSTER_INIT)
 		{
 		    const auto dist = sqrt(MONSTER_VELX * MONSTER_VELX + MONSTER_VELY * MONSTER_VELY);
-			switch (my->getMonsterTypeFromSprite()) {
-			case HUMAN: humanMoveBodyparts(my, nullptr, dist); break;
-			case RAT: ratAnimate(my, dist); break;
-			case GOBLIN: goblinMoveBodyparts(my, nullptr, dist); break;
-			case SLIME: slimeAnimate(my, dist); break;
-			case TROLL: trollMoveBodyparts(my, nullptr, dist); break;
-			case SPIDER: spiderMoveBodyparts(my, nullptr, dist); break;
-			case GHOUL: ghoulMoveBodyparts(my, nullptr, dist); break;
-			case SKELETON: skeletonMoveBodyparts(my, nullptr, dist); break;
-			case SCORPION: scorpionAnimate(my, dist); break;
-			case CREATURE_IMP: impMoveBodyparts(my, nullptr, dist); break;
-			case GNOME: gnomeMoveBodyparts(my, nullptr, dist); break;
-			case DEMON: demonMoveBodyparts(my, nullptr, dist); actDemonCeilingBuster(my); break;
-			case SUCCUBUS: succubusMoveBodyparts(my, nullptr, dist); break;
-			case LICH: lichAnimate(my, dist); break;
-			case MINOTAUR: minotaurMoveBodyparts(my, nullptr, dist); actMinotaurCeilingBuster(my); break;
-			case DEVIL: devilMoveBodyparts(my, nullptr, dist); break;
-			case SHOPKEEPER: shopkeeperMoveBodyparts(my, nullptr, dist); break;
-			case KOBOLD: koboldMoveBodyparts(my, nullptr, dist); break;
-			case SCARAB: scarabAnimate(my, nullptr, dist); break;
-			case CRYSTALGOLEM: crystalgolemMoveBodyparts(my, nullptr, dist); break;
-			case INCUBUS: incubusMoveBodyparts(my, nullptr, dist); break;
-			case VAMPIRE: vampireMoveBodyparts(my, nullptr, dist); break;
-			case SHADOW: shadowMoveBodyparts(my, nullptr, dist); break;
-			case COCKATRICE: cockatriceMoveBodyparts(my, nullptr, dist); break;
-			case INSECTOID: insectoidMoveBodyparts(my, nullptr, dist); break;
-			case GOATMAN: goatmanMoveBodyparts(my, nullptr, dist); break;
-			case AUTOMATON: automatonMoveBodyparts(my, nullptr, dist); break;
-			case LICH_ICE: lichIceAnimate(my, nullptr, dist); break;
-			case LICH_FIRE: lichFireAnimate(my, nullptr, dist); break;
-			case SENTRYBOT: sentryBotAnimate(my, nullptr, dist); break;
-			case SPELLBOT: sentryBotAnimate(my, nullptr, dist); break;
-			case GYROBOT: gyroBotAnimate(my, nullptr, dist); break;
-			case DUMMYBOT: dummyBotAnimate(my, nullptr, dist); break;
-			default: break;
+			if ( !monsterBodypartPoseCulled(my, nullptr, dist) )
+			{
+				switch (my->getMonsterTypeFromSprite()) {
+				case HUMAN: humanMoveBodyparts(my, nullptr, dist); break;
+				case RAT: ratAnimate(my, dist); break;
+				case GOBLIN: goblinMoveBodyparts(my, nullptr, dist); break;
+				case SLIME: slimeAnimate(my, dist); break;
+				case TROLL: trollMoveBodyparts(my, nullptr, dist); break;
+				case SPIDER: spiderMoveBodyparts(my, nullptr, dist); break;
+				case GHOUL: ghoulMoveBodyparts(my, nullptr, dist); break;
+				case SKELETON: skeletonMoveBodyparts(my, nullptr, dist); break;
+				case SCORPION: scorpionAnimate(my, dist); break;
+				case CREATURE_IMP: impMoveBodyparts(my, nullptr, dist); break;
+				case GNOME: gnomeMoveBodyparts(my, nullptr, dist); break;
+				case DEMON: demonMoveBodyparts(my, nullptr, dist); actDemonCeilingBuster(my); break;
+				case SUCCUBUS: succubusMoveBodyparts(my, nullptr, dist); break;
+				case LICH: lichAnimate(my, dist); break;
+				case MINOTAUR: minotaurMoveBodyparts(my, nullptr, dist); actMinotaurCeilingBuster(my); break;
+				case DEVIL: devilMoveBodyparts(my, nullptr, dist); break;
+				case SHOPKEEPER: shopkeeperMoveBodyparts(my, nullptr, dist); break;
+				case KOBOLD: koboldMoveBodyparts(my, nullptr, dist); break;
+				case SCARAB: scarabAnimate(my, nullptr, dist); break;
+				case CRYSTALGOLEM: crystalgolemMoveBodyparts(my, nullptr, dist); break;
+				case INCUBUS: incubusMoveBodyparts(my, nullptr, dist); break;
+				case VAMPIRE: vampireMoveBodyparts(my, nullptr, dist); break;
+				case SHADOW: shadowMoveBodyparts(my, nullptr, dist); break;
+				case COCKATRICE: cockatriceMoveBodyparts(my, nullptr, dist); break;
+				case INSECTOID: insectoidMoveBodyparts(my, nullptr, dist); break;
+				case GOATMAN: goatmanMoveBodyparts(my, nullptr, dist); break;
+				case AUTOMATON: automatonMoveBodyparts(my, nullptr, dist); break;
+				case LICH_ICE: lichIceAnimate(my, nullptr, dist); break;
+				case LICH_FIRE: lichFireAnimate(my, nullptr, dist); break;
+				case SENTRYBOT: sentryBotAnimate(my, nullptr, dist); break;
+				case SPELLBOT: sentryBotAnimate(my, nullptr, dist); break;
+				case GYROBOT: gyroBotAnimate(my, nullptr, dist); break;
+				case DUMMYBOT: dummyBotAnimate(my, nullptr, dist); break;
+				default: break;
+				}
+				my->monsterPoseSignature = monsterPoseStateSignature(my, nullptr);
 			}
 
 			if ( !intro )
@@ -2264,6 +2433,7 @@ void actMonster(Entity* my)
 				case DUMMYBOT: initDummyBot(my, myStats); break;
 				default: break; //This should never be reached.
 			}
+			myStats->updateAllegianceTags(); // map or init may have named it
 		}
 
 		MONSTER_INIT = 2;
@@ -8082,41 +8252,45 @@ timeToGoAgain:
 	if ( myStats != NULL )
 	{
 	    const auto dist = sqrt(MONSTER_VELX * MONSTER_VELX + MONSTER_VELY * MONSTER_VELY);
-		switch (my->getMonsterTypeFromSprite()) {
-		case HUMAN: humanMoveBodyparts(my, myStats, dist); break;
-		case RAT: ratAnimate(my, dist); break;
-		case GOBLIN: goblinMoveBodyparts(my, myStats, dist); break;
-		case SLIME: slimeAnimate(my, dist); break;
-		case TROLL: trollMoveBodyparts(my, myStats, dist); break;
-		case SPIDER: spiderMoveBodyparts(my, myStats, dist); break;
-		case GHOUL: ghoulMoveBodyparts(my, myStats, dist); break;
-		case SKELETON: skeletonMoveBodyparts(my, myStats, dist); break;
-		case SCORPION: scorpionAnimate(my, dist); break;
-		case CREATURE_IMP: impMoveBodyparts(my, myStats, dist); break;
-		case GNOME: gnomeMoveBodyparts(my, myStats, dist); break;
-		case DEMON: demonMoveBodyparts(my, myStats, dist); actDemonCeilingBuster(my); break;
-		case SUCCUBUS: succubusMoveBodyparts(my, myStats, dist); break;
-		case LICH: lichAnimate(my, dist); break;
-		case MINOTAUR: minotaurMoveBodyparts(my, myStats, dist); actMinotaurCeilingBuster(my); break;
-		case DEVIL: devilMoveBodyparts(my, myStats, dist); break;
-		case SHOPKEEPER: shopkeeperMoveBodyparts(my, myStats, dist); break;
-		case KOBOLD: koboldMoveBodyparts(my, myStats, dist); break;
-		case SCARAB: scarabAnimate(my, myStats, dist); break;
-		case CRYSTALGOLEM: crystalgolemMoveBodyparts(my, myStats, dist); break;
-		case INCUBUS: incubusMoveBodyparts(my, myStats, dist); break;
-		case VAMPIRE: vampireMoveBodyparts(my, myStats, dist); break;
-		case SHADOW: shadowMoveBodyparts(my, myStats, dist); break;
-		case COCKATRICE: cockatriceMoveBodyparts(my, myStats, dist); break;
-		case INSECTOID: insectoidMoveBodyparts(my, myStats, dist); break;
-		case GOATMAN: goatmanMoveBodyparts(my, myStats, dist); break;
-		case AUTOMATON: automatonMoveBodyparts(my, myStats, dist); break;
-		case LICH_ICE: lichIceAnimate(my, myStats, dist); break;
-		case LICH_FIRE: lichFireAnimate(my, myStats, dist); break;
-		case SENTRYBOT: sentryBotAnimate(my, myStats, dist); break;
-		case SPELLBOT: sentryBotAnimate(my, myStats, dist); break;
-		case GYROBOT: gyroBotAnimate(my, myStats, dist); break;
-		case DUMMYBOT: dummyBotAnimate(my, myStats, dist); break;
-		default: break;
+		if ( !monsterBodypartPoseCulled(my, myStats, dist) )
+		{
+			switch (my->getMonsterTypeFromSprite()) {
+			case HUMAN: humanMoveBodyparts(my, myStats, dist); break;
+			case RAT: ratAnimate(my, dist); break;
+			case GOBLIN: goblinMoveBodyparts(my, myStats, dist); break;
+			case SLIME: slimeAnimate(my, dist); break;
+			case TROLL: trollMoveBodyparts(my, myStats, dist); break;
+			case SPIDER: spiderMoveBodyparts(my, myStats, dist); break;
+			case GHOUL: ghoulMoveBodyparts(my, myStats, dist); break;
+			case SKELETON: skeletonMoveBodyparts(my, myStats, dist); break;
+			case SCORPION: scorpionAnimate(my, dist); break;
+			case CREATURE_IMP: impMoveBodyparts(my, myStats, dist); break;
+			case GNOME: gnomeMoveBodyparts(my, myStats, dist); break;
+			case DEMON: demonMoveBodyparts(my, myStats, dist); actDemonCeilingBuster(my); break;
+			case SUCCUBUS: succubusMoveBodyparts(my, myStats, dist); break;
+			case LICH: lichAnimate(my, dist); break;
+			case MINOTAUR: minotaurMoveBodyparts(my, myStats, dist); actMinotaurCeilingBuster(my); break;
+			case DEVIL: devilMoveBodyparts(my, myStats, dist); break;
+			case SHOPKEEPER: shopkeeperMoveBodyparts(my, myStats, dist); break;
+			case KOBOLD: koboldMoveBodyparts(my, myStats, dist); break;
+			case SCARAB: scarabAnimate(my, myStats, dist); break;
+			case CRYSTALGOLEM: crystalgolemMoveBodyparts(my, myStats, dist); break;
+			case INCUBUS: incubusMoveBodyparts(my, myStats, dist); break;
+			case VAMPIRE: vampireMoveBodyparts(my, myStats, dist); break;
+			case SHADOW: shadowMoveBodyparts(my, myStats, dist); break;
+			case COCKATRICE: cockatriceMoveBodyparts(my, myStats, dist); break;
+			case INSECTOID: insectoidMoveBodyparts(my, myStats, dist); break;
+			case GOATMAN: goatmanMoveBodyparts(my, myStats, dist); break;
+			case AUTOMATON: automatonMoveBodyparts(my, myStats, dist); break;
+			case LICH_ICE: lichIceAnimate(my, myStats, dist); break;
+			case LICH_FIRE: lichFireAnimate(my, myStats, dist); break;
+			case SENTRYBOT: sentryBotAnimate(my, myStats, dist); break;
+			case SPELLBOT: sentryBotAnimate(my, myStats, dist); break;
+			case GYROBOT: gyroBotAnimate(my, myStats, dist); break;
+			case DUMMYBOT: dummyBotAnimate(my, myStats, dist); break;
+			default: break;
+			}
+			my->monsterPoseSignature = monsterPoseStateSignature(my, myStats);
 		}
 	}
 }
@@ -8857,6 +9031,7 @@ bool forceFollower(Entity& leader, Entity& follower)
 			auto name = names[choice].c_str();
 			size_t len = names[choice].size();
 			stringCopy(followerStats->name, name, sizeof(Stat::name), len);
+			followerStats->updateAllegianceTags();
 		}
         
         // ... and a nametag
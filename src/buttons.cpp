@@ -1041,6 +1041,7 @@ void buttonDelete(button_t* my)
 	// delete the selected entity, if there is one
 	if ( selectedEntity[0] != NULL)
 	{
+		markUndoEntityDeleted(selectedEntity[0]);
 		list_RemoveNode(selectedEntity[0]->mynode);
 		selectedEntity[0] = NULL;
 		lastSelectedEntity[0] = NULL;
@@ -1053,6 +1054,7 @@ void buttonDelete(button_t* my)
 		{
 			for ( y = selectedarea_y1; y <= selectedarea_y2; y++ )
 			{
+				markUndoTile(drawlayer + y * MAPLAYERS + x * MAPLAYERS * map.height);
 				map.tiles[drawlayer + y * MAPLAYERS + x * MAPLAYERS * map.height] = 0;
 			}
 		}
@@ -1091,7 +1093,9 @@ void buttonCycleSprites(button_t* my)
 
 		// create new entity on the list, copying and removing the previous last one.
 		entity = newEntity(lastEntity->sprite, 0, map.entities, nullptr);
+		markUndoEntityCreated(entity);
 		setSpriteAttributes(entity, lastEntity, lastEntity);
+		markUndoEntityDeleted(lastEntity);
 		list_RemoveNode(lastEntity->mynode);
 
 		if ( entityWasSelected )
@@ -1355,6 +1359,7 @@ void buttonAttributesConfirm(button_t* my)
 	int x, y, z, c;
 	map_t mapcopy;
 	makeUndo();
+	markUndoAllTiles();
 
 	// make a copy of the current map
 	mapcopy.width = map.width;
@@ -1569,6 +1574,7 @@ void buttonClearMapConfirm(button_t* my)
 {
 	long x, y, z;
 	makeUndo();
+	markUndoAllTiles();
 	for ( z = 0; z < MAPLAYERS; z++ )
 	{
 		for ( y = 0; y < map.height; y++ )
@@ -1579,7 +1585,11 @@ void buttonClearMapConfirm(button_t* my)
 			}
 		}
 	}
-	list_FreeAll(map.entities);
+	while ( map.entities->first )
+	{
+		markUndoEntityDeleted((Entity*)map.entities->first->element);
+		list_RemoveNode(map.entities->first);
+	}
 	buttonCloseSubwindow(my);
 }
 
@@ -1781,6 +1791,7 @@ void buttonSpriteProperties(button_t* my)
 
 	if ( selectedEntity[0] != NULL )
 	{
+		markUndoEntity(selectedEntity[0]); // the dialogs below edit it in place
 		editproperty = 0;
 		for ( int i = 0; i < (sizeof(spriteProperties) / sizeof(spriteProperties[0])); i++ )
 		{
@@ -2912,6 +2923,7 @@ void buttonSpritePropertiesConfirm(button_t* my)
 	button_t* button = NULL;
 	if ( selectedEntity[0] != NULL )
 	{
+		markUndoEntity(selectedEntity[0]);
 		int spriteType = checkSpriteType(selectedEntity[0]->sprite);
 		switch ( spriteType )
 		{
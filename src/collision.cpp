@@ -857,6 +857,7 @@ int barony_clear(real_t tx, real_t ty, Entity* my)
 
 real_t clipMove(real_t* x, real_t* y, real_t vx, real_t vy, Entity* my)
 {
+	BENCHMARK_SCOPE(COLLISION, "clipMove");
 	real_t tx, ty;
 	hit.entity = NULL;
 
@@ -1271,6 +1272,7 @@ Entity* findEntityInLine( Entity* my, real_t x1, real_t y1, real_t angle, int en
 
 real_t lineTrace( Entity* my, real_t x1, real_t y1, real_t angle, real_t range, int entities, bool ground )
 {
+	BENCHMARK_SCOPE(COLLISION, "lineTrace");
 	int posx, posy;
 	real_t fracx, fracy;
 	real_t rx, ry;
@@ -1493,6 +1495,7 @@ real_t lineTrace( Entity* my, real_t x1, real_t y1, real_t angle, real_t range,
 
 real_t lineTraceTarget( Entity* my, real_t x1, real_t y1, real_t angle, real_t range, int entities, bool ground, Entity* target )
 {
+	BENCHMARK_SCOPE(COLLISION, "lineTraceTarget");
 	int posx, posy;
 	real_t fracx, fracy;
 	real_t rx, ry;
@@ -13,6 +13,7 @@
 #include "draw.hpp"
 #include "files.hpp"
 #include "hash.hpp"
+#include "profiler.hpp"
 #include "entity.hpp"
 #include "player.hpp"
 #include "ui/Frame.hpp"
@@ -69,6 +70,8 @@ Shader framebuffer::hdrShader;
 Shader voxelShader;
 Shader voxelBrightShader;
 Shader voxelDitheredShader;
+Shader voxelInstancedShader;
+bool voxelInstancingSupported = false;
 Shader worldShader;
 Shader worldDitheredShader;
 Shader worldDarkShader;
@@ -77,6 +80,8 @@ Shader spriteShader;
 Shader spriteDitheredShader;
 Shader spriteBrightShader;
 Shader spriteUIShader;
+Shader spriteInstancedShader;
+bool spriteInstancingSupported = false;
 TempTexture* lightmapTexture[MAXPLAYERS + 1];
 
 static Shader gearShader;
@@ -362,6 +367,83 @@ void createCommonDrawResources() {
 	buildVoxelShader(voxelDitheredShader, "voxelDitheredShader", true,
 		vox_vertex_glsl, sizeof(vox_vertex_glsl),
 		vox_dithered_fragment_glsl, sizeof(vox_dithered_fragment_glsl));
+
+    // instanced voxel shader: per-instance data is indexed out of uniform
+    // arrays with gl_InstanceID, which works all the way down to GLSL 1.50.
+    // VOXEL_INSTANCES_PER_DRAW in opengl.cpp must match the array sizes.
+
+    static const char vox_instanced_vertex_glsl[] =
+        "in vec3 iPosition;"
+        "in vec3 iColor;"
+        "in vec3 iNormal;"
+        "uniform mat4 uProj;"
+        "uniform mat4 uView;"
+        "uniform mat4 uModels[32];"
+        "uniform vec4 uLightFactors[32];"
+        "uniform vec4 uLightColors[32];"
+        "uniform vec4 uColorAdds[32];"
+        "out vec3 Color;"
+        "out vec4 WorldPos;"
+        "out vec3 Normal;"
+        "flat out vec4 LightFactor;"
+        "flat out vec4 LightColor;"
+        "flat out vec4 ColorAdd;"
+
+        "void main() {"
+        "mat4 model = uModels[gl_InstanceID];"
+        "WorldPos = model * vec4(iPosition, 1.0);"
+        "gl_Position = uProj * uView * WorldPos;"
+        "Color = iColor;"
+        "Normal = (model * vec4(iNormal, 0.0)).xyz;"
+        "LightFactor = uLightFactors[gl_InstanceID];"
+        "LightColor = uLightColors[gl_InstanceID];"
+        "ColorAdd = uColorAdds[gl_InstanceID];"
+        "}";
+
+    static const char vox_instanced_fragment_glsl[] =
+        "in vec3 Color;"
+        "in vec3 Normal;"
+        "in vec4 WorldPos;"
+        "flat in vec4 LightFactor;"
+        "flat in vec4 LightColor;"
+        "flat in vec4 ColorAdd;"
+        "uniform mat4 uColorRemap;"
+        "uniform vec4 uCameraPos;"
+        "uniform sampler2D uLightmap;"
+        "uniform vec2 uMapDims;"
+        "uniform float uFogDistance;"
+        "uniform vec4 uFogColor;"
+        "out vec4 FragColor;"
+
+        "void main() {"
+        "vec3 Remapped ="
+        "    (uColorRemap[0].rgb * Color.r)+"
+        "    (uColorRemap[1].rgb * Color.g)+"
+        "    (uColorRemap[2].rgb * Color.b);"
+        "vec2 TexCoord = WorldPos.xz / (uMapDims.xy * 32.0);"
+        "vec4 Lightmap = texture(uLightmap, TexCoord);"
+        "FragColor = vec4(Remapped, 1.0) * LightFactor * (Lightmap + LightColor) + ColorAdd;"
+
+        "if (uFogDistance > 0.0) {"
+        "float dist = length(uCameraPos.xyz - WorldPos.xyz);"
+        "float lerp = (min(dist, uFogDistance) / uFogDistance) * uFogColor.a;"
+        "vec3 mixed = mix(FragColor.rgb, uFogColor.rgb, lerp);"
+        "FragColor = vec4(mixed, FragColor.a);"
+        "}"
+        "}";
+
+    voxelInstancedShader.init("voxelInstancedShader");
+    voxelInstancingSupported =
+        voxelInstancedShader.compile(vox_instanced_vertex_glsl, sizeof(vox_instanced_vertex_glsl), Shader::Type::Vertex) &&
+        voxelInstancedShader.compile(vox_instanced_fragment_glsl, sizeof(vox_instanced_fragment_glsl), Shader::Type::Fragment);
+    voxelInstancedShader.bindAttribLocation("iPosition", 0);
+    voxelInstancedShader.bindAttribLocation("iColor", 1);
+    voxelInstancedShader.bindAttribLocation("iNormal", 2);
+    voxelInstancingSupported = voxelInstancedShader.link() && voxelInstancingSupported;
+    if (voxelInstancingSupported) {
+        voxelInstancedShader.bind();
+        GL_CHECK_ERR(glUniform1i(voxelInstancedShader.uniform("uLightmap"), 1));
+    }
     
     // world shader:
     
@@ -643,6 +725,78 @@ void createCommonDrawResources() {
     buildSpriteShader(spriteUIShader, "spriteUIShader", false,
         sprite_vertex_glsl, sizeof(sprite_vertex_glsl),
         sprite_bright_fragment_glsl, sizeof(sprite_bright_fragment_glsl));
+
+    // instanced sprite shader: runs of sprites sharing a texture, see
+    // SPRITE_INSTANCES_PER_DRAW in opengl.cpp. bright sprites ignore the
+    // lightmap, which is selected per draw with uLightmapWeight.
+
+    static const char sprite_instanced_vertex_glsl[] =
+        "in vec3 iPosition;"
+        "in vec2 iTexCoord;"
+        "uniform mat4 uProj;"
+        "uniform mat4 uView;"
+        "uniform mat4 uModels[32];"
+        "uniform vec4 uLightFactors[32];"
+        "uniform vec4 uLightColors[32];"
+        "uniform vec4 uColorAdds[32];"
+        "out vec4 WorldPos;"
+        "out vec2 TexCoord;"
+        "flat out vec4 LightFactor;"
+        "flat out vec4 LightColor;"
+        "flat out vec4 ColorAdd;"
+
+        "void main() {"
+        "WorldPos = uModels[gl_InstanceID] * vec4(iPosition, 1.0);"
+        "TexCoord = iTexCoord;"
+        "gl_Position = uProj * uView * WorldPos;"
+        "LightFactor = uLightFactors[gl_InstanceID];"
+        "LightColor = uLightColors[gl_InstanceID];"
+        "ColorAdd = uColorAdds[gl_InstanceID];"
+        "}";
+
+    static const char sprite_instanced_fragment_glsl[] =
+        "in vec4 WorldPos;"
+        "in vec2 TexCoord;"
+        "flat in vec4 LightFactor;"
+        "flat in vec4 LightColor;"
+        "flat in vec4 ColorAdd;"
+        "uniform float uLightmapWeight;"
+        "uniform vec4 uCameraPos;"
+        "uniform sampler2D uTexture;"
+        "uniform sampler2D uLightmap;"
+        "uniform vec2 uMapDims;"
+        "uniform float uFogDistance;"
+        "uniform vec4 uFogColor;"
+        "out vec4 FragColor;"
+
+        "void main() {"
+        "vec4 Texture = texture(uTexture, TexCoord);"
+        "vec2 LightCoord = WorldPos.xz / (uMapDims.xy * 32.0);"
+        "vec4 Lightmap = texture(uLightmap, LightCoord) * uLightmapWeight;"
+        "FragColor = Texture * LightFactor * (Lightmap + LightColor) + ColorAdd;"
+        "if (FragColor.a <= 0) discard;"
+
+        "if (uFogDistance > 0.0) {"
+        "float dist = length(uCameraPos.xyz - WorldPos.xyz);"
+        "float lerp = (min(dist, uFogDistance) / uFogDistance) * uFogColor.a;"
+        "vec3 mixed = mix(FragColor.rgb, uFogColor.rgb, lerp);"
+        "FragColor = vec4(mixed, FragColor.a);"
+        "}"
+        "}";
+
+    spriteInstancedShader.init("spriteInstancedShader");
+    spriteInstancingSupported =
+        spriteInstancedShader.compile(sprite_instanced_vertex_glsl, sizeof(sprite_instanced_vertex_glsl), Shader::Type::Vertex) &&
+        spriteInstancedShader.compile(sprite_instanced_fragment_glsl, sizeof(sprite_instanced_fragment_glsl), Shader::Type::Fragment);
+    spriteInstancedShader.bindAttribLocation("iPosition", 0);
+    spriteInstancedShader.bindAttribLocation("iTexCoord", 1);
+    spriteInstancedShader.bindAttribLocation("iColor", 2);
+    spriteInstancingSupported = spriteInstancedShader.link() && spriteInstancingSupported;
+    if (spriteInstancingSupported) {
+        spriteInstancedShader.bind();
+        GL_CHECK_ERR(glUniform1i(spriteInstancedShader.uniform("uTexture"), 0));
+        GL_CHECK_ERR(glUniform1i(spriteInstancedShader.uniform("uLightmap"), 1));
+    }
     
     spriteMesh.init();
     
@@ -655,6 +809,8 @@ void destroyCommonDrawResources() {
 	framebuffer::shader.destroy();
     framebuffer::hdrShader.destroy();
     voxelShader.destroy();
+    voxelInstancedShader.destroy();
+    voxelInstancingSupported = false;
     voxelBrightShader.destroy();
 	voxelDitheredShader.destroy();
     worldShader.destroy();
@@ -666,6 +822,8 @@ void destroyCommonDrawResources() {
     spriteDitheredShader.destroy();
     spriteBrightShader.destroy();
     spriteUIShader.destroy();
+    spriteInstancedShader.destroy();
+    spriteInstancingSupported = false;
     spriteMesh.destroy();
     lineShader.destroy();
     lineMesh.destroy();
@@ -726,7 +884,7 @@ void Mesh::destroy() {
 	}
 }
 
-void Mesh::draw(GLenum type, int numVertices) const {
+void Mesh::draw(GLenum type, int numVertices, int instances) const {
     // NOTE: OpenGL 2.1 does not support vertex arrays!
 #ifdef VERTEX_ARRAYS_ENABLED
 	GL_CHECK_ERR(glBindVertexArray(vao));
@@ -751,7 +909,12 @@ void Mesh::draw(GLenum type, int numVertices) const {
     
     // draw elements
     if (numVertices) {
-        GL_CHECK_ERR(glDrawArrays(type, 0, numVertices));
+        if (instances > 1) {
+            GL_CHECK_ERR(glDrawArraysInstanced(type, 0, numVertices, instances));
+        } else {
+            GL_CHECK_ERR(glDrawArrays(type, 0, numVertices));
+        }
+        ++drawStats.meshDrawCalls;
     }
     
     // disable buffers
@@ -1973,6 +2136,66 @@ void raycast(const view_t& camera, Sint8 (*minimap)[MINIMAP_MAX_DIMENSION], bool
 
 -------------------------------------------------------------------------------*/
 
+enum SpriteTypes
+{
+	SPRITE_ENTITY,
+	SPRITE_HPBAR,
+	SPRITE_DIALOGUE
+};
+
+struct SpriteToDraw
+{
+	Uint32 key; // see spriteDepthKey()
+	SpriteTypes type;
+	void* ptr;
+};
+
+// maps a (non-negative) squared camera distance to a key where smaller keys
+// are further away. the bits of a positive float sort like its value.
+static inline Uint32 spriteDepthKey(real_t camDist)
+{
+	const float f = (float)std::max(camDist, (real_t)0.0);
+	Uint32 bits;
+	memcpy(&bits, &f, sizeof(bits));
+	return ~bits;
+}
+
+// stable LSD radix sort on the depth key, 8 bits per pass. passes where every
+// key shares the same digit are skipped, which is most of them in practice.
+static void sortSpritesBackToFront(std::vector<SpriteToDraw>& sprites, std::vector<SpriteToDraw>& scratch)
+{
+	const size_t size = sprites.size();
+	if ( size < 2 )
+	{
+		return;
+	}
+	scratch.resize(size);
+	for ( int shift = 0; shift < 32; shift += 8 )
+	{
+		size_t counts[256] = { 0 };
+		for ( auto& sprite : sprites )
+		{
+			++counts[(sprite.key >> shift) & 0xff];
+		}
+		if ( counts[(sprites[0].key >> shift) & 0xff] == size )
+		{
+			continue;
+		}
+		size_t offset = 0;
+		for ( auto& count : counts )
+		{
+			const size_t c = count;
+			count = offset;
+			offset += c;
+		}
+		for ( auto& sprite : sprites )
+		{
+			scratch[counts[(sprite.key >> shift) & 0xff]++] = sprite;
+		}
+		sprites.swap(scratch);
+	}
+}
+
 Uint32 ditherDisabledTime = 0;
 void temporarilyDisableDithering() {
     ditherDisabledTime = ticks;
@@ -1980,6 +2203,7 @@ void temporarilyDisableDithering() {
 
 void drawEntities3D(view_t* camera, int mode)
 {
+    PROFILE_ZONE("drawEntities3D");
 #ifndef EDITOR
     static ConsoleVariable<bool> cvar_drawEnts("/draw_entities", true);
 	if (!*cvar_drawEnts) {
@@ -1992,13 +2216,13 @@ void drawEntities3D(view_t* camera, int mode)
 		return;
 	}
 
-	enum SpriteTypes
-	{
-		SPRITE_ENTITY,
-		SPRITE_HPBAR,
-		SPRITE_DIALOGUE
+	// reused from frame to frame so sprite-heavy scenes don't allocate
+	static std::vector<SpriteToDraw> spritesToDraw;
+	static std::vector<SpriteToDraw> spritesScratch;
+	spritesToDraw.clear();
+	auto addSprite = [](real_t camDist, void* sprite, SpriteTypes type) {
+		spritesToDraw.push_back(SpriteToDraw{ spriteDepthKey(camDist), type, sprite });
 	};
-	std::vector<std::tuple<real_t, void*, SpriteTypes>> spritesToDraw;
 
 	int currentPlayerViewport = -1;
 	for ( int c = 0; c < MAXPLAYERS; ++c )
@@ -2011,6 +2235,10 @@ void drawEntities3D(view_t* camera, int mode)
 	}
     
     const bool ditheringDisabled = ticks - ditherDisabledTime < TICKS_PER_SECOND;
+    const auto drawStartTime = std::chrono::high_resolution_clock::now();
+
+    // voxel models are collected by glDrawVoxel() and submitted in buckets
+    glBeginVoxelBatch(camera, mode);
 
 	node_t* nextnode = nullptr;
 	for ( node_t* node = map.entities->first; node != nullptr; node = nextnode )
@@ -2149,13 +2377,13 @@ void drawEntities3D(view_t* camera, int mode)
 			{
                 real_t camDist = (pow(camera->x * 16.0 - entity->x, 2)
                     + pow(camera->y * 16.0 - entity->y, 2));
-                spritesToDraw.push_back(std::make_tuple(camDist, entity, SPRITE_ENTITY));
+                addSprite(camDist, entity, SPRITE_ENTITY);
 			}
 			else if ( entity->behavior == &actSpriteWorldTooltip )
 			{
 				real_t camDist = (pow(camera->x * 16.0 - entity->x, 2)
 					+ pow(camera->y * 16.0 - entity->y, 2));
-				spritesToDraw.push_back(std::make_tuple(camDist, entity, SPRITE_ENTITY));
+				addSprite(camDist, entity, SPRITE_ENTITY);
 			}
 			else if ( entity->behavior == &actDamageGib )
 			{
@@ -2163,7 +2391,7 @@ void drawEntities3D(view_t* camera, int mode)
 				{
 					real_t camDist = (pow(camera->x * 16.0 - entity->x, 2)
 						+ pow(camera->y * 16.0 - entity->y, 2));
-					spritesToDraw.push_back(std::make_tuple(camDist, entity, SPRITE_ENTITY));
+					addSprite(camDist, entity, SPRITE_ENTITY);
 				}
 			}
 			else
@@ -2172,17 +2400,18 @@ void drawEntities3D(view_t* camera, int mode)
 				{
 					real_t camDist = (pow(camera->x * 16.0 - entity->x, 2)
 						+ pow(camera->y * 16.0 - entity->y, 2));
-					spritesToDraw.push_back(std::make_tuple(camDist, entity, SPRITE_ENTITY));
+					addSprite(camDist, entity, SPRITE_ENTITY);
 				}
 				else
 				{
 					real_t camDist = (pow(camera->x * 16.0 - entity->x, 2)
 						+ pow(camera->y * 16.0 - entity->y, 2));
-					spritesToDraw.push_back(std::make_tuple(camDist, entity, SPRITE_ENTITY));
+					addSprite(camDist, entity, SPRITE_ENTITY);
 				}
 			}
 		}
 	}
+	glEndVoxelBatch();
 
 #ifndef EDITOR
 	for ( int i = 0; i < MAXPLAYERS; ++i )
@@ -2191,7 +2420,7 @@ void drawEntities3D(view_t* camera, int mode)
 		{
 			real_t camDist = (pow(camera->x * 16.0 - enemybar.second.worldX, 2)
 				+ pow(camera->y * 16.0 - enemybar.second.worldY, 2));
-			spritesToDraw.push_back(std::make_tuple(camDist, &enemybar, SPRITE_HPBAR));
+			addSprite(camDist, &enemybar, SPRITE_HPBAR);
 		}
 		if ( players[i]->worldUI.worldTooltipDialogue.playerDialogue.init && players[i]->worldUI.worldTooltipDialogue.playerDialogue.draw )
 		{
@@ -2199,7 +2428,7 @@ void drawEntities3D(view_t* camera, int mode)
 			{
 				real_t camDist = (pow(camera->x * 16.0 - players[i]->worldUI.worldTooltipDialogue.playerDialogue.x, 2)
 					+ pow(camera->y * 16.0 - players[i]->worldUI.worldTooltipDialogue.playerDialogue.y, 2));
-				spritesToDraw.push_back(std::make_tuple(camDist, &players[i]->worldUI.worldTooltipDialogue.playerDialogue, SPRITE_DIALOGUE));
+				addSprite(camDist, &players[i]->worldUI.worldTooltipDialogue.playerDialogue, SPRITE_DIALOGUE);
 			}
 		}
 		for ( auto it = players[i]->worldUI.worldTooltipDialogue.sharedDialogues.begin();
@@ -2211,22 +2440,20 @@ void drawEntities3D(view_t* camera, int mode)
 				{
 					real_t camDist = (pow(camera->x * 16.0 - it->second.x, 2)
 						+ pow(camera->y * 16.0 - it->second.y, 2));
-					spritesToDraw.push_back(std::make_tuple(camDist, &it->second, SPRITE_DIALOGUE));
+					addSprite(camDist, &it->second, SPRITE_DIALOGUE);
 				}
 			}
 		}
 	}
 #endif
 
-	std::sort(spritesToDraw.begin(), spritesToDraw.end(), 
-		[](const std::tuple<real_t, void*, SpriteTypes>& lhs, const std::tuple<real_t, void*, SpriteTypes>& rhs) {
-		return lhs > rhs;
-	});
-	for ( auto& distSpriteType : spritesToDraw )
+	sortSpritesBackToFront(spritesToDraw, spritesScratch);
+	glBeginSpriteBatch(camera, mode);
+	for ( auto& sprite : spritesToDraw )
 	{
-		if ( std::get<2>(distSpriteType) == SpriteTypes::SPRITE_ENTITY )
+		if ( sprite.type == SpriteTypes::SPRITE_ENTITY )
 		{
-			Entity* entity = (Entity*)std::get<1>(distSpriteType);
+			Entity* entity = (Entity*)sprite.ptr;
 			if ( entity->behavior == &actSpriteNametag )
 			{
 				if ( intro ) { continue; } // don't draw on main menu
@@ -2280,23 +2507,27 @@ void drawEntities3D(view_t* camera, int mode)
 				glDrawSprite(camera, entity, mode);
 			}
 		}
-		else if ( std::get<2>(distSpriteType) == SpriteTypes::SPRITE_HPBAR )
+		else if ( sprite.type == SpriteTypes::SPRITE_HPBAR )
 		{
 #ifndef EDITOR
 			if ( intro ) { continue; } // don't draw on main menu
-			auto enemybar = (std::pair<Uint32, EnemyHPDamageBarHandler::EnemyHPDetails>*)std::get<1>(distSpriteType);
+			auto enemybar = (std::pair<Uint32, EnemyHPDamageBarHandler::EnemyHPDetails>*)sprite.ptr;
 			glDrawEnemyBarSprite(camera, mode, currentPlayerViewport, &enemybar->second);
 #endif
 		}
-		else if ( std::get<2>(distSpriteType) == SpriteTypes::SPRITE_DIALOGUE )
+		else if ( sprite.type == SpriteTypes::SPRITE_DIALOGUE )
 		{
 #ifndef EDITOR
 			if ( intro ) { continue; } // don't draw on main menu
-			auto dialogue = (Player::WorldUI_t::WorldTooltipDialogue_t::Dialogue_t*)std::get<1>(distSpriteType);
+			auto dialogue = (Player::WorldUI_t::WorldTooltipDialogue_t::Dialogue_t*)sprite.ptr;
 			glDrawWorldDialogueSprite(camera, dialogue, mode);
 #endif
 		}
 	}
+	glEndSpriteBatch();
+
+	const auto drawDuration = std::chrono::high_resolution_clock::now() - drawStartTime;
+	drawStats.entitiesMicroseconds += std::chrono::duration_cast<std::chrono::microseconds>(drawDuration).count();
 }
 
 /*-------------------------------------------------------------------------------
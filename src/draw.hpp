@@ -137,6 +137,15 @@ public:
         _h = surf->h;
         SDL_UnlockSurface(surf);
     }
+
+    // re-upload rows [y, y + rows) of a surface already loaded with load()
+    void loadRows(SDL_Surface* surf, int y, int rows) {
+        SDL_LockSurface(surf);
+        GL_CHECK_ERR(glBindTexture(GL_TEXTURE_2D, _texid));
+        GL_CHECK_ERR(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, surf->w, rows, GL_RGBA, GL_UNSIGNED_BYTE,
+            (Uint8*)surf->pixels + y * surf->pitch));
+        SDL_UnlockSurface(surf);
+    }
     
     void loadFloat(float* data, int width, int height, bool clamp, bool point) {
         GL_CHECK_ERR(glBindTexture(GL_TEXTURE_2D, _texid));
@@ -182,7 +191,7 @@ struct Mesh {
 
     void init();
     void destroy();
-    void draw(GLenum type = GL_TRIANGLES, int numVertices = 0) const;
+    void draw(GLenum type = GL_TRIANGLES, int numVertices = 0, int instances = 1) const;
     bool isInitialized() const { return vbo[0] != 0; }
 
 private:
@@ -309,6 +318,8 @@ extern framebuffer main_framebuffer;
 extern Shader voxelShader;
 extern Shader voxelBrightShader;
 extern Shader voxelDitheredShader;
+extern Shader voxelInstancedShader;
+extern bool voxelInstancingSupported;
 extern Shader worldShader;
 extern Shader worldDitheredShader;
 extern Shader worldDarkShader;
@@ -318,6 +329,8 @@ extern Shader spriteShader;
 extern Shader spriteDitheredShader;
 extern Shader spriteBrightShader;
 extern Shader spriteUIShader;
+extern Shader spriteInstancedShader;
+extern bool spriteInstancingSupported;
 extern Mesh spriteMesh;
 extern TempTexture* lightmapTexture[MAXPLAYERS + 1];
 
@@ -326,6 +339,26 @@ extern TempTexture* lightmapTexture[MAXPLAYERS + 1];
 extern Uint32 ditherDisabledTime;
 void temporarilyDisableDithering();
 
+// immutable copy of the level's tiles that chunk meshes are built from,
+// so worker threads never read map.tiles while the game is changing it
+struct ChunkMapSnapshot {
+    ChunkMapSnapshot(const map_t& map);
+    std::vector<Sint32> data;
+    const Sint32* tiles = nullptr;
+    Uint32 width = 0;
+    Uint32 height = 0;
+    Sint32 flags[MAPFLAGS];
+};
+
+// CPU-side geometry for one chunk, built off the main thread
+struct ChunkMesh {
+    int x = 0, y = 0, w = 0, h = 0;
+    std::vector<Sint32> tiles;
+    std::vector<float> positions;
+    std::vector<float> texcoords;
+    std::vector<float> colors;
+};
+
 struct Chunk {
     GLuint vao = 0;
     GLuint vbo_positions = 0;
@@ -347,6 +380,8 @@ struct Chunk {
         y = rhs.y;
         w = rhs.w;
         h = rhs.h;
+        dirty = rhs.dirty;
+        building = rhs.building;
         
         rhs.vao = 0;
         rhs.vbo_positions = 0;
@@ -357,6 +392,8 @@ struct Chunk {
         rhs.y = 0;
         rhs.w = 0;
         rhs.h = 0;
+        rhs.dirty = true;
+        rhs.building = false;
         
         tiles.swap(rhs.tiles);
         dithering.swap(rhs.dithering);
@@ -372,6 +409,8 @@ struct Chunk {
         y = rhs.y;
         w = rhs.w;
         h = rhs.h;
+        dirty = rhs.dirty;
+        building = rhs.building;
         
         rhs.vao = 0;
         rhs.vbo_positions = 0;
@@ -382,6 +421,8 @@ struct Chunk {
         rhs.y = 0;
         rhs.w = 0;
         rhs.h = 0;
+        rhs.dirty = true;
+        rhs.building = false;
         
         tiles.swap(rhs.tiles);
         dithering.swap(rhs.dithering);
@@ -393,6 +434,7 @@ struct Chunk {
     }
     
     void build(const map_t& map, bool ceiling, int startX, int startY, int w, int h);
+    void apply(ChunkMesh& mesh); // take a finished mesh and upload it
     void buildBuffers(const std::vector<float>& positions, const std::vector<float>& texcoords, const std::vector<float>& colors);
     void destroyBuffers();
     void draw();
@@ -400,6 +442,8 @@ struct Chunk {
     
     int x = 0, y = 0, w = 0, h = 0;
     std::vector<Sint32> tiles;
+    bool dirty = true;     // tiles changed since the mesh was built
+    bool building = false; // a worker is building a new mesh
     
     struct Dither {
         static constexpr int MAX = 10;
@@ -423,7 +467,11 @@ extern view_t menucam;
 void beginGraphics();
 void glBeginCamera(view_t* camera, bool useHDR);
 void glDrawVoxel(view_t* camera, Entity* entity, int mode);
+void glBeginVoxelBatch(view_t* camera, int mode);
+void glEndVoxelBatch();
 void glDrawSprite(view_t* camera, Entity* entity, int mode);
+void glBeginSpriteBatch(view_t* camera, int mode);
+void glEndSpriteBatch();
 void glDrawWorldUISprite(view_t* camera, Entity* entity, int mode);
 void glDrawWorldDialogueSprite(view_t* camera, void* worldDialogue, int mode);
 void glDrawEnemyBarSprite(view_t* camera, int mode, int playerViewport, void* enemyHPBarDetails);
@@ -432,6 +480,20 @@ void glDrawWorld(view_t* camera, int mode);
 void glEndCamera(view_t* camera, bool useHDR);
 unsigned int GO_GetPixelU32(int x, int y, view_t& camera);
 
+// per-frame draw statistics, see /drawstats
+struct DrawStats {
+    Uint32 voxelDrawCalls = 0;      // voxel models drawn one at a time
+    Uint32 voxelBatchDrawCalls = 0; // instanced voxel draws
+    Uint32 voxelInstances = 0;      // voxel models drawn by instanced draws
+    Uint32 chunkDrawCalls = 0;      // world geometry
+    Uint32 meshDrawCalls = 0;       // sprites, UI and everything else using Mesh
+    Uint32 spriteInstances = 0;     // sprites drawn by instanced mesh draws
+    Uint64 entitiesMicroseconds = 0;// CPU time spent in drawEntities3D
+    Uint64 frameMicroseconds = 0;   // CPU time between two beginGraphics() calls
+};
+extern DrawStats drawStats;          // stats being collected for the current frame
+extern DrawStats drawStatsLastFrame; // stats for the last finished frame
+
 extern bool hdrEnabled;
 
 #ifndef EDITOR
@@ -20,6 +20,9 @@
 #include "init.hpp"
 #include "mod_tools.hpp"
 #include <sys/stat.h>
+#include <deque>
+#include <memory>
+#include <unordered_map>
 #ifndef EDITOR
 #define EDITOR
 #endif
@@ -979,6 +982,7 @@ void editFill(int x, int y, int layer, int type)
 	}
 
 	fillspot = map.tiles[layer + y * MAPLAYERS + x * MAPLAYERS * map.height];
+	markUndoTile(layer + y * MAPLAYERS + x * MAPLAYERS * map.height);
 	map.tiles[layer + y * MAPLAYERS + x * MAPLAYERS * map.height] = type + numtiles;
 
 	while ( repeat )
@@ -994,6 +998,7 @@ void editFill(int x, int y, int layer, int type)
 					{
 						if ( map.tiles[layer + y * MAPLAYERS + (x + 1)*MAPLAYERS * map.height] == fillspot )
 						{
+							markUndoTile(layer + y * MAPLAYERS + (x + 1)*MAPLAYERS * map.height);
 							map.tiles[layer + y * MAPLAYERS + (x + 1)*MAPLAYERS * map.height] = type + numtiles;
 							repeat = 1;
 						}
@@ -1002,6 +1007,7 @@ void editFill(int x, int y, int layer, int type)
 					{
 						if ( map.tiles[layer + y * MAPLAYERS + (x - 1)*MAPLAYERS * map.height] == fillspot )
 						{
+							markUndoTile(layer + y * MAPLAYERS + (x - 1)*MAPLAYERS * map.height);
 							map.tiles[layer + y * MAPLAYERS + (x - 1)*MAPLAYERS * map.height] = type + numtiles;
 							repeat = 1;
 						}
@@ -1010,6 +1016,7 @@ void editFill(int x, int y, int layer, int type)
 					{
 						if ( map.tiles[layer + (y + 1)*MAPLAYERS + x * MAPLAYERS * map.height] == fillspot )
 						{
+							markUndoTile(layer + (y + 1)*MAPLAYERS + x * MAPLAYERS * map.height);
 							map.tiles[layer + (y + 1)*MAPLAYERS + x * MAPLAYERS * map.height] = type + numtiles;
 							repeat = 1;
 						}
@@ -1018,6 +1025,7 @@ void editFill(int x, int y, int layer, int type)
 					{
 						if ( map.tiles[layer + (y - 1)*MAPLAYERS + x * MAPLAYERS * map.height] == fillspot )
 						{
+							markUndoTile(layer + (y - 1)*MAPLAYERS + x * MAPLAYERS * map.height);
 							map.tiles[layer + (y - 1)*MAPLAYERS + x * MAPLAYERS * map.height] = type + numtiles;
 							repeat = 1;
 						}
@@ -1033,6 +1041,7 @@ void editFill(int x, int y, int layer, int type)
 		{
 			if ( map.tiles[layer + y * MAPLAYERS + x * MAPLAYERS * map.height] == type + numtiles )
 			{
+				markUndoTile(layer + y * MAPLAYERS + x * MAPLAYERS * map.height);
 				map.tiles[layer + y * MAPLAYERS + x * MAPLAYERS * map.height] = type;
 			}
 		}
@@ -1043,163 +1052,503 @@ void editFill(int x, int y, int layer, int type)
 
 	makeUndo
 
-	adds an undomap to the undolist
+	closes the current step of the undo journal. call it before making an
+	edit, the edit itself is recorded by the markUndo* calls at the edit site
+	and closed into a step by the next makeUndo(), undo() or redo(). a step
+	only holds the tiles and entities that were marked, and the oldest steps
+	are dropped once undoMemoryBudget is exceeded
 
 -------------------------------------------------------------------------------*/
 
-#define MAXUNDOS 10
+size_t undoMemoryBudget = 64 * 1024 * 1024; // set with -undobudget=<megabytes>
 
-node_t* undospot = nullptr;
-node_t* redospot = nullptr;
-list_t undolist;
-void makeUndo()
+// a copy of one entity, kept in its own list so it never touches map.entities
+struct UndoEntitySnapshot_t
 {
-	node_t* node, *nextnode;
+	list_t entities;
+	Entity* entity = nullptr;
+	Uint32 hash = 0; // hashUndoEntity() of the entity it was copied from
 
-	// eliminate any undo nodes beyond the one we are currently on
-	if ( undospot != nullptr )
+	UndoEntitySnapshot_t()
 	{
-		for ( node = undospot->next; node != nullptr; node = nextnode )
-		{
-			nextnode = node->next;
-			list_RemoveNode(node);
-		}
+		entities.first = nullptr;
+		entities.last = nullptr;
 	}
-	else
+	~UndoEntitySnapshot_t()
 	{
-		if ( redospot )
-		{
-			list_FreeAll(&undolist);
-		}
+		list_FreeAll(&entities);
 	}
+};
 
-	// copy all the current map data
-	map_t* undomap = (map_t*) malloc(sizeof(map_t));
-	strcpy(undomap->author, map.author);
-	strcpy(undomap->name, map.name);
-	undomap->skybox = map.skybox;
-	undomap->width = map.width;
-	undomap->height = map.height;
-	for ( int c = 0; c < MAPFLAGS; c++ )
-	{
-		undomap->flags[c] = map.flags[c];
-	}
-	undomap->tiles = (Sint32*) malloc(sizeof(Sint32) * undomap->width * undomap->height * MAPLAYERS);
-	memcpy(undomap->tiles, map.tiles, sizeof(Sint32)*undomap->width * undomap->height * MAPLAYERS);
-	undomap->entities = (list_t*) malloc(sizeof(list_t));
-	undomap->entities->first = nullptr;
-	undomap->entities->last = nullptr;
-	undomap->creatures = nullptr;
-	undomap->worldUI = nullptr;
-	for ( node = map.entities->first; node != nullptr; node = node->next )
+// undo and redo recreate entities, so steps refer to them through a handle
+// that always points at the entity's current incarnation (or null if deleted)
+struct UndoEntityHandle_t
+{
+	Entity* live = nullptr;
+};
+
+struct UndoEntityOp_t
+{
+	enum Kind
 	{
-		Entity* entity = newEntity(((Entity*)node->element)->sprite, 1, undomap->entities, nullptr);
+		ENTITY_CREATED,
+		ENTITY_DELETED,
+		ENTITY_MODIFIED
+	};
+	Kind kind;
+	std::shared_ptr<UndoEntityHandle_t> entity;
+	std::shared_ptr<UndoEntityHandle_t> prev; // entity in front of it in map.entities when created/deleted, null if first
+	std::shared_ptr<UndoEntitySnapshot_t> before; // deleted and modified
+	std::shared_ptr<UndoEntitySnapshot_t> after; // created and modified
+};
 
-		setSpriteAttributes(entity, (Entity*)node->element, (Entity*)node->element);
-	}
+struct UndoTileRun_t
+{
+	size_t offset;
+	std::vector<Sint32> before;
+	std::vector<Sint32> after;
+};
 
-	// add the new node to the undo list
-	node = list_AddNodeLast(&undolist);
-	node->element = undomap;
-	node->deconstructor = &mapDeconstructor;
-	if ( list_Size(&undolist) > MAXUNDOS + 1 )
+struct UndoStep_t
+{
+	Uint32 widthBefore, heightBefore;
+	Uint32 widthAfter, heightAfter;
+	std::vector<UndoTileRun_t> tiles; // a single run of the whole map if it was resized
+	std::vector<UndoEntityOp_t> entities; // in the order they happened
+	size_t bytes = 0;
+};
+
+static struct UndoJournal_t
+{
+	std::deque<UndoStep_t> steps;
+	size_t cursor = 0; // steps before the cursor can be undone, the rest redone
+	size_t bytes = 0;
+
+	std::unordered_map<Entity*, std::shared_ptr<UndoEntityHandle_t>> handles;
+
+	// the step being recorded
+	std::vector<std::pair<size_t, Sint32>> dirtyTiles; // tile index, value before the step
+	std::vector<bool> dirtyTileMask;
+	bool allTilesDirty = false; // set by markUndoAllTiles()
+	Uint32 widthBefore = 0;
+	Uint32 heightBefore = 0;
+	std::vector<Sint32> allTilesBefore;
+	std::vector<UndoEntityOp_t> entityOps;
+	std::unordered_map<UndoEntityHandle_t*, size_t> openEntityOps; // index of ops still waiting for their after state
+} undoJournal;
+
+// hashes everything the editor lets you change about an entity
+static Uint32 hashUndoEntity(Entity* entity)
+{
+	Uint32 hash = 2166136261u;
+	auto mix = [&hash](const void* data, size_t len)
+	{
+		const Uint8* bytes = (const Uint8*)data;
+		for ( size_t c = 0; c < len; ++c )
+		{
+			hash = (hash ^ bytes[c]) * 16777619u;
+		}
+	};
+	mix(&entity->sprite, sizeof(entity->sprite));
+	mix(&entity->x, sizeof(entity->x));
+	mix(&entity->y, sizeof(entity->y));
+	mix(&entity->yaw, sizeof(entity->yaw));
+	mix(entity->skill, sizeof(entity->skill));
+	mix(entity->fskill, sizeof(entity->fskill));
+	if ( Stat* stats = entity->getStats() )
 	{
-		list_RemoveNode(undolist.first);
+		const Sint32 attributes[] = {
+			(Sint32)stats->sex, (Sint32)stats->appearance,
+			stats->HP, stats->MAXHP, stats->MP, stats->MAXMP,
+			stats->STR, stats->DEX, stats->CON, stats->INT, stats->PER, stats->CHR,
+			stats->LVL, stats->GOLD,
+			stats->RANDOM_STR, stats->RANDOM_DEX, stats->RANDOM_CON, stats->RANDOM_INT, stats->RANDOM_PER, stats->RANDOM_CHR,
+			stats->RANDOM_MAXHP, stats->RANDOM_HP, stats->RANDOM_MAXMP, stats->RANDOM_MP,
+			stats->RANDOM_LVL, stats->RANDOM_GOLD,
+		};
+		mix(attributes, sizeof(attributes));
+		mix(stats->name, strnlen(stats->name, sizeof(stats->name)));
+		mix(stats->MISC_FLAGS, sizeof(stats->MISC_FLAGS));
+		mix(stats->EDITOR_ITEMS, sizeof(stats->EDITOR_ITEMS));
 	}
-	undospot = node;
-	redospot = nullptr;
+	return hash;
 }
 
-void clearUndos()
+// setSpriteAttributes only carries over the fields used by the entity's type,
+// copy the rest of what hashUndoEntity covers so a restored entity hashes the same
+static void copyUndoEntity(Entity* entity, Entity* source)
 {
-	list_FreeAll(&undolist);
-	undospot = nullptr;
-	redospot = nullptr;
+	setSpriteAttributes(entity, source, source);
+	entity->yaw = source->yaw;
+	std::copy(std::begin(source->skill), std::end(source->skill), std::begin(entity->skill));
+	std::copy(std::begin(source->fskill), std::end(source->fskill), std::begin(entity->fskill));
 }
 
-/*-------------------------------------------------------------------------------
+static std::shared_ptr<UndoEntitySnapshot_t> snapshotUndoEntity(Entity* entity)
+{
+	auto snapshot = std::make_shared<UndoEntitySnapshot_t>();
+	snapshot->entity = newEntity(entity->sprite, 1, &snapshot->entities, nullptr);
+	copyUndoEntity(snapshot->entity, entity);
+	snapshot->hash = hashUndoEntity(entity);
+	return snapshot;
+}
 
-	undo() / redo()
+static std::shared_ptr<UndoEntityHandle_t> getUndoHandle(Entity* entity)
+{
+	auto& handle = undoJournal.handles[entity];
+	if ( !handle )
+	{
+		handle = std::make_shared<UndoEntityHandle_t>();
+		handle->live = entity;
+	}
+	return handle;
+}
 
-	self explanatory
+static std::shared_ptr<UndoEntityHandle_t> getUndoPrevHandle(Entity* entity)
+{
+	node_t* prev = entity->mynode->prev;
+	return prev ? getUndoHandle((Entity*)prev->element) : nullptr;
+}
 
--------------------------------------------------------------------------------*/
+void markUndoTile(size_t index)
+{
+	auto& journal = undoJournal;
+	if ( journal.allTilesDirty )
+	{
+		return;
+	}
+	const size_t size = map.width * map.height * MAPLAYERS;
+	if ( journal.dirtyTileMask.size() != size )
+	{
+		journal.dirtyTileMask.assign(size, false);
+	}
+	if ( index >= size || journal.dirtyTileMask[index] )
+	{
+		return;
+	}
+	journal.dirtyTileMask[index] = true;
+	journal.dirtyTiles.emplace_back(index, map.tiles[index]);
+}
 
-void undo()
+void markUndoAllTiles()
 {
-	node_t* node;
-	if ( undospot == NULL )
+	auto& journal = undoJournal;
+	if ( journal.allTilesDirty )
 	{
 		return;
 	}
-	selectedEntity[0] = NULL;
-	if ( undospot == undolist.last )
+	journal.allTilesDirty = true;
+	journal.widthBefore = map.width;
+	journal.heightBefore = map.height;
+	journal.allTilesBefore.assign(map.tiles, map.tiles + map.width * map.height * MAPLAYERS);
+	for ( auto& tile : journal.dirtyTiles )
+	{
+		journal.allTilesBefore[tile.first] = tile.second;
+		journal.dirtyTileMask[tile.first] = false;
+	}
+	journal.dirtyTiles.clear();
+}
+
+void markUndoEntity(Entity* entity)
+{
+	auto& journal = undoJournal;
+	auto handle = getUndoHandle(entity);
+	if ( journal.openEntityOps.find(handle.get()) != journal.openEntityOps.end() )
 	{
-		node_t* tempnode = undospot;
-		makeUndo();
-		undospot = tempnode;
+		return; // already created or marked during this step
 	}
+	UndoEntityOp_t op;
+	op.kind = UndoEntityOp_t::ENTITY_MODIFIED;
+	op.entity = handle;
+	op.before = snapshotUndoEntity(entity);
+	journal.openEntityOps[handle.get()] = journal.entityOps.size();
+	journal.entityOps.push_back(std::move(op));
+}
+
+void markUndoEntityCreated(Entity* entity)
+{
+	auto& journal = undoJournal;
+	UndoEntityOp_t op;
+	op.kind = UndoEntityOp_t::ENTITY_CREATED;
+	op.entity = getUndoHandle(entity);
+	op.prev = getUndoPrevHandle(entity);
+	journal.openEntityOps[op.entity.get()] = journal.entityOps.size();
+	journal.entityOps.push_back(std::move(op));
+}
+
+void markUndoEntityDeleted(Entity* entity)
+{
+	auto& journal = undoJournal;
+	UndoEntityOp_t op;
+	op.kind = UndoEntityOp_t::ENTITY_DELETED;
+	op.entity = getUndoHandle(entity);
+	op.prev = getUndoPrevHandle(entity);
+	op.before = snapshotUndoEntity(entity);
+
+	// an entity created or modified earlier in this step ends up as it is now
+	auto open = journal.openEntityOps.find(op.entity.get());
+	if ( open != journal.openEntityOps.end() )
+	{
+		journal.entityOps[open->second].after = op.before;
+		journal.openEntityOps.erase(open);
+	}
+	journal.entityOps.push_back(std::move(op));
+
+	// the entity's memory may be reused by the next newEntity()
+	journal.handles.erase(entity);
+	journal.entityOps.back().entity->live = nullptr;
+}
+
+static void resizeUndoMap(Uint32 width, Uint32 height)
+{
 	free(map.tiles);
 	free(camera.vismap);
-	map_t* undomap = (map_t*)undospot->element;
-	map.width = undomap->width;
-	map.height = undomap->height;
+	map.width = width;
+	map.height = height;
 	map.tiles = (Sint32*) malloc(sizeof(Sint32) * map.width * map.height * MAPLAYERS);
 	camera.vismap = (bool*) malloc(sizeof(bool) * map.height * map.width);
-    memset(camera.vismap, 0, sizeof(bool) * map.height * map.width);
-	memcpy(map.tiles, undomap->tiles, sizeof(Sint32)*undomap->width * undomap->height * MAPLAYERS);
-	list_FreeAll(map.entities);
-	for ( node = undomap->entities->first; node != NULL; node = node->next )
+	memset(camera.vismap, 0, sizeof(bool) * map.height * map.width);
+}
+
+// turns everything marked since the last step into a new step
+static void recordUndoStep()
+{
+	auto& journal = undoJournal;
+	UndoStep_t step;
+	step.widthAfter = map.width;
+	step.heightAfter = map.height;
+	step.widthBefore = journal.allTilesDirty ? journal.widthBefore : map.width;
+	step.heightBefore = journal.allTilesDirty ? journal.heightBefore : map.height;
+
+	const size_t size = map.width * map.height * MAPLAYERS;
+	if ( journal.allTilesDirty )
+	{
+		if ( step.widthBefore != step.widthAfter || step.heightBefore != step.heightAfter
+			|| memcmp(journal.allTilesBefore.data(), map.tiles, sizeof(Sint32) * size) )
+		{
+			UndoTileRun_t run;
+			run.offset = 0;
+			run.before = std::move(journal.allTilesBefore);
+			run.after.assign(map.tiles, map.tiles + size);
+			step.tiles.push_back(std::move(run));
+		}
+		journal.allTilesBefore.clear();
+		journal.allTilesDirty = false;
+	}
+	else if ( !journal.dirtyTiles.empty() )
 	{
-		Entity* entity = newEntity(((Entity*)node->element)->sprite, 1, map.entities, nullptr);
+		// gather the marked tiles that actually changed into runs of neighbours
+		std::sort(journal.dirtyTiles.begin(), journal.dirtyTiles.end());
+		for ( auto& tile : journal.dirtyTiles )
+		{
+			journal.dirtyTileMask[tile.first] = false;
+			if ( map.tiles[tile.first] == tile.second )
+			{
+				continue;
+			}
+			if ( step.tiles.empty() || step.tiles.back().offset + step.tiles.back().after.size() != tile.first )
+			{
+				step.tiles.emplace_back();
+				step.tiles.back().offset = tile.first;
+			}
+			step.tiles.back().before.push_back(tile.second);
+			step.tiles.back().after.push_back(map.tiles[tile.first]);
+		}
+	}
+	journal.dirtyTiles.clear();
 
-		setSpriteAttributes(entity, (Entity*)node->element, (Entity*)node->element);
+	for ( auto& open : journal.openEntityOps )
+	{
+		auto& op = journal.entityOps[open.second];
+		op.after = snapshotUndoEntity(op.entity->live);
 	}
-	if ( redospot != NULL )
+	journal.openEntityOps.clear();
+	for ( auto& op : journal.entityOps )
 	{
-		redospot = redospot->prev;
+		if ( op.kind == UndoEntityOp_t::ENTITY_MODIFIED && op.before->hash == op.after->hash )
+		{
+			continue; // marked but left as it was
+		}
+		step.entities.push_back(std::move(op));
 	}
-	else
+	journal.entityOps.clear();
+
+	if ( step.tiles.empty() && step.entities.empty() )
+	{
+		return; // nothing changed
+	}
+
+	// a new edit discards anything that could be redone
+	while ( journal.steps.size() > journal.cursor )
+	{
+		journal.bytes -= journal.steps.back().bytes;
+		journal.steps.pop_back();
+	}
+
+	step.bytes = sizeof(UndoStep_t);
+	for ( auto& run : step.tiles )
+	{
+		step.bytes += sizeof(UndoTileRun_t) + sizeof(Sint32) * (run.before.size() + run.after.size());
+	}
+	for ( auto& op : step.entities )
+	{
+		step.bytes += sizeof(UndoEntityOp_t) + sizeof(Entity) * ((op.before ? 1 : 0) + (op.after && op.after != op.before ? 1 : 0));
+	}
+	journal.bytes += step.bytes;
+	journal.steps.push_back(std::move(step));
+	journal.cursor = journal.steps.size();
+
+	// stay within the memory budget, but always keep the latest step
+	while ( journal.bytes > undoMemoryBudget && journal.steps.size() > 1 )
 	{
-		redospot = undospot->next;
+		journal.bytes -= journal.steps.front().bytes;
+		journal.steps.pop_front();
+		--journal.cursor;
 	}
-	undospot = undospot->prev;
 }
 
-void redo()
+static void removeUndoEntity(UndoEntityHandle_t& handle)
 {
-	node_t* node;
+	undoJournal.handles.erase(handle.live);
+	list_RemoveNode(handle.live->mynode);
+	handle.live = nullptr;
+}
 
-	if ( redospot == NULL )
+// recreates an entity from a snapshot in map.entities, directly after "prev" or first if null
+static void restoreUndoEntity(const std::shared_ptr<UndoEntityHandle_t>& handle, UndoEntitySnapshot_t& snapshot, Entity* prev)
+{
+	Entity* entity = newEntity(snapshot.entity->sprite, 0, map.entities, nullptr);
+	copyUndoEntity(entity, snapshot.entity);
+	if ( prev )
 	{
-		return;
+		list_MoveNode(entity->mynode, prev->mynode);
 	}
-	selectedEntity[0] = NULL;
-	free(map.tiles);
-	free(camera.vismap);
-	map_t* undomap = (map_t*)redospot->element;
-	map.width = undomap->width;
-	map.height = undomap->height;
-	map.tiles = (Sint32*) malloc(sizeof(Sint32) * map.width * map.height * MAPLAYERS);
-	camera.vismap = (bool*) malloc(sizeof(bool) * map.height * map.width);
-    memset(camera.vismap, 0, sizeof(bool) * map.height * map.width);
-	memcpy(map.tiles, undomap->tiles, sizeof(Sint32)*undomap->width * undomap->height * MAPLAYERS);
-	list_FreeAll(map.entities);
-	for ( node = undomap->entities->first; node != NULL; node = node->next )
+	handle->live = entity;
+	undoJournal.handles[entity] = handle;
+}
+
+static void applyUndoEntityOp(UndoEntityOp_t& op, bool forward)
+{
+	Entity* prev = op.prev ? op.prev->live : nullptr;
+	switch ( op.kind )
 	{
-		Entity* entity = newEntity(((Entity*)node->element)->sprite, 1, map.entities, nullptr);
+		case UndoEntityOp_t::ENTITY_CREATED:
+			if ( forward )
+			{
+				restoreUndoEntity(op.entity, *op.after, prev);
+			}
+			else
+			{
+				removeUndoEntity(*op.entity);
+			}
+			break;
+		case UndoEntityOp_t::ENTITY_DELETED:
+			if ( forward )
+			{
+				removeUndoEntity(*op.entity);
+			}
+			else
+			{
+				restoreUndoEntity(op.entity, *op.before, prev);
+			}
+			break;
+		case UndoEntityOp_t::ENTITY_MODIFIED:
+		{
+			// setSpriteAttributes expects a fresh entity, so replace it in place
+			node_t* node = op.entity->live->mynode->prev;
+			prev = node ? (Entity*)node->element : nullptr;
+			removeUndoEntity(*op.entity);
+			restoreUndoEntity(op.entity, forward ? *op.after : *op.before, prev);
+			break;
+		}
+	}
+}
 
-		setSpriteAttributes(entity, (Entity*)node->element, (Entity*)node->element);
+// moves the map to the state before or after a step
+static void applyUndoStep(UndoStep_t& step, bool forward)
+{
+	selectedEntity[0] = NULL;
+	lastSelectedEntity[0] = NULL;
+	groupedEntities.clear();
+
+	const Uint32 width = forward ? step.widthAfter : step.widthBefore;
+	const Uint32 height = forward ? step.heightAfter : step.heightBefore;
+	if ( map.width != width || map.height != height )
+	{
+		resizeUndoMap(width, height);
 	}
-	if ( undospot != NULL )
+	for ( auto& run : step.tiles )
 	{
-		undospot = undospot->next;
+		auto& tiles = forward ? run.after : run.before;
+		std::copy(tiles.begin(), tiles.end(), map.tiles + run.offset);
+	}
+
+	if ( forward )
+	{
+		for ( auto& op : step.entities )
+		{
+			applyUndoEntityOp(op, true);
+		}
 	}
 	else
 	{
-		undospot = redospot->prev;
+		for ( auto op = step.entities.rbegin(); op != step.entities.rend(); ++op )
+		{
+			applyUndoEntityOp(*op, false);
+		}
 	}
-	redospot = redospot->next;
+}
+
+void makeUndo()
+{
+	recordUndoStep();
+}
+
+void clearUndos()
+{
+	auto& journal = undoJournal;
+	journal.steps.clear();
+	journal.cursor = 0;
+	journal.bytes = 0;
+	journal.handles.clear();
+	journal.dirtyTiles.clear();
+	journal.dirtyTileMask.clear();
+	journal.allTilesDirty = false;
+	journal.allTilesBefore.clear();
+	journal.entityOps.clear();
+	journal.openEntityOps.clear();
+}
+
+/*-------------------------------------------------------------------------------
+
+	undo() / redo()
+
+	self explanatory
+
+-------------------------------------------------------------------------------*/
+
+void undo()
+{
+	auto& journal = undoJournal;
+	recordUndoStep(); // pick up whatever was edited since the last makeUndo()
+	if ( journal.cursor == 0 )
+	{
+		return;
+	}
+	--journal.cursor;
+	applyUndoStep(journal.steps[journal.cursor], false);
+}
+
+void redo()
+{
+	auto& journal = undoJournal;
+	recordUndoStep();
+	if ( journal.cursor >= journal.steps.size() )
+	{
+		return;
+	}
+	applyUndoStep(journal.steps[journal.cursor], true);
+	++journal.cursor;
 }
 
 void processCommandLine(int argc, char** argv)
@@ -1225,6 +1574,10 @@ void processCommandLine(int argc, char** argv)
 					strncpy(datadir, argv[c] + 9, datadirsz);
 					datadir[datadirsz] = '\0';
 				}
+				else if ( !strncmp(argv[c], "-undobudget=", 12) )
+				{
+					undoMemoryBudget = (size_t)std::max(1, atoi(argv[c] + 12)) * 1024 * 1024;
+				}
 			}
 		}
 	}
@@ -1594,8 +1947,6 @@ int main(int argc, char** argv)
 	copymap.entities = nullptr;
 	copymap.creatures = nullptr;
 	copymap.worldUI = nullptr;
-	undolist.first = nullptr;
-	undolist.last = nullptr;
 
 	// Load Cursors
 	cursorArrow = SDL_GetCursor();
@@ -2210,6 +2561,7 @@ int main(int argc, char** argv)
 									duplicatedSprite = true;
 								}
 								selectedEntity[0] = newEntity(entity->sprite, 0, map.entities, nullptr);
+								markUndoEntityCreated(selectedEntity[0]);
 								
 								setSpriteAttributes(selectedEntity[0], entity, lastSelectedEntity[0]);
 
@@ -2218,6 +2570,7 @@ int main(int argc, char** argv)
 								mousestatus[SDL_BUTTON_RIGHT] = 0;
 								break;
 							}
+							markUndoEntity(entity);
 							entity->x = (long)(drawx << 4);
 							entity->y = (long)(drawy << 4);
 						}
@@ -2247,6 +2600,7 @@ int main(int argc, char** argv)
 										makeUndo();
 									}
 									selectedEntity[0] = newEntity(entity->sprite, 0, map.entities, nullptr);
+									markUndoEntityCreated(selectedEntity[0]);
 									lastSelectedEntity[0] = selectedEntity[0];
 
 									setSpriteAttributes(selectedEntity[0], entity, entity);
@@ -2274,6 +2628,7 @@ int main(int argc, char** argv)
 							{
 								if ( drawx >= 0 && drawx < map.width && drawy >= 0 && drawy < map.height )
 								{
+									markUndoTile(drawlayer + drawy * MAPLAYERS + drawx * MAPLAYERS * map.height);
 									map.tiles[drawlayer + drawy * MAPLAYERS + drawx * MAPLAYERS * map.height] = selectedTile;
 								}
 							}
@@ -2291,6 +2646,7 @@ int main(int argc, char** argv)
 										{
 											if ( x >= 0 && x < map.width && y >= 0 && y < map.height )
 											{
+												markUndoTile(drawlayer + y * MAPLAYERS + x * MAPLAYERS * map.height);
 												map.tiles[drawlayer + y * MAPLAYERS + x * MAPLAYERS * map.height] = selectedTile;
 											}
 										}
@@ -2366,6 +2722,7 @@ int main(int argc, char** argv)
 										z = copymap.name[0] + y * MAPLAYERS + x * MAPLAYERS * copymap.height;
 										if ( copymap.tiles[z] )
 										{
+											markUndoTile(drawlayer + (drawy + y)*MAPLAYERS + (drawx + x)*MAPLAYERS * map.height);
 											map.tiles[drawlayer + (drawy + y)*MAPLAYERS + (drawx + x)*MAPLAYERS * map.height] = copymap.tiles[z];
 										}
 									}
@@ -8721,6 +9078,7 @@ int main(int argc, char** argv)
 							for ( std::vector<Entity*>::iterator it = groupedEntities.begin(); it != groupedEntities.end(); ++it )
 							{
 								Entity* tmpEntity = *it;
+								markUndoEntity(tmpEntity);
 								tmpEntity->y += 16;
 							}
 							selectedarea_y2 += 1;
@@ -8740,6 +9098,7 @@ int main(int argc, char** argv)
 							for ( std::vector<Entity*>::iterator it = groupedEntities.begin(); it != groupedEntities.end(); ++it )
 							{
 								Entity* tmpEntity = *it;
+								markUndoEntity(tmpEntity);
 								tmpEntity->y -= 16;
 							}
 							selectedarea_y1 -= 1;
@@ -8759,6 +9118,7 @@ int main(int argc, char** argv)
 							for ( std::vector<Entity*>::iterator it = groupedEntities.begin(); it != groupedEntities.end(); ++it )
 							{
 								Entity* tmpEntity = *it;
+								markUndoEntity(tmpEntity);
 								tmpEntity->x -= 16;
 							}
 							selectedarea_x1 -= 1;
@@ -8778,6 +9138,7 @@ int main(int argc, char** argv)
 							for ( std::vector<Entity*>::iterator it = groupedEntities.begin(); it != groupedEntities.end(); ++it )
 							{
 								Entity* tmpEntity = *it;
+								markUndoEntity(tmpEntity);
 								tmpEntity->x += 16;
 							}
 							selectedarea_x2 += 1;
@@ -9023,6 +9384,7 @@ int main(int argc, char** argv)
 				if (palette[mousey + mousex * yres] >= 0)
 				{
 					entity = newEntity(palette[mousey + mousex * yres], 0, map.entities, nullptr);
+					markUndoEntityCreated(entity);
 					selectedEntity[0] = entity;
 					lastSelectedEntity[0] = selectedEntity[0];
 					setSpriteAttributes(selectedEntity[0], nullptr, nullptr);
@@ -9230,7 +9592,7 @@ int main(int argc, char** argv)
 	{
 		free(copymap.tiles);
 	}
-	list_FreeAll(&undolist);
+	clearUndos();
 	saveTilePalettes();
     for (int c = 0; c < sizeof(view_t::fb) / sizeof(view_t::fb[0]); ++c) {
         camera.fb[c].destroy();
@@ -128,7 +128,7 @@ extern int selectedarea_y1, selectedarea_y2;
 extern bool selectedarea;
 extern bool pasting;
 extern map_t copymap;
-extern list_t undolist;
+extern size_t undoMemoryBudget;
 
 // fps
 extern bool showfps;
@@ -144,6 +144,11 @@ void makeUndo();
 void clearUndos();
 void undo();
 void redo();
+void markUndoTile(size_t index); // before writing map.tiles[index]
+void markUndoAllTiles(); // before resizing or rewriting the whole map
+void markUndoEntity(Entity* entity); // before changing an entity
+void markUndoEntityCreated(Entity* entity); // after newEntity() in map.entities
+void markUndoEntityDeleted(Entity* entity); // before removing an entity from map.entities
 
 // function prototypes for buttons.c:
 void buttonExit(button_t* my);
@@ -188,6 +188,12 @@ int loadSoundResources(real_t base_load_percent, real_t top_load_percent)
 		updateLoadingScreen(base_load_percent + (top_load_percent * c) / numsounds);
 	}
 	FileIO::close(fp);
+	// decoding happens lazily, but warm up the cache in the background so
+	// the common (low index) sfx don't hitch the first time they play.
+	for ( Uint32 i = 0; i < c; ++i )
+	{
+		OPENAL_PrefetchSound(sounds[i]);
+	}
 	//FMOD_System_Set3DSettings(fmod_system, 1.0, 2.0, 1.0); // This on is hardcoded, I've been lazy here'
 #endif // defined USE_OPENAL
 
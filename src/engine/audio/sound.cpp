@@ -27,6 +27,7 @@
 #include <vorbis/vorbisfile.h>
 #include <vorbis/codec.h>
 #endif
+#include <deque>
 #endif
 
 #ifdef USE_FMOD
@@ -324,7 +325,17 @@ void sound_update(int player, int index, int numplayers)
 struct OPENAL_BUFFER {
 	ALuint id;
 	bool stream;
-	char oggfile[64];
+	char* oggfile;
+	bool b3D;
+	bool loaded;		// PCM is decoded and resident in the AL buffer
+	Uint32 size;		// bytes of PCM resident in the AL buffer
+	Uint32 lastused;	// LRU stamp from openal_soundcache_clock
+
+	// filled in by the prefetch thread, consumed by openal_bufferload()
+	char* pcm;
+	Uint32 pcm_size;
+	int pcm_channels;
+	int pcm_freq;
 };
 struct OPENAL_SOUND {
 	ALuint id;
@@ -564,6 +575,32 @@ int upper_unfreechannel = 0;
 SDL_Thread* openal_soundthread;
 bool OpenALSoundON = true;
 
+// sound effects are registered at startup but only decoded on first use (or by
+// the prefetch thread), and evicted least-recently-used once over budget.
+#ifndef EDITOR
+static ConsoleVariable<int> cvar_sound_cache_budget("/sound_cache_budget", 48, "decoded sound effect cache size (MB)");
+#endif
+
+static Uint32 openal_soundcache_budget()
+{
+#ifndef EDITOR
+	return (Uint32)std::max(0, *cvar_sound_cache_budget) * 1024 * 1024;
+#else
+	return 48 * 1024 * 1024;
+#endif
+}
+
+static Uint32 openal_soundcache_size = 0;	// bytes resident in AL buffers
+static Uint32 openal_soundcache_clock = 0;
+
+SDL_Thread* openal_prefetchthread = nullptr;
+SDL_mutex* openal_prefetchmutex = nullptr;
+SDL_cond* openal_prefetchcond = nullptr;
+static std::deque<OPENAL_BUFFER*> openal_prefetchqueue;
+static OPENAL_BUFFER* openal_prefetchcurrent = nullptr;
+static Uint32 openal_prefetchsize = 0;		// bytes decoded but not yet uploaded
+static bool openal_prefetchON = false;
+
 void OPENAL_RemoveChannelGroup(OPENAL_SOUND *channel, OPENAL_CHANNELGROUP *group);
 
 static void private_OPENAL_Channel_Stop(OPENAL_SOUND* channel) {
@@ -614,6 +651,50 @@ int OPENAL_ThreadFunction(void* data) {
 	return 1;
 }
 
+static bool openal_decodeogg(const char* name, bool b3D, char** pcm, Uint32* pcm_size, int* pcm_channels, int* pcm_freq);
+
+int OPENAL_PrefetchThreadFunction(void* data) {
+	(void)data;
+	SDL_LockMutex(openal_prefetchmutex);
+	while(openal_prefetchON) {
+		if(openal_prefetchqueue.empty()) {
+			SDL_CondWait(openal_prefetchcond, openal_prefetchmutex);
+			continue;
+		}
+		OPENAL_BUFFER* buffer = openal_prefetchqueue.front();
+		openal_prefetchqueue.pop_front();
+		if(buffer->loaded || buffer->pcm
+			|| openal_soundcache_size + openal_prefetchsize >= openal_soundcache_budget()) {
+			continue;
+		}
+		openal_prefetchcurrent = buffer;
+		SDL_UnlockMutex(openal_prefetchmutex);
+
+		char* pcm = nullptr;
+		Uint32 size = 0;
+		int channels = 0, freq = 0;
+		bool decoded = openal_decodeogg(buffer->oggfile, buffer->b3D, &pcm, &size, &channels, &freq);
+
+		SDL_LockMutex(openal_prefetchmutex);
+		openal_prefetchcurrent = nullptr;
+		if(decoded) {
+			if(buffer->loaded || buffer->pcm) {
+				// the main thread got there first.
+				free(pcm);
+			} else {
+				buffer->pcm = pcm;
+				buffer->pcm_size = size;
+				buffer->pcm_channels = channels;
+				buffer->pcm_freq = freq;
+				openal_prefetchsize += size;
+			}
+		}
+		SDL_CondBroadcast(openal_prefetchcond);
+	}
+	SDL_UnlockMutex(openal_prefetchmutex);
+	return 1;
+}
+
 int initOPENAL()
 {
 	static int initialized = 0;
@@ -658,6 +739,13 @@ int initOPENAL()
 	openal_mutex = SDL_CreateMutex();
 	openal_soundthread = SDL_CreateThread(OPENAL_ThreadFunction, "openal", NULL);
 
+	openal_soundcache_size = 0;
+	openal_prefetchsize = 0;
+	openal_prefetchON = true;
+	openal_prefetchmutex = SDL_CreateMutex();
+	openal_prefetchcond = SDL_CreateCond();
+	openal_prefetchthread = SDL_CreateThread(OPENAL_PrefetchThreadFunction, "openal_prefetch", NULL);
+
 	initialized = 1;
 
 #ifdef NINTENDO
@@ -690,6 +778,20 @@ int closeOPENAL()
 		openal_mutex = NULL;
 	}
 
+	if(openal_prefetchthread) {
+		SDL_LockMutex(openal_prefetchmutex);
+		openal_prefetchON = false;
+		openal_prefetchqueue.clear();
+		SDL_CondBroadcast(openal_prefetchcond);
+		SDL_UnlockMutex(openal_prefetchmutex);
+		SDL_WaitThread(openal_prefetchthread, NULL);
+		openal_prefetchthread = NULL;
+		SDL_DestroyCond(openal_prefetchcond);
+		openal_prefetchcond = NULL;
+		SDL_DestroyMutex(openal_prefetchmutex);
+		openal_prefetchmutex = NULL;
+	}
+
 	// stop all remaining sound
 	for (int i=0; i<upper_unfreechannel; i++) {
 		if(openal_sounds[i].active && !openal_sounds[i].buffer->stream) {
@@ -917,21 +1019,22 @@ static long int openal_file_oggtell(void* datasource) {
 	return file->tell();
 }
 
-int OPENAL_CreateSound(const char* name, bool b3D, OPENAL_BUFFER **buffer) {
-	*buffer = (OPENAL_BUFFER*)malloc(sizeof(OPENAL_BUFFER));
-	strncpy((*buffer)->oggfile, name, 64);	// for debugging purpose
-	(*buffer)->stream = false;
+static bool openal_decodeogg(const char* name, bool b3D, char** pcm, Uint32* pcm_size, int* pcm_channels, int* pcm_freq) {
 	File *f = openDataFile(name, "rb");
 	if(!f) {
 		printlog("Error loading sound %s\n", name);
-		return 0;
+		return false;
 	}
 
 	ov_callbacks oggcb = { openal_file_oggread, openal_file_oggseek, openal_file_oggclose, openal_file_oggtell };
 
 	vorbis_info * pInfo;
 	OggVorbis_File oggFile;
-	ov_open_callbacks(f, &oggFile, NULL, 0, oggcb);
+	if(ov_open_callbacks(f, &oggFile, NULL, 0, oggcb)) {
+		printlog("Error decoding sound %s\n", name);
+		FileIO::close(f);
+		return false;
+	}
 	pInfo = ov_info(&oggFile, -1);
 
 	int channels = pInfo->channels;
@@ -953,12 +1056,11 @@ int OPENAL_CreateSound(const char* name, bool b3D, OPENAL_BUFFER **buffer) {
 		ptr+=bytes;
 		sz+=bytes;
 	} while(bytes>0);
-	char *data2 = data;
 	if(b3D && channels==2) {
 		// downmixing sound to mono, because 3D sounds NEEDS mono sound
-		data2 = (char*)malloc(sz/2);
+		// (done in place, the mono samples never overtake the stereo ones)
 		int16_t *p1, *p2;
-		p1 = (int16_t*)data2;
+		p1 = (int16_t*)data;
 		p2 = (int16_t*)data;
 		sz/=2;
 		for(int i=0; i<sz/2; i++) {
@@ -969,19 +1071,107 @@ int OPENAL_CreateSound(const char* name, bool b3D, OPENAL_BUFFER **buffer) {
 	}
 
 	ov_clear(&oggFile);
-	alGenBuffers(1, &(*buffer)->id);
-	alBufferData((*buffer)->id, (channels==1)?AL_FORMAT_MONO16:AL_FORMAT_STEREO16, data2, sz, freq);
-	if(data2!=data)
-		free(data2);
-	free(data);
 	FileIO::close(f);
+
+	*pcm = data;
+	*pcm_size = sz;
+	*pcm_channels = channels;
+	*pcm_freq = freq;
+	return true;
+}
+
+static void openal_soundcache_evict() {
+	// caller holds openal_mutex, so no channel can pick up a buffer we drop here.
+	const Uint32 budget = openal_soundcache_budget();
+	while(openal_soundcache_size > budget) {
+		OPENAL_BUFFER* oldest = nullptr;
+		for(Uint32 c = 0; c < numsounds; ++c) {
+			OPENAL_BUFFER* buffer = sounds[c];
+			if(!buffer || buffer->stream || !buffer->loaded) {
+				continue;
+			}
+			if(oldest && oldest->lastused <= buffer->lastused) {
+				continue;
+			}
+			bool playing = false;
+			for(int i = 0; i < upper_unfreechannel; ++i) {
+				if(openal_sounds[i].active && openal_sounds[i].buffer == buffer) {
+					playing = true;
+					break;
+				}
+			}
+			if(!playing) {
+				oldest = buffer;
+			}
+		}
+		if(!oldest) {
+			return; // everything resident is playing right now
+		}
+		alDeleteBuffers(1, &oldest->id);
+		oldest->loaded = false;
+		openal_soundcache_size -= oldest->size;
+		oldest->size = 0;
+	}
+}
+
+static bool openal_bufferload(OPENAL_BUFFER* buffer) {
+	buffer->lastused = ++openal_soundcache_clock;
+	if(buffer->loaded) {
+		return true;
+	}
+
+	char* pcm = nullptr;
+	Uint32 size = 0;
+	int channels = 0, freq = 0;
+
+	SDL_LockMutex(openal_prefetchmutex);
+	if(buffer->pcm) {
+		pcm = buffer->pcm;
+		size = buffer->pcm_size;
+		channels = buffer->pcm_channels;
+		freq = buffer->pcm_freq;
+		buffer->pcm = nullptr;
+		openal_prefetchsize -= size;
+	}
+	SDL_UnlockMutex(openal_prefetchmutex);
+
+	if(!pcm && !openal_decodeogg(buffer->oggfile, buffer->b3D, &pcm, &size, &channels, &freq)) {
+		return false;
+	}
+
+	alGenBuffers(1, &buffer->id);
+	alBufferData(buffer->id, (channels==1)?AL_FORMAT_MONO16:AL_FORMAT_STEREO16, pcm, size, freq);
+	free(pcm);
+
+	buffer->loaded = true;
+	buffer->size = size;
+	openal_soundcache_size += size;
+	openal_soundcache_evict();
+	return true;
+}
+
+int OPENAL_CreateSound(const char* name, bool b3D, OPENAL_BUFFER **buffer) {
+	*buffer = (OPENAL_BUFFER*)calloc(1, sizeof(OPENAL_BUFFER));
+	(*buffer)->oggfile = strdup(name);
+	(*buffer)->stream = false;
+	(*buffer)->b3D = b3D;
 	return 1;
 }
 
+void OPENAL_PrefetchSound(OPENAL_BUFFER* buffer) {
+	if(!buffer || buffer->stream || buffer->loaded || !openal_prefetchmutex) {
+		return;
+	}
+	SDL_LockMutex(openal_prefetchmutex);
+	openal_prefetchqueue.push_back(buffer);
+	SDL_CondSignal(openal_prefetchcond);
+	SDL_UnlockMutex(openal_prefetchmutex);
+}
+
 int OPENAL_CreateStreamSound(const char* name, OPENAL_BUFFER **buffer) {
-	*buffer = (OPENAL_BUFFER*)malloc(sizeof(OPENAL_BUFFER));
+	*buffer = (OPENAL_BUFFER*)calloc(1, sizeof(OPENAL_BUFFER));
 	(*buffer)->stream = true;
-	strcpy((*buffer)->oggfile, name);
+	(*buffer)->oggfile = strdup(name);
 	return 1;
 }
 
@@ -1008,7 +1198,7 @@ OPENAL_SOUND* OPENAL_CreateChannel(OPENAL_BUFFER* buffer) {
 
 	if(buffer->stream) {
 		openal_oggopen(channel, buffer->oggfile);
-	} else
+	} else if(openal_bufferload(buffer))
 		alSourcei(channel->id, AL_BUFFER, buffer->id);
 	// default to 2D...
 	alSourcei(channel->id,AL_SOURCE_RELATIVE, AL_TRUE);
@@ -1101,13 +1291,39 @@ void OPENAL_Channel_GetPosition(OPENAL_SOUND* channel, unsigned int *position) {
 
 void OPENAL_Sound_GetLength(OPENAL_BUFFER* buffer, unsigned int *length) {
 	if(!buffer) return;
+	if(!buffer->stream && !buffer->loaded) {
+		SDL_LockMutex(openal_mutex);
+		openal_bufferload(buffer);
+		SDL_UnlockMutex(openal_mutex);
+	}
 	alGetBufferi(buffer->id, AL_SIZE, (GLint*)length);
 }
 
 void OPENAL_Sound_Release(OPENAL_BUFFER* buffer) {
 	if(!buffer) return;
-	if(!buffer->stream)
+	if(openal_prefetchmutex) {
+		// make sure the prefetch thread is done with this buffer
+		SDL_LockMutex(openal_prefetchmutex);
+		openal_prefetchqueue.erase(
+			std::remove(openal_prefetchqueue.begin(), openal_prefetchqueue.end(), buffer),
+			openal_prefetchqueue.end());
+		while(openal_prefetchcurrent == buffer)
+			SDL_CondWait(openal_prefetchcond, openal_prefetchmutex);
+		if(buffer->pcm) {
+			openal_prefetchsize -= buffer->pcm_size;
+			free(buffer->pcm);
+		}
+		SDL_UnlockMutex(openal_prefetchmutex);
+	} else if(buffer->pcm) {
+		// prefetch thread is already gone (closeOPENAL), nothing to sync with
+		openal_prefetchsize -= buffer->pcm_size;
+		free(buffer->pcm);
+	}
+	if(!buffer->stream && buffer->loaded) {
 		alDeleteBuffers( 1, &buffer->id );
+		openal_soundcache_size -= buffer->size;
+	}
+	free(buffer->oggfile);
 	free(buffer);
 }
 
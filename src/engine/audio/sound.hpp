@@ -36,6 +36,8 @@ void freeSoundResources();
 void setGlobalVolume(real_t master, real_t music, real_t gameplay, real_t ambient, real_t environment, real_t notification);
 void setAudioDevice(const std::string& device);
 bool loadMusic();
+void serverQueueSoundPos(real_t x, real_t y, Uint16 snd, Uint8 vol); // queue a positional sound for all clients
+void serverFlushSoundEvents(); // send this tick's queued sounds, one packet per client
 
 //Pointer to the FMOD system.
 #ifdef USE_FMOD
@@ -202,7 +204,8 @@ void playmusic(OPENAL_BUFFER* sound, bool loop, bool crossfade, bool resume); //
 
 void handleLevelMusic(); //Manages and updates the level music.
 
-int OPENAL_CreateSound(const char* name, bool b3D, OPENAL_BUFFER **buffer);
+int OPENAL_CreateSound(const char* name, bool b3D, OPENAL_BUFFER **buffer); // registers the sound, it's decoded on first use
+void OPENAL_PrefetchSound(OPENAL_BUFFER* buffer); // queue a sound to be decoded in the background
 int OPENAL_CreateStreamSound(const char* name, OPENAL_BUFFER **buffer);
 
 void OPENAL_ChannelGroup_Stop(OPENAL_CHANNELGROUP* group);
@@ -20,6 +20,93 @@
 #include "../../player.hpp"
 #include "../../ui/GameUI.hpp"
 
+/*-------------------------------------------------------------------------------
+
+	serverQueueSoundPos / serverFlushSoundEvents
+
+	positional sounds played by the server are queued per client and sent
+	once per tick in a single SNDB packet instead of one safe packet each.
+	the same sound on the same tile is only sent once (at the loudest
+	volume). these are cosmetic, so they go out unreliably - player
+	directed sounds (SNDG) are still sent as safe packets.
+
+-------------------------------------------------------------------------------*/
+
+struct SoundEvent_t
+{
+	Uint16 x;
+	Uint16 y;
+	Uint16 snd;
+	Uint8 vol;
+};
+static std::vector<SoundEvent_t> serverSoundEvents[MAXPLAYERS];
+
+void serverQueueSoundPos(real_t x, real_t y, Uint16 snd, Uint8 vol)
+{
+	const Uint16 sx = (Uint16)std::min(std::max((real_t)0.0, x), (real_t)0xFFFF);
+	const Uint16 sy = (Uint16)std::min(std::max((real_t)0.0, y), (real_t)0xFFFF);
+	for ( int c = 1; c < MAXPLAYERS; ++c )
+	{
+		if ( client_disconnected[c] == true || players[c]->isLocalPlayer() )
+		{
+			continue;
+		}
+		bool coalesced = false;
+		for ( auto& event : serverSoundEvents[c] )
+		{
+			if ( event.snd == snd && (event.x >> 4) == (sx >> 4) && (event.y >> 4) == (sy >> 4) )
+			{
+				event.vol = std::max(event.vol, vol);
+				coalesced = true;
+				break;
+			}
+		}
+		if ( !coalesced )
+		{
+			serverSoundEvents[c].push_back(SoundEvent_t{ sx, sy, snd, vol });
+		}
+	}
+}
+
+void serverFlushSoundEvents()
+{
+	constexpr int headerLen = 5;
+	constexpr int eventLen = 7;
+	constexpr int maxEvents = (NET_PACKET_SIZE - headerLen) / eventLen;
+	for ( int c = 1; c < MAXPLAYERS; ++c )
+	{
+		auto& events = serverSoundEvents[c];
+		if ( events.empty() )
+		{
+			continue;
+		}
+		if ( multiplayer != SERVER || client_disconnected[c] == true || players[c]->isLocalPlayer() )
+		{
+			events.clear();
+			continue;
+		}
+		for ( size_t i = 0; i < events.size(); )
+		{
+			const int num = std::min((int)(events.size() - i), maxEvents);
+			memcpy(net_packet->data, "SNDB", 4);
+			net_packet->data[4] = (Uint8)num;
+			Uint8* data = &net_packet->data[headerLen];
+			for ( int j = 0; j < num; ++j, ++i, data += eventLen )
+			{
+				SDLNet_Write16(events[i].x, &data[0]);
+				SDLNet_Write16(events[i].y, &data[2]);
+				SDLNet_Write16(events[i].snd, &data[4]);
+				data[6] = events[i].vol;
+			}
+			net_packet->address.host = net_clients[c - 1].host;
+			net_packet->address.port = net_clients[c - 1].port;
+			net_packet->len = headerLen + num * eventLen;
+			sendPacket(net_sock, -1, net_packet, c - 1);
+		}
+		events.clear();
+	}
+}
+
 /*-------------------------------------------------------------------------------
 
 	playSoundPlayer
@@ -132,22 +219,7 @@ FMOD::Channel* playSoundPos(real_t x, real_t y, Uint16 snd, Uint8 vol)
 
 	if (multiplayer == SERVER)
 	{
-		for (int c = 1; c < MAXPLAYERS; c++)
-		{
-			if ( client_disconnected[c] == true || players[c]->isLocalPlayer() )
-			{
-				continue;
-			}
-			memcpy(net_packet->data, "SNDP", 4);
-			SDLNet_Write32(x, &net_packet->data[4]);
-			SDLNet_Write32(y, &net_packet->data[8]);
-			SDLNet_Write16(snd, &net_packet->data[12]);
-			net_packet->data[14] = vol;
-			net_packet->address.host = net_clients[c - 1].host;
-			net_packet->address.port = net_clients[c - 1].port;
-			net_packet->len = 15;
-			sendPacketSafe(net_sock, -1, net_packet, c - 1);
-		}
+		serverQueueSoundPos(x, y, snd, vol);
 	}
 
 	return result;
@@ -417,7 +489,6 @@ OPENAL_SOUND* playSoundPos(real_t x, real_t y, Uint16 snd, Uint8 vol)
 #endif
 
 	OPENAL_SOUND* channel;
-	int c;
 
 	if (intro)
 	{
@@ -434,22 +505,7 @@ OPENAL_SOUND* playSoundPos(real_t x, real_t y, Uint16 snd, Uint8 vol)
 
 	if (multiplayer == SERVER)
 	{
-		for (c = 1; c < MAXPLAYERS; c++)
-		{
-			if ( client_disconnected[c] == true || players[c]->isLocalPlayer() )
-			{
-				continue;
-			}
-			memcpy(net_packet->data, "SNDP", 4);
-			SDLNet_Write32(x, &net_packet->data[4]);
-			SDLNet_Write32(y, &net_packet->data[8]);
-			SDLNet_Write16(snd, &net_packet->data[12]);
-			net_packet->data[14] = vol;
-			net_packet->address.host = net_clients[c - 1].host;
-			net_packet->address.port = net_clients[c - 1].port;
-			net_packet->len = 15;
-			sendPacketSafe(net_sock, -1, net_packet, c - 1);
-		}
+		serverQueueSoundPos(x, y, snd, vol);
 	}
 
 	if (!openal_context)   //For the client.
@@ -1045,8 +1101,6 @@ void* playSound(Uint16 snd, Uint8 vol)
 
 void* playSoundPos(real_t x, real_t y, Uint16 snd, Uint8 vol)
 {
-	int c;
-
 	if (intro || vol == 0)
 	{
 		return nullptr;
@@ -1054,22 +1108,7 @@ void* playSoundPos(real_t x, real_t y, Uint16 snd, Uint8 vol)
 
 	if (multiplayer == SERVER)
 	{
-		for (c = 1; c < MAXPLAYERS; c++)
-		{
-			if ( client_disconnected[c] == true || players[c]->isLocalPlayer() )
-			{
-				continue;
-			}
-			memcpy(net_packet->data, "SNDP", 4);
-			SDLNet_Write32(x, &net_packet->data[4]);
-			SDLNet_Write32(y, &net_packet->data[8]);
-			SDLNet_Write16(snd, &net_packet->data[12]);
-			net_packet->data[14] = vol;
-			net_packet->address.host = net_clients[c - 1].host;
-			net_packet->address.port = net_clients[c - 1].port;
-			net_packet->len = 15;
-			sendPacketSafe(net_sock, -1, net_packet, c - 1);
-		}
+		serverQueueSoundPos(x, y, snd, vol);
 	}
 
 	return NULL;
@@ -15,6 +15,7 @@
 #include <assert.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include <vector>
 
 //Don't create a FileBase or derivative class (such as this one) directly, use FileIO::open to get one...
@@ -40,10 +41,9 @@ public:
 		}
 		size_t readSize = 0U;
 		size_t end = std::min(this->size(), pos + size * count);
-		uint8_t* buf = (uint8_t*)buffer;
-		for (size_t c = pos; c < end; ++c) {
-			*buf = data[c]; ++buf;
-			++readSize;
+		if (end > pos) {
+			readSize = end - pos;
+			memcpy(buffer, data.data() + pos, readSize);
 		}
 		pos += readSize;
 		return readSize / size;
@@ -91,13 +91,13 @@ private:
 		    data.resize(end);
 		    size_t c = 0;
 		    for (; c < end;) {
-		        size_t result = fread(data.data(), sizeof(uint8_t), end - c, fp);
+		        size_t result = fread(data.data() + c, sizeof(uint8_t), end - c, fp);
 		        if (!result) {
 		            // failed to read, try to read just a chunk
 		            constexpr size_t chunk_size = 1024;
 		            size_t chunk = std::min(end - c, chunk_size);
 		            printlog("[FILES] failed to read %llu bytes from '%s', trying %llu bytes instead", end - c, path, chunk);
-		            result = fread(data.data(), sizeof(uint8_t), chunk, fp);
+		            result = fread(data.data() + c, sizeof(uint8_t), chunk, fp);
 		            assert(result);
 		        }
 		        c += result;
@@ -117,13 +117,13 @@ private:
 	        size_t c = 0u;
 	        size_t end = size();
 		    for (; c < end;) {
-		        size_t result = fwrite(data.data(), sizeof(uint8_t), end - c, fp);
+		        size_t result = fwrite(data.data() + c, sizeof(uint8_t), end - c, fp);
 		        if (!result) {
 		            // failed to write, try to write just a chunk
 		            constexpr size_t chunk_size = 1024;
 		            size_t chunk = std::min(end - c, chunk_size);
 		            printlog("[FILES] failed to write %llu bytes to '%s', trying %llu bytes instead", end - c, path.c_str(), chunk);
-		            result = fwrite(data.data(), sizeof(uint8_t), chunk, fp);
+		            result = fwrite(data.data() + c, sizeof(uint8_t), chunk, fp);
 		            assert(result);
 		        }
 		        c += result;
@@ -475,6 +475,11 @@ Entity::Entity(Sint32 in_sprite, Uint32 pos, list_t* entlist, list_t* creatureli
 			uid = -2;
 		}
 	}
+	else if ( stagedMapGen && entlist == stagedMapGen->map->entities )
+	{
+		// numbered from 0 while staged, offset when the level is swapped in
+		uid = stagedMapGen->uids++;
+	}
 	else
 	{
 		uid = -2;
@@ -530,6 +535,12 @@ Entity::~Entity()
 	}
 	}*/
 
+	// drop me from the cached list of interpolated entities
+	if ( !stagedMapGen )
+	{
+		TimerExperiments::removeFromInterpolatedLists(this);
+	}
+
 	//Remove me from the
 	if ( myCreatureListNode )
 	{
@@ -546,6 +557,10 @@ Entity::~Entity()
 		list_RemoveNode(myTileListNode);
 		myTileListNode = nullptr;
 	}
+	if ( !stagedMapGen )
+	{
+		CircuitNetlist.removeEntity(*this);
+	}
 
 	// alert clients of the entity's deletion
 	if ( multiplayer == SERVER && !loading )
@@ -602,9 +617,13 @@ Entity::~Entity()
 	// destroy my children
 	list_FreeAll(&this->children);
 
-	node = list_AddNodeLast(&entitiesdeleted);
-	node->element = this;
-	node->deconstructor = &emptyDeconstructor;
+	if ( !stagedMapGen )
+	{
+		// the staging thread mustn't touch the main thread's lists
+		node = list_AddNodeLast(&entitiesdeleted);
+		node->element = this;
+		node->deconstructor = &emptyDeconstructor;
+	}
 
 	if ( clientStats )
 	{
@@ -10240,6 +10259,7 @@ void Entity::attack(int pose, int charge, Entity* target)
 								}
 
 								map.tiles[OBSTACLELAYER + hit.mapy * MAPLAYERS + hit.mapx * MAPLAYERS * map.height] = 0;
+								notifyTileChanged(hit.mapx, hit.mapy);
 								// send wall destroy info to clients
 								if ( multiplayer == SERVER )
 								{
@@ -11468,6 +11488,371 @@ void Entity::awardXP(Entity* src, bool share, bool root)
 
 /*-------------------------------------------------------------------------------
 
+playerRaceRelation
+
+A player who isn't human counts as their race when checkEnemy/checkFriend
+fall back to the allegiance tables. That outcome depends only on the
+player's race and the monster's type, so it is tabulated once instead of
+being re-derived through a switch on every call.
+
+-------------------------------------------------------------------------------*/
+
+enum PlayerRaceRelationFlags : Uint8
+{
+	PLAYER_RACE_ENEMY_OF_MONSTER = 1 << 0,  // checkEnemy, player asking
+	MONSTER_ENEMY_OF_PLAYER_RACE = 1 << 1,  // checkEnemy, monster asking
+	PLAYER_RACE_FRIEND_OF_MONSTER = 1 << 2, // checkFriend, player asking
+	MONSTER_FRIEND_OF_PLAYER_RACE = 1 << 3  // checkFriend, monster asking
+};
+
+// races that get along with these monsters despite the allegiance tables
+static bool playerRaceKin(int race, int other)
+{
+	switch ( race )
+	{
+		case SKELETON:
+			return other == GHOUL;
+		case RAT:
+			return other == RAT;
+		case SPIDER:
+			return other == SPIDER || other == SCARAB || other == SCORPION;
+		case TROLL:
+			return other == TROLL;
+		case CREATURE_IMP:
+			return other == CREATURE_IMP;
+		case GOBLIN:
+			return other == GOBLIN;
+		case GOATMAN:
+			return other == GOATMAN;
+		case INCUBUS:
+		case SUCCUBUS:
+			return other == SUCCUBUS || other == INCUBUS;
+		case INSECTOID:
+			return other == SCARAB || other == INSECTOID || other == SCORPION;
+		case VAMPIRE:
+			return other == VAMPIRE;
+		default:
+			return false;
+	}
+}
+
+static Uint8 playerRaceRelation(int race, int other)
+{
+	static Uint8 table[NUMMONSTERS][NUMMONSTERS];
+	static bool built = false;
+	if ( !built )
+	{
+		for ( int r = 0; r < NUMMONSTERS; ++r )
+		{
+			for ( int o = 0; o < NUMMONSTERS; ++o )
+			{
+				const bool humanoid = (o == HUMAN || o == SHOPKEEPER) && r != AUTOMATON;
+				bool playerEnemy = swornenemies[HUMAN][o];
+				bool monsterEnemy = swornenemies[o][HUMAN];
+				bool playerFriend = monsterally[HUMAN][o];
+				bool monsterFriend = monsterally[o][HUMAN];
+				if ( humanoid )
+				{
+					playerEnemy = monsterEnemy = true;
+					playerFriend = monsterFriend = false;
+				}
+				else
+				{
+					playerFriend = false; // only the listed exceptions befriend a player
+					if ( r == AUTOMATON )
+					{
+						if ( o == INCUBUS || o == SUCCUBUS )
+						{
+							playerEnemy = monsterEnemy = false;
+						}
+						if ( o == SHOPKEEPER )
+						{
+							playerFriend = monsterFriend = monsterally[SHOPKEEPER][AUTOMATON];
+						}
+						else if ( o == HUMAN )
+						{
+							playerFriend = monsterFriend = true;
+						}
+					}
+					else if ( playerRaceKin(r, o) )
+					{
+						playerEnemy = monsterEnemy = false;
+						playerFriend = monsterFriend = true;
+					}
+				}
+				table[r][o] = (playerEnemy ? PLAYER_RACE_ENEMY_OF_MONSTER : 0)
+					| (monsterEnemy ? MONSTER_ENEMY_OF_PLAYER_RACE : 0)
+					| (playerFriend ? PLAYER_RACE_FRIEND_OF_MONSTER : 0)
+					| (monsterFriend ? MONSTER_FRIEND_OF_PLAYER_RACE : 0);
+			}
+		}
+		built = true;
+	}
+	return table[race][other];
+}
+
+/*-------------------------------------------------------------------------------
+
+/test_allegiance
+
+Checks playerRaceRelation() against the switch ladders it replaced for
+every pair of monster types, and the allegiance tags against the name
+comparisons they replaced, both for generated names and for every creature
+on the current level (a stale tag there means a name was assigned without
+updateAllegianceTags()).
+
+-------------------------------------------------------------------------------*/
+
+// the switch that used to follow the humanoid check in checkEnemy.
+// kin of the player race stop being enemies
+static bool playerRaceEnemyReference(int race, int other, bool result)
+{
+	switch ( race )
+	{
+		case SKELETON:
+			if ( other == GHOUL ) { result = false; }
+			break;
+		case RAT:
+			if ( other == RAT ) { result = false; }
+			break;
+		case SPIDER:
+			if ( other == SPIDER || other == SCARAB || other == SCORPION ) { result = false; }
+			break;
+		case TROLL:
+			if ( other == TROLL ) { result = false; }
+			break;
+		case CREATURE_IMP:
+			if ( other == CREATURE_IMP ) { result = false; }
+			break;
+		case GOBLIN:
+			if ( other == GOBLIN ) { result = false; }
+			break;
+		case GOATMAN:
+			if ( other == GOATMAN ) { result = false; }
+			break;
+		case INCUBUS:
+		case SUCCUBUS:
+			if ( other == SUCCUBUS || other == INCUBUS ) { result = false; }
+			break;
+		case INSECTOID:
+			if ( other == SCARAB || other == INSECTOID || other == SCORPION ) { result = false; }
+			break;
+		case VAMPIRE:
+			if ( other == VAMPIRE ) { result = false; }
+			break;
+		case AUTOMATON:
+			if ( other == INCUBUS || other == SUCCUBUS ) { result = false; }
+			break;
+		default:
+			break;
+	}
+	return result;
+}
+
+// the switch that used to follow the humanoid check in checkFriend
+static bool playerRaceFriendReference(int race, int other, bool result)
+{
+	switch ( race )
+	{
+		case SKELETON:
+			if ( other == GHOUL ) { result = true; }
+			break;
+		case RAT:
+			if ( other == RAT ) { result = true; }
+			break;
+		case SPIDER:
+			if ( other == SPIDER || other == SCARAB || other == SCORPION ) { result = true; }
+			break;
+		case TROLL:
+			if ( other == TROLL ) { result = true; }
+			break;
+		case CREATURE_IMP:
+			if ( other == CREATURE_IMP ) { result = true; }
+			break;
+		case GOBLIN:
+			if ( other == GOBLIN ) { result = true; }
+			break;
+		case GOATMAN:
+			if ( other == GOATMAN ) { result = true; }
+			break;
+		case INCUBUS:
+		case SUCCUBUS:
+			if ( other == SUCCUBUS || other == INCUBUS ) { result = true; }
+			break;
+		case INSECTOID:
+			if ( other == SCARAB || other == INSECTOID || other == SCORPION ) { result = true; }
+			break;
+		case VAMPIRE:
+			if ( other == VAMPIRE ) { result = true; }
+			break;
+		case AUTOMATON:
+			if ( other == SHOPKEEPER )
+			{
+				result = monsterally[SHOPKEEPER][AUTOMATON];
+			}
+			else if ( other == HUMAN )
+			{
+				result = true;
+			}
+			break;
+		default:
+			break;
+	}
+	return result;
+}
+
+static int testPlayerRaceRelations()
+{
+	int mismatches = 0;
+	for ( int race = 0; race < NUMMONSTERS; ++race )
+	{
+		for ( int other = 0; other < NUMMONSTERS; ++other )
+		{
+			const bool humanoid = (other == HUMAN || other == SHOPKEEPER) && race != AUTOMATON;
+			const Uint8 relation = playerRaceRelation(race, other);
+
+			// checkEnemy, player of this race asking about a monster
+			bool expected = humanoid ? true : playerRaceEnemyReference(race, other, swornenemies[HUMAN][other]);
+			bool actual = relation & PLAYER_RACE_ENEMY_OF_MONSTER;
+			if ( expected != actual )
+			{
+				printlog("[allegiance] checkEnemy player %d vs monster %d: expected %d, got %d", race, other, expected, actual);
+				++mismatches;
+			}
+
+			// checkEnemy, monster asking about a player of this race
+			expected = humanoid ? true : playerRaceEnemyReference(race, other, swornenemies[other][HUMAN]);
+			actual = relation & MONSTER_ENEMY_OF_PLAYER_RACE;
+			if ( expected != actual )
+			{
+				printlog("[allegiance] checkEnemy monster %d vs player %d: expected %d, got %d", other, race, expected, actual);
+				++mismatches;
+			}
+
+			// checkFriend, player asking. the ladder reset the table value first
+			expected = humanoid ? false : playerRaceFriendReference(race, other, false);
+			actual = relation & PLAYER_RACE_FRIEND_OF_MONSTER;
+			if ( expected != actual )
+			{
+				printlog("[allegiance] checkFriend player %d vs monster %d: expected %d, got %d", race, other, expected, actual);
+				++mismatches;
+			}
+
+			// checkFriend, monster asking. keeps the table value
+			expected = humanoid ? false : playerRaceFriendReference(race, other, monsterally[other][HUMAN]);
+			actual = relation & MONSTER_FRIEND_OF_PLAYER_RACE;
+			if ( expected != actual )
+			{
+				printlog("[allegiance] checkFriend monster %d vs player %d: expected %d, got %d", other, race, expected, actual);
+				++mismatches;
+			}
+		}
+	}
+	return mismatches;
+}
+
+// the tags as checkEnemy/checkFriend read them, each only counts for its type
+static Uint8 allegianceTagsForType(const Stat& stat)
+{
+	const Uint8 tags = stat.getAllegianceTags();
+	Uint8 result = 0;
+	if ( stat.type == AUTOMATON )
+	{
+		result |= tags & Stat::ALLEGIANCE_TAG_CORRUPTED_AUTOMATON;
+	}
+	if ( stat.type == INCUBUS )
+	{
+		result |= tags & Stat::ALLEGIANCE_TAG_INNER_DEMON;
+	}
+	if ( stat.type == VAMPIRE )
+	{
+		result |= tags & Stat::ALLEGIANCE_TAG_BRAM_KINDLY;
+	}
+	return result;
+}
+
+static int testAllegianceTags()
+{
+	std::vector<std::string> names = {
+		"", "corrupted automaton", "corrupted automaton 2", "corrupted", "Corrupted Automaton",
+		"inner demon", "inner demons", "inner", "bram kindly", "Bram Kindly", "skeleton knight"
+	};
+	for ( auto& entry : MonsterData_t::monsterDataEntries )
+	{
+		for ( auto& npc : entry.second.specialNPCs )
+		{
+			names.push_back(npc.second.name);
+		}
+	}
+
+	int mismatches = 0;
+	Stat stat(0);
+	for ( int type = 0; type < NUMMONSTERS; ++type )
+	{
+		// walk the names in both directions so every name follows every other
+		for ( int pass = 0; pass < 2; ++pass )
+		{
+			for ( size_t c = 0; c < names.size(); ++c )
+			{
+				const std::string& name = names[pass ? names.size() - 1 - c : c];
+				stat.type = static_cast<Monster>(type);
+				stringCopy(stat.name, name.c_str(), sizeof(stat.name), name.size());
+
+				Uint8 expected = 0;
+				if ( type == AUTOMATON && !strncmp(stat.name, "corrupted automaton", 19) )
+				{
+					expected |= Stat::ALLEGIANCE_TAG_CORRUPTED_AUTOMATON;
+				}
+				if ( type == INCUBUS && !strncmp(stat.name, "inner demon", strlen("inner demon")) )
+				{
+					expected |= Stat::ALLEGIANCE_TAG_INNER_DEMON;
+				}
+				if ( type == VAMPIRE && MonsterData_t::nameMatchesSpecialNPCName(stat, "bram kindly") )
+				{
+					expected |= Stat::ALLEGIANCE_TAG_BRAM_KINDLY;
+				}
+				stat.updateAllegianceTags();
+				if ( expected != allegianceTagsForType(stat) )
+				{
+					printlog("[allegiance] tags for type %d name '%s': expected %d, got %d", type, stat.name, expected, allegianceTagsForType(stat));
+					++mismatches;
+				}
+			}
+		}
+	}
+
+	for ( node_t* node = map.entities ? map.entities->first : nullptr; node != nullptr; node = node->next )
+	{
+		Entity* entity = (Entity*)node->element;
+		Stat* entityStats = entity ? entity->getStats() : nullptr;
+		if ( !entityStats )
+		{
+			continue;
+		}
+		const Uint8 stored = entityStats->allegianceTags;
+		entityStats->updateAllegianceTags();
+		if ( stored != entityStats->allegianceTags )
+		{
+			printlog("[allegiance] stale tags on uid %d type %d name '%s': stored %d, expected %d",
+				entity->getUID(), (int)entityStats->type, entityStats->name, stored, entityStats->allegianceTags);
+			++mismatches;
+		}
+	}
+	return mismatches;
+}
+
+static ConsoleCommand ccmd_test_allegiance("/test_allegiance", "compare cached allegiance lookups against the original comparisons",
+	[](int argc, const char* argv[]){
+	const int relationMismatches = testPlayerRaceRelations();
+	const int tagMismatches = testAllegianceTags();
+	printlog("[allegiance] %d race pairs checked, %d relation mismatches, %d tag mismatches",
+		NUMMONSTERS * NUMMONSTERS, relationMismatches, tagMismatches);
+	messagePlayer(clientnum, MESSAGE_MISC, "Allegiance test: %d relation mismatches, %d tag mismatches",
+		relationMismatches, tagMismatches);
+	});
+
+/*-------------------------------------------------------------------------------
+
 Entity::checkEnemy
 
 Returns true if my and your are enemies, otherwise returns false
@@ -11534,16 +11919,16 @@ bool Entity::checkEnemy(Entity* your)
 		return false;
 	}
 
-	if ( myStats->type == HUMAN && (yourStats->type == AUTOMATON && !strncmp(yourStats->name, "corrupted automaton", 19)) )
+	if ( myStats->type == HUMAN && (yourStats->type == AUTOMATON && (yourStats->getAllegianceTags() & Stat::ALLEGIANCE_TAG_CORRUPTED_AUTOMATON)) )
 	{
 		return true;
 	}
-	else if ( (yourStats->type == HUMAN || your->behavior == &actPlayer) && (myStats->type == AUTOMATON && !strncmp(myStats->name, "corrupted automaton", 19)) )
+	else if ( (yourStats->type == HUMAN || your->behavior == &actPlayer) && (myStats->type == AUTOMATON && (myStats->getAllegianceTags() & Stat::ALLEGIANCE_TAG_CORRUPTED_AUTOMATON)) )
 	{
 		return true;
 	}
 	else if ( your->behavior == &actPlayer && myStats->type == CREATURE_IMP 
-		&& (!strncmp(map.name, "Boss", 4) || !strncmp(map.name, "Hell Boss", 9)) )
+		&& map.bossLevel )
 	{
 		if ( this->monsterAllyGetPlayerLeader() )
 		{
@@ -11552,7 +11937,7 @@ bool Entity::checkEnemy(Entity* your)
 		return true;
 	}
 	else if ( behavior == &actPlayer && yourStats->type == CREATURE_IMP 
-		&& (!strncmp(map.name, "Boss", 4) || !strncmp(map.name, "Hell Boss", 9)) )
+		&& map.bossLevel )
 	{
 		if ( your->monsterAllyGetPlayerLeader() )
 		{
@@ -11560,15 +11945,15 @@ bool Entity::checkEnemy(Entity* your)
 		}
 		return true;
 	}
-	else if ( your->behavior == &actPlayer && myStats->type == VAMPIRE && MonsterData_t::nameMatchesSpecialNPCName(*myStats, "bram kindly") )
+	else if ( your->behavior == &actPlayer && myStats->type == VAMPIRE && (myStats->getAllegianceTags() & Stat::ALLEGIANCE_TAG_BRAM_KINDLY) )
 	{
 		return true;
 	}
-	else if ( behavior == &actPlayer && yourStats->type == VAMPIRE && MonsterData_t::nameMatchesSpecialNPCName(*yourStats, "bram kindly") )
+	else if ( behavior == &actPlayer && yourStats->type == VAMPIRE && (yourStats->getAllegianceTags() & Stat::ALLEGIANCE_TAG_BRAM_KINDLY) )
 	{
 		return true;
 	}
-	else if ( behavior == &actMonster && myStats->type == INCUBUS && !strncmp(myStats->name, "inner demon", strlen("inner demon")) )
+	else if ( behavior == &actMonster && myStats->type == INCUBUS && (myStats->getAllegianceTags() & Stat::ALLEGIANCE_TAG_INNER_DEMON) )
 	{
 		Entity* parentEntity = uidToEntity(this->parent);
 		if ( parentEntity != your )
@@ -11580,7 +11965,7 @@ bool Entity::checkEnemy(Entity* your)
 			return false;
 		}
 	}
-	else if ( behavior == &actPlayer && yourStats->type == INCUBUS && !strncmp(yourStats->name, "inner demon", strlen("inner demon")) )
+	else if ( behavior == &actPlayer && yourStats->type == INCUBUS && (yourStats->getAllegianceTags() & Stat::ALLEGIANCE_TAG_INNER_DEMON) )
 	{
 		Entity* parentEntity = uidToEntity(your->parent);
 		if ( parentEntity != this )
@@ -11592,7 +11977,7 @@ bool Entity::checkEnemy(Entity* your)
 			return false;
 		}
 	}
-	else if ( behavior == &actMonster && your->behavior == &actMonster && yourStats->type == INCUBUS && !strncmp(yourStats->name, "inner demon", strlen("inner demon")) )
+	else if ( behavior == &actMonster && your->behavior == &actMonster && yourStats->type == INCUBUS && (yourStats->getAllegianceTags() & Stat::ALLEGIANCE_TAG_INNER_DEMON) )
 	{
 		Entity* illusionTauntingThisEntity = uidToEntity(static_cast<Uint32>(your->monsterIllusionTauntingThisUid));
 		if ( illusionTauntingThisEntity == this )
@@ -11679,174 +12064,11 @@ bool Entity::checkEnemy(Entity* your)
 			}
 			else if ( behavior == &actPlayer && myStats->type != HUMAN )
 			{
-				result = swornenemies[HUMAN][yourStats->type];
-				if ( (yourStats->type == HUMAN || yourStats->type == SHOPKEEPER) && myStats->type != AUTOMATON )
-				{
-					// enemies.
-					result = true;
-				}
-				else
-				{
-					switch ( myStats->type )
-					{
-						case SKELETON:
-							if ( yourStats->type == GHOUL )
-							{
-								result = false;
-							}
-							break;
-						case RAT:
-							if ( yourStats->type == RAT )
-							{
-								result = false;
-							}
-							break;
-						case SPIDER:
-							if ( yourStats->type == SPIDER
-								|| yourStats->type == SCARAB || yourStats->type == SCORPION )
-							{
-								result = false;
-							}
-							break;
-						case TROLL:
-							if ( yourStats->type == TROLL )
-							{
-								result = false;
-							}
-							break;
-						case CREATURE_IMP:
-							if ( yourStats->type == CREATURE_IMP )
-							{
-								result = false;
-							}
-							break;
-						case GOBLIN:
-							if ( yourStats->type == GOBLIN )
-							{
-								result = false;
-							}
-							break;
-						case GOATMAN:
-							if ( yourStats->type == GOATMAN )
-							{
-								result = false;
-							}
-							break;
-						case INCUBUS:
-						case SUCCUBUS:
-							if ( yourStats->type == SUCCUBUS || yourStats->type == INCUBUS )
-							{
-								result = false;
-							}
-							break;
-						case INSECTOID:
-							if ( yourStats->type == SCARAB || yourStats->type == INSECTOID || yourStats->type == SCORPION )
-							{
-								result = false;
-							}
-							break;
-						case VAMPIRE:
-							if ( yourStats->type == VAMPIRE )
-							{
-								result = false;
-							}
-							break;
-						case AUTOMATON:
-							if ( yourStats->type == INCUBUS || yourStats->type == SUCCUBUS )
-							{
-								result = false;
-							}
-							break;
-						default:
-							break;
-					}
-				}
+				result = playerRaceRelation(myStats->type, yourStats->type) & PLAYER_RACE_ENEMY_OF_MONSTER;
 			}
 			else if ( behavior == &actMonster && your->behavior == &actPlayer && yourStats->type != HUMAN )
 			{
-				result = swornenemies[myStats->type][HUMAN];
-				if ( (myStats->type == HUMAN || myStats->type == SHOPKEEPER) && yourStats->type != AUTOMATON )
-				{
-					// enemies.
-					result = true;
-				}
-				else
-				{
-					switch ( yourStats->type )
-					{
-						case SKELETON:
-							if ( myStats->type == GHOUL )
-							{
-								result = false;
-							}
-							break;
-						case RAT:
-							if ( myStats->type == RAT )
-							{
-								result = false;
-							}
-							break;
-						case SPIDER:
-							if ( myStats->type == SPIDER
-								|| myStats->type == SCARAB || myStats->type == SCORPION )
-							{
-								result = false;
-							}
-							break;
-						case TROLL:
-							if ( myStats->type == TROLL )
-							{
-								result = false;
-							}
-							break;
-						case CREATURE_IMP:
-							if ( myStats->type == CREATURE_IMP )
-							{
-								result = false;
-							}
-							break;
-						case GOBLIN:
-							if ( myStats->type == GOBLIN )
-							{
-								result = false;
-							}
-							break;
-						case GOATMAN:
-							if ( myStats->type == GOATMAN )
-							{
-								result = false;
-							}
-							break;
-						case INCUBUS:
-						case SUCCUBUS:
-							if ( myStats->type == SUCCUBUS || myStats->type == INCUBUS )
-							{
-								result = false;
-							}
-							break;
-						case INSECTOID:
-							if ( myStats->type == SCARAB 
-								|| myStats->type == INSECTOID || myStats->type == SCORPION )
-							{
-								result = false;
-							}
-							break;
-						case VAMPIRE:
-							if ( myStats->type == VAMPIRE )
-							{
-								result = false;
-							}
-							break;
-						case AUTOMATON:
-							if ( myStats->type == INCUBUS || myStats->type == SUCCUBUS )
-							{
-								result = false;
-							}
-							break;
-						default:
-							break;
-					}
-				}
+				result = playerRaceRelation(yourStats->type, myStats->type) & MONSTER_ENEMY_OF_PLAYER_RACE;
 			}
 		}
 	}
@@ -11855,7 +12077,7 @@ bool Entity::checkEnemy(Entity* your)
 	if ( myStats->EFFECTS[EFF_CONFUSED] )
 	{
 		if ( myStats->type == AUTOMATON && yourStats->type == AUTOMATON 
-			&& !strncmp(myStats->name, "corrupted automaton", strlen("corrupted automaton")) )
+			&& (myStats->getAllegianceTags() & Stat::ALLEGIANCE_TAG_CORRUPTED_AUTOMATON) )
 		{
 			// these guys ignore themselves when confused..
 		}
@@ -11938,16 +12160,16 @@ bool Entity::checkFriend(Entity* your)
 		return true;
 	}
 
-	if ( (myStats->type == HUMAN || behavior == &actPlayer) && (yourStats->type == AUTOMATON && !strncmp(yourStats->name, "corrupted automaton", 19)) )
+	if ( (myStats->type == HUMAN || behavior == &actPlayer) && (yourStats->type == AUTOMATON && (yourStats->getAllegianceTags() & Stat::ALLEGIANCE_TAG_CORRUPTED_AUTOMATON)) )
 	{
 		return false;
 	}
-	else if ( (yourStats->type == HUMAN || your->behavior == &actPlayer) && (myStats->type == AUTOMATON && !strncmp(myStats->name, "corrupted automaton", 19)) )
+	else if ( (yourStats->type == HUMAN || your->behavior == &actPlayer) && (myStats->type == AUTOMATON && (myStats->getAllegianceTags() & Stat::ALLEGIANCE_TAG_CORRUPTED_AUTOMATON)) )
 	{
 		return false;
 	}
 	else if ( your->behavior == &actPlayer && myStats->type == CREATURE_IMP
-		&& (!strncmp(map.name, "Boss", 4) || !strncmp(map.name, "Hell Boss", 9)) )
+		&& map.bossLevel )
 	{
 		if ( this->monsterAllyGetPlayerLeader() )
 		{
@@ -11956,7 +12178,7 @@ bool Entity::checkFriend(Entity* your)
 		return false;
 	}
 	else if ( behavior == &actPlayer && yourStats->type == CREATURE_IMP
-		&& (!strncmp(map.name, "Boss", 4) || !strncmp(map.name, "Hell Boss", 9)) )
+		&& map.bossLevel )
 	{
 		if ( your->monsterAllyGetPlayerLeader() )
 		{
@@ -11964,15 +12186,15 @@ bool Entity::checkFriend(Entity* your)
 		}
 		return false;
 	}
-	else if ( your->behavior == &actPlayer && myStats->type == VAMPIRE && MonsterData_t::nameMatchesSpecialNPCName(*myStats, "bram kindly") )
+	else if ( your->behavior == &actPlayer && myStats->type == VAMPIRE && (myStats->getAllegianceTags() & Stat::ALLEGIANCE_TAG_BRAM_KINDLY) )
 	{
 		return false;
 	}
-	else if ( behavior == &actPlayer && yourStats->type == VAMPIRE && MonsterData_t::nameMatchesSpecialNPCName(*yourStats, "bram kindly") )
+	else if ( behavior == &actPlayer && yourStats->type == VAMPIRE && (yourStats->getAllegianceTags() & Stat::ALLEGIANCE_TAG_BRAM_KINDLY) )
 	{
 		return false;
 	}
-	else if ( behavior == &actMonster && myStats->type == INCUBUS && !strncmp(myStats->name, "inner demon", strlen("inner demon")) )
+	else if ( behavior == &actMonster && myStats->type == INCUBUS && (myStats->getAllegianceTags() & Stat::ALLEGIANCE_TAG_INNER_DEMON) )
 	{
 		Entity* parentEntity = uidToEntity(this->parent);
 		if ( parentEntity == your )
@@ -11984,7 +12206,7 @@ bool Entity::checkFriend(Entity* your)
 			return false;
 		}
 	}
-	else if ( behavior == &actPlayer && your->behavior == &actMonster && yourStats->type == INCUBUS && !strncmp(yourStats->name, "inner demon", strlen("inner demon")) )
+	else if ( behavior == &actPlayer && your->behavior == &actMonster && yourStats->type == INCUBUS && (yourStats->getAllegianceTags() & Stat::ALLEGIANCE_TAG_INNER_DEMON) )
 	{
 		Entity* parentEntity = uidToEntity(your->parent);
 		if ( parentEntity == this )
@@ -11996,7 +12218,7 @@ bool Entity::checkFriend(Entity* your)
 			return false;
 		}
 	}
-	else if ( behavior == &actMonster && your->behavior == &actMonster && yourStats->type == INCUBUS && !strncmp(yourStats->name, "inner demon", strlen("inner demon")) )
+	else if ( behavior == &actMonster && your->behavior == &actMonster && yourStats->type == INCUBUS && (yourStats->getAllegianceTags() & Stat::ALLEGIANCE_TAG_INNER_DEMON) )
 	{
 		Entity* illusionTauntingThisEntity = uidToEntity(static_cast<Uint32>(your->monsterIllusionTauntingThisUid));
 		if ( illusionTauntingThisEntity == this )
@@ -12083,181 +12305,11 @@ bool Entity::checkFriend(Entity* your)
 			}
 			else if ( behavior == &actPlayer && myStats->type != HUMAN )
 			{
-				result = monsterally[HUMAN][yourStats->type];
-				if ( (yourStats->type == HUMAN || yourStats->type == SHOPKEEPER) && myStats->type != AUTOMATON )
-				{
-					result = false;
-				}
-				else
-				{
-					result = false;
-					switch ( myStats->type )
-					{
-						case SKELETON:
-							if ( yourStats->type == GHOUL )
-							{
-								result = true;
-							}
-							break;
-						case RAT:
-							if ( yourStats->type == RAT )
-							{
-								result = true;
-							}
-							break;
-						case SPIDER:
-							if ( yourStats->type == SPIDER || yourStats->type == SCARAB || yourStats->type == SCORPION )
-							{
-								result = true;
-							}
-							break;
-						case TROLL:
-							if ( yourStats->type == TROLL )
-							{
-								result = true;
-							}
-							break;
-						case CREATURE_IMP:
-							if ( yourStats->type == CREATURE_IMP )
-							{
-								result = true;
-							}
-							break;
-						case GOBLIN:
-							if ( yourStats->type == GOBLIN )
-							{
-								result = true;
-							}
-							break;
-						case GOATMAN:
-							if ( yourStats->type == GOATMAN )
-							{
-								result = true;
-							}
-							break;
-						case INCUBUS:
-						case SUCCUBUS:
-							if ( yourStats->type == SUCCUBUS || yourStats->type == INCUBUS )
-							{
-								result = true;
-							}
-							break;
-						case INSECTOID:
-							if ( yourStats->type == SCARAB 
-								|| yourStats->type == INSECTOID || yourStats->type == SCORPION )
-							{
-								result = true;
-							}
-							break;
-						case VAMPIRE:
-							if ( yourStats->type == VAMPIRE )
-							{
-								result = true;
-							}
-							break;
-						case AUTOMATON:
-							if ( yourStats->type == SHOPKEEPER )
-							{
-								result = monsterally[SHOPKEEPER][AUTOMATON];
-							}
-							else if ( yourStats->type == HUMAN )
-							{
-								result = true;
-							}
-							break;
-						default:
-							break;
-					}
-				}
+				result = playerRaceRelation(myStats->type, yourStats->type) & PLAYER_RACE_FRIEND_OF_MONSTER;
 			}
 			else if ( behavior == &actMonster && your->behavior == &actPlayer && yourStats->type != HUMAN )
 			{
-				result = monsterally[myStats->type][HUMAN];
-				if ( (myStats->type == HUMAN || myStats->type == SHOPKEEPER) && yourStats->type != AUTOMATON )
-				{
-					result = false;
-				}
-				else
-				{
-					switch ( yourStats->type )
-					{
-						case SKELETON:
-							if ( myStats->type == GHOUL )
-							{
-								result = true;
-							}
-							break;
-						case RAT:
-							if ( myStats->type == RAT )
-							{
-								result = true;
-							}
-							break;
-						case SPIDER:
-							if ( myStats->type == SPIDER
-								|| myStats->type == SCARAB || myStats->type == SCORPION )
-							{
-								result = true;
-							}
-							break;
-						case TROLL:
-							if ( myStats->type == TROLL )
-							{
-								result = true;
-							}
-							break;
-						case CREATURE_IMP:
-							if ( myStats->type == CREATURE_IMP )
-							{
-								result = true;
-							}
-							break;
-						case GOBLIN:
-							if ( myStats->type == GOBLIN )
-							{
-								result = true;
-							}
-							break;
-						case GOATMAN:
-							if ( myStats->type == GOATMAN )
-							{
-								result = true;
-							}
-							break;
-						case INCUBUS:
-						case SUCCUBUS:
-							if ( myStats->type == SUCCUBUS || myStats->type == INCUBUS )
-							{
-								result = true;
-							}
-							break;
-						case INSECTOID:
-							if ( myStats->type == SCARAB 
-								|| myStats->type == INSECTOID || myStats->type == SCORPION )
-							{
-								result = true;
-							}
-							break;
-						case VAMPIRE:
-							if ( myStats->type == VAMPIRE )
-							{
-								result = true;
-							}
-							break;
-						case AUTOMATON:
-							if ( myStats->type == SHOPKEEPER )
-							{
-								result = monsterally[SHOPKEEPER][AUTOMATON];
-							}
-							else if ( myStats->type == HUMAN )
-							{
-								result = true;
-							}
-							break;
-						default:
-							break;
-					}
-				}
+				result = playerRaceRelation(yourStats->type, myStats->type) & MONSTER_FRIEND_OF_PLAYER_RACE;
 			}
 		}
 	}
@@ -18530,6 +18582,10 @@ node_t* TileEntityListHandler::addEntity(Entity& entity)
 	if ( x >= 0 && x < kMaxMapDimension && y >= 0 && y < kMaxMapDimension )
 	{
 		//messagePlayer(0, "added at %d, %d", x, y);
+		if ( entity.circuit_status )
+		{
+			CircuitNetlist.invalidate();
+		}
 		entity.myTileListNode = list_AddNodeLast(&TileEntityList.gridEntities[x][y]);
 		entity.myTileListNode->element = &entity;
 		entity.myTileListNode->deconstructor = &emptyDeconstructor;
@@ -18551,6 +18607,10 @@ node_t* TileEntityListHandler::updateEntity(Entity& entity)
 	int y = (static_cast<int>(entity.y) >> 4);
 	if ( x >= 0 && x < kMaxMapDimension && y >= 0 && y < kMaxMapDimension )
 	{
+		if ( entity.myTileListNode->list != &TileEntityList.gridEntities[x][y] )
+		{
+			CircuitNetlist.removeEntity(entity); // changed tiles
+		}
 		list_RemoveNode(entity.myTileListNode);
 		entity.myTileListNode = list_AddNodeLast(&TileEntityList.gridEntities[x][y]);
 		entity.myTileListNode->element = &entity;
@@ -18564,6 +18624,7 @@ node_t* TileEntityListHandler::updateEntity(Entity& entity)
 
 void TileEntityListHandler::clearTile(int x, int y)
 {
+	CircuitNetlist.invalidate();
 	list_FreeAll(&gridEntities[x][y]);
 }
 
@@ -124,6 +124,7 @@ public:
         static constexpr int MAX = 10;
     };
     std::unordered_map<view_t*, Dither> dithering;
+	Uint32 monsterPoseSignature = 0; // limb-affecting state at the last pose, see monsterBodypartPoseCulled()
 	vec4_t lightBonus;
 
 	Uint32 getUID() const {return uid;}
@@ -159,6 +160,7 @@ public:
 	real_t lerp_oy;
 	bool bNeedsRenderPositionInit = true;
 	bool bUseRenderInterpolation = false;
+	TimerExperiments::InterpolatedListSlot lerpListSlots[2];
 	int mapGenerationRoomX = 0; // captures the x/y of the 'room' this spawned in on generate dungeon
 	int mapGenerationRoomY = 0; // captures the x/y of the 'room' this spawned in on generate dungeon
 
@@ -684,7 +686,6 @@ public:
 	void mechanismPowerOff(); //Called when a circuit or switch next to a mechanism powers on.
 	void toggleSwitch(int skillIndexForPower = -1); //Called when a player flips a switch (lever). skillIndexForPower can use any skill[] to reference for the entity power status (defaults to skill[0] for switches)
 	void switchUpdateNeighbors(); //Run each time actSwitch() is called to make sure the network is online if any one switch connected to it is still set to the on position.
-	list_t* getPowerableNeighbors(); //Returns a list of all circuits and mechanisms this entity can influence.
 
 	//Chest/container functions.
 	void closeChest();
@@ -1498,6 +1498,22 @@ void EOSFuncs::readFromCmdLineArgs()
 }
 
 bool EOSFuncs::HandleReceivedMessages(EOS_ProductUserId* remoteIdReturn)
+{
+	if (!net_packet)
+	{
+		return false;
+	}
+
+	Uint32 bytesWritten = 0;
+	if ( HandleReceivedMessages(remoteIdReturn, net_packet->data, net_packet->maxlen, &bytesWritten) )
+	{
+		net_packet->len = bytesWritten;
+		return true;
+	}
+	return false;
+}
+
+bool EOSFuncs::HandleReceivedMessages(EOS_ProductUserId* remoteIdReturn, Uint8* data, Uint32 maxlen, Uint32* lenReturn)
 {
 	if (!CurrentUserInfo.isValid())
 	{
@@ -1505,7 +1521,7 @@ bool EOSFuncs::HandleReceivedMessages(EOS_ProductUserId* remoteIdReturn)
 		return false;
 	}
 
-	if (!net_packet)
+	if (!data || !lenReturn)
 	{
 		return false;
 	}
@@ -1520,7 +1536,7 @@ bool EOSFuncs::HandleReceivedMessages(EOS_ProductUserId* remoteIdReturn)
 	EOS_P2P_ReceivePacketOptions ReceivePacketOptions{};
 	ReceivePacketOptions.ApiVersion = EOS_P2P_RECEIVEPACKET_API_LATEST;
 	ReceivePacketOptions.LocalUserId = CurrentUserInfo.getProductUserIdHandle();
-	ReceivePacketOptions.MaxDataSizeBytes = 512;
+	ReceivePacketOptions.MaxDataSizeBytes = std::min<Uint32>(512, maxlen);
 	ReceivePacketOptions.RequestedChannel = nullptr;
 
 	EOS_P2P_SocketId SocketId;
@@ -1528,7 +1544,7 @@ bool EOSFuncs::HandleReceivedMessages(EOS_ProductUserId* remoteIdReturn)
 	uint8_t Channel = 0;
 
 	Uint32 bytesWritten = 0;
-	EOS_EResult result = EOS_P2P_ReceivePacket(P2PHandle, &ReceivePacketOptions, remoteIdReturn, &SocketId, &Channel, net_packet->data, &bytesWritten);
+	EOS_EResult result = EOS_P2P_ReceivePacket(P2PHandle, &ReceivePacketOptions, remoteIdReturn, &SocketId, &Channel, data, &bytesWritten);
 	if (result == EOS_EResult::EOS_NotFound
 		|| result == EOS_EResult::EOS_InvalidAuth
 		|| result == EOS_EResult::EOS_InvalidUser)
@@ -1538,9 +1554,9 @@ bool EOSFuncs::HandleReceivedMessages(EOS_ProductUserId* remoteIdReturn)
 	}
 	else if (result == EOS_EResult::EOS_Success)
 	{
-		net_packet->len = bytesWritten;
+		*lenReturn = bytesWritten;
 		//char buffer[512] = "";
-		//strncpy_s(buffer, (char*)net_packet->data, 512 - 1);
+		//strncpy_s(buffer, (char*)data, 512 - 1);
 		//buffer[4] = '\0';
 		//logInfo("HandleReceivedMessages: remote id: %s received: %s", EOSFuncs::Helpers_t::productIdToString(*remoteIdReturn).c_str(), buffer);
 		return true;
@@ -836,6 +836,7 @@ public:
 	}
 
 	bool HandleReceivedMessages(EOS_ProductUserId* remoteIdReturn);
+	bool HandleReceivedMessages(EOS_ProductUserId* remoteIdReturn, Uint8* data, Uint32 maxlen, Uint32* lenReturn); // receive into a caller-owned buffer instead of net_packet
 	bool HandleReceivedMessagesAndIgnore(EOS_ProductUserId* remoteIdReturn); // function to empty the packet queue on main lobby.
 	void SendMessageP2P(EOS_ProductUserId RemoteId, const void* data, int len);
 	bool serialize(void* file);
@@ -12,6 +12,11 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <dirent.h>
+#if !defined(WINDOWS) && !defined(NINTENDO)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 #include <fstream>
 #include <list>
@@ -1456,6 +1461,96 @@ File* openDataFile(const char * const filename, const char * const mode) {
 	return result;
 }
 
+bool MappedFile::open(const char* path)
+{
+	close();
+#if defined(WINDOWS)
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if ( file == INVALID_HANDLE_VALUE )
+	{
+		return false;
+	}
+	LARGE_INTEGER size;
+	if ( !GetFileSizeEx(file, &size) || size.QuadPart <= 0 )
+	{
+		CloseHandle(file);
+		return false;
+	}
+	// the view keeps the mapping and the file open once it exists
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if ( !mapping )
+	{
+		return false;
+	}
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if ( !view )
+	{
+		return false;
+	}
+	_data = (const Uint8*)view;
+	_size = (size_t)size.QuadPart;
+	return true;
+#elif defined(NINTENDO)
+	File* fp = FileIO::open(path, "rb");
+	if ( !fp )
+	{
+		return false;
+	}
+	_buffer.resize(fp->size());
+	const size_t read = _buffer.empty() ? 0 : fp->read(_buffer.data(), sizeof(Uint8), _buffer.size());
+	FileIO::close(fp);
+	if ( !read || read != _buffer.size() )
+	{
+		_buffer.clear();
+		return false;
+	}
+	_data = _buffer.data();
+	_size = _buffer.size();
+	return true;
+#else
+	const int fd = ::open(path, O_RDONLY);
+	if ( fd < 0 )
+	{
+		return false;
+	}
+	struct stat st;
+	if ( fstat(fd, &st) != 0 || st.st_size <= 0 )
+	{
+		::close(fd);
+		return false;
+	}
+	// the mapping stays valid after the descriptor is closed
+	void* view = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if ( view == MAP_FAILED )
+	{
+		return false;
+	}
+	_data = (const Uint8*)view;
+	_size = (size_t)st.st_size;
+	return true;
+#endif
+}
+
+void MappedFile::close()
+{
+	if ( !_data )
+	{
+		return;
+	}
+#if defined(WINDOWS)
+	UnmapViewOfFile(_data);
+#elif defined(NINTENDO)
+	_buffer.clear();
+#else
+	munmap((void*)_data, _size);
+#endif
+	_data = nullptr;
+	_size = 0;
+}
+
 DIR* openDataDir(const char * const name) {
 	char path[PATH_MAX];
 	completePath(path, name);
@@ -1619,63 +1714,140 @@ bool verifyMapHash(const char* filename, int hash, bool *fileExistsInTable) {
 	return result;
 }
 
-int loadMap(const char* filename2, map_t* destmap, list_t* entlist, list_t* creatureList, int *checkMapHash)
+/*-------------------------------------------------------------------------------
+
+	compiled maps
+
+	The game loads levels from a compiled form of each .lmp: a header, the
+	raw tile array and a flat table of fixed-layout spawn records, which is
+	memory-mapped from outputdir/mapcache and used in place. An entry is
+	written the first time its .lmp is loaded (or ahead of time with
+	/compile_maps) and is rebuilt whenever the .lmp's size or timestamp
+	changes. The editor only ever reads and writes .lmp.
+
+-------------------------------------------------------------------------------*/
+
+#if !defined(EDITOR) && !defined(NINTENDO)
+ #define COMPILED_MAPS
+#endif
+
+static constexpr Uint32 COMPILED_MAP_FORMAT = 1;
+
+struct CompiledMapHeader_t
 {
-	File* fp;
-	char valid_data[16];
-	Uint32 numentities;
-	Uint32 c;
-	Sint32 x, y;
-	Entity* entity;
-	Sint32 sprite;
-	Stat* myStats;
-	Stat* dummyStats;
-	int editorVersion = 0;
-	char filename[1024];
-	int mapHashData = 0;
-	if ( checkMapHash )
-	{
-		*checkMapHash = 0;
-	}
+	char magic[8];       // "BARONYLC"
+	char version[16];    // VERSION of the game that wrote it
+	Uint32 format;       // COMPILED_MAP_FORMAT
+	Uint32 fileSize;
+	Uint64 sourceSize;   // size and timestamp of the .lmp it was compiled from
+	Sint64 sourceTime;
+	Sint32 mapHash;      // what loadMap reports through checkMapHash
+	char name[32];
+	char author[32];
+	Uint32 width;
+	Uint32 height;
+	Uint32 skybox;
+	Sint32 flags[MAPFLAGS];
+	Uint32 numEntities;
+	Uint32 numStats;
+	Uint32 tilesOffset;  // Sint32[width * height * MAPLAYERS], before animated tiles are fixed up
+	Uint32 spawnsOffset; // CompiledMapSpawn_t[numEntities]
+	Uint32 statsOffset;  // CompiledMapStat_t[numStats]
+};
 
-	char oldmapname[64];
-	strcpy(oldmapname, map.name);
+// an entity as it stands once its .lmp record has been read
+struct CompiledMapSpawn_t
+{
+	real_t yaw;
+	Sint32 sprite;
+	Sint32 x;
+	Sint32 y;
+	Sint32 stats; // index into the stat table, or -1
+	Sint32 skill[NUMENTITYSKILLS];
+};
 
-	printlog("LoadMap %s", filename2);
+// the monster stats an .lmp stores, laid out as the editor writes them
+struct CompiledMapStat_t
+{
+	char name[128];
+	Sint32 HP, MAXHP, OLDHP, MP, MAXMP;
+	Sint32 STR, DEX, CON, INT, PER, CHR;
+	Sint32 LVL, GOLD;
+	Sint32 RANDOM_MAXHP, RANDOM_HP, RANDOM_MAXMP, RANDOM_MP;
+	Sint32 RANDOM_STR, RANDOM_CON, RANDOM_DEX, RANDOM_INT, RANDOM_PER, RANDOM_CHR;
+	Sint32 RANDOM_LVL, RANDOM_GOLD;
+	Sint32 EDITOR_ITEMS[ITEM_SLOT_NUM];
+	Sint32 MISC_FLAGS[32];
+};
 
-	if (! (filename2 && filename2[0]))
-	{
-		printlog("map filename empty or null");
-		return -1;
-	}
+// a map read from an .lmp, collected while reading so it can be written out in compiled form
+struct CompiledMapData_t
+{
+	std::vector<Sint32> tiles;
+	std::vector<CompiledMapSpawn_t> spawns;
+	std::vector<CompiledMapStat_t> stats;
+};
 
-	if ( !PHYSFS_isInit() )
-	{
-		strcpy(filename, "maps/");
-		strcat(filename, filename2);
-	}
-	else
-	{
-		strcpy(filename, filename2);
-	}
+static void storeMapStats(const Stat& stats, CompiledMapStat_t& out)
+{
+	memcpy(out.name, stats.name, sizeof(out.name));
+	out.HP = stats.HP;
+	out.MAXHP = stats.MAXHP;
+	out.OLDHP = stats.OLDHP;
+	out.MP = stats.MP;
+	out.MAXMP = stats.MAXMP;
+	out.STR = stats.STR;
+	out.DEX = stats.DEX;
+	out.CON = stats.CON;
+	out.INT = stats.INT;
+	out.PER = stats.PER;
+	out.CHR = stats.CHR;
+	out.LVL = stats.LVL;
+	out.GOLD = stats.GOLD;
+	out.RANDOM_MAXHP = stats.RANDOM_MAXHP;
+	out.RANDOM_HP = stats.RANDOM_HP;
+	out.RANDOM_MAXMP = stats.RANDOM_MAXMP;
+	out.RANDOM_MP = stats.RANDOM_MP;
+	out.RANDOM_STR = stats.RANDOM_STR;
+	out.RANDOM_CON = stats.RANDOM_CON;
+	out.RANDOM_DEX = stats.RANDOM_DEX;
+	out.RANDOM_INT = stats.RANDOM_INT;
+	out.RANDOM_PER = stats.RANDOM_PER;
+	out.RANDOM_CHR = stats.RANDOM_CHR;
+	out.RANDOM_LVL = stats.RANDOM_LVL;
+	out.RANDOM_GOLD = stats.RANDOM_GOLD;
+	memcpy(out.EDITOR_ITEMS, stats.EDITOR_ITEMS, sizeof(out.EDITOR_ITEMS));
+	memcpy(out.MISC_FLAGS, stats.MISC_FLAGS, sizeof(out.MISC_FLAGS));
+}
 
+// gives a map monster a fresh Stat, behind the empty node that
+// traversal of entity->children expects
+static Stat* addMapEntityStats(Entity* entity)
+{
+	// need to give the entity its list stuff.
+	// create an empty first node for traversal purposes
+	node_t* node2 = list_AddNodeFirst(&entity->children);
+	node2->element = NULL;
+	node2->deconstructor = &emptyDeconstructor;
+
+	Stat* myStats = new Stat(entity->sprite);
+	node2 = list_AddNodeLast(&entity->children);
+	node2->element = myStats;
+	node2->size = sizeof(myStats);
+	node2->deconstructor = &statDeconstructor;
+	return myStats;
+}
 
-	// add extension if missing
-	if ( strstr(filename, ".lmp") == nullptr )
-	{
-		strcat(filename, ".lmp");
-	}
+// opens an .lmp and reads its version tag, leaving fp at the map name
+static File* openMapLMP(const char* filename, int& editorVersion)
+{
+	File* fp;
+	char valid_data[16];
 
-	// load the file!
 	if ((fp = openDataFile(filename, "rb")) == nullptr)
 	{
 		printlog("warning: failed to open file '%s' for map loading!\n", filename);
-		if ( destmap == &map && game )
-		{
-			printlog("error: main map failed to load, aborting.\n");
-			mainloop = 0;
-		}
-		return -1;
+		return nullptr;
 	}
 
 	// read map version number
@@ -1738,56 +1910,53 @@ int loadMap(const char* filename2, map_t* destmap, list_t* entlist, list_t* crea
 		{
 			printlog("warning: file '%s' is an invalid map file.\n", filename);
 			FileIO::close(fp);
-			if ( destmap == &map && game )
-			{
-				printlog("error: main map failed to load, aborting.\n");
-				mainloop = 0;
-			}
-			return -1;
+			return nullptr;
 		}
 	}
+	return fp;
+}
 
-	list_FreeAll(entlist);
-
-	if ( destmap == &map )
-	{
-		// remove old lights
-		list_FreeAll(&light_l);
-		// remove old world UI
-		if ( destmap->worldUI )
-		{
-			list_FreeAll(map.worldUI);
-		}
-	}
-	if ( destmap->tiles != nullptr )
+// allocates the camera vismaps for the main map's dimensions
+static void allocateMainMapVismaps()
+{
+#ifdef EDITOR
+	camera.vismap = (bool*)malloc(sizeof(bool) * map.width * map.height);
+    memset(camera.vismap, 0, sizeof(bool) * map.height * map.width);
+#endif
+	menucam.vismap = (bool*)malloc(sizeof(bool) * map.width * map.height);
+    memset(menucam.vismap, 0, sizeof(bool) * map.height * map.width);
+	for ( int i = 0; i < MAXPLAYERS; ++i )
 	{
-		free(destmap->tiles);
-		destmap->tiles = nullptr;
+		cameras[i].vismap = (bool*)malloc(sizeof(bool) * map.width * map.height);
+        memset(cameras[i].vismap, 0, sizeof(bool) * map.height * map.width);
 	}
+}
+
+// allocates the tile array for a map whose dimensions have been read, plus
+// the camera vismaps when it's the main map
+static void allocateMapTiles(map_t* destmap)
+{
+	destmap->tiles = (Sint32*) malloc(sizeof(Sint32) * destmap->width * destmap->height * MAPLAYERS);
 	if ( destmap == &map )
 	{
-#ifdef EDITOR
-		if ( camera.vismap != nullptr )
-		{
-			free(camera.vismap);
-			camera.vismap = nullptr;
-		}
-#endif
-		if ( menucam.vismap != nullptr )
-		{
-			free(menucam.vismap);
-			menucam.vismap = nullptr;
-		}
-		for ( int i = 0; i < MAXPLAYERS; ++i )
-		{
-			if ( cameras[i].vismap != nullptr )
-			{
-				free(cameras[i].vismap);
-				cameras[i].vismap = nullptr;
-			}
-		}
+		allocateMainMapVismaps();
 	}
+}
+
+// reads the header, tiles and entities of an .lmp opened by openMapLMP.
+// if compiled is given, it is filled in with the same map in compiled form.
+static Uint32 readMapLMP(File* fp, int editorVersion, map_t* destmap, list_t* entlist, list_t* creatureList, int& mapHashData, CompiledMapData_t* compiled)
+{
+	Uint32 numentities;
+	Uint32 c;
+	Sint32 x, y;
+	Entity* entity;
+	Sint32 sprite;
+	Stat* myStats;
+	Stat* dummyStats;
+
 	fp->read(destmap->name, sizeof(char), 32); // map name
+	destmap->bossLevel = !strncmp(destmap->name, "Boss", 4) || !strncmp(destmap->name, "Hell Boss", 9);
 	fp->read(destmap->author, sizeof(char), 32); // map author
 	fp->read(&destmap->width, sizeof(Uint32), 1); // map width
 	fp->read(&destmap->height, sizeof(Uint32), 1); // map height
@@ -1823,21 +1992,7 @@ int loadMap(const char* filename2, map_t* destmap, list_t* entlist, list_t* crea
 	{
 		fp->read(destmap->flags, sizeof(Sint32), MAPFLAGS); // map flags
 	}
-	destmap->tiles = (Sint32*) malloc(sizeof(Sint32) * destmap->width * destmap->height * MAPLAYERS);
-	if ( destmap == &map )
-	{
-#ifdef EDITOR
-		camera.vismap = (bool*)malloc(sizeof(bool) * destmap->width * destmap->height);
-        memset(camera.vismap, 0, sizeof(bool) * destmap->height * destmap->width);
-#endif
-		menucam.vismap = (bool*)malloc(sizeof(bool) * destmap->width * destmap->height);
-        memset(menucam.vismap, 0, sizeof(bool) * destmap->height * destmap->width);
-		for ( int i = 0; i < MAXPLAYERS; ++i )
-		{
-			cameras[i].vismap = (bool*)malloc(sizeof(bool) * destmap->width * destmap->height);
-            memset(cameras[i].vismap, 0, sizeof(bool) * destmap->height * destmap->width);
-		}
-	}
+	allocateMapTiles(destmap);
 	fp->read(destmap->tiles, sizeof(Sint32), destmap->width * destmap->height * MAPLAYERS);
 	fp->read(&numentities, sizeof(Uint32), 1); // number of entities on the map
 
@@ -1846,32 +2001,17 @@ int loadMap(const char* filename2, map_t* destmap, list_t* entlist, list_t* crea
 	{
 		mapHashData += destmap->tiles[c];
 	}
- 
-    // new as of july 30 2023
-    // fix animated tiles so they always start on the correct index
-    constexpr int numTileAtlases = sizeof(AnimatedTile::indices) / sizeof(AnimatedTile::indices[0]);
-    for (int c = 0; c < mapsize; ++c) {
-        int& tile = destmap->tiles[c];
-        if (animatedtiles[tile]) {
-            auto find = tileAnimations.find(tile);
-            if (find == tileAnimations.end()) {
-                // this is not the correct index!
-                for (const auto& pair : tileAnimations) {
-                    const auto& animation = pair.second;
-                    for (int i = 0; i < numTileAtlases; ++i) {
-                        if (animation.indices[i] == tile) {
-                            tile = animation.indices[0];
-                        }
-                    }
-                }
-            }
-        }
-    }
+
+	if ( compiled )
+	{
+		compiled->tiles.assign(destmap->tiles, destmap->tiles + mapsize);
+	}
 
 	for (c = 0; c < numentities; c++)
 	{
 		fp->read(&sprite, sizeof(Sint32), 1);
 		entity = newEntity(sprite, 0, entlist, nullptr); //TODO: Figure out when we need to assign an entity to the global monster list. And do it!
+		Sint32 statIndex = -1;
 		switch( editorVersion )
 		{	case 1:
 				// V1.0 of editor version
@@ -1905,17 +2045,7 @@ int loadMap(const char* filename2, map_t* destmap, list_t* entlist, list_t* crea
 					case 1:
 						if ( multiplayer != CLIENT )
 						{
-							// need to give the entity its list stuff.
-							// create an empty first node for traversal purposes
-							node_t* node2 = list_AddNodeFirst(&entity->children);
-							node2->element = NULL;
-							node2->deconstructor = &emptyDeconstructor;
-
-							myStats = new Stat(entity->sprite);
-							node2 = list_AddNodeLast(&entity->children);
-							node2->element = myStats;
-							node2->size = sizeof(myStats);
-							node2->deconstructor = &statDeconstructor;
+							myStats = addMapEntityStats(entity);
 
 							sex_t dummyVar = MALE; 
 							// we don't actually embed the sex from the editor
@@ -1924,6 +2054,7 @@ int loadMap(const char* filename2, map_t* destmap, list_t* entlist, list_t* crea
 							// certainly were a lot of male adventurers locked in cells...
 							fp->read(&dummyVar, sizeof(sex_t), 1);
 							fp->read(&myStats->name, sizeof(char[128]), 1);
+							myStats->updateAllegianceTags();
 							fp->read(&myStats->HP, sizeof(Sint32), 1);
 							fp->read(&myStats->MAXHP, sizeof(Sint32), 1);
 							fp->read(&myStats->OLDHP, sizeof(Sint32), 1);
@@ -1961,6 +2092,12 @@ int loadMap(const char* filename2, map_t* destmap, list_t* entlist, list_t* crea
 								fp->read(&myStats->EDITOR_ITEMS, sizeof(Sint32), 96);
 							}
 							fp->read(&myStats->MISC_FLAGS, sizeof(Sint32), 32);
+							if ( compiled )
+							{
+								statIndex = (Sint32)compiled->stats.size();
+								compiled->stats.emplace_back();
+								storeMapStats(*myStats, compiled->stats.back());
+							}
 						}
 						//Read dummy values to move fp for the client
 						else
@@ -2004,6 +2141,12 @@ int loadMap(const char* filename2, map_t* destmap, list_t* entlist, list_t* crea
 								fp->read(&dummyStats->EDITOR_ITEMS, sizeof(Sint32), 96);
 							}
 							fp->read(&dummyStats->MISC_FLAGS, sizeof(Sint32), 32);
+							if ( compiled )
+							{
+								statIndex = (Sint32)compiled->stats.size();
+								compiled->stats.emplace_back();
+								storeMapStats(*dummyStats, compiled->stats.back());
+							}
 							delete dummyStats;
 						}
 						break;
@@ -2253,133 +2396,576 @@ int loadMap(const char* filename2, map_t* destmap, list_t* entlist, list_t* crea
 		entity->x = x;
 		entity->y = y;
 		mapHashData += (sprite * c);
-	}
-
-	FileIO::close(fp);
-
-	if ( destmap == &map )
-	{
-		nummonsters = 0;
-		minotaurlevel = 0;
 
-#if defined (USE_FMOD) || defined(USE_OPENAL)
-		if ( strcmp(oldmapname, map.name) )
+		if ( compiled )
 		{
-			if ( gameModeManager.getMode() != GameModeManager_t::GAME_MODE_TUTORIAL
-				&& gameModeManager.getMode() != GameModeManager_t::GAME_MODE_TUTORIAL_INIT )
-			{
-				levelmusicplaying = false;
-			}
+			CompiledMapSpawn_t spawn;
+			spawn.yaw = entity->yaw;
+			spawn.sprite = sprite;
+			spawn.x = x;
+			spawn.y = y;
+			spawn.stats = statIndex;
+			memcpy(spawn.skill, entity->skill, sizeof(spawn.skill));
+			compiled->spawns.push_back(spawn);
 		}
-#endif
-
-		// create new lightmap
-        for (int c = 0; c < MAXPLAYERS + 1; ++c) {
-            auto& lightmap = lightmaps[c];
-            auto& lightmapSmoothed = lightmapsSmoothed[c];
-            lightmap.resize(destmap->width * destmap->height);
-            lightmapSmoothed.resize((destmap->width + 2) * (destmap->height + 2));
-            if ( strncmp(map.name, "Hell", 4) )
-            {
-                memset(lightmap.data(), 0, sizeof(vec4_t) * map.width * map.height);
-                memset(lightmapSmoothed.data(), 0, sizeof(vec4_t) * (map.width + 2) * (map.height + 2));
-            }
-            else
-            {
-                for (int c = 0; c < destmap->width * destmap->height; c++ )
-                {
-                    lightmap[c].x = hellAmbience;
-                    lightmap[c].y = hellAmbience;
-                    lightmap[c].z = hellAmbience;
-#ifndef EDITOR
-                    if ( svFlags & SV_FLAG_CHEATS )
-                    {
-                        lightmap[c].x = *cvar_hell_ambience;
-                        lightmap[c].y = *cvar_hell_ambience;
-                        lightmap[c].z = *cvar_hell_ambience;
-                    }
-#endif
-                }
-                for (int c = 0; c < (destmap->width + 2) * (destmap->height + 2); c++ )
-                {
-                    lightmapSmoothed[c].x = hellAmbience;
-                    lightmapSmoothed[c].y = hellAmbience;
-                    lightmapSmoothed[c].z = hellAmbience;
-#ifndef EDITOR
-                    if ( svFlags & SV_FLAG_CHEATS )
-                    {
-                        lightmapSmoothed[c].x = *cvar_hell_ambience;
-                        lightmapSmoothed[c].y = *cvar_hell_ambience;
-                        lightmapSmoothed[c].z = *cvar_hell_ambience;
-                    }
-#endif
-                }
-            }
-        }
+	}
 
-		// reset minimap
-		for ( x = 0; x < MINIMAP_MAX_DIMENSION; x++ )
-		{
-			for ( y = 0; y < MINIMAP_MAX_DIMENSION; y++ )
-			{
-				minimap[y][x] = 0;
-			}
-		}
+	return numentities;
+}
 
-		// reset cameras
-		for (int c = 0; c < MAXPLAYERS; ++c) {
-			auto& camera = cameras[c];
-			if ( game )
-			{
-				camera.x = -32;
-				camera.y = -32;
-				camera.z = 0;
-				camera.ang = 3 * PI / 2;
-				camera.vang = 0;
-			}
-			else
-			{
-				camera.x = 2;
-				camera.y = 2;
-				camera.z = 0;
-				camera.ang = 0;
-				camera.vang = 0;
-			}
-		}
+#ifdef COMPILED_MAPS
+static ConsoleVariable<bool> cvar_mapCache("/map_cache", true);
 
-		// shoparea
-		if ( shoparea )
-		{
-			free(shoparea);
-		}
-		shoparea = (bool*) malloc(sizeof(bool) * destmap->width * destmap->height);
-		for ( x = 0; x < destmap->width; x++ )
+// the short name keeps the cache browsable, the path hash keeps
+// different mods' copies of a level apart
+static std::string compiledMapPath(const char* sourcePath)
+{
+	const char* shortName = sourcePath;
+	for ( const char* c = sourcePath; *c; ++c )
+	{
+		if ( *c == '/' || *c == '\\' )
 		{
-			for ( y = 0; y < destmap->height; y++ )
-			{
-				shoparea[y + x * destmap->height] = false;
-			}
+			shortName = c + 1;
 		}
 	}
+	char path[PATH_MAX];
+	snprintf(path, sizeof(path), "%s/mapcache/%s.%08x.lvc", outputdir, shortName,
+		(unsigned int)(std::hash<std::string>()(sourcePath) & 0xFFFFFFFF));
+	return path;
+}
 
-	std::string mapShortName = filename2;
-	size_t found = mapShortName.rfind("/");
-	if ( found != std::string::npos )
+static bool getMapSourceStamp(const char* sourcePath, Uint64& size, Sint64& time)
+{
+	struct stat st;
+	if ( stat(sourcePath, &st) != 0 )
 	{
-		mapShortName = mapShortName.substr(found + 1);
+		return false;
 	}
-	else
+	size = (Uint64)st.st_size;
+	time = (Sint64)st.st_mtime;
+	return true;
+}
+
+// maps the compiled form of sourcePath, if there is one and it's still current
+static bool openCompiledMap(const char* sourcePath, MappedFile& file)
+{
+	Uint64 sourceSize = 0;
+	Sint64 sourceTime = 0;
+	if ( !*cvar_mapCache || !getMapSourceStamp(sourcePath, sourceSize, sourceTime) )
 	{
-		found = mapShortName.rfind("\\");
-		if ( found != std::string::npos )
+		return false;
+	}
+	const std::string path = compiledMapPath(sourcePath);
+	if ( !file.open(path.c_str()) )
+	{
+		return false; // not compiled yet
+	}
+
+	const auto header = (const CompiledMapHeader_t*)file.data();
+	bool valid = file.size() >= sizeof(CompiledMapHeader_t)
+		&& !memcmp(header->magic, "BARONYLC", sizeof(header->magic))
+		&& !strncmp(header->version, VERSION, sizeof(header->version))
+		&& header->format == COMPILED_MAP_FORMAT
+		&& header->fileSize == file.size()
+		&& header->sourceSize == sourceSize
+		&& header->sourceTime == sourceTime;
+	if ( valid )
+	{
+		const Uint64 tilesEnd = header->tilesOffset + (Uint64)sizeof(Sint32) * header->width * header->height * MAPLAYERS;
+		const Uint64 spawnsEnd = header->spawnsOffset + (Uint64)sizeof(CompiledMapSpawn_t) * header->numEntities;
+		const Uint64 statsEnd = header->statsOffset + (Uint64)sizeof(CompiledMapStat_t) * header->numStats;
+		valid = tilesEnd <= file.size() && spawnsEnd <= file.size() && statsEnd <= file.size()
+			&& header->tilesOffset % alignof(Sint32) == 0
+			&& header->spawnsOffset % alignof(CompiledMapSpawn_t) == 0
+			&& header->statsOffset % alignof(CompiledMapStat_t) == 0;
+	}
+	if ( valid )
+	{
+		const auto spawns = (const CompiledMapSpawn_t*)(file.data() + header->spawnsOffset);
+		for ( Uint32 c = 0; c < header->numEntities && valid; ++c )
+		{
+			valid = spawns[c].stats < (Sint32)header->numStats;
+		}
+	}
+	if ( !valid )
+	{
+		printlog("[MAP CACHE]: '%s' is out of date, recompiling from '%s'", path.c_str(), sourcePath);
+		file.close();
+		return false;
+	}
+	return true;
+}
+
+static void restoreMapStats(const CompiledMapStat_t& in, Stat& stats)
+{
+	memcpy(stats.name, in.name, sizeof(in.name));
+	stats.name[sizeof(stats.name) - 1] = '\0';
+	stats.updateAllegianceTags();
+	stats.HP = in.HP;
+	stats.MAXHP = in.MAXHP;
+	stats.OLDHP = in.OLDHP;
+	stats.MP = in.MP;
+	stats.MAXMP = in.MAXMP;
+	stats.STR = in.STR;
+	stats.DEX = in.DEX;
+	stats.CON = in.CON;
+	stats.INT = in.INT;
+	stats.PER = in.PER;
+	stats.CHR = in.CHR;
+	stats.LVL = in.LVL;
+	stats.GOLD = in.GOLD;
+	stats.RANDOM_MAXHP = in.RANDOM_MAXHP;
+	stats.RANDOM_HP = in.RANDOM_HP;
+	stats.RANDOM_MAXMP = in.RANDOM_MAXMP;
+	stats.RANDOM_MP = in.RANDOM_MP;
+	stats.RANDOM_STR = in.RANDOM_STR;
+	stats.RANDOM_CON = in.RANDOM_CON;
+	stats.RANDOM_DEX = in.RANDOM_DEX;
+	stats.RANDOM_INT = in.RANDOM_INT;
+	stats.RANDOM_PER = in.RANDOM_PER;
+	stats.RANDOM_CHR = in.RANDOM_CHR;
+	stats.RANDOM_LVL = in.RANDOM_LVL;
+	stats.RANDOM_GOLD = in.RANDOM_GOLD;
+	memcpy(stats.EDITOR_ITEMS, in.EDITOR_ITEMS, sizeof(in.EDITOR_ITEMS));
+	memcpy(stats.MISC_FLAGS, in.MISC_FLAGS, sizeof(in.MISC_FLAGS));
+}
+
+// the compiled counterpart of readMapLMP. records are used straight out of the mapping
+static Uint32 readCompiledMap(const MappedFile& file, map_t* destmap, list_t* entlist, list_t* creatureList, int& mapHashData)
+{
+	const auto& header = *(const CompiledMapHeader_t*)file.data();
+	memcpy(destmap->name, header.name, sizeof(destmap->name));
+	destmap->name[sizeof(destmap->name) - 1] = '\0';
+	destmap->bossLevel = !strncmp(destmap->name, "Boss", 4) || !strncmp(destmap->name, "Hell Boss", 9);
+	memcpy(destmap->author, header.author, sizeof(destmap->author));
+	destmap->author[sizeof(destmap->author) - 1] = '\0';
+	destmap->width = header.width;
+	destmap->height = header.height;
+	destmap->skybox = header.skybox;
+	memcpy(destmap->flags, header.flags, sizeof(destmap->flags));
+	allocateMapTiles(destmap);
+	memcpy(destmap->tiles, file.data() + header.tilesOffset, sizeof(Sint32) * destmap->width * destmap->height * MAPLAYERS);
+	mapHashData = header.mapHash;
+
+	const auto spawns = (const CompiledMapSpawn_t*)(file.data() + header.spawnsOffset);
+	const auto stats = (const CompiledMapStat_t*)(file.data() + header.statsOffset);
+	for ( Uint32 c = 0; c < header.numEntities; ++c )
+	{
+		const CompiledMapSpawn_t& spawn = spawns[c];
+		Entity* entity = newEntity(spawn.sprite, 0, entlist, nullptr);
+		entity->yaw = spawn.yaw;
+		memcpy(entity->skill, spawn.skill, sizeof(entity->skill));
+		if ( spawn.stats >= 0 && multiplayer != CLIENT )
+		{
+			restoreMapStats(stats[spawn.stats], *addMapEntityStats(entity));
+		}
+		if ( entity->behavior == actMonster || entity->behavior == actPlayer )
+		{
+			entity->addToCreatureList(creatureList);
+		}
+		entity->x = spawn.x;
+		entity->y = spawn.y;
+	}
+	return header.numEntities;
+}
+
+static void saveCompiledMap(const char* sourcePath, const map_t* destmap, const CompiledMapData_t& data, int mapHash)
+{
+	CompiledMapHeader_t header;
+	memset(&header, 0, sizeof(header));
+	if ( !getMapSourceStamp(sourcePath, header.sourceSize, header.sourceTime) )
+	{
+		return;
+	}
+	memcpy(header.magic, "BARONYLC", sizeof(header.magic));
+	strncpy(header.version, VERSION, sizeof(header.version) - 1);
+	header.format = COMPILED_MAP_FORMAT;
+	header.mapHash = mapHash;
+	memcpy(header.name, destmap->name, sizeof(header.name));
+	memcpy(header.author, destmap->author, sizeof(header.author));
+	header.width = destmap->width;
+	header.height = destmap->height;
+	header.skybox = destmap->skybox;
+	memcpy(header.flags, destmap->flags, sizeof(header.flags));
+	header.numEntities = (Uint32)data.spawns.size();
+	header.numStats = (Uint32)data.stats.size();
+
+	// every table starts 8-byte aligned so it can be used in place
+	auto align = [](size_t offset) { return (Uint32)((offset + 7) & ~(size_t)7); };
+	const size_t tilesSize = sizeof(Sint32) * data.tiles.size();
+	const size_t spawnsSize = sizeof(CompiledMapSpawn_t) * data.spawns.size();
+	const size_t statsSize = sizeof(CompiledMapStat_t) * data.stats.size();
+	header.tilesOffset = align(sizeof(header));
+	header.spawnsOffset = align(header.tilesOffset + tilesSize);
+	header.statsOffset = align(header.spawnsOffset + spawnsSize);
+	header.fileSize = (Uint32)(header.statsOffset + statsSize);
+
+	std::vector<Uint8> buffer(header.fileSize, 0);
+	memcpy(buffer.data(), &header, sizeof(header));
+	if ( tilesSize )
+	{
+		memcpy(buffer.data() + header.tilesOffset, data.tiles.data(), tilesSize);
+	}
+	if ( spawnsSize )
+	{
+		memcpy(buffer.data() + header.spawnsOffset, data.spawns.data(), spawnsSize);
+	}
+	if ( statsSize )
+	{
+		memcpy(buffer.data() + header.statsOffset, data.stats.data(), statsSize);
+	}
+
+	const std::string dir = std::string(outputdir) + "/mapcache";
+	if ( access(dir.c_str(), F_OK) == -1 )
+	{
+#ifdef WINDOWS
+		CreateDirectoryA(dir.c_str(), nullptr);
+#else
+		mkdir(dir.c_str(), 0777);
+#endif
+	}
+	const std::string path = compiledMapPath(sourcePath);
+	File* fp = FileIO::open(path.c_str(), "wb");
+	if ( !fp )
+	{
+		printlog("[MAP CACHE]: failed to write '%s'", path.c_str());
+		return;
+	}
+	fp->write(buffer.data(), sizeof(Uint8), buffer.size());
+	FileIO::close(fp);
+}
+
+// compiles every level in maps/ ahead of time, skipping the ones that are current
+static ConsoleCommand ccmd_compileMaps("/compile_maps", "build the compiled map cache for every .lmp in maps/",
+	[](int argc, const char** argv){
+	int count = 0;
+	for ( auto& f : directoryContents("maps/", false, true) )
+	{
+		if ( f.size() < 4 || f.compare(f.size() - 4, 4, ".lmp") )
+		{
+			continue;
+		}
+		const std::string mapPath = "maps/" + f;
+		auto path = PHYSFS_getRealDir(mapPath.c_str());
+		if ( !path )
+		{
+			continue;
+		}
+		map_t m;
+		m.tiles = nullptr;
+		m.entities = (list_t*)malloc(sizeof(list_t));
+		m.entities->first = nullptr;
+		m.entities->last = nullptr;
+		m.creatures = new list_t;
+		m.creatures->first = nullptr;
+		m.creatures->last = nullptr;
+		m.worldUI = nullptr;
+		const std::string fullMapPath = path + (PHYSFS_getDirSeparator() + mapPath);
+		if ( loadMap(fullMapPath.c_str(), &m, m.entities, m.creatures) >= 0 )
+		{
+			++count;
+		}
+		list_FreeAll(m.entities);
+		free(m.entities);
+		list_FreeAll(m.creatures);
+		delete m.creatures;
+		if ( m.tiles )
+		{
+			free(m.tiles);
+		}
+	}
+	messagePlayer(clientnum, MESSAGE_MISC, "compiled %d maps", count);
+	});
+#endif
+
+// frees what belongs to the level currently in the main map: its lights,
+// world UI, tiles and camera vismaps. entities are freed by the caller
+static void releaseMainMap()
+{
+	// remove old lights
+	list_FreeAll(&light_l);
+	// remove old world UI
+	if ( map.worldUI )
+	{
+		list_FreeAll(map.worldUI);
+	}
+	if ( map.tiles != nullptr )
+	{
+		free(map.tiles);
+		map.tiles = nullptr;
+	}
+#ifdef EDITOR
+	if ( camera.vismap != nullptr )
+	{
+		free(camera.vismap);
+		camera.vismap = nullptr;
+	}
+#endif
+	if ( menucam.vismap != nullptr )
+	{
+		free(menucam.vismap);
+		menucam.vismap = nullptr;
+	}
+	for ( int i = 0; i < MAXPLAYERS; ++i )
+	{
+		if ( cameras[i].vismap != nullptr )
+		{
+			free(cameras[i].vismap);
+			cameras[i].vismap = nullptr;
+		}
+	}
+}
+
+// resets the lightmaps, minimap, cameras and shop area for a level that has
+// just been placed in the main map
+static void setupMainMap(const char* oldmapname)
+{
+	Sint32 x, y;
+
+	nummonsters = 0;
+	minotaurlevel = 0;
+
+#if defined (USE_FMOD) || defined(USE_OPENAL)
+	if ( strcmp(oldmapname, map.name) )
+	{
+		if ( gameModeManager.getMode() != GameModeManager_t::GAME_MODE_TUTORIAL
+			&& gameModeManager.getMode() != GameModeManager_t::GAME_MODE_TUTORIAL_INIT )
+		{
+			levelmusicplaying = false;
+		}
+	}
+#endif
+
+	// create new lightmap
+    for (int c = 0; c < MAXPLAYERS + 1; ++c) {
+        auto& lightmap = lightmaps[c];
+        auto& lightmapSmoothed = lightmapsSmoothed[c];
+        lightmap.resize(map.width * map.height);
+        lightmapSmoothed.resize((map.width + 2) * (map.height + 2));
+        if ( strncmp(map.name, "Hell", 4) )
+        {
+            memset(lightmap.data(), 0, sizeof(vec4_t) * map.width * map.height);
+            memset(lightmapSmoothed.data(), 0, sizeof(vec4_t) * (map.width + 2) * (map.height + 2));
+        }
+        else
+        {
+            for (int c = 0; c < map.width * map.height; c++ )
+            {
+                lightmap[c].x = hellAmbience;
+                lightmap[c].y = hellAmbience;
+                lightmap[c].z = hellAmbience;
+#ifndef EDITOR
+                if ( svFlags & SV_FLAG_CHEATS )
+                {
+                    lightmap[c].x = *cvar_hell_ambience;
+                    lightmap[c].y = *cvar_hell_ambience;
+                    lightmap[c].z = *cvar_hell_ambience;
+                }
+#endif
+            }
+            for (int c = 0; c < (map.width + 2) * (map.height + 2); c++ )
+            {
+                lightmapSmoothed[c].x = hellAmbience;
+                lightmapSmoothed[c].y = hellAmbience;
+                lightmapSmoothed[c].z = hellAmbience;
+#ifndef EDITOR
+                if ( svFlags & SV_FLAG_CHEATS )
+                {
+                    lightmapSmoothed[c].x = *cvar_hell_ambience;
+                    lightmapSmoothed[c].y = *cvar_hell_ambience;
+                    lightmapSmoothed[c].z = *cvar_hell_ambience;
+                }
+#endif
+            }
+        }
+    }
+
+	// reset minimap
+	for ( x = 0; x < MINIMAP_MAX_DIMENSION; x++ )
+	{
+		for ( y = 0; y < MINIMAP_MAX_DIMENSION; y++ )
+		{
+			minimap[y][x] = 0;
+		}
+	}
+
+	// reset cameras
+	for (int c = 0; c < MAXPLAYERS; ++c) {
+		auto& camera = cameras[c];
+		if ( game )
+		{
+			camera.x = -32;
+			camera.y = -32;
+			camera.z = 0;
+			camera.ang = 3 * PI / 2;
+			camera.vang = 0;
+		}
+		else
+		{
+			camera.x = 2;
+			camera.y = 2;
+			camera.z = 0;
+			camera.ang = 0;
+			camera.vang = 0;
+		}
+	}
+
+	// shoparea
+	if ( shoparea )
+	{
+		free(shoparea);
+	}
+	shoparea = (bool*) malloc(sizeof(bool) * map.width * map.height);
+	for ( x = 0; x < map.width; x++ )
+	{
+		for ( y = 0; y < map.height; y++ )
+		{
+			shoparea[y + x * map.height] = false;
+		}
+	}
+}
+
+int loadMap(const char* filename2, map_t* destmap, list_t* entlist, list_t* creatureList, int *checkMapHash)
+{
+	File* fp = nullptr;
+	Uint32 numentities = 0;
+	Uint32 c;
+	int editorVersion = 0;
+	char filename[1024];
+	int mapHashData = 0;
+	if ( checkMapHash )
+	{
+		*checkMapHash = 0;
+	}
+
+	char oldmapname[64];
+	strcpy(oldmapname, map.name);
+
+	printlog("LoadMap %s", filename2);
+
+	if (! (filename2 && filename2[0]))
+	{
+		printlog("map filename empty or null");
+		return -1;
+	}
+
+	if ( !PHYSFS_isInit() )
+	{
+		strcpy(filename, "maps/");
+		strcat(filename, filename2);
+	}
+	else
+	{
+		strcpy(filename, filename2);
+	}
+
+
+	// add extension if missing
+	if ( strstr(filename, ".lmp") == nullptr )
+	{
+		strcat(filename, ".lmp");
+	}
+
+	// load the file! the game uses the compiled form while it's current
+#ifdef COMPILED_MAPS
+	char sourcePath[PATH_MAX];
+	completePath(sourcePath, filename);
+	MappedFile compiledMap;
+	if ( !openCompiledMap(sourcePath, compiledMap) )
+#endif
+	{
+		if ( (fp = openMapLMP(filename, editorVersion)) == nullptr )
+		{
+			if ( destmap == &map && game )
+			{
+				printlog("error: main map failed to load, aborting.\n");
+				mainloop = 0;
+			}
+			return -1;
+		}
+	}
+
+	list_FreeAll(entlist);
+
+	if ( destmap == &map )
+	{
+		releaseMainMap();
+	}
+	else if ( destmap->tiles != nullptr )
+	{
+		free(destmap->tiles);
+		destmap->tiles = nullptr;
+	}
+
+	CompiledMapData_t compiledData;
+	bool compileMap = false;
+	if ( fp )
+	{
+#ifdef COMPILED_MAPS
+		// V1.0 maps get stats from setSpriteAttributes, which the stat records don't cover
+		compileMap = *cvar_mapCache && editorVersion >= 2;
+#endif
+		numentities = readMapLMP(fp, editorVersion, destmap, entlist, creatureList, mapHashData, compileMap ? &compiledData : nullptr);
+		FileIO::close(fp);
+	}
+#ifdef COMPILED_MAPS
+	else
+	{
+		numentities = readCompiledMap(compiledMap, destmap, entlist, creatureList, mapHashData);
+		compiledMap.close();
+	}
+#endif
+
+	const int mapsize = destmap->width * destmap->height * MAPLAYERS;
+
+    // new as of july 30 2023
+    // fix animated tiles so they always start on the correct index
+    constexpr int numTileAtlases = sizeof(AnimatedTile::indices) / sizeof(AnimatedTile::indices[0]);
+    for (int c = 0; c < mapsize; ++c) {
+        int& tile = destmap->tiles[c];
+        if (animatedtiles[tile]) {
+            auto find = tileAnimations.find(tile);
+            if (find == tileAnimations.end()) {
+                // this is not the correct index!
+                for (const auto& pair : tileAnimations) {
+                    const auto& animation = pair.second;
+                    for (int i = 0; i < numTileAtlases; ++i) {
+                        if (animation.indices[i] == tile) {
+                            tile = animation.indices[0];
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+	if ( destmap == &map )
+	{
+		setupMainMap(oldmapname);
+	}
+
+	std::string mapShortName = filename2;
+	size_t found = mapShortName.rfind("/");
+	if ( found != std::string::npos )
+	{
+		mapShortName = mapShortName.substr(found + 1);
+	}
+	else
+	{
+		found = mapShortName.rfind("\\");
+		if ( found != std::string::npos )
 		{
 			mapShortName = mapShortName.substr(found + 1);
 		}
 	}
 
-	for ( c = 0; c < 512; c++ )
+	if ( destmap == &map )
 	{
-		keystatus[c] = 0;
+		for ( c = 0; c < 512; c++ )
+		{
+			keystatus[c] = 0;
+		}
+		notifyMapTilesReplaced();
 	}
 
 	if ( checkMapHash != nullptr )
@@ -2391,9 +2977,64 @@ int loadMap(const char* filename2, map_t* destmap, list_t* entlist, list_t* crea
     memcpy(destmap->filename, mapShortName.c_str(), size);
     destmap->filename[size] = '\0';
 
+#ifdef COMPILED_MAPS
+	if ( compileMap )
+	{
+		saveCompiledMap(sourcePath, destmap, compiledData, mapHashData);
+	}
+#endif
+
 	return numentities;
 }
 
+/*-------------------------------------------------------------------------------
+
+	adoptMainMap
+
+	makes a level that was built in another map_t (see takeStagedLevel) the
+	main map, with the same housekeeping loadMap() does when it loads into
+	map directly. source is left holding the main map's old, emptied lists
+
+-------------------------------------------------------------------------------*/
+
+void adoptMainMap(map_t& source)
+{
+	char oldmapname[64];
+	strcpy(oldmapname, map.name);
+
+	list_FreeAll(map.entities);
+	releaseMainMap();
+
+	memcpy(map.name, source.name, sizeof(map.name));
+	memcpy(map.author, source.author, sizeof(map.author));
+	memcpy(map.filename, source.filename, sizeof(map.filename));
+	memcpy(map.flags, source.flags, sizeof(map.flags));
+	map.width = source.width;
+	map.height = source.height;
+	map.skybox = source.skybox;
+	map.bossLevel = source.bossLevel;
+	map.tiles = source.tiles;
+	source.tiles = nullptr;
+
+	// entities keep pointers to their lists, so the lists themselves change hands
+	std::swap(map.entities, source.entities);
+	std::swap(map.creatures, source.creatures);
+	map.entities_map.clear();
+	for ( node_t* node = map.entities->first; node != nullptr; node = node->next )
+	{
+		Entity* entity = (Entity*)node->element;
+		map.entities_map.insert({ entity->getUID(), node });
+	}
+
+	allocateMainMapVismaps();
+	setupMainMap(oldmapname);
+	for ( int c = 0; c < 512; c++ )
+	{
+		keystatus[c] = 0;
+	}
+	notifyMapTilesReplaced();
+}
+
 /*-------------------------------------------------------------------------------
 
 	saveMap
@@ -2824,58 +3465,127 @@ std::vector<std::string> getLinesFromDataFile(std::string filename)
 	return lines;
 }
 
-int physfsLoadMapFile(int levelToLoad, Uint32 seed, bool useRandSeed, int* checkMapHash)
+std::string physfsGetLevelsFileLine(int levelToLoad, bool secret)
 {
 	std::string mapsDirectory; // store the full file path here.
 	std::string line = "";
-	if ( loadCustomNextMap.compare("") != 0 )
+	if ( !secret )
 	{
-		line = "map: " + loadCustomNextMap;
-		loadCustomNextMap = "";
+		mapsDirectory = PHYSFS_getRealDir(LEVELSFILE);
+		mapsDirectory.append(PHYSFS_getDirSeparator()).append(LEVELSFILE);
 	}
 	else
 	{
-		if ( !secretlevel )
+		mapsDirectory = PHYSFS_getRealDir(SECRETLEVELSFILE);
+		mapsDirectory.append(PHYSFS_getDirSeparator()).append(SECRETLEVELSFILE);
+	}
+	printlog("Maps directory: %s", mapsDirectory.c_str());
+	std::vector<std::string> levelsList = getLinesFromDataFile(mapsDirectory);
+	if ( levelsList.empty() )
+	{
+		return line;
+	}
+	line = levelsList.front();
+	int levelsCounted = 0;
+	if ( levelToLoad > 0 ) // if level == 0, then load up the first map.
+	{
+		for ( std::vector<std::string>::const_iterator i = levelsList.begin(); i != levelsList.end() && levelsCounted <= levelToLoad; ++i )
 		{
-			mapsDirectory = PHYSFS_getRealDir(LEVELSFILE);
-			mapsDirectory.append(PHYSFS_getDirSeparator()).append(LEVELSFILE);
+			// process i, iterate through all the map levels until currentlevel.
+			line = *i;
+			if ( line[0] == '\n' )
+			{
+				continue;
+			}
+			++levelsCounted;
 		}
-		else
+	}
+	return line;
+}
+
+bool physfsParseLevelsFileLine(const std::string& line, std::string& mapType, std::string& mapName, std::tuple<int, int, int, int>& mapParameters)
+{
+	std::size_t found = line.find(' ');
+	if ( found == std::string::npos )
+	{
+		return false;
+	}
+	mapType = line.substr(0, found);
+	mapName = line.substr(found + 1, line.find('\n'));
+	std::size_t carriageReturn = mapName.find('\r');
+	if ( carriageReturn != std::string::npos )
+	{
+		mapName.erase(carriageReturn);
+		printlog("%s", mapName.c_str());
+	}
+	mapParameters = std::make_tuple(-1, -1, -1, 0);
+	if ( mapType.compare("gen:") == 0 )
+	{
+		std::size_t secretChanceFound = mapName.find(" secret%: ");
+		std::size_t darkmapChanceFound = mapName.find(" darkmap%: ");
+		std::size_t minotaurChanceFound = mapName.find(" minotaur%: ");
+		std::size_t disableNormalExitFound = mapName.find(" noexit");
+		std::string parameterStr = "";
+		if ( secretChanceFound != std::string::npos )
 		{
-			mapsDirectory = PHYSFS_getRealDir(SECRETLEVELSFILE);
-			mapsDirectory.append(PHYSFS_getDirSeparator()).append(SECRETLEVELSFILE);
+			// found a percentage for secret levels to spawn.
+			parameterStr = mapName.substr(secretChanceFound + strlen(" secret%: "));
+			parameterStr = parameterStr.substr(0, parameterStr.find_first_of(" \0"));
+			std::get<LEVELPARAM_CHANCE_SECRET>(mapParameters) = std::stoi(parameterStr);
+			if ( std::get<LEVELPARAM_CHANCE_SECRET>(mapParameters) < 0 || std::get<LEVELPARAM_CHANCE_SECRET>(mapParameters) > 100 )
+			{
+				std::get<LEVELPARAM_CHANCE_SECRET>(mapParameters) = -1;
+			}
 		}
-		printlog("Maps directory: %s", mapsDirectory.c_str());
-		std::vector<std::string> levelsList = getLinesFromDataFile(mapsDirectory);
-		line = levelsList.front();
-		int levelsCounted = 0;
-		if ( levelToLoad > 0 ) // if level == 0, then load up the first map.
+		if ( darkmapChanceFound != std::string::npos )
 		{
-			for ( std::vector<std::string>::const_iterator i = levelsList.begin(); i != levelsList.end() && levelsCounted <= levelToLoad; ++i )
+			// found a percentage for secret levels to spawn.
+			parameterStr = mapName.substr(darkmapChanceFound + strlen(" darkmap%: "));
+			parameterStr = parameterStr.substr(0, parameterStr.find_first_of(" \0"));
+			std::get<LEVELPARAM_CHANCE_DARKNESS>(mapParameters) = std::stoi(parameterStr);
+			if ( std::get<LEVELPARAM_CHANCE_DARKNESS>(mapParameters) < 0 || std::get<LEVELPARAM_CHANCE_DARKNESS>(mapParameters) > 100 )
 			{
-				// process i, iterate through all the map levels until currentlevel.
-				line = *i;
-				if ( line[0] == '\n' )
-				{
-					continue;
-				}
-				++levelsCounted;
+				std::get<LEVELPARAM_CHANCE_DARKNESS>(mapParameters) = -1;
+			}
+		}
+		if ( minotaurChanceFound != std::string::npos )
+		{
+			// found a percentage for secret levels to spawn.
+			parameterStr = mapName.substr(minotaurChanceFound + strlen(" minotaur%: "));
+			parameterStr = parameterStr.substr(0, parameterStr.find_first_of(" \0"));
+			std::get<LEVELPARAM_CHANCE_MINOTAUR>(mapParameters) = std::stoi(parameterStr);
+			if ( std::get<LEVELPARAM_CHANCE_MINOTAUR>(mapParameters) < 0 || std::get<LEVELPARAM_CHANCE_MINOTAUR>(mapParameters) > 100 )
+			{
+				std::get<LEVELPARAM_CHANCE_MINOTAUR>(mapParameters) = -1;
 			}
 		}
+		if ( disableNormalExitFound != std::string::npos )
+		{
+			std::get<LEVELPARAM_DISABLE_NORMAL_EXIT>(mapParameters) = 1;
+		}
+		mapName = mapName.substr(0, mapName.find_first_of(" \0"));
 	}
-	std::size_t found = line.find(' ');
+	return true;
+}
+
+int physfsLoadMapFile(int levelToLoad, Uint32 seed, bool useRandSeed, int* checkMapHash)
+{
+	std::string line = "";
+	if ( loadCustomNextMap.compare("") != 0 )
+	{
+		line = "map: " + loadCustomNextMap;
+		loadCustomNextMap = "";
+	}
+	else
+	{
+		line = physfsGetLevelsFileLine(levelToLoad, secretlevel);
+	}
+	std::string mapType;
+	std::string mapName;
+	std::tuple<int, int, int, int> mapParameters;
 	char tempstr[1024];
-	if ( found != std::string::npos )
+	if ( physfsParseLevelsFileLine(line, mapType, mapName, mapParameters) )
 	{
-		std::string mapType = line.substr(0, found);
-		std::string mapName;
-		mapName = line.substr(found + 1, line.find('\n'));
-		std::size_t carriageReturn = mapName.find('\r');
-		if ( carriageReturn != std::string::npos )
-		{
-			mapName.erase(carriageReturn);
-			printlog("%s", mapName.c_str());
-		}
 		if ( mapType.compare("map:") == 0 )
 		{
 			strncpy(tempstr, mapName.c_str(), mapName.length());
@@ -2889,51 +3599,6 @@ int physfsLoadMapFile(int levelToLoad, Uint32 seed, bool useRandSeed, int* check
 		}
 		else if ( mapType.compare("gen:") == 0 )
 		{
-			std::size_t secretChanceFound = mapName.find(" secret%: ");
-			std::size_t darkmapChanceFound = mapName.find(" darkmap%: ");
-			std::size_t minotaurChanceFound = mapName.find(" minotaur%: ");
-			std::size_t disableNormalExitFound = mapName.find(" noexit");
-			std::string parameterStr = "";
-			std::tuple<int, int, int, int> mapParameters = std::make_tuple(-1, -1, -1, 0);
-			if ( secretChanceFound != std::string::npos )
-			{
-				// found a percentage for secret levels to spawn.
-				parameterStr = mapName.substr(secretChanceFound + strlen(" secret%: "));
-				parameterStr = parameterStr.substr(0, parameterStr.find_first_of(" \0"));
-				std::get<LEVELPARAM_CHANCE_SECRET>(mapParameters) = std::stoi(parameterStr);
-				if ( std::get<LEVELPARAM_CHANCE_SECRET>(mapParameters) < 0 || std::get<LEVELPARAM_CHANCE_SECRET>(mapParameters) > 100 )
-				{
-					std::get<LEVELPARAM_CHANCE_SECRET>(mapParameters) = -1;
-				}
-			}
-			if ( darkmapChanceFound != std::string::npos )
-			{
-				// found a percentage for secret levels to spawn.
-				parameterStr = mapName.substr(darkmapChanceFound + strlen(" darkmap%: "));
-				parameterStr = parameterStr.substr(0, parameterStr.find_first_of(" \0"));
-				std::get<LEVELPARAM_CHANCE_DARKNESS>(mapParameters) = std::stoi(parameterStr);
-				if ( std::get<LEVELPARAM_CHANCE_DARKNESS>(mapParameters) < 0 || std::get<LEVELPARAM_CHANCE_DARKNESS>(mapParameters) > 100 )
-				{
-					std::get<LEVELPARAM_CHANCE_DARKNESS>(mapParameters) = -1;
-				}
-			}
-			if ( minotaurChanceFound != std::string::npos )
-			{
-				// found a percentage for secret levels to spawn.
-				parameterStr = mapName.substr(minotaurChanceFound + strlen(" minotaur%: "));
-				parameterStr = parameterStr.substr(0, parameterStr.find_first_of(" \0"));
-				std::get<LEVELPARAM_CHANCE_MINOTAUR>(mapParameters) = std::stoi(parameterStr);
-				if ( std::get<LEVELPARAM_CHANCE_MINOTAUR>(mapParameters) < 0 || std::get<LEVELPARAM_CHANCE_MINOTAUR>(mapParameters) > 100 )
-				{
-					std::get<LEVELPARAM_CHANCE_MINOTAUR>(mapParameters) = -1;
-				}
-			}
-			if ( disableNormalExitFound != std::string::npos )
-			{
-				std::get<LEVELPARAM_DISABLE_NORMAL_EXIT>(mapParameters) = 1;
-			}
-			mapName = mapName.substr(0, mapName.find_first_of(" \0"));
-
 			strncpy(tempstr, mapName.c_str(), mapName.length());
 			tempstr[mapName.length()] = '\0';
 			if ( useRandSeed )
@@ -269,6 +269,30 @@ public:
 	}
 };
 
+// Read-only view of a whole file for data that is used in place, such as
+// compiled maps. Memory-mapped where the platform allows, otherwise read
+// into memory in one go.
+class MappedFile {
+public:
+	MappedFile() {}
+	~MappedFile() { close(); }
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// @param path complete path to the file to map
+	// @return true if the file exists, is not empty and could be mapped
+	bool open(const char* path);
+	void close();
+
+	const Uint8* data() const { return _data; }
+	size_t size() const { return _size; }
+
+private:
+	const Uint8* _data = nullptr;
+	size_t _size = 0;
+	std::vector<Uint8> _buffer; // used when the file can't be mapped
+};
+
 enum HolidayTheme {
     THEME_NONE,
     THEME_HALLOWEEN,
@@ -292,6 +316,7 @@ SDL_Surface* loadImage(char const * const filename);
 voxel_t* loadVoxel(char* filename2);
 bool verifyMapHash(const char* filename, int hash, bool* fileExistsInTable = nullptr);
 int loadMap(const char* filename, map_t* destmap, list_t* entlist, list_t* creatureList, int *checkMapHash = nullptr);
+void adoptMainMap(map_t& source); // makes a level built in another map_t the main map
 int loadConfig(char* filename);
 int loadDefaultConfig();
 int saveMap(const char* filename);
@@ -304,6 +329,8 @@ bool completePath(char *dest, const char * const path, const char *base = datadi
 void openLogFile();
 std::vector<std::string> getLinesFromDataFile(std::string filename);
 int loadMainMenuMap(bool blessedAdditionMaps, bool forceVictoryMap, int forcemap = -1);
+std::string physfsGetLevelsFileLine(int levelToLoad, bool secret); // the levels.txt (or secret_levels.txt) entry for a level
+bool physfsParseLevelsFileLine(const std::string& line, std::string& mapType, std::string& mapName, std::tuple<int, int, int, int>& mapParameters); // false if the entry is malformed
 int physfsLoadMapFile(int levelToLoad, Uint32 seed, bool useRandSeed, int *checkMapHash = nullptr);
 std::list<std::string> physfsGetFileNamesInDirectory(const char* dir);
 std::string physfsFormatMapName(char const * const levelfilename);
@@ -57,6 +57,7 @@
 
 #include <atomic>
 #include <future>
+#include <mutex>
 #include <thread>
 
 #ifdef LINUX
@@ -230,6 +231,7 @@ std::vector<std::string> randomPlayerNamesFemale;
 std::vector<std::string> randomNPCNamesMale;
 std::vector<std::string> randomNPCNamesFemale;
 std::vector<std::string> physFSFilesInDirectory;
+CircuitNetlist_t CircuitNetlist; // declared first so it outlives TileEntityList
 TileEntityListHandler TileEntityList;
 // recommended for valgrind debugging:
 // res of 480x270
@@ -288,6 +290,9 @@ bool TimerExperiments::bUseTimerInterpolation = true;
 bool TimerExperiments::bIsInit = false;
 bool TimerExperiments::bDebug = false;
 real_t TimerExperiments::lerpFactor = 30.0;
+TimerExperiments::InterpolatedList TimerExperiments::interpolatedLists[2];
+int TimerExperiments::frontInterpolatedList = 0;
+static Uint32 nextInterpolatedListId = 1;
 void preciseSleep(double seconds);
 
 void TimerExperiments::integrate(TimerExperiments::State& state,
@@ -321,6 +326,20 @@ void TimerExperiments::updateEntityInterpolationPosition(Entity* entity)
 		return;
 	}
 
+	const int back = frontInterpolatedList ^ 1;
+	auto& list = interpolatedLists[back];
+	auto& slot = entity->lerpListSlots[back];
+	if ( list.id == 0 )
+	{
+		list.id = nextInterpolatedListId++;
+	}
+	if ( slot.id != list.id ) // entities can be visited more than once per tick
+	{
+		slot.id = list.id;
+		slot.index = (Uint32)list.entities.size();
+		list.entities.push_back(entity);
+	}
+
 	if ( entity->bNeedsRenderPositionInit )
 	{
 		// wait for entity to position itself in the world by setting useful x/y vlues (monster limbs etc)
@@ -562,6 +581,31 @@ void TimerExperiments::reset()
 
 }
 
+void TimerExperiments::swapInterpolatedLists()
+{
+	frontInterpolatedList ^= 1;
+	auto& back = interpolatedLists[frontInterpolatedList ^ 1];
+	back.entities.clear();
+	back.id = nextInterpolatedListId++;
+	if ( back.id == 0 )
+	{
+		back.id = nextInterpolatedListId++;
+	}
+}
+
+void TimerExperiments::removeFromInterpolatedLists(Entity* entity)
+{
+	for ( int c = 0; c < 2; ++c )
+	{
+		auto& slot = entity->lerpListSlots[c];
+		auto& list = interpolatedLists[c];
+		if ( slot.id && slot.id == list.id && slot.index < list.entities.size() )
+		{
+			list.entities[slot.index] = nullptr;
+		}
+	}
+}
+
 
 void TimerExperiments::updateClocks()
 {
@@ -633,15 +677,7 @@ void TimerExperiments::updateClocks()
 		}
 	}
 
-	std::vector<Entity*> entitiesToInterpolate;
-	for ( node_t* node = map.entities->first; node != nullptr; node = node->next )
-	{
-		Entity* entity = (Entity*)node->element;
-		if ( entity->bUseRenderInterpolation )
-		{
-			entitiesToInterpolate.push_back(entity);
-		}
-	}
+	auto& entitiesToInterpolate = interpolatedEntities();
 
 	while ( accumulator >= dt )
 	{
@@ -655,8 +691,12 @@ void TimerExperiments::updateClocks()
 			integrate(cameraCurrentState[i].pitch, timepoint, dt);
 			integrate(cameraCurrentState[i].roll, timepoint, dt);
 		}
-		for ( auto& entity : entitiesToInterpolate )
+		for ( auto entity : entitiesToInterpolate )
 		{
+			if ( !entity )
+			{
+				continue;
+			}
 			entity->lerpPreviousState = entity->lerpCurrentState;
 			integrate(entity->lerpCurrentState.x, timepoint, dt);
 			integrate(entity->lerpCurrentState.y, timepoint, dt);
@@ -695,8 +735,12 @@ void TimerExperiments::updateClocks()
 		//real_t adiff = a2 - a1;
 		//cameraRenderState[i].yaw.position = a1 + alpha * (fmod(3 * PI + fmod(adiff, 2 * PI), 2 * PI) - PI);
 	}
-	for ( auto& entity : entitiesToInterpolate )
+	for ( auto entity : entitiesToInterpolate )
 	{
+		if ( !entity )
+		{
+			continue;
+		}
 		entity->lerpRenderState = entity->lerpCurrentState * alpha + entity->lerpPreviousState * (1.0 - alpha);
 		// make sure these are limited to prevent large jumps
 		entity->lerpCurrentState.yaw.normalize(0, 2 * PI);
@@ -754,6 +798,267 @@ enum DemoMode {
 static DemoMode demo_mode = DemoMode::STOPPED;
 static File* demo_file = nullptr;
 
+// /demo_bench replays a demo (or runs a scenario script with no input)
+// as fast as the simulation allows and writes a timing report at the end.
+static struct DemoBenchmark
+{
+    bool running = false;
+    bool quitWhenDone = false;  // -bench= exits once the report is written
+    Uint32 tickLimit = 0;       // 0 = run until the demo ends
+    Uint32 ticksRun = 0;
+    std::string source;         // demo or scenario being run
+    std::string scenario;       // script to run on the first tick (scenarios only)
+    std::string reportPath;
+    std::chrono::high_resolution_clock::time_point start;
+} demo_benchmark;
+
+static ConsoleVariable<int> cvar_demo_bench_ticks("/demo_bench_ticks", 3000,
+    "number of ticks a /demo_bench scenario runs for");
+static ConsoleVariable<int> cvar_demo_bench_seed("/demo_bench_seed", 1234,
+    "RNG seed used by /demo_bench scenarios");
+static ConsoleVariable<int> cvar_demo_bench_batch("/demo_bench_batch", 50,
+    "ticks simulated per main loop cycle while /demo_bench runs");
+
+bool BenchmarkTimers::active = false;
+const char* BenchmarkTimers::subsystemNames[NUM_SUBSYSTEMS] = {
+    "pathing",
+    "collision",
+    "lighting",
+    "net_serialize",
+};
+BenchmarkTimers::Timing BenchmarkTimers::subsystems[NUM_SUBSYSTEMS];
+std::map<std::pair<void (*)(Entity*), int>, BenchmarkTimers::Timing> BenchmarkTimers::behaviors;
+int BenchmarkTimers::Scope::depth[NUM_SUBSYSTEMS] = { 0 };
+
+void BenchmarkTimers::reset() {
+    for (auto& timing : subsystems) {
+        timing = Timing();
+    }
+    for (auto& count : Scope::depth) {
+        count = 0;
+    }
+    behaviors.clear();
+}
+
+BenchmarkTimers::Scope::Scope(Subsystem _subsystem, const char* zoneName):
+    subsystem(_subsystem),
+    zone(zoneName)
+{
+    // level loading runs on its own thread and isn't part of the measurement
+    if (!active || loading) {
+        return;
+    }
+    entered = true;
+    if (depth[subsystem]++ == 0) {
+        timing = true;
+        start = std::chrono::high_resolution_clock::now();
+    }
+}
+
+BenchmarkTimers::Scope::~Scope() {
+    if (!entered) {
+        return;
+    }
+    --depth[subsystem];
+    if (timing) {
+        auto& result = subsystems[subsystem];
+        result.totalMs += 1000.0 * std::chrono::duration_cast<std::chrono::duration<double>>(
+            std::chrono::high_resolution_clock::now() - start).count();
+        ++result.calls;
+    }
+}
+
+// Profiler zone names have to outlive the trace. The behaviors that run
+// every tick in numbers get readable names here; everything else is keyed
+// on its address and the generated name is kept for the rest of the session.
+static const char* benchmarkBehaviorName(void (*behavior)(Entity*)) {
+    static const std::unordered_map<void (*)(Entity*), const char*> names = {
+        {&actPlayer, "actPlayer"},
+        {&actPlayerLimb, "actPlayerLimb"},
+        {&actMonster, "actMonster"},
+        {&actItem, "actItem"},
+        {&actGib, "actGib"},
+        {&actDamageGib, "actDamageGib"},
+        {&actArrow, "actArrow"},
+        {&actMagicMissile, "actMagicMissile"},
+        {&actMagicParticle, "actMagicParticle"},
+        {&actFlame, "actFlame"},
+        {&actSprite, "actSprite"},
+        {&actTorch, "actTorch"},
+        {&actDoor, "actDoor"},
+        {&actDoorFrame, "actDoorFrame"},
+        {&actGate, "actGate"},
+        {&actChest, "actChest"},
+        {&actBoulder, "actBoulder"},
+        {&actFountain, "actFountain"},
+        {&actSink, "actSink"},
+        {&actHudWeapon, "actHudWeapon"},
+        {&actHudArm, "actHudArm"},
+        {&actHudShield, "actHudShield"},
+    };
+    if (!behavior) {
+        return "none";
+    }
+    auto find = names.find(behavior);
+    if (find != names.end()) {
+        return find->second;
+    }
+    static std::mutex unnamedMutex;
+    static std::unordered_map<void (*)(Entity*), std::string> unnamed;
+    std::lock_guard<std::mutex> lock(unnamedMutex);
+    auto& name = unnamed[behavior];
+    if (name.empty()) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "behavior@%p", (void*)behavior);
+        name = buf;
+    }
+    return name.c_str();
+}
+
+BenchmarkTimers::BehaviorScope::BehaviorScope(const Entity* entity):
+    behavior(active ? entity->behavior : nullptr)
+{
+    if (Profiler::recording.load(std::memory_order_relaxed)) {
+        zone.begin(benchmarkBehaviorName(entity->behavior));
+    }
+    if (!behavior) {
+        return;
+    }
+    if (behavior == &actMonster) {
+        monsterType = (int)entity->getMonsterTypeFromSprite();
+    }
+    start = std::chrono::high_resolution_clock::now();
+}
+
+BenchmarkTimers::BehaviorScope::~BehaviorScope() {
+    if (!behavior || !active) {
+        return;
+    }
+    auto& result = behaviors[{behavior, monsterType}];
+    result.totalMs += 1000.0 * std::chrono::duration_cast<std::chrono::duration<double>>(
+        std::chrono::high_resolution_clock::now() - start).count();
+    ++result.calls;
+}
+
+// FNV-1a over the parts of the world a desync would show up in. Two runs of
+// the same demo on the same build should always produce the same value.
+static Uint64 worldStateHash() {
+    Uint64 hash = 14695981039346656037ull;
+    auto mix = [&hash](const void* data, size_t size){
+        auto bytes = (const Uint8*)data;
+        for (size_t c = 0; c < size; ++c) {
+            hash ^= bytes[c];
+            hash *= 1099511628211ull;
+        }
+    };
+    mix(&currentlevel, sizeof(currentlevel));
+    if (map.tiles) {
+        mix(map.tiles, sizeof(Sint32) * map.width * map.height * MAPLAYERS);
+    }
+    for (node_t* node = map.entities->first; node != nullptr; node = node->next) {
+        auto entity = (Entity*)node->element;
+        const Uint32 uid = entity->getUID();
+        mix(&uid, sizeof(uid));
+        mix(&entity->sprite, sizeof(entity->sprite));
+        mix(&entity->x, sizeof(entity->x));
+        mix(&entity->y, sizeof(entity->y));
+        mix(&entity->z, sizeof(entity->z));
+        mix(&entity->yaw, sizeof(entity->yaw));
+        if (Stat* entitystats = entity->getStats()) {
+            mix(&entitystats->HP, sizeof(entitystats->HP));
+            mix(&entitystats->MP, sizeof(entitystats->MP));
+            mix(&entitystats->LVL, sizeof(entitystats->LVL));
+            mix(&entitystats->EXP, sizeof(entitystats->EXP));
+            mix(&entitystats->GOLD, sizeof(entitystats->GOLD));
+        }
+    }
+    return hash;
+}
+
+static void demo_bench_finish() {
+    BenchmarkTimers::active = false;
+    demo_benchmark.running = false;
+
+    const double wallMs = 1000.0 * std::chrono::duration_cast<std::chrono::duration<double>>(
+        std::chrono::high_resolution_clock::now() - demo_benchmark.start).count();
+    const Uint32 ticksRun = std::max(demo_benchmark.ticksRun, 1u);
+    const Uint64 hash = worldStateHash();
+    char hashStr[17];
+    snprintf(hashStr, sizeof(hashStr), "%016llx", (unsigned long long)hash);
+
+    // collapse behaviors into readable names
+    std::map<std::string, BenchmarkTimers::Timing> behaviors;
+    for (auto& it : BenchmarkTimers::behaviors) {
+        std::string name = benchmarkBehaviorName(it.first.first);
+        if (it.first.first == &actMonster && it.first.second > 0 && it.first.second < NUMMONSTERS) {
+            name.append(":");
+            name.append(monstertypename[it.first.second]);
+        }
+        auto& result = behaviors[name];
+        result.totalMs += it.second.totalMs;
+        result.calls += it.second.calls;
+    }
+
+    printlog("[bench] %s: %u ticks in %.1f ms (%.3f ms/tick), world hash %s",
+        demo_benchmark.source.c_str(), demo_benchmark.ticksRun, wallMs, wallMs / ticksRun, hashStr);
+    messagePlayer(clientnum, MESSAGE_MISC, "Benchmark: %u ticks, %.3f ms/tick, hash %s",
+        demo_benchmark.ticksRun, wallMs / ticksRun, hashStr);
+
+    char path[PATH_MAX];
+    completePath(path, demo_benchmark.reportPath.c_str(), outputdir);
+    File* fp = FileIO::open(path, "wb");
+    if (!fp) {
+        printlog("[bench] failed to open report file '%s'", path);
+    } else {
+        const bool json = demo_benchmark.reportPath.size() >= 5 &&
+            demo_benchmark.reportPath.compare(demo_benchmark.reportPath.size() - 5, 5, ".json") == 0;
+        if (json) {
+            fp->printf("{\n");
+            fp->printf("\t\"source\": \"%s\",\n", demo_benchmark.source.c_str());
+            fp->printf("\t\"ticks\": %u,\n", demo_benchmark.ticksRun);
+            fp->printf("\t\"wall_ms\": %.3f,\n", wallMs);
+            fp->printf("\t\"ms_per_tick\": %.4f,\n", wallMs / ticksRun);
+            fp->printf("\t\"world_hash\": \"%s\",\n", hashStr);
+            fp->printf("\t\"subsystems\": {\n");
+            for (int c = 0; c < BenchmarkTimers::NUM_SUBSYSTEMS; ++c) {
+                auto& result = BenchmarkTimers::subsystems[c];
+                fp->printf("\t\t\"%s\": {\"calls\": %u, \"total_ms\": %.3f, \"ms_per_tick\": %.4f}%s\n",
+                    BenchmarkTimers::subsystemNames[c], result.calls, result.totalMs, result.totalMs / ticksRun,
+                    c + 1 < BenchmarkTimers::NUM_SUBSYSTEMS ? "," : "");
+            }
+            fp->printf("\t},\n");
+            fp->printf("\t\"behaviors\": {\n");
+            size_t index = 0;
+            for (auto& it : behaviors) {
+                fp->printf("\t\t\"%s\": {\"calls\": %u, \"total_ms\": %.3f, \"ms_per_tick\": %.4f}%s\n",
+                    it.first.c_str(), it.second.calls, it.second.totalMs, it.second.totalMs / ticksRun,
+                    ++index < behaviors.size() ? "," : "");
+            }
+            fp->printf("\t}\n");
+            fp->printf("}\n");
+        } else {
+            fp->printf("category,name,calls,total_ms,ms_per_tick\n");
+            fp->printf("run,%s,%u,%.3f,%.4f\n", demo_benchmark.source.c_str(), demo_benchmark.ticksRun, wallMs, wallMs / ticksRun);
+            fp->printf("world_hash,%s,,,\n", hashStr);
+            for (int c = 0; c < BenchmarkTimers::NUM_SUBSYSTEMS; ++c) {
+                auto& result = BenchmarkTimers::subsystems[c];
+                fp->printf("subsystem,%s,%u,%.3f,%.4f\n",
+                    BenchmarkTimers::subsystemNames[c], result.calls, result.totalMs, result.totalMs / ticksRun);
+            }
+            for (auto& it : behaviors) {
+                fp->printf("behavior,%s,%u,%.3f,%.4f\n",
+                    it.first.c_str(), it.second.calls, it.second.totalMs, it.second.totalMs / ticksRun);
+            }
+        }
+        FileIO::close(fp);
+        printlog("[bench] wrote report to '%s'", path);
+    }
+
+    if (demo_benchmark.quitWhenDone) {
+        mainloop = 0;
+    }
+}
+
 static void demo_stop() {
     if (demo_mode == DemoMode::STOPPED) {
         messagePlayer(clientnum, MESSAGE_MISC, "Demo is not running");
@@ -761,7 +1066,7 @@ static void demo_stop() {
     }
     switch (demo_mode) {
     case DemoMode::PLAYING:
-        if (demo_file->eof()) {
+        if (demo_file && demo_file->eof()) {
             messagePlayer(clientnum, MESSAGE_MISC, "End of demo");
         } else {
             messagePlayer(clientnum, MESSAGE_MISC, "Stopped demo playback");
@@ -781,6 +1086,10 @@ static void demo_stop() {
     demo_mode = DemoMode::STOPPED;
 
     TimerExperiments::bUseTimerInterpolation = true;
+
+    if (demo_benchmark.running) {
+        demo_bench_finish();
+    }
 }
 
 static void demo_record(const char* filename) {
@@ -871,6 +1180,7 @@ static void demo_play(const char* filename) {
     demo_file->read(&name_len, sizeof(name_len), 1);
     demo_file->read(stats[clientnum]->name, sizeof(char), name_len);
     stats[clientnum]->name[name_len] = '\0';
+    stats[clientnum]->updateAllegianceTags();
 
     // reset player
     stats[clientnum]->clearStats();
@@ -906,6 +1216,79 @@ static ConsoleCommand ccmd_demo_play("/demo_play", "play a recorded demo(default
     }
     });
 
+static void demo_bench(const char* filename, const char* report, Uint32 ticks) {
+    if (demo_mode != DemoMode::STOPPED) {
+        messagePlayer(clientnum, MESSAGE_MISC, "Demo must be stopped first (/demo_stop)");
+        return;
+    }
+
+    if (multiplayer != SINGLE || splitscreen) {
+        messagePlayer(clientnum, MESSAGE_MISC, "Demos not permitted in multiplayer");
+        return;
+    }
+
+    if (strstr(filename, ".cfg")) {
+        // a scenario is a console script run on the first tick, with a
+        // fixed seed and character and no recorded input.
+        char path[PATH_MAX];
+        completePath(path, filename, outputdir);
+        File* fp = FileIO::open(path, "rb");
+        if (!fp) {
+            messagePlayer(clientnum, MESSAGE_MISC, "failed to open scenario file '%s'", path);
+            return;
+        }
+        FileIO::close(fp);
+
+        TimerExperiments::bUseTimerInterpolation = false; // this causes mass desyncs
+
+        uniqueGameKey = (Uint32)*cvar_demo_bench_seed;
+        local_rng.seedBytes(&uniqueGameKey, sizeof(uniqueGameKey));
+        net_rng.seedBytes(&uniqueGameKey, sizeof(uniqueGameKey));
+
+        stats[clientnum]->playerRace = RACE_HUMAN;
+        stats[clientnum]->sex = MALE;
+        stats[clientnum]->appearance = 0;
+        client_classes[clientnum] = CLASS_BARBARIAN;
+        strcpy(stats[clientnum]->name, "Benchmark");
+        stats[clientnum]->clearStats();
+        initClass(clientnum);
+
+        doNewGame(false);
+
+        demo_mode = DemoMode::PLAYING;
+        demo_benchmark.scenario = path;
+        demo_benchmark.tickLimit = ticks ? ticks : (Uint32)std::max(*cvar_demo_bench_ticks, 1);
+    } else {
+        demo_play(filename);
+        if (demo_mode != DemoMode::PLAYING) {
+            return;
+        }
+        demo_benchmark.scenario.clear();
+        demo_benchmark.tickLimit = ticks;
+    }
+
+    messagePlayer(clientnum, MESSAGE_MISC, "Benchmarking '%s'", filename);
+    demo_benchmark.running = true;
+    demo_benchmark.ticksRun = 0;
+    demo_benchmark.source = filename;
+    demo_benchmark.reportPath = report;
+    demo_benchmark.start = std::chrono::high_resolution_clock::now();
+    BenchmarkTimers::reset();
+    BenchmarkTimers::active = true;
+#if !BARONY_PROFILER
+    messagePlayer(clientnum, MESSAGE_MISC, "Built with BARONY_PROFILER=0, subsystem timings will be empty");
+#endif
+}
+
+static ConsoleCommand ccmd_demo_bench("/demo_bench", "replay a demo or .cfg scenario at full speed and write a timing report: /demo_bench <file> [report.csv|report.json] [ticks]",
+    [](int argc, const char* argv[]){
+    if (argc < 2) {
+        demo_bench("demo.dat", "bench.csv", 0);
+    } else {
+        demo_bench(argv[1], argc >= 3 ? argv[2] : "bench.csv", argc >= 4 ? (Uint32)std::max(atoi(argv[3]), 0) : 0);
+    }
+    });
+
 /*-------------------------------------------------------------------------------
 
 	gameLogic
@@ -933,11 +1316,34 @@ void gameLogic(void)
 	Uint32 i = 0, j;
 	bool entitydeletedself;
 
+	PROFILE_ZONE("gameLogic");
+
 #ifdef NINTENDO
 	(void)nxUpdateCrashMessage();
 #endif
 
     if (!gamePaused && !loading) {
+        if (demo_benchmark.running) {
+            if (!demo_benchmark.scenario.empty() && players[clientnum]->entity) {
+                std::vector<char> script(demo_benchmark.scenario.begin(), demo_benchmark.scenario.end());
+                script.push_back('\0');
+                demo_benchmark.scenario.clear();
+                loadConfig(script.data());
+            }
+            if (!demo_file) {
+                // scenarios have no recorded input, so hold everything still
+                for (auto& key : Input::keys) {
+                    key.second = false;
+                }
+                for (auto& key : keystatus) {
+                    key.second = false;
+                }
+                memset(Input::mouseButtons, 0, sizeof(Input::mouseButtons));
+                memset(mousestatus, 0, sizeof(mousestatus));
+                mousexrel = 0;
+                mouseyrel = 0;
+            }
+        }
         if (demo_file) {
             // demo recording
             if (demo_mode == DemoMode::RECORDING) {
@@ -966,8 +1372,20 @@ void gameLogic(void)
                 }
             }
         }
+        if (demo_benchmark.running) {
+            ++demo_benchmark.ticksRun;
+            if (demo_benchmark.tickLimit && demo_benchmark.ticksRun >= demo_benchmark.tickLimit) {
+                demo_stop();
+            }
+        }
     }
 
+	if ( !gamePaused && !loading )
+	{
+		// parse one of the next level's rooms ahead of time
+		updateRoomTemplatePrefetch();
+	}
+
 	for (auto& input : Input::inputs) {
 		input.update();
 		input.consumeBindingsSharedWithFaceHotbar();
@@ -1173,6 +1591,7 @@ void gameLogic(void)
 			//printlog("Packet resend: %d", packet->hostnum);
 			sendPacket(packet->sock, packet->channel, packet->packet, packet->hostnum, true);
 			packet->tries++;
+			NetTrafficStats.countSafeResend(*packet, packet->tries >= MAXTRIES);
 			if ( packet->tries >= MAXTRIES )
 			{
 				list_RemoveNode(node);
@@ -1731,6 +2150,7 @@ void gameLogic(void)
 							{
 								printlog("DEBUG: Starting Entity sprite: %d", entity->sprite);
 							}*/
+							BENCHMARK_BEHAVIOR(entity);
 							(*entity->behavior)(entity);
 						}
 						if ( entitiesdeleted.first != nullptr )
@@ -1978,7 +2398,7 @@ void gameLogic(void)
 					}
 
 					// signal clients about level change
-					mapseed = local_rng.rand();
+					mapseed = nextLevelSeed();
 					lastEntityUIDs = entity_uids;
 					if ( forceMapSeed > 0 )
 					{
@@ -2080,12 +2500,18 @@ void gameLogic(void)
 	                createLevelLoadScreen(5);
 	                std::atomic_bool loading_done {false};
 	                auto loading_task = std::async(std::launch::async, [&loading_done](){
+					    // the staged level's thread reads gameplayCustomManager, so take it before reloading that
+					    int result = 0;
+					    const bool staged = takeStagedLevel(currentlevel, secretlevel, mapseed, result);
 					    gameplayCustomManager.readFromFile();
 					    textSourceScript.scriptVariables.clear();
 	                    updateLoadingScreen(10);
 
 					    int checkMapHash = -1;
-					    int result = physfsLoadMapFile(currentlevel, mapseed, false, &checkMapHash);
+					    if ( !staged )
+					    {
+						    result = physfsLoadMapFile(currentlevel, mapseed, false, &checkMapHash);
+					    }
 					    if (!verifyMapHash(map.filename, checkMapHash))
 					    {
 						    conductGameChallenges[CONDUCT_MODDED] = 1;
@@ -2114,6 +2540,9 @@ void gameLogic(void)
 		            loading = false;
 	                int result = loading_task.get();
 
+                    // start generating the next floor while this one is played
+                    stageNextLevel();
+
                     for (int c = 0; c < MAXPLAYERS; ++c) {
                         auto& camera = players[c]->camera();
 					    camera.globalLightModifierActive = GLOBAL_LIGHT_MODIFIER_STOPPED;
@@ -2540,6 +2969,8 @@ void gameLogic(void)
 					ShopkeeperPlayerHostility.serverSendClientUpdate(forceUpdate);
 				}
 
+				serverFlushSoundEvents();
+
 				// send entity info to clients
 				if ( ticks % (TICKS_PER_SECOND / 8) == 0 )
 				{
@@ -3607,6 +4038,113 @@ static void bindControllerToPlayer(int id, int player) {
     }
 }
 
+// lists the main thread's most expensive profiler zones over the last second
+static void drawProfilerOverlay()
+{
+	if ( !Profiler::recording )
+	{
+		printTextFormatted(font8x8_bmp, 8, 32, "profiler is not recording (/profiler_start)");
+		return;
+	}
+	static std::vector<std::pair<const char*, double>> zones;
+	static Uint32 lastUpdate = 0;
+	if ( zones.empty() || SDL_GetTicks() - lastUpdate >= 500 )
+	{
+		lastUpdate = SDL_GetTicks();
+		Profiler::getTopZones(zones, 16);
+	}
+	printTextFormatted(font8x8_bmp, 8, 32, "zone (main thread)            ms/sec");
+	int y = 44;
+	for ( auto& zone : zones )
+	{
+		printTextFormatted(font8x8_bmp, 8, y, "%-28.28s %8.2f", zone.first, zone.second);
+		y += 10;
+	}
+}
+
+/*-------------------------------------------------------------------------------
+
+	headless server
+
+	-headless runs the simulation and network code with nothing drawn or
+	played, hosting a direct-connect lobby on -port= (or the configured
+	port). Time spent in gameLogic() is recorded per tick and summarized
+	in the log every /headless_report_interval seconds.
+
+-------------------------------------------------------------------------------*/
+
+static Uint16 headlessPort = 0;
+static std::string benchmarkFile; // -bench=, run /demo_bench on startup and quit
+static std::string benchmarkReport = "bench.csv";
+
+static struct HeadlessTickStats
+{
+	Uint32 ticks = 0;
+	double totalMs = 0.0;
+	double maxMs = 0.0;
+	Uint32 lastReport = 0;
+} headlessTickStats;
+
+static ConsoleVariable<int> cvar_headless_report_interval("/headless_report_interval", 10,
+	"seconds between per-tick timing reports when running headless (0 disables)");
+
+static void recordHeadlessTick(const std::chrono::high_resolution_clock::time_point& start)
+{
+	const double ms = 1000.0 * std::chrono::duration_cast<std::chrono::duration<double>>(
+		std::chrono::high_resolution_clock::now() - start).count();
+	auto& stats = headlessTickStats;
+	++stats.ticks;
+	stats.totalMs += ms;
+	stats.maxMs = std::max(stats.maxMs, ms);
+}
+
+static void reportHeadlessTicks()
+{
+	auto& stats = headlessTickStats;
+	const int interval = *cvar_headless_report_interval;
+	if ( interval <= 0 || SDL_GetTicks() - stats.lastReport < (Uint32)interval * 1000 )
+	{
+		return;
+	}
+	stats.lastReport = SDL_GetTicks();
+	if ( stats.ticks )
+	{
+		int connected = 0;
+		for ( int c = 0; c < MAXPLAYERS; ++c )
+		{
+			if ( !client_disconnected[c] )
+			{
+				++connected;
+			}
+		}
+		printlog("[headless] %u ticks, avg %.3f ms, max %.3f ms (%s, %d player(s), level %d)",
+			stats.ticks, stats.totalMs / stats.ticks, stats.maxMs,
+			intro ? "lobby" : "ingame", connected, currentlevel);
+	}
+	stats.ticks = 0;
+	stats.totalMs = 0.0;
+	stats.maxMs = 0.0;
+}
+
+static void doHeadlessFrame()
+{
+	// nothing is drawn, but the menu tree is still processed so the
+	// lobby's network handling and ready-state callbacks keep running.
+	if ( intro || gamePaused )
+	{
+		MainMenu::doMainMenu(!intro);
+	}
+	else
+	{
+		MainMenu::destroyMainMenu();
+	}
+	if ( gui )
+	{
+		(void)gui->process();
+	}
+	reportHeadlessTicks();
+}
+
 bool handleEvents(void)
 {
 	double d;
@@ -3651,6 +4189,12 @@ bool handleEvents(void)
 		numframes = max_frames;
 	}
 
+	// benchmarks run as many ticks as the machine can manage
+	if (demo_benchmark.running && !loading) {
+		numframes = std::max(1, *cvar_demo_bench_batch);
+		time_diff = 0.0;
+	}
+
 	// calculate fps
 	if ( timesync != 0 )
 	{
@@ -4725,7 +5269,13 @@ bool handleEvents(void)
 	{
 		if (!loading && initialized)
 		{
+			const auto tickStart = std::chrono::high_resolution_clock::now();
 			gameLogic();
+			TimerExperiments::swapInterpolatedLists();
+			if (headless)
+			{
+				recordHeadlessTick(tickStart);
+			}
 			++ticks;
 		}
 		else
@@ -6572,6 +7122,24 @@ int main(int argc, char** argv)
 					{
 						no_sound = true;
 					}
+					else if ( !strcmp(argv[c], "-headless") )
+					{
+						headless = true;
+						no_sound = true;
+						fullscreen = 0;
+					}
+					else if ( !strncmp(argv[c], "-port=", 6) )
+					{
+						headlessPort = (Uint16)std::min(std::max(atoi(argv[c] + 6), 0), 65535);
+					}
+					else if ( !strncmp(argv[c], "-bench=", 7) )
+					{
+						benchmarkFile = argv[c] + 7;
+					}
+					else if ( !strncmp(argv[c], "-benchout=", 10) )
+					{
+						benchmarkReport = argv[c] + 10;
+					}
 					else
 					{
 #ifdef USE_EOS
@@ -6585,6 +7153,12 @@ int main(int argc, char** argv)
 		printlog("Output path is %s", outputdir);
         
         // init sdl
+        if ( headless )
+        {
+            // no display is required: render into an offscreen surface instead
+            SDL_setenv("SDL_VIDEODRIVER", "offscreen", 1);
+            printlog("running headless\n");
+        }
         Uint32 init_flags = SDL_INIT_VIDEO | SDL_INIT_EVENTS;
         init_flags |= SDL_INIT_JOYSTICK | SDL_INIT_GAMECONTROLLER | SDL_INIT_HAPTIC;
         if (SDL_Init(init_flags) == -1)
@@ -6605,6 +7179,12 @@ int main(int argc, char** argv)
 		else {
 			skipintro = false;
 		}
+		if ( headless ) {
+			skipintro = true;
+			if ( headlessPort ) {
+				portnumber = headlessPort;
+			}
+		}
 
 		// initialize map
 		map.tiles = nullptr;
@@ -6688,6 +7268,33 @@ int main(int argc, char** argv)
 		//inputs.setPlayerIDAllowedKeyboard(-1);
 #endif
 
+		if ( !benchmarkFile.empty() )
+		{
+			// skip the logos and title screen and go straight to the benchmark
+			introstage = 1;
+			numplayers = 0;
+			multiplayer = SINGLE;
+			demo_benchmark.quitWhenDone = true;
+			demo_bench(benchmarkFile.c_str(), benchmarkReport.c_str(), 0);
+			if ( !demo_benchmark.running )
+			{
+				printlog("[bench] failed to start benchmark '%s', exiting.\n", benchmarkFile.c_str());
+				deinitGame();
+				return deinitApp();
+			}
+		}
+		else if ( headless )
+		{
+			// skip the logos and title screen and go straight to a lobby
+			introstage = 1;
+			if ( !MainMenu::hostHeadlessLobby() )
+			{
+				printlog("[headless] failed to host a lobby on port %d, exiting.\n", (int)portnumber);
+				deinitGame();
+				return deinitApp();
+			}
+		}
+
 		// play splash sound
 #ifdef MUSIC
 		playMusic(splashmusic, false, false, false);
@@ -6700,6 +7307,7 @@ int main(int argc, char** argv)
 		printlog("running main loop.\n");
 		while (mainloop)
 		{
+			PROFILE_ZONE("mainloop");
 			Frame::numFindFrameCalls = 0;
 			// record the time at the start of this cycle
 			lastGameTickCount = SDL_GetPerformanceCounter();
@@ -6780,6 +7388,23 @@ int main(int argc, char** argv)
 
 			DebugStats.t3SteamCallbacks = std::chrono::high_resolution_clock::now();
 
+			if ( headless )
+			{
+				doHeadlessFrame();
+
+				// no vsync or display to pace us, so run at the fixed tick rate
+				while ( !demo_benchmark.running && frameRateLimit(TICKS_PER_SECOND, true, true) )
+				{
+					if ( !intro && multiplayer == SERVER )
+					{
+						serverHandleMessages(TICKS_PER_SECOND);
+					}
+				}
+				Text::dumpCacheInMainLoop();
+				cycles++;
+				continue;
+			}
+
 #ifdef USE_IMGUI
 			ImGui_t::update();
 #endif
@@ -7152,10 +7777,9 @@ int main(int argc, char** argv)
 					//cameras[0].y = players[0]->entity->y / 16.0;//TimerExperiments::cameraRenderState.y.position;
 					//cameras[0].z = TimerExperiments::cameraRenderState.z.position;
 					//printTextFormatted(font8x8_bmp, 8, 20, "%s", timerOutput.c_str());
-					for ( node_t* node = map.entities->first; node; node = node->next )
+					for ( auto entity : TimerExperiments::interpolatedEntities() )
 					{
-						entity = (Entity*)node->element;
-						if ( entity->bUseRenderInterpolation )
+						if ( entity && entity->bUseRenderInterpolation )
 						{
 							entity->lerp_ox = entity->x;
 							entity->lerp_oy = entity->y;
@@ -7187,10 +7811,9 @@ int main(int argc, char** argv)
 
 				if ( TimerExperiments::bUseTimerInterpolation )
 				{
-					for ( node_t* node = map.entities->first; node; node = node->next )
+					for ( auto entity : TimerExperiments::interpolatedEntities() )
 					{
-						entity = (Entity*)node->element;
-						if ( entity->bUseRenderInterpolation )
+						if ( entity && entity->bUseRenderInterpolation )
 						{
 							entity->x = entity->lerp_ox;
 							entity->y = entity->lerp_oy;
@@ -7375,6 +7998,18 @@ int main(int argc, char** argv)
 			DebugTimers.printAllTimepoints();
 			DebugTimers.clearAllTimepoints();
 
+			static ConsoleVariable<bool> cvar_profiler_overlay("/profiler_overlay", false);
+			if ( *cvar_profiler_overlay )
+			{
+				drawProfilerOverlay();
+			}
+
+			static ConsoleVariable<bool> cvar_netstats_overlay("/netstats_overlay", false);
+			if ( *cvar_netstats_overlay && multiplayer != SINGLE )
+			{
+				NetTrafficStats.drawOverlay();
+			}
+
 			static ConsoleVariable<bool> cvar_frame_search_count("/framesearchcount", false);
 			if ( *cvar_frame_search_count )
 			{
@@ -7407,7 +8042,7 @@ int main(int argc, char** argv)
 			}
 
 			// frame rate limiter
-			while ( frameRateLimit(fpsLimit, true, true) )
+			while ( !demo_benchmark.running && frameRateLimit(fpsLimit, true, true) )
 			{
 				if ( !intro )
 				{
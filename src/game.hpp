@@ -12,6 +12,8 @@
 #pragma once
 
 #include <vector>
+#include <map>
+#include <unordered_map>
 #include <chrono>
 
 #ifdef STEAMWORKS
@@ -20,6 +22,7 @@
 #endif
 
 #include "interface/consolecommand.hpp"
+#include "profiler.hpp"
 
 #include "Config.hpp"
 
@@ -53,6 +56,7 @@ typedef struct packetsend_t
 	int num;
 	int tries;
 	int hostnum;
+	Uint32 sendtime; // SDL_GetTicks() of the first send
 } packetsend_t;
 extern list_t safePacketsSent;
 extern std::unordered_map<int, Uint32> safePacketsReceivedMap[MAXPLAYERS];
@@ -408,6 +412,23 @@ public:
 };
 extern TileEntityListHandler TileEntityList;
 
+/*
+ * Cached circuit topology: for each circuit/switch that has propagated power,
+ * the powerables on its own tile and the 4 neighboring tiles. Filled lazily and
+ * thrown away whenever a powerable joins, moves between or leaves the tiles of
+ * TileEntityList, so it always matches what a fresh tile scan would find.
+ */
+class CircuitNetlist_t
+{
+	bool dirty = true;
+	std::unordered_map<Entity*, std::vector<Entity*>> neighbors;
+public:
+	const std::vector<Entity*>& getNeighbors(Entity& entity);
+	void removeEntity(Entity& entity);
+	void invalidate() { dirty = true; }
+};
+extern CircuitNetlist_t CircuitNetlist;
+
 class DebugStatsClass
 {
 public:
@@ -520,6 +541,70 @@ public:
 extern ConsoleVariable<bool> cvar_enableKeepAlives;
 
 extern DebugStatsClass DebugStats;
+
+// Inclusive time spent in a few simulation subsystems, collected while a
+// /demo_bench run is active. Only the outermost call of each subsystem is
+// timed so recursion and nesting aren't counted twice. Every scope is also
+// a profiler zone, named after the function it times.
+class BenchmarkTimers
+{
+public:
+	enum Subsystem : int
+	{
+		PATHING,
+		COLLISION,
+		LIGHTING,
+		NET_SERIALIZE,
+		NUM_SUBSYSTEMS
+	};
+	static const char* subsystemNames[NUM_SUBSYSTEMS];
+
+	struct Timing
+	{
+		double totalMs = 0.0;
+		Uint32 calls = 0;
+	};
+	static bool active;
+	static Timing subsystems[NUM_SUBSYSTEMS];
+	static std::map<std::pair<void (*)(Entity*), int>, Timing> behaviors; // (behavior, monster type)
+	static void reset();
+
+	class Scope
+	{
+		Subsystem subsystem;
+		bool timing = false;
+		bool entered = false;
+		std::chrono::high_resolution_clock::time_point start;
+		Profiler::Scope zone;
+		static int depth[NUM_SUBSYSTEMS];
+	public:
+		Scope(Subsystem _subsystem, const char* zoneName);
+		~Scope();
+	};
+
+	// times one call of an entity's behavior function, keyed by behavior
+	// (and by monster type for actMonster)
+	class BehaviorScope
+	{
+		void (*behavior)(Entity*);
+		int monsterType = 0;
+		std::chrono::high_resolution_clock::time_point start;
+		Profiler::Scope zone;
+	public:
+		BehaviorScope(const Entity* _entity);
+		~BehaviorScope();
+	};
+};
+
+// benchmark scopes are profiler zones too, so they compile out with BARONY_PROFILER
+#if BARONY_PROFILER
+#define BENCHMARK_SCOPE(subsystem, name) BenchmarkTimers::Scope PROFILE_CONCAT(benchmarkScope, __LINE__)(BenchmarkTimers::subsystem, name)
+#define BENCHMARK_BEHAVIOR(entity) BenchmarkTimers::BehaviorScope PROFILE_CONCAT(benchmarkBehavior, __LINE__)(entity)
+#else
+#define BENCHMARK_SCOPE(subsystem, name)
+#define BENCHMARK_BEHAVIOR(entity)
+#endif
+
 //extern ConsoleVariable<bool> cvar_useTimerInterpolation;
 
 #include "draw.hpp"
@@ -605,6 +690,26 @@ public:
 	static EntityStates cameraCurrentState[MAXPLAYERS];
 	static EntityStates cameraRenderState[MAXPLAYERS];
 
+	// cache of the entities the latest simulation tick interpolated, so
+	// updateClocks() and the draw loop don't walk every entity on the map.
+	// each tick fills the back list, swapInterpolatedLists() makes it the
+	// front one. these are the live entities, not copies of their state
+	struct InterpolatedList
+	{
+		Uint32 id = 0;
+		std::vector<Entity*> entities; // deleted entities are nulled out
+	};
+	struct InterpolatedListSlot
+	{
+		Uint32 id = 0;     // list the entity was last added to
+		Uint32 index = 0;  // its position in that list
+	};
+	static InterpolatedList interpolatedLists[2];
+	static int frontInterpolatedList;
+	static const std::vector<Entity*>& interpolatedEntities() { return interpolatedLists[frontInterpolatedList].entities; }
+	static void swapInterpolatedLists();
+	static void removeFromInterpolatedLists(Entity* entity);
+
 	static std::string render(State state);
 
 	static void reset();
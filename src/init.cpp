@@ -1553,6 +1553,11 @@ bool initVideo()
         if (borderless) {
             flags |= SDL_WINDOW_BORDERLESS;
         }
+        if (headless) {
+            // the context is still needed to load assets, but nothing is ever shown
+            flags &= ~(SDL_WINDOW_FULLSCREEN | SDL_WINDOW_RESIZABLE);
+            flags |= SDL_WINDOW_HIDDEN;
+        }
 #endif
 
 		positionAndLimitWindow(screen_x, screen_y, screen_width, screen_height);
@@ -417,6 +417,9 @@ void deinitGame()
 	// destroy enemy hp bar textures
 	EnemyHPDamageBarHandler::dumpCache();
 
+	// free cached dungeon rooms
+	clearRoomTemplateCache();
+
 	// send disconnect messages
 	if (multiplayer != SINGLE) {
 	    if ( multiplayer == CLIENT )
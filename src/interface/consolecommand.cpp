@@ -1912,6 +1912,7 @@ namespace ConsoleCommands {
 					stats[i]->appearance = local_rng.rand() % 18;
 				}
 				strcpy(stats[i]->name, randomPlayerNamesFemale[local_rng.rand() % randomPlayerNamesFemale.size()].c_str());
+				stats[i]->updateAllegianceTags();
 				bool oldIntro = intro;
 				intro = true; // so initClass doesn't add items to hotbar.
 				initClass(i);
@@ -4609,7 +4610,12 @@ namespace ConsoleCommands {
         if (argc < 2) {
             return;
         }
-        loadMap(argv[1], &map, map.entities, map.creatures, nullptr);
+        // accept bare map names ("minetown") as well as full paths
+        std::string path = physfsFormatMapName(argv[1]);
+        if (path.empty()) {
+            path = argv[1];
+        }
+        loadMap(path.c_str(), &map, map.entities, map.creatures, nullptr);
         numplayers = 0;
         assignActions(&map);
     });
@@ -4659,6 +4665,7 @@ namespace ConsoleCommands {
 
         // initialize class
         strcpy(stats[clientnum]->name, "Avatar");
+        stats[clientnum]->updateAllegianceTags();
         stats[clientnum]->playerRace = RACE_HUMAN;
         stats[clientnum]->sex = static_cast<sex_t>(local_rng.rand() % 2);
         stats[clientnum]->appearance = local_rng.rand() % NUMAPPEARANCES;
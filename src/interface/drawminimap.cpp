@@ -40,6 +40,8 @@ SDL_Rect minimaps[MAXPLAYERS];
 
 static TempTexture* minimapTextures[MAXPLAYERS] = { nullptr };
 static SDL_Surface* minimapSurfaces[MAXPLAYERS] = { nullptr };
+static std::vector<Sint8> minimapTexels[MAXPLAYERS]; // tile index each texel was last drawn with, -1 if never
+static int minimapTexelsTransparency[MAXPLAYERS] = { 0 };
 
 static Mesh circle_mesh;
 static Mesh triangle_mesh = {
@@ -84,6 +86,7 @@ void cleanupMinimapTextures() {
 			SDL_FreeSurface(minimapSurfaces[c]);
 			minimapSurfaces[c] = nullptr;
 		}
+		minimapTexels[c].clear();
 	}
     circle_mesh.destroy();
     triangle_mesh.destroy();
@@ -130,10 +133,28 @@ void drawMinimap(const int player, SDL_Rect rect, bool drawingSharedMap)
         minimap_shader.link();
     }
 
-	// create a new minimap image
-	SDL_Surface* minimapSurface = SDL_CreateRGBSurface(0, mapGCD, mapGCD, 32,
-		0xff000000, 0x00ff0000, 0x0000ff00, 0x000000ff);
-	assert(minimapSurface);
+	// (re)create the minimap image if the map size changed
+	SDL_Surface*& minimapSurface = minimapSurfaces[player];
+	bool fullUpload = false;
+	if ( !minimapSurface || minimapSurface->w != mapGCD || minimapSurface->h != mapGCD ) {
+		if ( minimapSurface ) {
+			SDL_FreeSurface(minimapSurface);
+		}
+		minimapSurface = SDL_CreateRGBSurface(0, mapGCD, mapGCD, 32,
+			0xff000000, 0x00ff0000, 0x0000ff00, 0x000000ff);
+		assert(minimapSurface);
+		minimapTexels[player].clear();
+		fullUpload = true;
+	}
+
+	// texels are only redrawn when their tile index changes, so a change of
+	// transparency has to redraw everything
+	auto& texels = minimapTexels[player];
+	const int transparency = minimapTransparencyBackground * 1000 + minimapTransparencyForeground;
+	if ( texels.size() != (size_t)(mapGCD * mapGCD) || minimapTexelsTransparency[player] != transparency ) {
+		texels.assign(mapGCD * mapGCD, -1);
+		minimapTexelsTransparency[player] = transparency;
+	}
 	SDL_LockSurface(minimapSurface);
 
 	std::vector<Entity*> entityPointsOfInterest;
@@ -201,83 +222,73 @@ void drawMinimap(const int player, SDL_Rect rect, bool drawingSharedMap)
 	const int xmax = map.width - xmin;
 	const int ymin = ((int)map.height - mapGCD) / 2;
 	const int ymax = map.height - ymin;
+	const Uint8 backgroundAlpha = 255 * ((100 - minimapTransparencyBackground) / 100.f);
+	const Uint8 foregroundAlpha = 255 * ((100 - minimapTransparencyForeground) / 100.f);
+	int dirtyRowMin = mapGCD;
+	int dirtyRowMax = -1;
 	for ( int x = xmin; x < xmax; ++x ) {
 		for ( int y = ymin; y < ymax; ++y ) {
-			Uint32 color = 0;
-			Uint8 backgroundAlpha = 255 * ((100 - minimapTransparencyBackground) / 100.f);
-			Uint8 foregroundAlpha = 255 * ((100 - minimapTransparencyForeground) / 100.f);
-			auto foundCustomWall = customWalls.find(x + y * 10000);
-			if ( x < 0 || y < 0 || x >= map.width || y >= map.height )
+			Sint8 mapIndex = 0; // out-of-bounds draws the same as unknown
+			if ( x >= 0 && y >= 0 && x < map.width && y < map.height )
 			{
-				// out-of-bounds
-				color = makeColor(0, 64, 64, backgroundAlpha);
-			}
-			else
-			{
-				Sint8 mapIndex = minimap[y][x];
-				if ( foundCustomWall != customWalls.end() )
+				mapIndex = minimap[y][x];
+				if ( !customWalls.empty() && customWalls.find(x + y * 10000) != customWalls.end() )
 				{
 					if ( mapIndex == 1 ) { mapIndex = 2; } // force walkable to wall
 					else if ( mapIndex == 3 ) { mapIndex = 4; } // force undiscovered walkable to wall
 				}
+			}
 
-				if ( mapIndex == 0 )
-				{
-					// unknown / no floor
-					color = makeColor(0, 64, 64, backgroundAlpha);
-				}
-				else if ( mapIndex == 1 )
-				{
-					// walkable space
-					color = makeColor(0, 128, 128, foregroundAlpha);
-				}
-				else if ( mapIndex == 2 )
-				{
-					// wall
-					color = makeColor(0, 255, 255, foregroundAlpha);
-				}
-				else if ( mapIndex == 3 )
-				{
-					// mapped but undiscovered walkable ground
-					color = makeColor(64, 64, 64, foregroundAlpha);
-				}
-				else if ( mapIndex == 4 )
-				{
-					// mapped but undiscovered wall
-					color = makeColor(128, 128, 128, foregroundAlpha);
-				}
+			Sint8& texel = texels[(y - ymin) * mapGCD + (x - xmin)];
+			if ( texel == mapIndex )
+			{
+				continue;
+			}
+			texel = mapIndex;
+
+			Uint32 color = 0;
+			if ( mapIndex == 0 )
+			{
+				// unknown / no floor
+				color = makeColor(0, 64, 64, backgroundAlpha);
+			}
+			else if ( mapIndex == 1 )
+			{
+				// walkable space
+				color = makeColor(0, 128, 128, foregroundAlpha);
+			}
+			else if ( mapIndex == 2 )
+			{
+				// wall
+				color = makeColor(0, 255, 255, foregroundAlpha);
+			}
+			else if ( mapIndex == 3 )
+			{
+				// mapped but undiscovered walkable ground
+				color = makeColor(64, 64, 64, foregroundAlpha);
+			}
+			else if ( mapIndex == 4 )
+			{
+				// mapped but undiscovered wall
+				color = makeColor(128, 128, 128, foregroundAlpha);
 			}
 			putPixel(minimapSurface, x - xmin, y - ymin, color);
+			dirtyRowMin = std::min(dirtyRowMin, y - ymin);
+			dirtyRowMax = std::max(dirtyRowMax, y - ymin);
 		}
 	}
+	SDL_UnlockSurface(minimapSurface);
 
-	// upload minimap image to an OpenGL texture, if it is different
-	if ( minimapSurfaces[player] ) {
-		SDL_LockSurface(minimapSurfaces[player]);
+	// upload only the rows of the minimap image that changed
+	if ( !minimapTextures[player] ) {
+		minimapTextures[player] = new TempTexture();
+		fullUpload = true;
 	}
-	auto m1 = minimapSurface;
-	auto m2 = minimapSurfaces[player];
-	const auto size1 = m1->w * m1->h * m1->format->BytesPerPixel;
-	const auto size2 = m2 ? (m2->w * m2->h * m2->format->BytesPerPixel) : 0;
-	if ( size1 != size2 || memcmp(m1, m2, size2) ) {
-		if ( !minimapTextures[player] ) {
-			minimapTextures[player] = new TempTexture();
-		}
+	if ( fullUpload ) {
 		minimapTextures[player]->load(minimapSurface, false, true);
-		if ( minimapSurfaces[player] ) {
-			SDL_UnlockSurface(minimapSurfaces[player]);
-			SDL_FreeSurface(minimapSurfaces[player]);
-		}
-		SDL_UnlockSurface(minimapSurface);
-		minimapSurfaces[player] = minimapSurface;
 	}
-	else {
-		if ( minimapSurfaces[player] ) {
-			SDL_UnlockSurface(minimapSurfaces[player]);
-		}
-		SDL_UnlockSurface(minimapSurface);
-		SDL_FreeSurface(minimapSurface);
-		minimapSurface = nullptr;
+	else if ( dirtyRowMax >= 0 ) {
+		minimapTextures[player]->loadRows(minimapSurface, dirtyRowMin, dirtyRowMax - dirtyRowMin + 1);
 	}
     
     auto tex = minimapTextures[player];
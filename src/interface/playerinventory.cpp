@@ -4271,6 +4271,7 @@ void Player::HUD_t::updateFrameTooltip(Item* item, const int x, const int y, int
     if ( bUpdateDisplayedTooltip )
     {
         tooltipDisplayedSettings.updateItem(player, item);
+        ItemTooltips.updateStatVersion(player);
         
         std::string tooltipType = ItemTooltips.tmpItems[item->type].tooltip;
         
@@ -4282,7 +4283,7 @@ void Player::HUD_t::updateFrameTooltip(Item* item, const int x, const int y, int
         {
             tooltipType = "tooltip_unidentified";
         }
-        auto itemTooltip = ItemTooltips.tooltips[tooltipType];
+        auto& itemTooltip = ItemTooltips.tooltips[tooltipType];
         
         int textx = 0;
         int texty = 0;
@@ -4551,13 +4552,22 @@ void Player::HUD_t::updateFrameTooltip(Item* item, const int x, const int y, int
             }
         }
         
+        // itemTooltip is the shared definition, look widths up without inserting missing keys
+        auto getTooltipWidth = [](const std::map<std::string, int>& widths, const std::string& key) {
+            auto find = widths.find(key);
+            return find != widths.end() ? find->second : 0;
+        };
+        const int minWidth = getTooltipWidth(itemTooltip.minWidths, minWidthKey);
+        const int maxWidth = getTooltipWidth(itemTooltip.maxWidths, maxWidthKey);
+        const int headerMaxWidth = getTooltipWidth(itemTooltip.headerMaxWidths, headerMaxWidthKey);
+        
         bool useDefaultHeaderHeight = true;
         if ( manuallyInsertedNewline ||
-            (itemTooltip.headerMaxWidths[headerMaxWidthKey] > 0 && textx > itemTooltip.headerMaxWidths[headerMaxWidthKey]) )
+            (headerMaxWidth > 0 && textx > headerMaxWidth) )
         {
             if ( !manuallyInsertedNewline )
             {
-                txtHeader->setSize(SDL_Rect{ 0, 0, itemTooltip.headerMaxWidths[headerMaxWidthKey], 0 });
+                txtHeader->setSize(SDL_Rect{ 0, 0, headerMaxWidth, 0 });
                 txtHeader->reflowTextToFit(0);
             }
             
@@ -4623,32 +4633,32 @@ void Player::HUD_t::updateFrameTooltip(Item* item, const int x, const int y, int
             tooltipMin->pos = SDL_Rect{
                 imgTopBackgroundLeft->pos.x + imgTopBackgroundLeft->pos.w + padx,
                 2,
-                itemTooltip.minWidths[minWidthKey],
+                minWidth,
                 1 };
             tooltipMin->disabled = false;
             auto tooltipMax = frameMain->findImage("inventory mouse tooltip max");
             tooltipMax->pos = SDL_Rect{
                 imgTopBackgroundLeft->pos.x + imgTopBackgroundLeft->pos.w + padx,
                 4,
-                itemTooltip.maxWidths[maxWidthKey],
+                maxWidth,
                 1 };
             tooltipMax->disabled = false;
             auto headerMax = frameMain->findImage("inventory mouse tooltip header max");
             headerMax->pos = SDL_Rect{
                 imgTopBackgroundLeft->pos.x + imgTopBackgroundLeft->pos.w + padx,
                 6,
-                itemTooltip.headerMaxWidths[headerMaxWidthKey],
+                headerMaxWidth,
                 1 };
             headerMax->disabled = false;
         }
         
-        if ( itemTooltip.minWidths[minWidthKey] > 0 )
+        if ( minWidth > 0 )
         {
-            textx = std::max(itemTooltip.minWidths[minWidthKey], textx);
+            textx = std::max(minWidth, textx);
         }
-        if ( itemTooltip.maxWidths[maxWidthKey] > 0 )
+        if ( maxWidth > 0 )
         {
-            textx = std::min(itemTooltip.maxWidths[maxWidthKey], textx);
+            textx = std::min(maxWidth, textx);
         }
         
         if ( ItemTooltips.itemDebug )
@@ -5023,14 +5033,6 @@ void Player::HUD_t::updateFrameTooltip(Item* item, const int x, const int y, int
             txtAttributes->setDisabled(false);
             txtAttributes->setColor(itemTooltip.descriptionTextColor);
             int index = 0;
-            for ( auto it = itemTooltip.descriptionText.begin(); it != itemTooltip.descriptionText.end(); ++it )
-            {
-                descriptionTextString += (*it);
-                if ( std::next(it) != itemTooltip.descriptionText.end() )
-                {
-                    descriptionTextString += '\n';
-                }
-            }
             ItemTooltips.formatItemDescription(player, tooltipType, *item, descriptionTextString);
             txtAttributes->setText(descriptionTextString.c_str());
             
@@ -5226,10 +5228,9 @@ void Player::HUD_t::updateFrameTooltip(Item* item, const int x, const int y, int
                              || tag.compare("blank_text_if_armor_has_stats") == 0 )
                     {
                         bool skip = true;
-                        for ( auto it = ItemTooltips.templates["template_attributes_text_armor_conditional_tags"].begin();
-                             it != ItemTooltips.templates["template_attributes_text_armor_conditional_tags"].end(); ++it )
+                        for ( auto& attribute : ItemTooltips.getTemplateLines("template_attributes_text_armor_conditional_tags") )
                         {
-                            if ( items[item->type].hasAttribute(*it) )
+                            if ( items[item->type].hasAttribute(attribute) )
                             {
                                 skip = false;
                                 break;
@@ -5407,14 +5408,6 @@ void Player::HUD_t::updateFrameTooltip(Item* item, const int x, const int y, int
                 }
                 
                 std::string tagText = "";
-                for ( auto it = itemTooltip.detailsText[tag.c_str()].begin(); it != itemTooltip.detailsText[tag.c_str()].end(); ++it )
-                {
-                    tagText += (*it);
-                    if ( std::next(it) != itemTooltip.detailsText[tag.c_str()].end() )
-                    {
-                        tagText += '\n';
-                    }
-                }
                 ItemTooltips.formatItemDetails(player, tooltipType, *item, tagText, tag);
                 if ( detailsTextString.compare("") != 0 )
                 {
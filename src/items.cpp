@@ -27,6 +27,7 @@
 #include "mod_tools.hpp"
 
 #include <assert.h>
+#include <tuple>
 
 Uint32 itemuids = 1;
 ItemGeneric items[NUMITEMS];
@@ -281,137 +282,222 @@ Item* newItem(const ItemType type, const Status status, const Sint16 beatitude,
 
 -------------------------------------------------------------------------------*/
 
+static std::unordered_map<Uint32, Item*> itemUidIndex;
+static bool itemUidIndexDirty = true;
+static Stat* itemUidIndexStats[MAXPLAYERS] = { nullptr };
+static bool itemUidIndexLocal[MAXPLAYERS] = { false };
+
+void itemUidIndexInvalidate()
+{
+	itemUidIndexDirty = true;
+}
+
 Item* uidToItem(const Uint32 uid)
 {
 	if ( uid == 0 )
 	{
 		return nullptr;
 	}
-	for ( int i = 0; i < MAXPLAYERS; ++i )
+
+	// the index is rebuilt lazily whenever a player inventory changes
+	// (see list.cpp), or the set of local players does.
+	for ( int i = 0; i < MAXPLAYERS && !itemUidIndexDirty; ++i )
 	{
-		if ( !players[i]->isLocalPlayer() )
+		if ( itemUidIndexStats[i] != stats[i] || itemUidIndexLocal[i] != players[i]->isLocalPlayer() )
 		{
-			continue;
+			itemUidIndexDirty = true;
 		}
-		for ( node_t* node = stats[i]->inventory.first; node != nullptr; node = node->next )
+	}
+	if ( itemUidIndexDirty )
+	{
+		itemUidIndex.clear();
+		for ( int i = 0; i < MAXPLAYERS; ++i )
 		{
-			Item* item = static_cast<Item*>(node->element);
-			if ( item->uid == uid )
+			itemUidIndexStats[i] = stats[i];
+			itemUidIndexLocal[i] = players[i]->isLocalPlayer();
+			if ( !itemUidIndexLocal[i] )
 			{
-				return item;
+				continue;
+			}
+			for ( node_t* node = stats[i]->inventory.first; node != nullptr; node = node->next )
+			{
+				Item* item = static_cast<Item*>(node->element);
+				if ( item )
+				{
+					itemUidIndex.emplace(item->uid, item); // first match wins, same as a linear search
+				}
 			}
 		}
+		itemUidIndexDirty = false;
+	}
+
+	auto find = itemUidIndex.find(uid);
+	if ( find != itemUidIndex.end() )
+	{
+		return find->second;
 	}
 	return nullptr;
 }
 
 /*-------------------------------------------------------------------------------
 
-	itemCurve
+	item curve tables
 
-	Selects an item type from the given category of items by factoring in
-	dungeon level, value of the item, etc.
+	items of each category in items[] order, and the subset itemCurve()
+	can pick from for the current dungeon level. rebuilt when currentlevel
+	changes or item definitions are reloaded. the candidates are walked in
+	the same order as before so map_rng calls (and thus seeds) are unchanged.
 
 -------------------------------------------------------------------------------*/
 
-ItemType itemCurve(const Category cat)
+static struct ItemCurveTables_t
 {
-	const int numitems = NUMITEMS - ( NUMITEMS - static_cast<int>(ARTIFACT_SWORD) );
-	bool chances[NUMITEMS];
-	int c;
-
-	if ( cat < 0 || cat >= NUMCATEGORIES )
-	{
-		printlog("warning: itemCurve() called with bad category value!\n");
-		return GEM_ROCK;
-	}
+	bool dirty = true;
+	int level = -1;
+	std::vector<ItemType> curveItems[NUMCATEGORIES]; // items below ARTIFACT_SWORD
+	std::vector<ItemType> curveCandidates[NUMCATEGORIES];
+	std::vector<ItemType> levelCurveItems[NUMCATEGORIES]; // all items
+	std::map<std::tuple<int, int, int>, std::vector<ItemType>> levelCurveCandidates;
 
-	// find highest value of items in category
-	Uint32 highestvalue = 0;
-	Uint32 lowestvalue = 0;
-	Uint32 numoftype = 0;
-	for ( c = 0; c < numitems; c++ )
+	void update()
 	{
-		if ( items[c].category == cat )
+		if ( dirty )
 		{
-			highestvalue = std::max<Uint32>(highestvalue, items[c].value); //TODO: Why are Uint32 and int being compared?
-			lowestvalue = std::min<Uint32>(lowestvalue, items[c].value); //TODO: Why are Uint32 and int being compared?
-			numoftype++;
-		}
-	}
-	if ( numoftype == 0 )
-	{
-		printlog("warning: category passed to itemCurve has no items!\n");
-		return GEM_ROCK;
-	}
-
-	if ( cat == SCROLL || cat == POTION || cat == BOOK )
-	{
-		// these item categories will spawn anything of their type
-		for ( c = 0; c < numitems; c++ )
-		{
-			chances[c] = false;
-			if ( items[c].category == cat )
+			for ( int cat = 0; cat < NUMCATEGORIES; ++cat )
 			{
-				chances[c] = true;
+				curveItems[cat].clear();
+				levelCurveItems[cat].clear();
+			}
+			for ( int c = 0; c < NUMITEMS; ++c )
+			{
+				if ( items[c].category < 0 || items[c].category >= NUMCATEGORIES )
+				{
+					continue;
+				}
+				if ( c < static_cast<int>(ARTIFACT_SWORD) )
+				{
+					curveItems[items[c].category].push_back(static_cast<ItemType>(c));
+				}
+				levelCurveItems[items[c].category].push_back(static_cast<ItemType>(c));
 			}
 		}
-	}
-	else if ( cat == TOOL )
-	{
-		// this category will spawn specific items more frequently regardless of level
-		for ( c = 0; c < numitems; c++ )
+		if ( dirty || level != currentlevel )
 		{
-			chances[c] = false;
-			if ( items[c].category == cat )
+			level = currentlevel;
+			levelCurveCandidates.clear();
+			for ( int cat = 0; cat < NUMCATEGORIES; ++cat )
 			{
-				switch ( static_cast<ItemType>(c) )
+				curveCandidates[cat].clear();
+				if ( cat == SCROLL || cat == POTION || cat == BOOK || cat == TOOL )
 				{
-					case TOOL_TINOPENER:
-						if ( map_rng.rand() % 2 )   // 50% chance
-						{
-							chances[c] = true;
-						}
-						break;
-					case TOOL_LANTERN:
-						if ( map_rng.rand() % 4 )   // 75% chance
-						{
-							chances[c] = true;
-						}
-						break;
-					case TOOL_SKELETONKEY:
-						chances[c] = false; // 0% chance
-						break;
-					default:
-						chances[c] = true;
-						break;
+					// these spawn anything of their type (tools are decided per roll)
+					curveCandidates[cat] = curveItems[cat];
+					continue;
+				}
+
+				// other categories get a special chance algorithm based on item value and dungeon level
+				Uint32 highestvalue = 0;
+				Uint32 lowestvalue = 0;
+				for ( auto c : curveItems[cat] )
+				{
+					highestvalue = std::max<Uint32>(highestvalue, items[c].value);
+					lowestvalue = std::min<Uint32>(lowestvalue, items[c].value);
+				}
+				const int acceptablehigh = std::max<Uint32>(highestvalue * fmin(1.0, (currentlevel + 10) / 25.0), lowestvalue);
+				for ( auto c : curveItems[cat] )
+				{
+					if ( items[c].value <= acceptablehigh )
+					{
+						curveCandidates[cat].push_back(c);
+					}
 				}
 			}
 		}
+		dirty = false;
 	}
-	else
+
+	const std::vector<ItemType>& getLevelCurveCandidates(const Category cat, const int minLevel, const int maxLevel)
 	{
-		// other categories get a special chance algorithm based on item value and dungeon level
-		const int acceptablehigh = std::max<Uint32>(highestvalue * fmin(1.0, (currentlevel + 10) / 25.0), lowestvalue); //TODO: Why are double and Uint32 being compared?
-		for ( c = 0; c < numitems; c++ )
+		auto key = std::make_tuple(static_cast<int>(cat), minLevel, maxLevel);
+		auto find = levelCurveCandidates.find(key);
+		if ( find != levelCurveCandidates.end() )
+		{
+			return find->second;
+		}
+		auto& candidates = levelCurveCandidates[key];
+		for ( auto c : levelCurveItems[cat] )
 		{
-			chances[c] = false;
-			if ( items[c].category == cat && items[c].value <= acceptablehigh )
+			if ( items[c].level != -1 && (items[c].level >= minLevel && items[c].level <= maxLevel) )
 			{
-				chances[c] = true;
+				candidates.push_back(c);
 			}
 		}
+		return candidates;
 	}
+} itemCurveTables;
 
-	// calculate number of items left
-	Uint32 numleft = 0;
-	for ( c = 0; c < numitems; c++ )
+void itemCurveTablesInvalidate()
+{
+	itemCurveTables.dirty = true;
+}
+
+/*-------------------------------------------------------------------------------
+
+	itemCurve
+
+	Selects an item type from the given category of items by factoring in
+	dungeon level, value of the item, etc.
+
+-------------------------------------------------------------------------------*/
+
+ItemType itemCurve(const Category cat)
+{
+	if ( cat < 0 || cat >= NUMCATEGORIES )
 	{
-		if ( chances[c] == true )
+		printlog("warning: itemCurve() called with bad category value!\n");
+		return GEM_ROCK;
+	}
+
+	itemCurveTables.update();
+	if ( itemCurveTables.curveItems[cat].empty() )
+	{
+		printlog("warning: category passed to itemCurve has no items!\n");
+		return GEM_ROCK;
+	}
+
+	static std::vector<ItemType> rolled;
+	const std::vector<ItemType>* candidates = &itemCurveTables.curveCandidates[cat];
+	if ( cat == TOOL )
+	{
+		// this category will spawn specific items more frequently regardless of level
+		rolled.clear();
+		for ( auto c : *candidates )
 		{
-			numleft++;
+			switch ( c )
+			{
+				case TOOL_TINOPENER:
+					if ( map_rng.rand() % 2 )   // 50% chance
+					{
+						rolled.push_back(c);
+					}
+					break;
+				case TOOL_LANTERN:
+					if ( map_rng.rand() % 4 )   // 75% chance
+					{
+						rolled.push_back(c);
+					}
+					break;
+				case TOOL_SKELETONKEY:
+					break; // 0% chance
+				default:
+					rolled.push_back(c);
+					break;
+			}
 		}
+		candidates = &rolled;
 	}
+
+	const Uint32 numleft = candidates->size();
 	if ( numleft == 0 )
 	{
 		return GEM_ROCK;
@@ -427,26 +513,7 @@ ItemType itemCurve(const Category cat)
 	}
 
 	// pick the item
-	Uint32 pick = map_rng.rand() % numleft;
-	for ( c = 0; c < numitems; c++ )
-	{
-		if ( items[c].category == cat )
-		{
-			if ( chances[c] == true )
-			{
-				if ( pick == 0 )
-				{
-					return static_cast<ItemType>(c);
-				}
-				else
-				{
-					pick--;
-				}
-			}
-		}
-	}
-
-	return GEM_ROCK;
+	return (*candidates)[map_rng.rand() % numleft];
 }
 
 /*-------------------------------------------------------------------------------
@@ -460,78 +527,66 @@ dungeon level and defined level of the item
 
 ItemType itemLevelCurve(const Category cat, const int minLevel, const int maxLevel)
 {
-	const int numitems = NUMITEMS;
-	bool chances[NUMITEMS];
-	int c;
-
 	if ( cat < 0 || cat >= NUMCATEGORIES )
 	{
 		printlog("warning: itemLevelCurve() called with bad category value!\n");
 		return GEM_ROCK;
 	}
 
-	Uint32 numoftype = 0;
-	for ( c = 0; c < numitems; ++c )
+	itemCurveTables.update();
+	const std::vector<ItemType>* candidates = &itemCurveTables.getLevelCurveCandidates(cat, minLevel, maxLevel);
+	if ( candidates->empty() )
 	{
-		chances[c] = false;
-		if ( items[c].category == cat )
+		printlog("warning: category passed to itemLevelCurve has no items!\n");
+		return GEM_ROCK;
+	}
+
+	static std::vector<ItemType> rolled;
+	if ( cat == TOOL || cat == ARMOR )
+	{
+		rolled.clear();
+		for ( auto c : *candidates )
 		{
-			if ( items[c].level != -1 && (items[c].level >= minLevel && items[c].level <= maxLevel) )
+			if ( cat == TOOL )
 			{
-				chances[c] = true;
-				numoftype++;
-				if ( cat == TOOL )
+				switch ( c )
 				{
-					switch ( static_cast<ItemType>(c) )
-					{
-						case TOOL_TINOPENER:
-							if ( map_rng.rand() % 2 )   // 50% chance
-							{
-								chances[c] = false;
-							}
-							break;
-						case TOOL_LANTERN:
-							if ( map_rng.rand() % 4 == 0 )   // 25% chance
-							{
-								chances[c] = false;
-							}
-							break;
-						default:
-							break;
-					}
+					case TOOL_TINOPENER:
+						if ( map_rng.rand() % 2 )   // 50% chance
+						{
+							continue;
+						}
+						break;
+					case TOOL_LANTERN:
+						if ( map_rng.rand() % 4 == 0 )   // 25% chance
+						{
+							continue;
+						}
+						break;
+					default:
+						break;
 				}
-				else if ( cat == ARMOR )
+			}
+			else if ( cat == ARMOR )
+			{
+				switch ( c )
 				{
-					switch ( static_cast<ItemType>(c) )
-					{
-						case CLOAK_BACKPACK:
-							if ( map_rng.rand() % 4 )   // 25% chance
-							{
-								chances[c] = false;
-							}
-							break;
-						default:
-							break;
-					}
+					case CLOAK_BACKPACK:
+						if ( map_rng.rand() % 4 )   // 25% chance
+						{
+							continue;
+						}
+						break;
+					default:
+						break;
 				}
 			}
+			rolled.push_back(c);
 		}
-	}
-	if ( numoftype == 0 )
-	{
-		printlog("warning: category passed to itemLevelCurve has no items!\n");
-		return GEM_ROCK;
+		candidates = &rolled;
 	}
 
-	// calculate number of items left
-	Uint32 numleft = 0;
-	for ( c = 0; c < numitems; c++ )
-	{
-		if ( chances[c] == true )
-		{
-			numleft++;
-		}
-	}
+	const Uint32 numleft = candidates->size();
 	if ( numleft == 0 )
 	{
 		return GEM_ROCK;
@@ -547,27 +602,7 @@ ItemType itemLevelCurve(const Category cat, const int minLevel, const int maxLev
 	}
 
 	// pick the item
-	Uint32 pick = map_rng.rand() % numleft;
-	for ( c = 0; c < numitems; c++ )
-	{
-		if ( items[c].category == cat )
-		{
-			if ( chances[c] == true )
-			{
-				if ( pick == 0 )
-				{
-					//messagePlayer(0, "Chose item: %s of %d items.", items[c].getIdentifiedName() ,numleft);
-					return static_cast<ItemType>(c);
-				}
-				else
-				{
-					pick--;
-				}
-			}
-		}
-	}
-
-	return GEM_ROCK;
+	return (*candidates)[map_rng.rand() % numleft];
 }
 
 /*-------------------------------------------------------------------------------
@@ -5387,6 +5422,7 @@ void copyItem(Item* const itemToSet, const Item* const itemToCopy) //This should
 	itemToSet->appearance = itemToCopy->appearance;
 	itemToSet->identified = itemToCopy->identified;
 	itemToSet->uid = itemToCopy->uid;
+	itemUidIndexInvalidate();
 	itemToSet->ownerUid = itemToCopy->ownerUid;
 	itemToSet->isDroppable = itemToCopy->isDroppable;
 }
@@ -12,6 +12,9 @@
 #include "main.hpp"
 #include "light.hpp"
 #include "draw.hpp"
+#ifndef EDITOR
+#include "game.hpp"
+#endif
 
 /*-------------------------------------------------------------------------------
 
@@ -24,6 +27,9 @@
 
 light_t* lightSphereShadow(int index, Sint32 x, Sint32 y, Sint32 radius, float r, float g, float b, float exp)
 {
+#ifndef EDITOR
+	BENCHMARK_SCOPE(LIGHTING, "lightSphereShadow");
+#endif
 	light_t* light = newLight(index, x, y, radius);
     r = r * 255.f;
     g = g * 255.f;
@@ -133,6 +139,9 @@ light_t* lightSphereShadow(int index, Sint32 x, Sint32 y, Sint32 radius, float r
 
 light_t* lightSphere(int index, Sint32 x, Sint32 y, Sint32 radius, float r, float g, float b, float exp)
 {
+#ifndef EDITOR
+	BENCHMARK_SCOPE(LIGHTING, "lightSphere");
+#endif
 	light_t* light = newLight(index, x, y, radius);
     r = r * 255.f;
     g = g * 255.f;
@@ -14,6 +14,94 @@
 #include "items.hpp"
 #include "interface/interface.hpp"
 #include "player.hpp"
+
+#ifndef EDITOR
+// keeps uidToItem()'s index in sync with the local inventories
+static void list_InventoryChanged(const list_t* list)
+{
+	for ( int i = 0; i < MAXPLAYERS; ++i )
+	{
+		if ( stats[i] && list == &stats[i]->inventory )
+		{
+			itemUidIndexInvalidate();
+			return;
+		}
+	}
+}
+#endif // !EDITOR
+
+/*-------------------------------------------------------------------------------
+
+	list_AllocNode / list_FreeNode
+
+	nodes are recycled through a small free list rather than going back to
+	malloc every time. kept per thread, as levels are loaded on a worker
+
+-------------------------------------------------------------------------------*/
+
+static const int kNodePoolMax = 4096;
+
+// frees the pooled nodes when their thread exits
+struct NodePool
+{
+	node_t* first = nullptr;
+	int size = 0;
+	~NodePool()
+	{
+		while ( first )
+		{
+			node_t* next = first->next;
+			free(first);
+			first = next;
+		}
+		size = kNodePoolMax; // nodes freed during later teardown go straight to free()
+	}
+};
+static thread_local NodePool nodePool;
+
+static node_t* list_AllocNode()
+{
+	node_t* node = nodePool.first;
+	if ( node )
+	{
+		nodePool.first = node->next;
+		--nodePool.size;
+		return node;
+	}
+
+	// allocate memory for node
+	if ( (node = (node_t*) malloc(sizeof(node_t))) == NULL )
+	{
+		printlog( "failed to allocate memory for new node!\n" );
+		exit(1);
+	}
+	return node;
+}
+
+static void list_FreeNode(node_t* node)
+{
+	if ( nodePool.size < kNodePoolMax )
+	{
+		node->next = nodePool.first;
+		nodePool.first = node;
+		++nodePool.size;
+		return;
+	}
+	free(node);
+}
+
+// called before a node is linked into list
+static void list_NodeAdded(list_t* list)
+{
+	if ( list->first == NULL )
+	{
+		// empty lists may never have had their bookkeeping initialized
+		list->count = 0;
+	}
+	++list->count;
+	list->indexNode = NULL;
+}
+
 /*-------------------------------------------------------------------------------
 
 	list_FreeAll
@@ -38,6 +126,8 @@ void list_FreeAll(list_t* list)
 	}
 	list->first = NULL;
 	list->last = NULL;
+	list->count = 0;
+	list->indexNode = NULL;
 }
 
 /*-------------------------------------------------------------------------------
@@ -78,6 +168,7 @@ void list_RemoveNode(node_t* node)
 	}
 
 #ifndef EDITOR
+	list_InventoryChanged(node->list);
 	for ( int i = 0; i < MAXPLAYERS; ++i )
 	{
 		if ( !players[i] || !players[i]->isLocalPlayer() )
@@ -137,6 +228,9 @@ void list_RemoveNode(node_t* node)
 #endif // !EDITOR
 	if ( node->list && node->list->first )
 	{
+		--node->list->count;
+		node->list->indexNode = NULL;
+
 		// if this is the first node...
 		if ( node == node->list->first )
 		{
@@ -181,7 +275,7 @@ void list_RemoveNode(node_t* node)
 	{
 		free(node->element);
 	}
-	free(node);
+	list_FreeNode(node);
 }
 
 /*-------------------------------------------------------------------------------
@@ -196,14 +290,7 @@ void list_RemoveNode(node_t* node)
 
 node_t* list_AddNodeFirst(list_t* list)
 {
-	node_t* node;
-
-	// allocate memory for node
-	if ( (node = (node_t*) malloc(sizeof(node_t))) == NULL )
-	{
-		printlog( "failed to allocate memory for new node!\n" );
-		exit(1);
-	}
+	node_t* node = list_AllocNode();
 
 	// initialize data pointers to NULL
 	node->element = NULL;
@@ -213,6 +300,10 @@ node_t* list_AddNodeFirst(list_t* list)
 
 	// integrate it into the list
 	node->list = list;
+#ifndef EDITOR
+	list_InventoryChanged(list);
+#endif
+	list_NodeAdded(list);
 	if ( list->first != NULL )
 	{
 		// there are prior nodes in the list
@@ -242,14 +333,7 @@ node_t* list_AddNodeFirst(list_t* list)
 
 node_t* list_AddNodeLast(list_t* list)
 {
-	node_t* node;
-
-	// allocate memory for node
-	if ( (node = (node_t*) malloc(sizeof(node_t))) == NULL )
-	{
-		printlog( "failed to allocate memory for new node!\n" );
-		exit(1);
-	}
+	node_t* node = list_AllocNode();
 
 	// initialize data pointers to NULL
 	node->element = NULL;
@@ -259,6 +343,10 @@ node_t* list_AddNodeLast(list_t* list)
 
 	// integrate it into the list
 	node->list = list;
+#ifndef EDITOR
+	list_InventoryChanged(list);
+#endif
+	list_NodeAdded(list);
 	if ( list->last != NULL )
 	{
 		// there are prior nodes in the list
@@ -295,12 +383,7 @@ node_t* list_AddNode(list_t* list, int index)
 		return NULL;
 	}
 
-	// allocate memory for node
-	if ( (node = (node_t*) malloc(sizeof(node_t))) == NULL )
-	{
-		printlog( "failed to allocate memory for new node!\n" );
-		exit(1);
-	}
+	node = list_AllocNode();
 
 	// initialize data pointers to NULL
 	node->element = NULL;
@@ -311,7 +394,12 @@ node_t* list_AddNode(list_t* list, int index)
 
 	// integrate it into the list
 	node->list = list;
+#ifndef EDITOR
+	list_InventoryChanged(list);
+#endif
 	node_t* oldnode = list_Node(list, index);
+	const bool wasEmpty = list->first == NULL;
+	list_NodeAdded(list);
 	if ( oldnode )
 	{
 		// inserting at the beginning or middle of a list
@@ -331,7 +419,7 @@ node_t* list_AddNode(list_t* list, int index)
 	}
 	else
 	{
-		if ( list_Size(list) )
+		if ( !wasEmpty )
 		{
 			// inserting at the end of a list
 			node->prev = list->last;
@@ -352,6 +440,63 @@ node_t* list_AddNode(list_t* list, int index)
 	return node;
 }
 
+/*-------------------------------------------------------------------------------
+
+	list_MoveNode
+
+	unlinks a node and relinks it in the same list directly after the node
+	"after", or at the beginning of the list if "after" is NULL
+
+-------------------------------------------------------------------------------*/
+
+void list_MoveNode(node_t* node, node_t* after)
+{
+	list_t* list = node->list;
+	if ( node == after || (after ? after->next == node : list->first == node) )
+	{
+		return;
+	}
+	list->indexNode = NULL;
+
+	// unlink
+	if ( node->prev )
+	{
+		node->prev->next = node->next;
+	}
+	else
+	{
+		list->first = node->next;
+	}
+	if ( node->next )
+	{
+		node->next->prev = node->prev;
+	}
+	else
+	{
+		list->last = node->prev;
+	}
+
+	// relink
+	node->prev = after;
+	node->next = after ? after->next : list->first;
+	if ( node->next )
+	{
+		node->next->prev = node;
+	}
+	else
+	{
+		list->last = node;
+	}
+	if ( after )
+	{
+		after->next = node;
+	}
+	else
+	{
+		list->first = node;
+	}
+}
+
 /*-------------------------------------------------------------------------------
 
 	list_Size
@@ -362,16 +507,11 @@ node_t* list_AddNode(list_t* list, int index)
 
 Uint32 list_Size(list_t* list)
 {
-	node_t* node;
-	int c;
-
-	if ( !list )
+	if ( !list || !list->first )
 	{
 		return 0;
 	}
-
-	for ( c = 0, node = list->first; node != NULL; node = node->next, c++ );
-	return c;
+	return list->count;
 }
 
 /*-------------------------------------------------------------------------------
@@ -458,13 +598,29 @@ Uint32 list_Index(node_t* node)
 	if (node == nullptr) {
 		return UINT32_MAX;
 	}
+	list_t* list = node->list;
+	if ( list->first && list->indexNode )
+	{
+		// iterating a list while asking for indices is common, check around the last lookup
+		if ( list->indexNode == node )
+		{
+			return list->index;
+		}
+		if ( list->indexNode->next == node )
+		{
+			list->indexNode = node;
+			return ++list->index;
+		}
+	}
 	node_t* tempnode;
-	int i;
+	Uint32 i;
 
-	for ( i = 0, tempnode = node->list->first; tempnode != NULL; tempnode = tempnode->next, i++ )
+	for ( i = 0, tempnode = list->first; tempnode != NULL; tempnode = tempnode->next, i++ )
 	{
 		if ( tempnode == node )
 		{
+			list->indexNode = node;
+			list->index = i;
 			break;
 		}
 	}
@@ -482,11 +638,253 @@ Uint32 list_Index(node_t* node)
 
 node_t* list_Node(list_t* list, int index)
 {
-	if (index < 0) {
+	if (index < 0 || !list->first || (Uint32)index >= list->count) {
 		return NULL;
 	}
-    int i = 0;
+
+	// walk from whichever of the first node, last node or last lookup is closest
+	const Uint32 target = index;
+	Uint32 i = 0;
 	node_t* node = list->first;
-	for (; i != index && node; node = node->next, i++ );
+	if ( list->count - 1 - target < target )
+	{
+		i = list->count - 1;
+		node = list->last;
+	}
+	if ( list->indexNode )
+	{
+		const Uint32 fromCached = list->index > target ? list->index - target : target - list->index;
+		const Uint32 fromCurrent = i > target ? i - target : target - i;
+		if ( fromCached < fromCurrent )
+		{
+			i = list->index;
+			node = list->indexNode;
+		}
+	}
+	for ( ; i < target; ++i )
+	{
+		node = node->next;
+	}
+	for ( ; i > target; --i )
+	{
+		node = node->prev;
+	}
+	list->indexNode = node;
+	list->index = target;
 	return node;
 }
+
+#ifndef EDITOR
+#include "net.hpp"
+#include "interface/consolecommand.hpp"
+
+#include <chrono>
+
+/*-------------------------------------------------------------------------------
+
+	/bench_lists
+
+	Times the list access patterns the game uses (list_Size in loop
+	conditions, list_Node over every index, list_Index while iterating,
+	add/remove churn) against the walking, malloc-per-node versions they
+	replaced. List lengths are taken from the current session (level
+	entities, local inventory) so the numbers match what play looks like.
+	Both versions have to produce the same results.
+
+-------------------------------------------------------------------------------*/
+
+// list_Size/list_Node/list_Index as they were before count and index caching
+static Uint32 referenceListSize(list_t* list)
+{
+	Uint32 c = 0;
+	for ( node_t* node = list->first; node != NULL; node = node->next )
+	{
+		++c;
+	}
+	return c;
+}
+
+static node_t* referenceListNode(list_t* list, int index)
+{
+	node_t* node = list->first;
+	for ( int i = 0; node != NULL && i < index; ++i )
+	{
+		node = node->next;
+	}
+	return node;
+}
+
+static Uint32 referenceListIndex(node_t* node)
+{
+	Uint32 i = 0;
+	for ( node_t* tempnode = node->list->first; tempnode != NULL && tempnode != node; tempnode = tempnode->next )
+	{
+		++i;
+	}
+	return i;
+}
+
+// list_AddNodeLast/list_RemoveNode linking with a node malloc'd and freed every time
+static void referenceListAddLast(list_t* list)
+{
+	node_t* node = (node_t*)malloc(sizeof(node_t));
+	node->element = NULL;
+	node->deconstructor = NULL;
+	node->size = 0;
+	node->list = list;
+	node->next = NULL;
+	node->prev = list->last;
+	if ( list->last )
+	{
+		list->last->next = node;
+	}
+	else
+	{
+		list->first = node;
+	}
+	list->last = node;
+}
+
+static void referenceListRemoveFirst(list_t* list)
+{
+	node_t* node = list->first;
+	list->first = node->next;
+	if ( list->first )
+	{
+		list->first->prev = NULL;
+	}
+	else
+	{
+		list->last = NULL;
+	}
+	free(node);
+}
+
+static void benchListElementFree(void*)
+{
+}
+
+static ConsoleCommand ccmd_bench_lists("/bench_lists", "time list_Size/list_Node/list_Index/add-remove against the uncached versions: /bench_lists [reps]",
+	[](int argc, const char* argv[]){
+	const int reps = argc >= 2 ? std::max(1, atoi(argv[1])) : 20;
+
+	std::vector<Uint32> lengths;
+	if ( map.entities && list_Size(map.entities) )
+	{
+		lengths.push_back(list_Size(map.entities));
+	}
+	if ( stats[clientnum] && list_Size(&stats[clientnum]->inventory) )
+	{
+		lengths.push_back(list_Size(&stats[clientnum]->inventory));
+	}
+	if ( lengths.empty() )
+	{
+		lengths = { 40, 1500 }; // a full inventory, a busy level
+	}
+
+	using Clock = std::chrono::high_resolution_clock;
+	auto elapsedMs = [](Clock::time_point start) {
+		return 1000.0 * std::chrono::duration_cast<std::chrono::duration<double>>(Clock::now() - start).count();
+	};
+
+	int mismatches = 0;
+	double totalCurrent = 0.0;
+	double totalReference = 0.0;
+	for ( Uint32 length : lengths )
+	{
+		list_t list;
+		list.first = NULL;
+		list.last = NULL;
+		for ( Uint32 c = 0; c < length; ++c )
+		{
+			list_AddNodeLast(&list)->deconstructor = &benchListElementFree;
+		}
+
+		// list_Size in a loop condition, list_Node over every index, list_Index while iterating
+		Uint64 sums[2][3] = { { 0 } };
+		double times[2][4] = { { 0.0 } };
+		for ( int ref = 0; ref < 2; ++ref )
+		{
+			auto start = Clock::now();
+			for ( int rep = 0; rep < reps; ++rep )
+			{
+				for ( Uint32 i = 0; i < (ref ? referenceListSize(&list) : list_Size(&list)); ++i )
+				{
+					++sums[ref][0];
+				}
+			}
+			times[ref][0] = elapsedMs(start);
+
+			start = Clock::now();
+			for ( int rep = 0; rep < reps; ++rep )
+			{
+				for ( int i = 0; i < (int)length; ++i )
+				{
+					sums[ref][1] += (uintptr_t)(ref ? referenceListNode(&list, i) : list_Node(&list, i));
+				}
+			}
+			times[ref][1] = elapsedMs(start);
+
+			start = Clock::now();
+			for ( int rep = 0; rep < reps; ++rep )
+			{
+				for ( node_t* node = list.first; node != NULL; node = node->next )
+				{
+					sums[ref][2] += ref ? referenceListIndex(node) : list_Index(node);
+				}
+			}
+			times[ref][2] = elapsedMs(start);
+		}
+
+		// add/remove churn, as with messages and safe packets
+		list_t churn;
+		churn.first = NULL;
+		churn.last = NULL;
+		auto start = Clock::now();
+		for ( int rep = 0; rep < reps; ++rep )
+		{
+			for ( Uint32 c = 0; c < length; ++c )
+			{
+				list_AddNodeLast(&churn)->deconstructor = &benchListElementFree;
+			}
+			while ( churn.first )
+			{
+				list_RemoveNode(churn.first);
+			}
+		}
+		times[0][3] = elapsedMs(start);
+		start = Clock::now();
+		for ( int rep = 0; rep < reps; ++rep )
+		{
+			for ( Uint32 c = 0; c < length; ++c )
+			{
+				referenceListAddLast(&churn);
+			}
+			while ( churn.first )
+			{
+				referenceListRemoveFirst(&churn);
+			}
+		}
+		times[1][3] = elapsedMs(start);
+		list_FreeAll(&list);
+
+		for ( int c = 0; c < 3; ++c )
+		{
+			if ( sums[0][c] != sums[1][c] )
+			{
+				++mismatches;
+			}
+		}
+		static const char* names[4] = { "list_Size", "list_Node", "list_Index", "add/remove" };
+		for ( int c = 0; c < 4; ++c )
+		{
+			printlog("[lists] %u nodes x %d: %-10s %8.3f ms, uncached %8.3f ms", length, reps, names[c], times[0][c], times[1][c]);
+			totalCurrent += times[0][c];
+			totalReference += times[1][c];
+		}
+	}
+
+	printlog("[lists] total %.3f ms, uncached %.3f ms, %d mismatches", totalCurrent, totalReference, mismatches);
+	messagePlayer(clientnum, MESSAGE_MISC, "List bench: %.3f ms vs %.3f ms uncached, %d mismatches", totalCurrent, totalReference, mismatches);
+	});
+#endif // !EDITOR
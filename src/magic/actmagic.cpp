@@ -4468,6 +4468,7 @@ void actParticleTimer(Entity* my)
 							{
 								case AUTOMATON:
 									strcpy(monsterStats->name, "corrupted automaton");
+									monsterStats->updateAllegianceTags();
 									monsterStats->EFFECTS[EFF_CONFUSED] = true;
 									monsterStats->EFFECTS_TIMERS[EFF_CONFUSED] = -1;
 									break;
@@ -5197,6 +5198,7 @@ void actParticleSapCenter(Entity* my)
 							monster->monsterAllySummonRank = magicLevel;
 							monsterStats->setAttribute("special_npc", "skeleton knight");
 							strcpy(monsterStats->name, MonsterData_t::getSpecialNPCName(*monsterStats).c_str());
+							monsterStats->updateAllegianceTags();
 							forceFollower(*caster, *monster);
 
 							monster->setEffect(EFF_STUNNED, true, 20, false);
@@ -5254,6 +5256,7 @@ void actParticleSapCenter(Entity* my)
 									{
 										monsterStats->setAttribute("special_npc", "skeleton sentinel");
 										strcpy(monsterStats->name, MonsterData_t::getSpecialNPCName(*monsterStats).c_str());
+										monsterStats->updateAllegianceTags();
 										magicLevel = 1;
 										if ( stats[caster->skill[2]] )
 										{
@@ -6374,6 +6377,7 @@ bool magicDig(Entity* parent, Entity* projectile, int numRocks, int randRocks)
 				}
 
 				map.tiles[(int)(OBSTACLELAYER + hit.mapy * MAPLAYERS + hit.mapx * MAPLAYERS * map.height)] = 0;
+				notifyTileChanged(hit.mapx, hit.mapy);
 
 				// send wall destroy info to clients
 				if ( multiplayer == SERVER )
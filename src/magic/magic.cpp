@@ -1965,6 +1965,7 @@ Entity* spellEffectPolymorph(Entity* target, Entity* parent, bool fromMagicSpell
 		if ( targetStats->type == HUMAN )
 		{
 			strcpy(summonedStats->name, targetStats->name);
+			summonedStats->updateAllegianceTags();
 		}
 
 		if ( hitMonsterCanTransferEquipment && summonCanEquipItems )
@@ -2717,6 +2718,7 @@ bool spellEffectDemonIllusion(Entity& my, spellElement_t& element, Entity* paren
 					{
 						monsterStats->leader_uid = 0;
 						strcpy(monsterStats->name, "inner demon");
+						monsterStats->updateAllegianceTags();
 						monster->setEffect(EFF_STUNNED, true, 20, false);
 						monster->flags[USERFLAG2] = true;
 						serverUpdateEntityFlag(monster, USERFLAG2);
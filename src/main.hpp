@@ -443,6 +443,12 @@ typedef struct list_t
 {
 	node_t* first;
 	node_t* last;
+
+	// bookkeeping for the list_ functions. lists are often made with malloc
+	// and only first/last cleared, so these are reset whenever the list is empty
+	Uint32 count;        // number of nodes
+	node_t* indexNode;   // node last found by list_Node()/list_Index(), or NULL
+	Uint32 index;        // index of indexNode
 } list_t;
 extern list_t button_l;
 extern list_t light_l;
@@ -460,6 +466,7 @@ typedef struct map_t
 	list_t* creatures; //A list of Entity* pointers.
 	list_t* worldUI; //A list of Entity* pointers.
 	char filename[256];
+	bool bossLevel = false; // name starts with "Boss" or "Hell Boss", set by loadMap()
 } map_t;
 
 #define MAPLAYERS 3 // number of layers contained in a single map
@@ -838,6 +845,7 @@ void list_RemoveNodeWithElement(list_t &list, T element)
 node_t* list_AddNodeFirst(list_t* list);
 node_t* list_AddNodeLast(list_t* list);
 node_t* list_AddNode(list_t* list, int index);
+void list_MoveNode(node_t* node, node_t* after);
 Uint32 list_Size(list_t* list);
 list_t* list_Copy(list_t* destlist, list_t* srclist);
 list_t* list_CopyNew(list_t* srclist);
@@ -861,9 +869,46 @@ string_t* newString(list_t* list, Uint32 color, Uint32 time, int player, char co
 SDL_Cursor* newCursor(char const * const image[]);
 
 // function prototypes for maps.c:
+class BaronyRNG;
+
+// where generateDungeon() builds a level and what it decides about it. for the
+// live level map and rng point at the globals; a staged level (see
+// stageNextLevel()) owns its own until takeStagedLevel() swaps it in
+struct MapGenTarget_t
+{
+	map_t* map = nullptr;
+	BaronyRNG* rng = nullptr;      // generation rolls, seeded by generateDungeon()
+	BaronyRNG* localRng = nullptr; // rolls that aren't kept in sync with clients
+	Uint32 uids = 0;               // uids handed out to a staged map's entities, counted from 0
+	int currentlevel = 0;          // the level being generated
+	bool secretlevel = false;
+
+	// written by generateDungeon(), copied to the globals by applyMapGenTarget()
+	std::vector<bool> shoparea;
+	bool darkmap = false;
+	bool darkmapHint = false;      // tell the players the level is dark
+	int minotaurlevel = 0;
+	Uint32 nummonsters = 0;
+	bool modded = false;           // non-default generation or a room failed its hash check
+};
+extern thread_local MapGenTarget_t* stagedMapGen; // set on the thread generating a staged level
+
 int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int> mapParameters = std::make_tuple(-1, -1, -1, 0)); // secretLevelChance of -1 is default Barony generation.
+int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int> mapParameters, MapGenTarget_t& target);
+void applyMapGenTarget(MapGenTarget_t& target); // once target.map is the current map
+void stageNextLevel(); // starts generating the level after this one in the background
+bool takeStagedLevel(int levelToLoad, bool secret, Uint32 seed, int& result); // swaps the staged level in if it's the one asked for
+void discardStagedLevel(); // waits for and frees any staged level
+Uint32 nextLevelSeed(); // the seed a staged level was generated with, otherwise a fresh one
+void clearRoomTemplateCache(); // frees the room maps kept by generateDungeon
+void prefetchLevelRoomTemplates(int levelToLoad, bool secret); // starts loading the rooms of an upcoming level
+void updateRoomTemplatePrefetch(); // loads one queued room, call once per tick
 void assignActions(map_t* map);
 
+// function prototypes for opengl.c:
+void notifyTileChanged(int x, int y); // rebuild world geometry around a tile of the current map
+void notifyMapTilesReplaced();        // rebuild all world geometry, eg. after loading a level
+
 // Cursor bitmap definitions
 extern char const *cursor_pencil[];
 extern char const *cursor_point[];
@@ -873,6 +918,7 @@ extern char const *cursor_fill[];
 GLuint create_shader(const char* filename, GLenum type);
 
 extern bool no_sound; //False means sound initialized properly. True means sound failed to initialize.
+extern bool headless; //True when running as a windowless server (-headless): nothing is drawn and no audio is played.
 extern bool initialized; //So that messagePlayer doesn't explode before the game is initialized. //TODO: Does the editor need this set too and stuff?
 
 void GO_SwapBuffers(SDL_Window* screen);
@@ -9,6 +9,11 @@
 
 -------------------------------------------------------------------------------*/
 
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+
 #include "main.hpp"
 #include "game.hpp"
 #include "stat.hpp"
@@ -361,25 +366,32 @@ int monsterCurve(int level)
 
 struct StartRoomInfo_t
 {
+	map_t& destmap;
+	BaronyRNG& rng;
+	StartRoomInfo_t(map_t& _destmap, BaronyRNG& _rng) :
+		destmap(_destmap),
+		rng(_rng)
+	{
+	}
 	int x1 = -1;
 	int x2 = -1;
 	int y1 = -1;
 	int y2 = -1;
 	bool isWall(int x, int y)
 	{
-		if ( x <= 0 || x >= map.width - 1 || y <= 0 || y >= map.height - 1 )
+		if ( x <= 0 || x >= destmap.width - 1 || y <= 0 || y >= destmap.height - 1 )
 		{
 			return true;
 		}
-		return map.tiles[OBSTACLELAYER + (y)* MAPLAYERS + (x)* MAPLAYERS * map.height];
+		return destmap.tiles[OBSTACLELAYER + (y)* MAPLAYERS + (x)* MAPLAYERS * destmap.height];
 	}
 	bool isWalkable(int x, int y)
 	{
-		if ( x <= 0 || x >= map.width - 1 || y <= 0 || y >= map.height - 1 )
+		if ( x <= 0 || x >= destmap.width - 1 || y <= 0 || y >= destmap.height - 1 )
 		{
 			return false;
 		}
-		return map.tiles[(y)* MAPLAYERS + (x)* MAPLAYERS * map.height];
+		return destmap.tiles[(y)* MAPLAYERS + (x)* MAPLAYERS * destmap.height];
 	}
 	void addCoord(int x, int y)
 	{
@@ -453,7 +465,7 @@ struct StartRoomInfo_t
 							}
 							else
 							{
-								if ( pathCheckObstacle(x1 - 2, y, nullptr, nullptr) == 1 ) // check interfering entities
+								if ( pathCheckObstacle(destmap, x1 - 2, y, nullptr, nullptr) == 1 ) // check interfering entities
 								{
 									badTunnelPoints.push_back(std::make_pair(std::make_pair(x1, y), Direction::WEST));
 								}
@@ -471,7 +483,7 @@ struct StartRoomInfo_t
 				}
 			}
 		}
-		if ( x2 + 1 < (map.width) )
+		if ( x2 + 1 < (destmap.width) )
 		{
 			for ( int y = y1; y <= y2; ++y )
 			{
@@ -493,7 +505,7 @@ struct StartRoomInfo_t
 							}
 							else
 							{
-								if ( pathCheckObstacle(x2 + 2, y, nullptr, nullptr) == 1 ) // check interfering entities
+								if ( pathCheckObstacle(destmap, x2 + 2, y, nullptr, nullptr) == 1 ) // check interfering entities
 								{
 									badTunnelPoints.push_back(std::make_pair(std::make_pair(x2, y), Direction::EAST));
 								}
@@ -533,7 +545,7 @@ struct StartRoomInfo_t
 							}
 							else
 							{
-								if ( pathCheckObstacle(x, y1 - 2, nullptr, nullptr) == 1 ) // check interfering entities
+								if ( pathCheckObstacle(destmap, x, y1 - 2, nullptr, nullptr) == 1 ) // check interfering entities
 								{
 									badTunnelPoints.push_back(std::make_pair(std::make_pair(x, y1), Direction::NORTH));
 								}
@@ -551,7 +563,7 @@ struct StartRoomInfo_t
 				}
 			}
 		}
-		if ( y2 + 1 < (map.height) )
+		if ( y2 + 1 < (destmap.height) )
 		{
 			for ( int x = x1; x <= x2; ++x )
 			{
@@ -573,7 +585,7 @@ struct StartRoomInfo_t
 							}
 							else
 							{
-								if ( pathCheckObstacle(x, y2 + 2, nullptr, nullptr) == 1 ) // check interfering entities
+								if ( pathCheckObstacle(destmap, x, y2 + 2, nullptr, nullptr) == 1 ) // check interfering entities
 								{
 									badTunnelPoints.push_back(std::make_pair(std::make_pair(x, y2), Direction::SOUTH));
 								}
@@ -685,7 +697,7 @@ struct StartRoomInfo_t
 			}
 			if ( !goodTunnelPoints.empty() )
 			{
-				auto picked = goodTunnelPoints.at(map_rng.rand() % goodTunnelPoints.size());
+				auto picked = goodTunnelPoints.at(rng.rand() % goodTunnelPoints.size());
 				switch ( picked.second )
 				{
 					case WEST:
@@ -704,11 +716,11 @@ struct StartRoomInfo_t
 						break;
 				}
 				printlog("[MAP GENERATOR]: Dug hole using TunnelPoints1 at x: %d y: %d", picked.first.first, picked.first.second);
-				map.tiles[OBSTACLELAYER + (picked.first.second)* MAPLAYERS + (picked.first.first)* MAPLAYERS * map.height] = 0;
+				destmap.tiles[OBSTACLELAYER + (picked.first.second)* MAPLAYERS + (picked.first.first)* MAPLAYERS * destmap.height] = 0;
 			}
 			else if ( !badTunnelPoints.empty() )
 			{
-				auto picked = badTunnelPoints.at(map_rng.rand() % badTunnelPoints.size());
+				auto picked = badTunnelPoints.at(rng.rand() % badTunnelPoints.size());
 				switch ( picked.second )
 				{
 					case WEST:
@@ -727,11 +739,11 @@ struct StartRoomInfo_t
 						break;
 				}
 				printlog("[MAP GENERATOR]: Dug hole using TunnelPoints2 at x: %d y: %d", picked.first.first, picked.first.second);
-				map.tiles[OBSTACLELAYER + (picked.first.second)* MAPLAYERS + (picked.first.first)* MAPLAYERS * map.height] = 0;
+				destmap.tiles[OBSTACLELAYER + (picked.first.second)* MAPLAYERS + (picked.first.first)* MAPLAYERS * destmap.height] = 0;
 			}
 			else if ( !worstTunnelPoints.empty() )
 			{
-				auto picked = worstTunnelPoints.at(map_rng.rand() % worstTunnelPoints.size());
+				auto picked = worstTunnelPoints.at(rng.rand() % worstTunnelPoints.size());
 				switch ( picked.second )
 				{
 					case WEST:
@@ -750,7 +762,7 @@ struct StartRoomInfo_t
 						break;
 				}
 				printlog("[MAP GENERATOR]: Dug hole using TunnelPoints3 at x: %d y: %d", picked.first.first, picked.first.second);
-				map.tiles[OBSTACLELAYER + (picked.first.second)* MAPLAYERS + (picked.first.first)* MAPLAYERS * map.height] = 0;
+				destmap.tiles[OBSTACLELAYER + (picked.first.second)* MAPLAYERS + (picked.first.first)* MAPLAYERS * destmap.height] = 0;
 			}
 		}
 	}
@@ -778,28 +790,28 @@ bool mapSpriteIsDoorway(int sprite)
 	return false;
 }
 
-int getMapPossibleLocationX1()
+int getMapPossibleLocationX1(const map_t& destmap)
 {
-	const int perimeter = MFLAG_PERIMETER_GAP;
+	const int perimeter = (destmap.flags[MAP_FLAG_GENBYTES4] >> 0) & 0xFF;
 	return perimeter;
 }
 
-int getMapPossibleLocationY1()
+int getMapPossibleLocationY1(const map_t& destmap)
 {
-	const int perimeter = MFLAG_PERIMETER_GAP;
+	const int perimeter = (destmap.flags[MAP_FLAG_GENBYTES4] >> 0) & 0xFF;
 	return perimeter;
 }
 
-int getMapPossibleLocationX2()
+int getMapPossibleLocationX2(const map_t& destmap)
 {
-	const int perimeter = MFLAG_PERIMETER_GAP;
-	return map.width - perimeter;
+	const int perimeter = (destmap.flags[MAP_FLAG_GENBYTES4] >> 0) & 0xFF;
+	return destmap.width - perimeter;
 }
 
-int getMapPossibleLocationY2()
+int getMapPossibleLocationY2(const map_t& destmap)
 {
-	const int perimeter = MFLAG_PERIMETER_GAP;
-	return map.height - perimeter;
+	const int perimeter = (destmap.flags[MAP_FLAG_GENBYTES4] >> 0) & 0xFF;
+	return destmap.height - perimeter;
 }
 
 bool mapTileDiggable(const int x, const int y)
@@ -811,8 +823,8 @@ bool mapTileDiggable(const int x, const int y)
 	}
 	if ( !strncmp(map.name, "Hell", 4) )
 	{
-		if ( x < getMapPossibleLocationX1() || x >= getMapPossibleLocationX2()
-			|| y < getMapPossibleLocationY1() || y >= getMapPossibleLocationY2() )
+		if ( x < getMapPossibleLocationX1(map) || x >= getMapPossibleLocationX2(map)
+			|| y < getMapPossibleLocationY1(map) || y >= getMapPossibleLocationY2(map) )
 		{
 			return false;
 		}
@@ -820,17 +832,421 @@ bool mapTileDiggable(const int x, const int y)
 	return true;
 }
 
+/*-------------------------------------------------------------------------------
+
+	RoomTemplateCache_t
+
+	rooms, subrooms and shop subrooms parsed by generateDungeon, kept across
+	level transitions so each file is only loaded once. templates are shared
+	between generations so must not be modified, and are dropped whenever
+	mods are loaded or unloaded. a staged level (see stageNextLevel) looks
+	rooms up from its own thread, so the table is locked
+
+-------------------------------------------------------------------------------*/
+
+static struct RoomTemplateCache_t
+{
+	struct Template_t
+	{
+		map_t* map = nullptr;
+		int hash = 0;
+	};
+	std::unordered_map<std::string, Template_t> templates;
+	std::mutex templatesMutex;
+
+	// returns the room at fullMapPath, loading it on first use. nullptr if it failed to load
+	map_t* get(const std::string& fullMapPath, int& checkMapHash)
+	{
+		if ( fullMapPath.empty() )
+		{
+			return nullptr;
+		}
+		std::lock_guard<std::mutex> lock(templatesMutex);
+		std::string key = fullMapPath;
+		if ( multiplayer == CLIENT )
+		{
+			key += "#client"; // clients don't load monster stats
+		}
+		auto find = templates.find(key);
+		if ( find != templates.end() )
+		{
+			checkMapHash = find->second.hash;
+			return find->second.map;
+		}
+
+		map_t* tempMap = (map_t*) malloc(sizeof(map_t));
+		tempMap->tiles = nullptr;
+		tempMap->entities = (list_t*) malloc(sizeof(list_t));
+		tempMap->entities->first = nullptr;
+		tempMap->entities->last = nullptr;
+		tempMap->creatures = new list_t;
+		tempMap->creatures->first = nullptr;
+		tempMap->creatures->last = nullptr;
+		tempMap->worldUI = nullptr;
+		if ( loadMap(fullMapPath.c_str(), tempMap, tempMap->entities, tempMap->creatures, &checkMapHash) == -1 )
+		{
+			mapDeconstructor((void*)tempMap);
+			return nullptr;
+		}
+		templates[key] = Template_t{ tempMap, checkMapHash };
+		return tempMap;
+	}
+
+	void clear()
+	{
+		std::lock_guard<std::mutex> lock(templatesMutex);
+		for ( auto& pair : templates )
+		{
+			mapDeconstructor((void*)pair.second.map);
+		}
+		templates.clear();
+		prefetchQueue.clear();
+	}
+
+	// rooms waiting to be loaded ahead of the level that uses them
+	std::deque<std::string> prefetchQueue;
+
+	// queues every room and subroom of a levelset, in the order generateDungeon looks them up
+	void prefetch(const char* levelset)
+	{
+		prefetchQueue.clear();
+		char name[128];
+		int numlevels = 0;
+		for ( ; numlevels < 100; ++numlevels )
+		{
+			snprintf(name, sizeof(name), "%s%02d", levelset, numlevels);
+			std::string fullMapPath = physfsFormatMapName(name);
+			if ( fullMapPath.empty() )
+			{
+				break;
+			}
+			prefetchQueue.push_back(fullMapPath);
+		}
+		for ( int subRoomNumLevels = 0; subRoomNumLevels <= numlevels; ++subRoomNumLevels )
+		{
+			for ( char letter = 'a'; letter <= 'z'; ++letter )
+			{
+				snprintf(name, sizeof(name), "%s%02d%c", levelset, subRoomNumLevels, letter);
+				std::string fullMapPath = physfsFormatMapName(name);
+				if ( fullMapPath.empty() )
+				{
+					break;
+				}
+				prefetchQueue.push_back(fullMapPath);
+			}
+		}
+	}
+
+	// loads the next queued room, if any
+	void prefetchStep()
+	{
+		if ( prefetchQueue.empty() )
+		{
+			return;
+		}
+		std::string fullMapPath = prefetchQueue.front();
+		prefetchQueue.pop_front();
+		int checkMapHash = 0;
+		(void)get(fullMapPath, checkMapHash);
+	}
+} roomTemplateCache;
+
+void clearRoomTemplateCache()
+{
+	discardStagedLevel(); // its worker may be reading rooms from the cache
+	roomTemplateCache.clear();
+}
+
+/*-------------------------------------------------------------------------------
+
+	prefetchLevelRoomTemplates
+
+	queues the rooms of a generated level to be loaded into the room
+	template cache a little at a time by updateRoomTemplatePrefetch(), so
+	the following level transition finds them already parsed. fixed
+	("map:") levels have nothing to prefetch
+
+-------------------------------------------------------------------------------*/
+
+void prefetchLevelRoomTemplates(int levelToLoad, bool secret)
+{
+	roomTemplateCache.prefetchQueue.clear();
+	std::string line = physfsGetLevelsFileLine(levelToLoad, secret);
+	std::size_t found = line.find(' ');
+	if ( found == std::string::npos || line.substr(0, found).compare("gen:") != 0 )
+	{
+		return;
+	}
+	std::string levelset = line.substr(found + 1);
+	levelset = levelset.substr(0, levelset.find_first_of(" \r\n"));
+	if ( !levelset.empty() )
+	{
+		roomTemplateCache.prefetch(levelset.c_str());
+	}
+}
+
+void updateRoomTemplatePrefetch()
+{
+	roomTemplateCache.prefetchStep();
+}
+
+/*-------------------------------------------------------------------------------
+
+	BlockedTileTable_t
+
+	summed-area table over the tiles rooms can't be placed on, so the
+	generator can ask whether a room footprint overlaps anything in O(1)
+
+-------------------------------------------------------------------------------*/
+
+struct BlockedTileTable_t
+{
+	int width = 0;
+	int height = 0;
+	bool dirty = true;
+	std::vector<int> sums; // (width + 1) * (height + 1), row/column 0 are zero
+
+	// rebuilds from a width * height array of possible locations if anything was stamped since
+	void update(const bool* possiblelocations, int w, int h)
+	{
+		if ( !dirty && width == w && height == h )
+		{
+			return;
+		}
+		width = w;
+		height = h;
+		dirty = false;
+		sums.assign((width + 1) * (height + 1), 0);
+		for ( int y = 0; y < height; ++y )
+		{
+			int rowSum = 0;
+			for ( int x = 0; x < width; ++x )
+			{
+				rowSum += possiblelocations[x + y * width] ? 0 : 1;
+				sums[(x + 1) + (y + 1) * (width + 1)] = sums[(x + 1) + y * (width + 1)] + rowSum;
+			}
+		}
+	}
+
+	// number of blocked tiles in [x0, x1) x [y0, y1)
+	int count(int x0, int y0, int x1, int y1) const
+	{
+		const int stride = width + 1;
+		return sums[x1 + y1 * stride] - sums[x0 + y1 * stride] - sums[x1 + y0 * stride] + sums[x0 + y0 * stride];
+	}
+};
+
+// marks in possiblelocations2 where a footprintW x footprintH room fits
+// (clipped at the map edge) and returns how many spots there are
+static Sint32 findRoomLocations(BlockedTileTable_t& blockedTiles, const bool* possiblelocations, bool* possiblelocations2,
+	int mapWidth, int mapHeight, int footprintW, int footprintH)
+{
+	Sint32 numpossiblelocations = mapWidth * mapHeight;
+	blockedTiles.update(possiblelocations, mapWidth, mapHeight);
+	for ( int y0 = 0; y0 < mapHeight; y0++ )
+	{
+		const int y1 = std::min(y0 + footprintH, mapHeight);
+		for ( int x0 = 0; x0 < mapWidth; x0++ )
+		{
+			const int x1 = std::min(x0 + footprintW, mapWidth);
+			if ( blockedTiles.count(x0, y0, x1, y1) > 0 )
+			{
+				possiblelocations2[x0 + y0 * mapWidth] = false;
+				numpossiblelocations--;
+			}
+			else
+			{
+				possiblelocations2[x0 + y0 * mapWidth] = true;
+			}
+		}
+	}
+	return numpossiblelocations;
+}
+
+// the per-tile footprint scan findRoomLocations() replaced, kept to check it against
+static Sint32 findRoomLocationsReference(const bool* possiblelocations, bool* possiblelocations2,
+	int mapWidth, int mapHeight, int footprintW, int footprintH)
+{
+	Sint32 numpossiblelocations = mapWidth * mapHeight;
+	for ( int y = 0; y < mapHeight; y++ )
+	{
+		for ( int x = 0; x < mapWidth; x++ )
+		{
+			possiblelocations2[x + y * mapWidth] = true;
+		}
+	}
+	for ( int y0 = 0; y0 < mapHeight; y0++ )
+	{
+		for ( int x0 = 0; x0 < mapWidth; x0++ )
+		{
+			for ( int y1 = y0; y1 < std::min(y0 + footprintH, mapHeight); y1++ )
+			{
+				for ( int x1 = x0; x1 < std::min(x0 + footprintW, mapWidth); x1++ )
+				{
+					if ( possiblelocations[x1 + y1 * mapWidth] == false && possiblelocations2[x0 + y0 * mapWidth] == true )
+					{
+						possiblelocations2[x0 + y0 * mapWidth] = false;
+						numpossiblelocations--;
+					}
+				}
+			}
+		}
+	}
+	return numpossiblelocations;
+}
+
+static ConsoleVariable<bool> cvar_mapgen_verify_rooms("/mapgen_verify_rooms", false);
+
+/*-------------------------------------------------------------------------------
+
+	/test_room_placement
+
+	seed sweep for findRoomLocations(). each seed grows a random level the
+	way generateDungeon does: pick a room size, compare the candidate spots
+	and their count with the reference scan, pick one of the spots with the
+	seeded rng, stamp the room and repeat until nothing fits.
+
+-------------------------------------------------------------------------------*/
+
+static ConsoleCommand ccmd_test_room_placement("/test_room_placement", "compare summed-area room placement against the per-tile scan over a seed sweep (default 1000 seeds)",
+	[](int argc, const char* argv[]){
+	const int numSeeds = argc >= 2 ? std::max(1, atoi(argv[1])) : 1000;
+	int queries = 0;
+	int mismatches = 0;
+	for ( int seed = 0; seed < numSeeds; ++seed )
+	{
+		BaronyRNG rng;
+		rng.seedBytes(&seed, sizeof(seed));
+		const int width = rng.uniform(8, 96);
+		const int height = rng.uniform(8, 96);
+		const int size = width * height;
+		std::unique_ptr<bool[]> possible(new bool[size]);
+		std::unique_ptr<bool[]> expected(new bool[size]);
+		std::unique_ptr<bool[]> actual(new bool[size]);
+		std::fill(possible.get(), possible.get() + size, true);
+
+		// some levels start with solid borders or pillars already blocked
+		const int prestamped = rng.uniform(0, 6);
+		for ( int c = 0; c < prestamped; ++c )
+		{
+			possible[rng.uniform(0, size - 1)] = false;
+		}
+
+		BlockedTileTable_t blockedTiles;
+		for ( int room = 0; room < size; ++room )
+		{
+			// first room may get the two extra hell columns
+			const int footprintW = rng.uniform(1, 24) + ((room == 0 && rng.uniform(0, 1)) ? 2 : 0);
+			const int footprintH = rng.uniform(1, 24);
+			const Sint32 expectedCount = findRoomLocationsReference(possible.get(), expected.get(),
+				width, height, footprintW, footprintH);
+			const Sint32 actualCount = findRoomLocations(blockedTiles, possible.get(), actual.get(),
+				width, height, footprintW, footprintH);
+			++queries;
+			if ( expectedCount != actualCount || !std::equal(expected.get(), expected.get() + size, actual.get()) )
+			{
+				++mismatches;
+				printlog("[rooms] mismatch: seed %d room %d (%dx%d in %dx%d): %d vs %d spots",
+					seed, room, footprintW, footprintH, width, height, expectedCount, actualCount);
+				break;
+			}
+			if ( expectedCount <= 0 )
+			{
+				break;
+			}
+
+			// stamp the room at a random candidate, like generateDungeon
+			int pick = rng.uniform(0, expectedCount - 1);
+			int x0 = 0, y0 = 0;
+			for ( int i = 0; i < size; ++i )
+			{
+				if ( expected[i] && pick-- == 0 )
+				{
+					x0 = i % width;
+					y0 = i / width;
+					break;
+				}
+			}
+			for ( int y = y0; y < std::min(y0 + footprintH, height); ++y )
+			{
+				for ( int x = x0; x < std::min(x0 + footprintW, width); ++x )
+				{
+					possible[x + y * width] = false;
+				}
+			}
+			blockedTiles.dirty = true;
+		}
+	}
+	printlog("[rooms] %d seeds, %d placement queries, %d mismatches", numSeeds, queries, mismatches);
+	messagePlayer(clientnum, MESSAGE_MISC, "Room placement test: %d queries, %d mismatches", queries, mismatches);
+	});
+
+/*-------------------------------------------------------------------------------
+
+	mapGenCheckObstacle
+
+	checkObstacle() as generateDungeon uses it, against destmap instead of
+	the current map: walls and missing floor, and with checkEntities any
+	solid entity placed so far (items, gold and doors don't count)
+
+-------------------------------------------------------------------------------*/
+
+static int mapGenCheckObstacle(const map_t& destmap, long x, long y, bool checkEntities)
+{
+	if ( x < 0 || x >= destmap.width << 4 || y < 0 || y >= destmap.height << 4 )
+	{
+		return 0;
+	}
+	int index = (y >> 4) * MAPLAYERS + (x >> 4) * MAPLAYERS * destmap.height;
+	if ( destmap.tiles[OBSTACLELAYER + index] || !destmap.tiles[index] )
+	{
+		return 1;
+	}
+	if ( !checkEntities )
+	{
+		return 0;
+	}
+	for ( node_t* node = destmap.entities->first; node != nullptr; node = node->next )
+	{
+		Entity* entity = (Entity*)node->element;
+		if ( !entity
+			|| entity->flags[PASSABLE]
+			|| entity->sprite == 8 // items
+			|| entity->sprite == 9 // gold
+			|| entity->behavior == &actDoor )
+		{
+			continue;
+		}
+		if ( x >= (int)(entity->x - entity->sizex) && x <= (int)(entity->x + entity->sizex) )
+		{
+			if ( y >= (int)(entity->y - entity->sizey) && y <= (int)(entity->y + entity->sizey) )
+			{
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
 /*-------------------------------------------------------------------------------
 
 	generateDungeon
 
 	generates a level by drawing data from numerous files and connecting
-	their rooms together with tunnels.
+	their rooms together with tunnels. the level is built in target.map
+	using target's rngs, and everything else the generator decides is left
+	in target for the caller to apply (see applyMapGenTarget). it writes
+	no other game state, so a staged level can be generated off the main
+	thread while the current one is played.
 
 -------------------------------------------------------------------------------*/
 
-int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int> mapParameters)
+int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int> mapParameters, MapGenTarget_t& target)
 {
+	map_t& destmap = *target.map;
+	BaronyRNG& rng = *target.rng;
+	const int currentlevel = target.currentlevel; // not ::currentlevel yet for a staged level
+	const bool secretlevel = target.secretlevel;
 	char* sublevelname, *subRoomName;
 	char sublevelnum[3];
 	map_t* tempMap = nullptr;
@@ -892,92 +1308,88 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 		strcat(generationLog, ", (seed %lu)...\n");
 		printlog(generationLog, levelset, seed);
 
-		conductGameChallenges[CONDUCT_MODDED] = 1;
-		Mods::disableSteamAchievements = true;
+		target.modded = true;
 	}
 
 	std::string fullMapPath;
 	fullMapPath = physfsFormatMapName(levelset);
 
 	int checkMapHash = -1;
-	if ( fullMapPath.empty() || loadMap(fullMapPath.c_str(), &map, map.entities, map.creatures, &checkMapHash) == -1 )
+	if ( fullMapPath.empty() || loadMap(fullMapPath.c_str(), &destmap, destmap.entities, destmap.creatures, &checkMapHash) == -1 )
 	{
 		printlog("error: no level of set '%s' could be found.\n", levelset);
 		return -1;
 	}
 	if ( !verifyMapHash(fullMapPath.c_str(), checkMapHash) )
 	{
-		conductGameChallenges[CONDUCT_MODDED] = 1;
-		Mods::disableSteamAchievements = true;
+		target.modded = true;
 	}
+	target.shoparea.assign(destmap.width * destmap.height, false);
+	const int genAdjacentRooms = (destmap.flags[MAP_FLAG_GENBYTES3] >> 0) & 0xFF;
 
-	// store this map's seed
-	mapseed = seed;
-	map_rng.seedBytes(&mapseed, sizeof(mapseed));
-
-	// generate a custom monster curve if file exists
-	monsterCurveCustomManager.readFromFile();
+	// seed the generator with this map's seed
+	rng.seedBytes(&seed, sizeof(seed));
 
 	// determine whether shop level or not
-	if ( gameplayCustomManager.processedShopFloor(currentlevel, secretlevel, map.name, shoplevel) )
+	if ( gameplayCustomManager.processedShopFloor(currentlevel, secretlevel, destmap.name, shoplevel, rng) )
 	{
 		// function sets shop level for us.
 	}
-	else if ( map_rng.rand() % 2 && currentlevel > 1 && strncmp(map.name, "Underworld", 10) && strncmp(map.name, "Hell", 4) )
+	else if ( rng.rand() % 2 && currentlevel > 1 && strncmp(destmap.name, "Underworld", 10) && strncmp(destmap.name, "Hell", 4) )
 	{
 		shoplevel = true;
 	}
 
 	// determine whether minotaur level or not
-	if ( (svFlags & SV_FLAG_MINOTAURS) && gameplayCustomManager.processedMinotaurSpawn(currentlevel, secretlevel, map.name) )
+	if ( (svFlags & SV_FLAG_MINOTAURS) && gameplayCustomManager.processedMinotaurSpawn(currentlevel, secretlevel, destmap.name, target.minotaurlevel, rng) )
 	{
 		// function sets mino level for us.
 	}
 	else if ( std::get<LEVELPARAM_CHANCE_MINOTAUR>(mapParameters) != -1 )
 	{
-		if ( map_rng.rand() % 100 < std::get<LEVELPARAM_CHANCE_MINOTAUR>(mapParameters) && (svFlags & SV_FLAG_MINOTAURS) )
+		if ( rng.rand() % 100 < std::get<LEVELPARAM_CHANCE_MINOTAUR>(mapParameters) && (svFlags & SV_FLAG_MINOTAURS) )
 		{
-			minotaurlevel = 1;
+			target.minotaurlevel = 1;
 		}
 	}
 	else if ( (currentlevel < 25 && (currentlevel % LENGTH_OF_LEVEL_REGION == 2 || currentlevel % LENGTH_OF_LEVEL_REGION == 3))
 		|| (currentlevel > 25 && (currentlevel % LENGTH_OF_LEVEL_REGION == 2 || currentlevel % LENGTH_OF_LEVEL_REGION == 4)) )
 	{
-		if ( map_rng.rand() % 2 && (svFlags & SV_FLAG_MINOTAURS) )
+		if ( rng.rand() % 2 && (svFlags & SV_FLAG_MINOTAURS) )
 		{
-			minotaurlevel = 1;
+			target.minotaurlevel = 1;
 		}
 	}
 
 	// dark level
-	if ( gameplayCustomManager.processedDarkFloor(currentlevel, secretlevel, map.name) )
+	if ( gameplayCustomManager.processedDarkFloor(currentlevel, secretlevel, destmap.name, target.darkmap, rng) )
 	{
 		// function sets dark level for us.
-		if ( darkmap )
+		if ( target.darkmap )
 		{
-			messageLocalPlayers(MESSAGE_HINT, Language::get(1108));
+			target.darkmapHint = true;
 		}
 	}
 	else if ( !secretlevel )
 	{
 		if ( std::get<LEVELPARAM_CHANCE_DARKNESS>(mapParameters) != -1 )
 		{
-			if ( map_rng.rand() % 100 < std::get<LEVELPARAM_CHANCE_DARKNESS>(mapParameters) )
+			if ( rng.rand() % 100 < std::get<LEVELPARAM_CHANCE_DARKNESS>(mapParameters) )
 			{
-				darkmap = true;
-				messageLocalPlayers(MESSAGE_HINT, Language::get(1108));
+				target.darkmap = true;
+				target.darkmapHint = true;
 			}
 			else
 			{
-				darkmap = false;
+				target.darkmap = false;
 			}
 		}
 		else if ( currentlevel % LENGTH_OF_LEVEL_REGION >= 2 )
 		{
-			if ( map_rng.rand() % 4 == 0 )
+			if ( rng.rand() % 4 == 0 )
 			{
-				darkmap = true;
-				messageLocalPlayers(MESSAGE_HINT, Language::get(1108));
+				target.darkmap = true;
+				target.darkmapHint = true;
 			}
 		}
 	}
@@ -987,7 +1399,7 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 	{
 		if ( std::get<LEVELPARAM_CHANCE_SECRET>(mapParameters) != -1 )
 		{
-			if ( map_rng.rand() % 100 < std::get<LEVELPARAM_CHANCE_SECRET>(mapParameters) )
+			if ( rng.rand() % 100 < std::get<LEVELPARAM_CHANCE_SECRET>(mapParameters) )
 			{
 				secretlevelexit = 7;
 			}
@@ -996,7 +1408,7 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 				secretlevelexit = 0;
 			}
 		}
-		else if ( (currentlevel == 3 && map_rng.rand() % 2) || currentlevel == 2 )
+		else if ( (currentlevel == 3 && rng.rand() % 2) || currentlevel == 2 )
 		{
 			secretlevelexit = 1;
 		}
@@ -1046,7 +1458,7 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 	{
 		sublevelname = (char*) malloc(sizeof(char) * 128);
 		std::string shopMapTitle = "shop";
-		if ( MFLAG_GENADJACENTROOMS )
+		if ( genAdjacentRooms )
 		{
 			shopMapTitle = "shop-roomgen";
 		}
@@ -1065,7 +1477,7 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 		}
 		if ( numlevels )
 		{
-			int shopleveltouse = map_rng.rand() % numlevels;
+			int shopleveltouse = rng.rand() % numlevels;
 			strcpy(sublevelname, shopMapTitle.c_str());
 			snprintf(sublevelnum, 3, "%02d", shopleveltouse);
 			strcat(sublevelname, sublevelnum);
@@ -1093,8 +1505,7 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 			}
 			if (!verifyMapHash(fullMapPath.c_str(), checkMapHash))
 			{
-				conductGameChallenges[CONDUCT_MODDED] = 1;
-				Mods::disableSteamAchievements = true;
+				target.modded = true;
 			}
 		}
 		else
@@ -1119,25 +1530,15 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 			break;    // no more levels to load
 		}
 
-		// allocate memory for the next sublevel and attempt to load it
-		tempMap = (map_t*) malloc(sizeof(map_t));
-		tempMap->tiles = nullptr;
-		tempMap->entities = (list_t*) malloc(sizeof(list_t));
-		tempMap->entities->first = nullptr;
-		tempMap->entities->last = nullptr;
-		tempMap->creatures = new list_t;
-		tempMap->creatures->first = nullptr;
-		tempMap->creatures->last = nullptr;
-		tempMap->worldUI = nullptr;
-		if ( fullMapPath.empty() || loadMap(fullMapPath.c_str(), tempMap, tempMap->entities, tempMap->creatures, &checkMapHash) == -1 )
+		// fetch the next sublevel, loading it if it isn't cached yet
+		tempMap = roomTemplateCache.get(fullMapPath, checkMapHash);
+		if ( !tempMap )
 		{
-			mapDeconstructor((void*)tempMap);
 			continue; // failed to load level
 		}
 		if (!verifyMapHash(fullMapPath.c_str(), checkMapHash))
 		{
-			conductGameChallenges[CONDUCT_MODDED] = 1;
-			Mods::disableSteamAchievements = true;
+			target.modded = true;
 		}
 
 		// level is successfully loaded, add it to the pool
@@ -1150,7 +1551,7 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 
 		node = list_AddNodeLast(newList);
 		node->element = tempMap;
-		node->deconstructor = &mapDeconstructor;
+		node->deconstructor = &emptyDeconstructor; // owned by roomTemplateCache
 
 		// more nodes are created to record the exit points on the sublevel
 		for ( y = 0; y < tempMap->height; y++ )
@@ -1272,25 +1673,15 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 			printlog("[SUBMAP GENERATOR] Found map lv %s, count: %d", subRoomName, subroomCount[subRoomNumLevels]);
 			++subroomCount[subRoomNumLevels];
 
-			// allocate memory for the next subroom and attempt to load it
-			subRoomMap = (map_t*)malloc(sizeof(map_t));
-			subRoomMap->tiles = nullptr;
-			subRoomMap->entities = (list_t*)malloc(sizeof(list_t));
-			subRoomMap->entities->first = nullptr;
-			subRoomMap->entities->last = nullptr;
-			subRoomMap->creatures = new list_t;
-			subRoomMap->creatures->first = nullptr;
-			subRoomMap->creatures->last = nullptr;
-			subRoomMap->worldUI = nullptr;
-			if ( fullMapPath.empty() || loadMap(fullMapPath.c_str(), subRoomMap, subRoomMap->entities, subRoomMap->creatures, &checkMapHash) == -1 )
-			{
-				mapDeconstructor((void*)subRoomMap);
+			// fetch the next subroom, loading it if it isn't cached yet
+			subRoomMap = roomTemplateCache.get(fullMapPath, checkMapHash);
+			if ( !subRoomMap )
+			{
 				continue; // failed to load level
 			}
 			if (!verifyMapHash(fullMapPath.c_str(), checkMapHash))
 			{
-				conductGameChallenges[CONDUCT_MODDED] = 1;
-				Mods::disableSteamAchievements = true;
+				target.modded = true;
 			}
 
 			// level is successfully loaded, add it to the pool
@@ -1303,7 +1694,7 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 
 			node = list_AddNodeLast(subRoomList);
 			node->element = subRoomMap;
-			node->deconstructor = &mapDeconstructor;
+			node->deconstructor = &emptyDeconstructor; // owned by roomTemplateCache
 
 			/*if ( subRoomMap->flags[MAP_FLAG_DISABLETRAPS] == 1 )
 			{
@@ -1425,25 +1816,15 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 		printlog("[SUBMAP GENERATOR] Found map lv %s, count: %d", shopSubRoomName, shopSubRooms.count);
 		++shopSubRooms.count;
 
-		// allocate memory for the next subroom and attempt to load it
-		map_t* subRoomMap = (map_t*)malloc(sizeof(map_t));
-		subRoomMap->tiles = nullptr;
-		subRoomMap->entities = (list_t*)malloc(sizeof(list_t));
-		subRoomMap->entities->first = nullptr;
-		subRoomMap->entities->last = nullptr;
-		subRoomMap->creatures = new list_t;
-		subRoomMap->creatures->first = nullptr;
-		subRoomMap->creatures->last = nullptr;
-		subRoomMap->worldUI = nullptr;
-		if ( fullMapPath.empty() || loadMap(fullMapPath.c_str(), subRoomMap, subRoomMap->entities, subRoomMap->creatures, &checkMapHash) == -1 )
+		// fetch the next subroom, loading it if it isn't cached yet
+		map_t* subRoomMap = roomTemplateCache.get(fullMapPath, checkMapHash);
+		if ( !subRoomMap )
 		{
-			mapDeconstructor((void*)subRoomMap);
 			continue; // failed to load level
 		}
 		if (!verifyMapHash(fullMapPath.c_str(), checkMapHash))
 		{
-			conductGameChallenges[CONDUCT_MODDED] = 1;
-			Mods::disableSteamAchievements = true;
+			target.modded = true;
 		}
 
 		// level is successfully loaded, add it to the pool
@@ -1457,7 +1838,7 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 
 		node = list_AddNodeLast(subRoomList);
 		node->element = subRoomMap;
-		node->deconstructor = &mapDeconstructor;
+		node->deconstructor = &emptyDeconstructor; // owned by roomTemplateCache
 
 		// more nodes are created to record the exit points on the sublevel
 		for ( y = 0; y < subRoomMap->height; y++ )
@@ -1544,70 +1925,63 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 		}
 	}
 
-	StartRoomInfo_t startRoomInfo;
+	StartRoomInfo_t startRoomInfo(destmap, rng);
 
 	// generate dungeon level...
 	int roomcount = 0;
 	if ( numlevels > 1 )
 	{
-		possiblelocations = (bool*) malloc(sizeof(bool) * map.width * map.height);
-		trapexcludelocations = (bool*)malloc(sizeof(bool) * map.width * map.height);
-		monsterexcludelocations = (bool*)malloc(sizeof(bool) * map.width * map.height);
-		lootexcludelocations = (bool*)malloc(sizeof(bool) * map.width * map.height);
-		for ( y = 0; y < map.height; y++ )
+		possiblelocations = (bool*) malloc(sizeof(bool) * destmap.width * destmap.height);
+		trapexcludelocations = (bool*)malloc(sizeof(bool) * destmap.width * destmap.height);
+		monsterexcludelocations = (bool*)malloc(sizeof(bool) * destmap.width * destmap.height);
+		lootexcludelocations = (bool*)malloc(sizeof(bool) * destmap.width * destmap.height);
+		for ( y = 0; y < destmap.height; y++ )
 		{
-			for ( x = 0; x < map.width; x++ )
+			for ( x = 0; x < destmap.width; x++ )
 			{
-				if ( x < (std::max(2, getMapPossibleLocationX1()))
-					|| y < (std::max(2, getMapPossibleLocationY1())) 
-					|| x > (std::min(getMapPossibleLocationX2(), (int)map.width - 3))
-					|| y > (std::min(getMapPossibleLocationY2(), (int)map.height - 3)) )
+				if ( x < (std::max(2, getMapPossibleLocationX1(destmap)))
+					|| y < (std::max(2, getMapPossibleLocationY1(destmap))) 
+					|| x > (std::min(getMapPossibleLocationX2(destmap), (int)destmap.width - 3))
+					|| y > (std::min(getMapPossibleLocationY2(destmap), (int)destmap.height - 3)) )
 				{
-					possiblelocations[x + y * map.width] = false;
+					possiblelocations[x + y * destmap.width] = false;
 				}
 				else
 				{
-					possiblelocations[x + y * map.width] = true;
+					possiblelocations[x + y * destmap.width] = true;
 				}
-				trapexcludelocations[x + y * map.width] = false;
-				if ( map.flags[MAP_FLAG_DISABLEMONSTERS] == 1 )
+				trapexcludelocations[x + y * destmap.width] = false;
+				if ( destmap.flags[MAP_FLAG_DISABLEMONSTERS] == 1 )
 				{
 					// the base map excludes all monsters
-					monsterexcludelocations[x + y * map.width] = true;
+					monsterexcludelocations[x + y * destmap.width] = true;
 				}
 				else
 				{
-					monsterexcludelocations[x + y * map.width] = false;
+					monsterexcludelocations[x + y * destmap.width] = false;
 				}
-				if ( map.flags[MAP_FLAG_DISABLELOOT] == 1 )
+				if ( destmap.flags[MAP_FLAG_DISABLELOOT] == 1 )
 				{
 					// the base map excludes all monsters
-					lootexcludelocations[x + y * map.width] = true;
+					lootexcludelocations[x + y * destmap.width] = true;
 				}
 				else
 				{
-					lootexcludelocations[x + y * map.width] = false;
+					lootexcludelocations[x + y * destmap.width] = false;
 				}
 			}
 		}
-		possiblelocations2 = (bool*) malloc(sizeof(bool) * map.width * map.height);
-		firstroomtile = (bool*) malloc(sizeof(bool) * map.width * map.height);
+		possiblelocations2 = (bool*) malloc(sizeof(bool) * destmap.width * destmap.height);
+		firstroomtile = (bool*) malloc(sizeof(bool) * destmap.width * destmap.height);
 		possiblerooms = (bool*) malloc(sizeof(bool) * numlevels);
 		for ( c = 0; c < numlevels; c++ )
 		{
 			possiblerooms[c] = true;
 		}
-		levellimit = (map.width * map.height);
+		BlockedTileTable_t blockedTiles;
+		levellimit = (destmap.width * destmap.height);
 		for ( c = 0; c < levellimit; c++ )
 		{
-			// reset array of possible locations for the current room
-			for ( y = 0; y < map.height; y++ )
-			{
-				for ( x = 0; x < map.width; x++ )
-				{
-					possiblelocations2[x + y * map.width] = true;
-				}
-			}
 			doorNode = nullptr;
 
 			// pick the room to be used
@@ -1674,8 +2048,7 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 				}
 				if (!verifyMapHash(fullMapPath.c_str(), checkMapHash))
 				{
-					conductGameChallenges[CONDUCT_MODDED] = 1;
-					Mods::disableSteamAchievements = true;
+					target.modded = true;
 				}
 
 				levelnum = 0;
@@ -1695,7 +2068,7 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 				{
 					break;
 				}
-				levelnum = map_rng.rand() % (numlevels); // draw randomly from the pool
+				levelnum = rng.rand() % (numlevels); // draw randomly from the pool
 
 				// traverse the map list to the picked level
 				node = mapList.first;
@@ -1721,27 +2094,23 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 			}
 
 			// find locations where the selected room can be added to the level
-			numpossiblelocations = map.width * map.height;
-
-			bool hellGenerationFix = !strncmp(map.name, "Hell", 4) && !MFLAG_GENADJACENTROOMS;
+			bool hellGenerationFix = !strncmp(destmap.name, "Hell", 4) && !genAdjacentRooms;
 
-			for ( y0 = 0; y0 < map.height; y0++ )
+			// don't generate start room in hell along the rightmost wall, causes pathing to fail. Check 2 tiles to the right extra
+			// to try fit start room.
+			const int footprintW = tempMap->width + ((hellGenerationFix && c == 0) ? 2 : 0);
+			const int footprintH = tempMap->height;
+			numpossiblelocations = findRoomLocations(blockedTiles, possiblelocations, possiblelocations2,
+				destmap.width, destmap.height, footprintW, footprintH);
+			if ( *cvar_mapgen_verify_rooms )
 			{
-				for ( x0 = 0; x0 < map.width; x0++ )
+				std::unique_ptr<bool[]> reference(new bool[destmap.width * destmap.height]);
+				const Sint32 referenceCount = findRoomLocationsReference(possiblelocations, reference.get(),
+					destmap.width, destmap.height, footprintW, footprintH);
+				if ( referenceCount != numpossiblelocations
+					|| !std::equal(reference.get(), reference.get() + destmap.width * destmap.height, possiblelocations2) )
 				{
-					for ( y1 = y0; y1 < std::min(y0 + tempMap->height, map.height); y1++ )
-					{
-						// don't generate start room in hell along the rightmost wall, causes pathing to fail. Check 2 tiles to the right extra
-						// to try fit start room.
-						for ( x1 = x0; x1 < std::min(x0 + tempMap->width + ((hellGenerationFix && c == 0) ? 2 : 0), map.width); x1++ )
-						{
-							if ( possiblelocations[x1 + y1 * map.width] == false && possiblelocations2[x0 + y0 * map.width] == true )
-							{
-								possiblelocations2[x0 + y0 * map.width] = false;
-								numpossiblelocations--;
-							}
-						}
-					}
+					printlog("[rooms] placement mismatch on seed %u room %d: %d vs %d spots", seed, c, referenceCount, numpossiblelocations);
 				}
 			}
 
@@ -1801,53 +2170,53 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 			}
 
 			// otherwise, choose a location from those available (to be stored in x/y)
-			if ( MFLAG_GENADJACENTROOMS )
+			if ( genAdjacentRooms )
 			{
 				pickedlocation = 0;
 				i = -1;
 				x = 0;
 				y = 0;
 
-				if ( !strncmp(map.name, "Citadel", 7) )
+				if ( !strncmp(destmap.name, "Citadel", 7) )
 				{
 					if ( c == 0 )
 					{
 						// 7x7, pick random location across all map.
-						x = 2 + (map_rng.rand() % 7) * 7;
-						y = 2 + (map_rng.rand() % 7) * 7;
+						x = 2 + (rng.rand() % 7) * 7;
+						y = 2 + (rng.rand() % 7) * 7;
 					}
 					else if ( secretlevelexit && c == 1 )
 					{
 						// 14x14, pick random location minus 1 from both edges.
-						x = 2 + (map_rng.rand() % 6) * 7;
-						y = 2 + (map_rng.rand() % 6) * 7;
+						x = 2 + (rng.rand() % 6) * 7;
+						y = 2 + (rng.rand() % 6) * 7;
 					}
 					else if ( c == 2 && shoplevel )
 					{
 						// 7x7, pick random location across all map.
-						x = 2 + (map_rng.rand() % 7) * 7;
-						y = 2 + (map_rng.rand() % 7) * 7;
+						x = 2 + (rng.rand() % 7) * 7;
+						y = 2 + (rng.rand() % 7) * 7;
 					}
 				}
-				else if ( !strncmp(map.name, "Hell", 4) )
+				else if ( !strncmp(destmap.name, "Hell", 4) )
 				{
 					if ( c == 0 )
 					{
 						// 7x7, pick random location across all map.
-						x = getMapPossibleLocationX1() + (1 + map_rng.rand() % 4) * 7;
-						y = getMapPossibleLocationY1() + (1 + map_rng.rand() % 4) * 7;
+						x = getMapPossibleLocationX1(destmap) + (1 + rng.rand() % 4) * 7;
+						y = getMapPossibleLocationY1(destmap) + (1 + rng.rand() % 4) * 7;
 					}
 					else if ( secretlevelexit && c == 1 )
 					{
 						// 14x14, pick random location minus 1 from both edges.
-						x = 2 + (map_rng.rand() % 5) * 7;
-						y = 2 + (map_rng.rand() % 5) * 7;
+						x = 2 + (rng.rand() % 5) * 7;
+						y = 2 + (rng.rand() % 5) * 7;
 					}
 					else if ( c == 2 && shoplevel )
 					{
 						// 7x7, pick random location across all map.
-						x = 2 + (map_rng.rand() % 6) * 7;
-						y = 2 + (map_rng.rand() % 6) * 7;
+						x = 2 + (rng.rand() % 6) * 7;
+						y = 2 + (rng.rand() % 6) * 7;
 					}
 				}
 				else
@@ -1855,33 +2224,33 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 					if ( c == 0 )
 					{
 						// pick random location across all map.
-						x = 2 + (map_rng.rand() % tempMap->width) * tempMap->width;
-						y = 2 + (map_rng.rand() % tempMap->height) * tempMap->height;
+						x = 2 + (rng.rand() % tempMap->width) * tempMap->width;
+						y = 2 + (rng.rand() % tempMap->height) * tempMap->height;
 					}
 					else if ( secretlevelexit && c == 1 )
 					{
-						x = 2 + (map_rng.rand() % tempMap->width) * tempMap->width;
-						y = 2 + (map_rng.rand() % tempMap->height) * tempMap->height;
-						while ( x + tempMap->width >= map.width )
+						x = 2 + (rng.rand() % tempMap->width) * tempMap->width;
+						y = 2 + (rng.rand() % tempMap->height) * tempMap->height;
+						while ( x + tempMap->width >= destmap.width )
 						{
-							x = 2 + (map_rng.rand() % tempMap->width) * tempMap->width;
+							x = 2 + (rng.rand() % tempMap->width) * tempMap->width;
 						}
-						while ( y + tempMap->height >= map.height )
+						while ( y + tempMap->height >= destmap.height )
 						{
-							y = 2 + (map_rng.rand() % tempMap->height) * tempMap->height;
+							y = 2 + (rng.rand() % tempMap->height) * tempMap->height;
 						}
 					}
 					else if ( c == 2 && shoplevel )
 					{
 						// pick random location across all map.
-						x = 2 + (map_rng.rand() % tempMap->width) * tempMap->width;
-						y = 2 + (map_rng.rand() % tempMap->height) * tempMap->height;
+						x = 2 + (rng.rand() % tempMap->width) * tempMap->width;
+						y = 2 + (rng.rand() % tempMap->height) * tempMap->height;
 					}
 				}
 
 				while ( 1 )
 				{
-					if ( possiblelocations2[x + y * map.width] == true )
+					if ( possiblelocations2[x + y * destmap.width] == true )
 					{
 						++i;
 						if ( i == pickedlocation )
@@ -1890,11 +2259,11 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 						}
 					}
 					++x;
-					if ( x >= map.width )
+					if ( x >= destmap.width )
 					{
 						x = 0;
 						++y;
-						if ( y >= map.height )
+						if ( y >= destmap.height )
 						{
 							y = 0;
 							++pickedlocation;
@@ -1904,13 +2273,13 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 			}
 			else
 			{
-				pickedlocation = map_rng.rand() % numpossiblelocations;
+				pickedlocation = rng.rand() % numpossiblelocations;
 				i = -1;
 				x = 0;
 				y = 0;
 				while ( 1 )
 				{
-					if ( possiblelocations2[x + y * map.width] == true )
+					if ( possiblelocations2[x + y * destmap.width] == true )
 					{
 						++i;
 						if ( i == pickedlocation )
@@ -1919,11 +2288,11 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 						}
 					}
 					++x;
-					if ( x >= map.width )
+					if ( x >= destmap.width )
 					{
 						x = 0;
 						++y;
-						if ( y >= map.height )
+						if ( y >= destmap.height )
 						{
 							y = 0;
 						}
@@ -1934,7 +2303,7 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 			// now copy all the geometry from the sublevel to the chosen location
 			if ( c == 0 )
 			{
-				for ( z = 0; z < map.width * map.height; ++z )
+				for ( z = 0; z < destmap.width * destmap.height; ++z )
 				{
 					firstroomtile[z] = false;
 				}
@@ -1952,7 +2321,7 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 			bool foundSubRoom = false;
 			if ( c == 2 && shoplevel && tempMap == &shopmap && shopSubRooms.count > 0 )
 			{
-				pickSubRoom = map_rng.rand() % shopSubRooms.count;
+				pickSubRoom = rng.rand() % shopSubRooms.count;
 				subRoomNode = shopSubRooms.list.first;
 				int k = 0;
 				while ( 1 )
@@ -1983,7 +2352,7 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 				if ( subroomCount[levelnum + 1] > 0 )
 				{
 					int jumps = 0;
-					pickSubRoom = map_rng.rand() % subroomCount[levelnum + 1];
+					pickSubRoom = rng.rand() % subroomCount[levelnum + 1];
 					// traverse the map list to the picked level
 					subRoomNode = subRoomMapList.first;
 					for ( int cycleRooms = 0; (cycleRooms < levelnum + 1) && (subRoomNode != nullptr); ++cycleRooms )
@@ -2045,23 +2414,23 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 								}
 							}
 
-							map.tiles[z + y0 * MAPLAYERS + x0 * MAPLAYERS * map.height] = subRoomMap->tiles[z + (subRoom_tiley)* MAPLAYERS + (subRoom_tilex)* MAPLAYERS * subRoomMap->height];
+							destmap.tiles[z + y0 * MAPLAYERS + x0 * MAPLAYERS * destmap.height] = subRoomMap->tiles[z + (subRoom_tiley)* MAPLAYERS + (subRoom_tilex)* MAPLAYERS * subRoomMap->height];
 
 							if ( z == 0 )
 							{
 								// apply submap disable flags
 								if ( subRoomMap->flags[MAP_FLAG_DISABLETRAPS] == 1 )
 								{
-									trapexcludelocations[x0 + y0 * map.width] = true;
-									//map.tiles[z + y0 * MAPLAYERS + x0 * MAPLAYERS * map.height] = 83;
+									trapexcludelocations[x0 + y0 * destmap.width] = true;
+									//destmap.tiles[z + y0 * MAPLAYERS + x0 * MAPLAYERS * destmap.height] = 83;
 								}
 								if ( subRoomMap->flags[MAP_FLAG_DISABLEMONSTERS] == 1 )
 								{
-									monsterexcludelocations[x0 + y0 * map.width] = true;
+									monsterexcludelocations[x0 + y0 * destmap.width] = true;
 								}
 								if ( subRoomMap->flags[MAP_FLAG_DISABLELOOT] == 1 )
 								{
-									lootexcludelocations[x0 + y0 * map.width] = true;
+									lootexcludelocations[x0 + y0 * destmap.width] = true;
 								}
 							}
 
@@ -2078,42 +2447,43 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 						}
 						else
 						{
-							map.tiles[z + y0 * MAPLAYERS + x0 * MAPLAYERS * map.height] = tempMap->tiles[z + (y0 - y) * MAPLAYERS + (x0 - x) * MAPLAYERS * tempMap->height];
+							destmap.tiles[z + y0 * MAPLAYERS + x0 * MAPLAYERS * destmap.height] = tempMap->tiles[z + (y0 - y) * MAPLAYERS + (x0 - x) * MAPLAYERS * tempMap->height];
 						}
 
 						if ( z == 0 )
 						{
-							possiblelocations[x0 + y0 * map.width] = false;
+							possiblelocations[x0 + y0 * destmap.width] = false;
+							blockedTiles.dirty = true;
 							if ( tempMap->flags[MAP_FLAG_DISABLETRAPS] == 1 )
 							{
-								trapexcludelocations[x0 + y0 * map.width] = true;
-								//map.tiles[z + y0 * MAPLAYERS + x0 * MAPLAYERS * map.height] = 83;
+								trapexcludelocations[x0 + y0 * destmap.width] = true;
+								//destmap.tiles[z + y0 * MAPLAYERS + x0 * MAPLAYERS * destmap.height] = 83;
 							}
 							if ( tempMap->flags[MAP_FLAG_DISABLEMONSTERS] == 1 )
 							{
-								monsterexcludelocations[x0 + y0 * map.width] = true;
+								monsterexcludelocations[x0 + y0 * destmap.width] = true;
 							}
 							if ( tempMap->flags[MAP_FLAG_DISABLELOOT] == 1 )
 							{
-								lootexcludelocations[x0 + y0 * map.width] = true;
+								lootexcludelocations[x0 + y0 * destmap.width] = true;
 							}
 							if ( c == 0 )
 							{
-								firstroomtile[y0 + x0 * map.height] = true;
+								firstroomtile[y0 + x0 * destmap.height] = true;
 								startRoomInfo.addCoord(x0, y0);
 							}
 							else if ( c == 2 && shoplevel )
 							{
-								firstroomtile[y0 + x0 * map.height] = true;
+								firstroomtile[y0 + x0 * destmap.height] = true;
 								if ( x0 - x > 0 && y0 - y > 0 && x0 - x < tempMap->width - 1 && y0 - y < tempMap->height - 1 )
 								{
-									shoparea[y0 + x0 * map.height] = true;
+									target.shoparea[y0 + x0 * destmap.height] = true;
 								}
 							}
 						}
 
 						// remove any existing entities in this region too
-						for ( node = map.entities->first; node != nullptr; node = nextnode )
+						for ( node = destmap.entities->first; node != nullptr; node = nextnode )
 						{
 							nextnode = node->next;
 							Entity* entity = (Entity*)node->element;
@@ -2130,26 +2500,24 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 			for ( node = tempMap->entities->first; node != nullptr; node = node->next )
 			{
 				entity = (Entity*)node->element;
-				childEntity = newEntity(entity->sprite, 1, map.entities, nullptr);
+				childEntity = newEntity(entity->sprite, 1, destmap.entities, nullptr);
 
 				// entity will return nullptr on getStats called in setSpriteAttributes as behaviour &actmonster is not set.
 				// check if the monster sprite is correct and set the behaviour manually for getStats.
+				// the template is restored afterwards as it is reused by later generations.
+				auto templateBehavior = entity->behavior;
 				if ( checkSpriteType(entity->sprite) == 1 && multiplayer != CLIENT )
 				{
 					entity->behavior = &actMonster;
 				}
 
 				setSpriteAttributes(childEntity, entity, entity);
+				entity->behavior = templateBehavior;
 				childEntity->x = entity->x + x * 16;
 				childEntity->y = entity->y + y * 16;
 				childEntity->mapGenerationRoomX = x;
 				childEntity->mapGenerationRoomY = y;
 				//printlog("1 Generated entity. Sprite: %d Uid: %d X: %.2f Y: %.2f\n",childEntity->sprite,childEntity->getUID(),childEntity->x,childEntity->y);
-
-				if ( entity->behavior == &actMonster || entity->behavior == &actPlayer )
-				{
-					entity->addToCreatureList(map.creatures);
-				}
 			}
 
 			if ( foundSubRoom )
@@ -2158,24 +2526,22 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 				for ( subRoomNode = subRoomMap->entities->first; subRoomNode != nullptr; subRoomNode = subRoomNode->next )
 				{
 					entity = (Entity*)subRoomNode->element;
-					childEntity = newEntity(entity->sprite, 1, map.entities, nullptr);
+					childEntity = newEntity(entity->sprite, 1, destmap.entities, nullptr);
 
 					// entity will return nullptr on getStats called in setSpriteAttributes as behaviour &actmonster is not set.
 					// check if the monster sprite is correct and set the behaviour manually for getStats.
+					auto templateBehavior = entity->behavior;
 					if ( checkSpriteType(entity->sprite) == 1 && multiplayer != CLIENT )
 					{
 						entity->behavior = &actMonster;
 					}
 
 					setSpriteAttributes(childEntity, entity, entity);
+					entity->behavior = templateBehavior;
 					childEntity->x = entity->x + subRoom_tileStartx * 16;
 					childEntity->y = entity->y + subRoom_tileStarty * 16;
 					childEntity->mapGenerationRoomX = subRoom_tileStartx;
 					childEntity->mapGenerationRoomY = subRoom_tileStarty;
-					if ( entity->behavior == &actMonster || entity->behavior == &actPlayer )
-					{
-						entity->addToCreatureList(map.creatures);
-					}
 
 					//messagePlayer(0, "1 Generated entity. Sprite: %d X: %.2f Y: %.2f", childEntity->sprite, childEntity->x / 16, childEntity->y / 16);
 				}
@@ -2261,7 +2627,7 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 	for ( node = doorList.first; node != nullptr; node = node->next )  // loop through gates first to delete conflicting gates/doors
 	{
 		door = (door_t*)node->element;
-		for (node2 = map.entities->first; node2 != nullptr; node2 = node2->next)
+		for (node2 = destmap.entities->first; node2 != nullptr; node2 = node2->next)
 		{
 			entity = (Entity*)node2->element;
 			if ( entity->x / 16 == door->x && entity->y / 16 == door->y 
@@ -2319,8 +2685,8 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 				switch ( doordir )
 				{
 					case door_t::DIR_EAST: // east
-						map.tiles[OBSTACLELAYER + door->y * MAPLAYERS + (door->x + 1)*MAPLAYERS * map.height] = 0;
-						for ( node3 = map.entities->first; node3 != nullptr; node3 = nextnode )
+						destmap.tiles[OBSTACLELAYER + door->y * MAPLAYERS + (door->x + 1)*MAPLAYERS * destmap.height] = 0;
+						for ( node3 = destmap.entities->first; node3 != nullptr; node3 = nextnode )
 						{
 							entity = (Entity*)node3->element;
 							nextnode = node3->next;
@@ -2347,8 +2713,8 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 						}
 						break;
 					case door_t::DIR_SOUTH: // south
-						map.tiles[OBSTACLELAYER + (door->y + 1)*MAPLAYERS + door->x * MAPLAYERS * map.height] = 0;
-						for ( node3 = map.entities->first; node3 != nullptr; node3 = nextnode )
+						destmap.tiles[OBSTACLELAYER + (door->y + 1)*MAPLAYERS + door->x * MAPLAYERS * destmap.height] = 0;
+						for ( node3 = destmap.entities->first; node3 != nullptr; node3 = nextnode )
 						{
 							entity = (Entity*)node3->element;
 							nextnode = node3->next;
@@ -2375,8 +2741,8 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 						}
 						break;
 					case door_t::DIR_WEST: // west
-						map.tiles[OBSTACLELAYER + door->y * MAPLAYERS + (door->x - 1)*MAPLAYERS * map.height] = 0;
-						for ( node3 = map.entities->first; node3 != nullptr; node3 = nextnode )
+						destmap.tiles[OBSTACLELAYER + door->y * MAPLAYERS + (door->x - 1)*MAPLAYERS * destmap.height] = 0;
+						for ( node3 = destmap.entities->first; node3 != nullptr; node3 = nextnode )
 						{
 							entity = (Entity*)node3->element;
 							nextnode = node3->next;
@@ -2403,8 +2769,8 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 						}
 						break;
 					case door_t::DIR_NORTH: // north
-						map.tiles[OBSTACLELAYER + (door->y - 1)*MAPLAYERS + door->x * MAPLAYERS * map.height] = 0;
-						for ( node3 = map.entities->first; node3 != nullptr; node3 = nextnode )
+						destmap.tiles[OBSTACLELAYER + (door->y - 1)*MAPLAYERS + door->x * MAPLAYERS * destmap.height] = 0;
+						for ( node3 = destmap.entities->first; node3 != nullptr; node3 = nextnode )
 						{
 							entity = (Entity*)node3->element;
 							nextnode = node3->next;
@@ -2439,7 +2805,7 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 	for ( node = doorList.first; node != nullptr; node = node->next ) // now loop through doors to delete conflicting gates/doors
 	{
 		door = (door_t*)node->element;
-		for ( node2 = map.entities->first; node2 != nullptr; node2 = node2->next )
+		for ( node2 = destmap.entities->first; node2 != nullptr; node2 = node2->next )
 		{
 			entity = (Entity*)node2->element;
 			if ( entity->x / 16 == door->x && entity->y / 16 == door->y
@@ -2499,8 +2865,8 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 				switch ( doordir )
 				{
 					case door_t::DIR_EAST: // east
-						map.tiles[OBSTACLELAYER + door->y * MAPLAYERS + (door->x + 1)*MAPLAYERS * map.height] = 0;
-						for ( node3 = map.entities->first; node3 != nullptr; node3 = nextnode )
+						destmap.tiles[OBSTACLELAYER + door->y * MAPLAYERS + (door->x + 1)*MAPLAYERS * destmap.height] = 0;
+						for ( node3 = destmap.entities->first; node3 != nullptr; node3 = nextnode )
 						{
 							entity = (Entity*)node3->element;
 							nextnode = node3->next;
@@ -2527,8 +2893,8 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 						}
 						break;
 					case door_t::DIR_SOUTH: // south
-						map.tiles[OBSTACLELAYER + (door->y + 1)*MAPLAYERS + door->x * MAPLAYERS * map.height] = 0;
-						for ( node3 = map.entities->first; node3 != nullptr; node3 = nextnode )
+						destmap.tiles[OBSTACLELAYER + (door->y + 1)*MAPLAYERS + door->x * MAPLAYERS * destmap.height] = 0;
+						for ( node3 = destmap.entities->first; node3 != nullptr; node3 = nextnode )
 						{
 							entity = (Entity*)node3->element;
 							nextnode = node3->next;
@@ -2555,8 +2921,8 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 						}
 						break;
 					case door_t::DIR_WEST: // west
-						map.tiles[OBSTACLELAYER + door->y * MAPLAYERS + (door->x - 1)*MAPLAYERS * map.height] = 0;
-						for ( node3 = map.entities->first; node3 != nullptr; node3 = nextnode )
+						destmap.tiles[OBSTACLELAYER + door->y * MAPLAYERS + (door->x - 1)*MAPLAYERS * destmap.height] = 0;
+						for ( node3 = destmap.entities->first; node3 != nullptr; node3 = nextnode )
 						{
 							entity = (Entity*)node3->element;
 							nextnode = node3->next;
@@ -2583,8 +2949,8 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 						}
 						break;
 					case door_t::DIR_NORTH: // north
-						map.tiles[OBSTACLELAYER + (door->y - 1)*MAPLAYERS + door->x * MAPLAYERS * map.height] = 0;
-						for ( node3 = map.entities->first; node3 != nullptr; node3 = nextnode )
+						destmap.tiles[OBSTACLELAYER + (door->y - 1)*MAPLAYERS + door->x * MAPLAYERS * destmap.height] = 0;
+						for ( node3 = destmap.entities->first; node3 != nullptr; node3 = nextnode )
 						{
 							entity = (Entity*)node3->element;
 							nextnode = node3->next;
@@ -2618,13 +2984,13 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 	// if for whatever reason some submap 201 tiles didn't get filled in, let's get rid of those.
 	for ( z = 0; z < MAPLAYERS; ++z )
 	{
-		for ( y = 1; y < map.height; ++y )
+		for ( y = 1; y < destmap.height; ++y )
 		{
-			for ( x = 1; x < map.height; ++x )
+			for ( x = 1; x < destmap.height; ++x )
 			{
-				if ( map.tiles[z + y * MAPLAYERS + x * MAPLAYERS * map.height] == 201 )
+				if ( destmap.tiles[z + y * MAPLAYERS + x * MAPLAYERS * destmap.height] == 201 )
 				{
-					map.tiles[z + y * MAPLAYERS + x * MAPLAYERS * map.height] = 0;
+					destmap.tiles[z + y * MAPLAYERS + x * MAPLAYERS * destmap.height] = 0;
 					foundsubmaptile = true;
 				}
 			}
@@ -2635,10 +3001,10 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 		printlog("[SUBMAP GENERATOR] Found some junk tiles!");
 	}
 
-	for ( node = map.entities->first; node != nullptr; node = node->next )
+	for ( node = destmap.entities->first; node != nullptr; node = node->next )
 	{
 		// fix gate air-gap borders on citadel map next to perimeter gates.
-		if ( !strncmp(map.name, "Citadel", 7) )
+		if ( !strncmp(destmap.name, "Citadel", 7) )
 		{
 			Entity* gateEntity = (Entity*)node->element;
 			if ( gateEntity->sprite == 19 || gateEntity->sprite == 20 ) // N/S E/W gates take these sprite numbers in the editor.
@@ -2649,33 +3015,33 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 				{
 					if ( gateEntity->x / 16 == 1 ) // along leftmost edge
 					{
-						if ( !map.tiles[z + gatey * MAPLAYERS + (gatex + 1) * MAPLAYERS * map.height] )
+						if ( !destmap.tiles[z + gatey * MAPLAYERS + (gatex + 1) * MAPLAYERS * destmap.height] )
 						{
-							map.tiles[z + gatey * MAPLAYERS + (gatex + 1) * MAPLAYERS * map.height] = 230;
+							destmap.tiles[z + gatey * MAPLAYERS + (gatex + 1) * MAPLAYERS * destmap.height] = 230;
 							//messagePlayer(0, "replaced at: %d, %d", gatex, gatey);
 						}
 					}
 					else if ( gateEntity->x / 16 == 51 ) // along rightmost edge
 					{
-						if ( !map.tiles[z + gatey * MAPLAYERS + (gatex - 1) * MAPLAYERS * map.height] )
+						if ( !destmap.tiles[z + gatey * MAPLAYERS + (gatex - 1) * MAPLAYERS * destmap.height] )
 						{
-							map.tiles[z + gatey * MAPLAYERS + (gatex - 1) * MAPLAYERS * map.height] = 230;
+							destmap.tiles[z + gatey * MAPLAYERS + (gatex - 1) * MAPLAYERS * destmap.height] = 230;
 							//messagePlayer(0, "replaced at: %d, %d", gatex, gatey);
 						}
 					}
 					else if ( gateEntity->y / 16 == 1 ) // along top edge
 					{
-						if ( !map.tiles[z + (gatey + 1) * MAPLAYERS + gatex * MAPLAYERS * map.height] )
+						if ( !destmap.tiles[z + (gatey + 1) * MAPLAYERS + gatex * MAPLAYERS * destmap.height] )
 						{
-							map.tiles[z + (gatey + 1) * MAPLAYERS + gatex * MAPLAYERS * map.height] = 230;
+							destmap.tiles[z + (gatey + 1) * MAPLAYERS + gatex * MAPLAYERS * destmap.height] = 230;
 							//messagePlayer(0, "replaced at: %d, %d", gatex, gatey);
 						}
 					}
 					else if ( gateEntity->y / 16 == 51 ) // along bottom edge
 					{
-						if ( !map.tiles[z + (gatey - 1) * MAPLAYERS + gatex * MAPLAYERS * map.height] )
+						if ( !destmap.tiles[z + (gatey - 1) * MAPLAYERS + gatex * MAPLAYERS * destmap.height] )
 						{
-							map.tiles[z + (gatey - 1) * MAPLAYERS + gatex * MAPLAYERS * map.height] = 230;
+							destmap.tiles[z + (gatey - 1) * MAPLAYERS + gatex * MAPLAYERS * destmap.height] = 230;
 							//messagePlayer(0, "replaced at: %d, %d", gatex, gatey);
 						}
 					}
@@ -2693,9 +3059,9 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 		bool verticalSpelltraps = false;
 	} customTraps;
 
-	if ( gameplayCustomManager.inUse() && gameplayCustomManager.mapGenerationExistsForMapName(map.name) )
+	if ( gameplayCustomManager.inUse() && gameplayCustomManager.mapGenerationExistsForMapName(destmap.name) )
 	{
-		auto m = gameplayCustomManager.getMapGenerationForMapName(map.name);
+		auto m = gameplayCustomManager.getMapGenerationForMapName(destmap.name);
 		if ( m && m->usingTrapTypes )
 		{
 			customTrapsForMapInUse = true;
@@ -2722,61 +3088,61 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 	}
 
 	// boulder and arrow traps
-	if ( (svFlags & SV_FLAG_TRAPS) && map.flags[MAP_FLAG_DISABLETRAPS] == 0
+	if ( (svFlags & SV_FLAG_TRAPS) && destmap.flags[MAP_FLAG_DISABLETRAPS] == 0
 		&& (!customTrapsForMapInUse || (customTrapsForMapInUse && (customTraps.boulders || customTraps.arrows)) )
 		)
 	{
 		numpossiblelocations = 0;
-		for ( c = 0; c < map.width * map.height; ++c )
+		for ( c = 0; c < destmap.width * destmap.height; ++c )
 		{
 			possiblelocations[c] = false;
 		}
 		std::unordered_map<int, int> trapLocationAndSide;
-		for ( y = 1; y < map.height - 1; ++y )
+		for ( y = 1; y < destmap.height - 1; ++y )
 		{
-			for ( x = 1; x < map.width - 1; ++x )
+			for ( x = 1; x < destmap.width - 1; ++x )
 			{
 				int sides = 0;
-				if ( firstroomtile[y + x * map.height] )
+				if ( firstroomtile[y + x * destmap.height] )
 				{
 					continue;
 				}
-				if ( !map.tiles[OBSTACLELAYER + y * MAPLAYERS + (x + 1)*MAPLAYERS * map.height] )
+				if ( !destmap.tiles[OBSTACLELAYER + y * MAPLAYERS + (x + 1)*MAPLAYERS * destmap.height] )
 				{
 					sides++;
 				}
-				if ( !map.tiles[OBSTACLELAYER + (y + 1)*MAPLAYERS + x * MAPLAYERS * map.height] )
+				if ( !destmap.tiles[OBSTACLELAYER + (y + 1)*MAPLAYERS + x * MAPLAYERS * destmap.height] )
 				{
 					sides++;
 				}
-				if ( !map.tiles[OBSTACLELAYER + y * MAPLAYERS + (x - 1)*MAPLAYERS * map.height] )
+				if ( !destmap.tiles[OBSTACLELAYER + y * MAPLAYERS + (x - 1)*MAPLAYERS * destmap.height] )
 				{
 					sides++;
 				}
-				if ( !map.tiles[OBSTACLELAYER + (y - 1)*MAPLAYERS + x * MAPLAYERS * map.height] )
+				if ( !destmap.tiles[OBSTACLELAYER + (y - 1)*MAPLAYERS + x * MAPLAYERS * destmap.height] )
 				{
 					sides++;
 				}
 				int side = 0;
-				if ( !map.tiles[OBSTACLELAYER + y * MAPLAYERS + (x + 1)*MAPLAYERS * map.height] )
+				if ( !destmap.tiles[OBSTACLELAYER + y * MAPLAYERS + (x + 1)*MAPLAYERS * destmap.height] )
 				{
 					side = 0;
 				}
-				else if ( !map.tiles[OBSTACLELAYER + (y + 1)*MAPLAYERS + x * MAPLAYERS * map.height] )
+				else if ( !destmap.tiles[OBSTACLELAYER + (y + 1)*MAPLAYERS + x * MAPLAYERS * destmap.height] )
 				{
 					side = 1;
 				}
-				else if ( !map.tiles[OBSTACLELAYER + y * MAPLAYERS + (x - 1)*MAPLAYERS * map.height] )
+				else if ( !destmap.tiles[OBSTACLELAYER + y * MAPLAYERS + (x - 1)*MAPLAYERS * destmap.height] )
 				{
 					side = 2;
 				}
-				else if ( !map.tiles[OBSTACLELAYER + (y - 1)*MAPLAYERS + x * MAPLAYERS * map.height] )
+				else if ( !destmap.tiles[OBSTACLELAYER + (y - 1)*MAPLAYERS + x * MAPLAYERS * destmap.height] )
 				{
 					side = 3;
 				}
-				if ( sides == 1 && (trapexcludelocations[x + y * map.width] == false) )
+				if ( sides == 1 && (trapexcludelocations[x + y * destmap.width] == false) )
 				{
-					possiblelocations[y + x * map.height] = true;
+					possiblelocations[y + x * destmap.height] = true;
 					numpossiblelocations++;
 
 					int trapTileX = x + (side == 0 ? 1 : 0) + (side == 2 ? -1 : 0);
@@ -2791,17 +3157,17 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 		for ( doorNode = doorList.first; doorNode != nullptr; doorNode = doorNode->next )
 		{
 			door_t* door = (door_t*)doorNode->element;
-			int x = std::min<unsigned int>(std::max(0, door->x), map.width - 1); //TODO: Why are const int and unsigned int being compared?
-			int y = std::min<unsigned int>(std::max(0, door->y), map.height - 1); //TODO: Why are const int and unsigned int being compared?
-			if ( possiblelocations[y + x * map.height] == true )
+			int x = std::min<unsigned int>(std::max(0, door->x), destmap.width - 1); //TODO: Why are const int and unsigned int being compared?
+			int y = std::min<unsigned int>(std::max(0, door->y), destmap.height - 1); //TODO: Why are const int and unsigned int being compared?
+			if ( possiblelocations[y + x * destmap.height] == true )
 			{
-				possiblelocations[y + x * map.height] = false;
+				possiblelocations[y + x * destmap.height] = false;
 				--numpossiblelocations;
 			}
 		}
 
 		bool arrowtrappotential = false;
-		if ( !strncmp(map.name, "Hell", 4) )
+		if ( !strncmp(destmap.name, "Hell", 4) )
 		{
 			arrowtrappotential = true;
 		}
@@ -2814,13 +3180,13 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 		std::vector<Entity*> ceilingTilesToDeleteForBoulders;
 
 		// do a second pass to look for internal doorways
-		for ( node = map.entities->first; node != nullptr; node = node->next )
+		for ( node = destmap.entities->first; node != nullptr; node = node->next )
 		{
 			entity = (Entity*)node->element;
 			int x = entity->x / 16;
 			int y = entity->y / 16;
-			if ( (x >= 1 && x < map.width - 1)
-				&& (y >= 1 && y < map.height - 1) )
+			if ( (x >= 1 && x < destmap.width - 1)
+				&& (y >= 1 && y < destmap.height - 1) )
 			{
 				if ( mapSpriteIsDoorway(entity->sprite) )
 				{
@@ -2830,9 +3196,9 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 						int side = find->second;
 						int trapx = x + (side == 0 ? -1 : 0) + (side == 2 ? 1 : 0);
 						int trapy = y + (side == 1 ? -1 : 0) + (side == 3 ? 1 : 0);
-						if ( possiblelocations[trapy + trapx * map.height] )
+						if ( possiblelocations[trapy + trapx * destmap.height] )
 						{
-							possiblelocations[trapy + trapx * map.height] = false;
+							possiblelocations[trapy + trapx * destmap.height] = false;
 							--numpossiblelocations;
 						}
 					}
@@ -2849,9 +3215,9 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 								int side = find->second;
 								int trapx = x + (side == 0 ? -1 : 0) + (side == 2 ? 1 : 0);
 								int trapy = y + (side == 1 ? -1 : 0) + (side == 3 ? 1 : 0);
-								if ( possiblelocations[trapy + trapx * map.height] )
+								if ( possiblelocations[trapy + trapx * destmap.height] )
 								{
-									possiblelocations[trapy + trapx * map.height] = false;
+									possiblelocations[trapy + trapx * destmap.height] = false;
 									--numpossiblelocations;
 								}
 							}
@@ -2874,9 +3240,9 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 						int side = find->second;
 						int trapx = x + (side == 0 ? -1 : 0) + (side == 2 ? 1 : 0);
 						int trapy = y + (side == 1 ? -1 : 0) + (side == 3 ? 1 : 0);
-						if ( possiblelocations[trapy + trapx * map.height] )
+						if ( possiblelocations[trapy + trapx * destmap.height] )
 						{
-							possiblelocations[trapy + trapx * map.height] = false;
+							possiblelocations[trapy + trapx * destmap.height] = false;
 							--numpossiblelocations;
 						}
 					}
@@ -2884,8 +3250,8 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 			}
 		}
 
-		int whatever = map_rng.rand() % 5;
-		if ( strncmp(map.name, "Hell", 4) )
+		int whatever = rng.rand() % 5;
+		if ( strncmp(destmap.name, "Hell", 4) )
 			j = std::min(
 			        std::min(
 			            std::max(1, currentlevel),
@@ -2893,7 +3259,7 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 			        )
 			        + whatever, numpossiblelocations
 			    )
-			    / ((strcmp(map.name, "The Mines") == 0) + 1);
+			    / ((strcmp(destmap.name, "The Mines") == 0) + 1);
 		else
 		{
 			j = std::min(15, numpossiblelocations);
@@ -2903,7 +3269,7 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 		for ( c = 0; c < j; ++c )
 		{
 			// choose a random location from those available
-			pickedlocation = map_rng.rand() % numpossiblelocations;
+			pickedlocation = rng.rand() % numpossiblelocations;
 			i = -1;
 			//printlog("pickedlocation: %d\n",pickedlocation);
 			//printlog("numpossiblelocations: %d\n",numpossiblelocations);
@@ -2911,7 +3277,7 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 			y = 0;
 			while ( 1 )
 			{
-				if ( possiblelocations[y + x * map.height] == true )
+				if ( possiblelocations[y + x * destmap.height] == true )
 				{
 					i++;
 					if ( i == pickedlocation )
@@ -2920,11 +3286,11 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 					}
 				}
 				x++;
-				if ( x >= map.width )
+				if ( x >= destmap.width )
 				{
 					x = 0;
 					y++;
-					if ( y >= map.height )
+					if ( y >= destmap.height )
 					{
 						y = 0;
 					}
@@ -2932,34 +3298,34 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 			}
 			int side = 0;
 			bool nofloor = false;
-			if ( !map.tiles[OBSTACLELAYER + y * MAPLAYERS + (x + 1)*MAPLAYERS * map.height] )
+			if ( !destmap.tiles[OBSTACLELAYER + y * MAPLAYERS + (x + 1)*MAPLAYERS * destmap.height] )
 			{
 				side = 0;
-				if ( !map.tiles[y * MAPLAYERS + (x + 1)*MAPLAYERS * map.height] )
+				if ( !destmap.tiles[y * MAPLAYERS + (x + 1)*MAPLAYERS * destmap.height] )
 				{
 					nofloor = true;
 				}
 			}
-			else if ( !map.tiles[OBSTACLELAYER + (y + 1)*MAPLAYERS + x * MAPLAYERS * map.height] )
+			else if ( !destmap.tiles[OBSTACLELAYER + (y + 1)*MAPLAYERS + x * MAPLAYERS * destmap.height] )
 			{
 				side = 1;
-				if ( !map.tiles[(y + 1)*MAPLAYERS + x * MAPLAYERS * map.height] )
+				if ( !destmap.tiles[(y + 1)*MAPLAYERS + x * MAPLAYERS * destmap.height] )
 				{
 					nofloor = true;
 				}
 			}
-			else if ( !map.tiles[OBSTACLELAYER + y * MAPLAYERS + (x - 1)*MAPLAYERS * map.height] )
+			else if ( !destmap.tiles[OBSTACLELAYER + y * MAPLAYERS + (x - 1)*MAPLAYERS * destmap.height] )
 			{
 				side = 2;
-				if ( !map.tiles[y * MAPLAYERS + (x - 1)*MAPLAYERS * map.height] )
+				if ( !destmap.tiles[y * MAPLAYERS + (x - 1)*MAPLAYERS * destmap.height] )
 				{
 					nofloor = true;
 				}
 			}
-			else if ( !map.tiles[OBSTACLELAYER + (y - 1)*MAPLAYERS + x * MAPLAYERS * map.height] )
+			else if ( !destmap.tiles[OBSTACLELAYER + (y - 1)*MAPLAYERS + x * MAPLAYERS * destmap.height] )
 			{
 				side = 3;
-				if ( !map.tiles[(y - 1)*MAPLAYERS + x * MAPLAYERS * map.height] )
+				if ( !destmap.tiles[(y - 1)*MAPLAYERS + x * MAPLAYERS * destmap.height] )
 				{
 					nofloor = true;
 				}
@@ -2967,21 +3333,21 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 			bool arrowtrap = false;
 			bool noceiling = false;
 			bool arrowtrapspawn = false;
-			if ( !strncmp(map.name, "Hell", 4) )
+			if ( !strncmp(destmap.name, "Hell", 4) )
 			{
-				if ( side == 0 && !map.tiles[(MAPLAYERS - 1) + y * MAPLAYERS + (x + 1)*MAPLAYERS * map.height] )
+				if ( side == 0 && !destmap.tiles[(MAPLAYERS - 1) + y * MAPLAYERS + (x + 1)*MAPLAYERS * destmap.height] )
 				{
 					noceiling = true;
 				}
-				if ( side == 1 && !map.tiles[(MAPLAYERS - 1) + (y + 1)*MAPLAYERS + x * MAPLAYERS * map.height] )
+				if ( side == 1 && !destmap.tiles[(MAPLAYERS - 1) + (y + 1)*MAPLAYERS + x * MAPLAYERS * destmap.height] )
 				{
 					noceiling = true;
 				}
-				if ( side == 2 && !map.tiles[(MAPLAYERS - 1) + y * MAPLAYERS + (x - 1)*MAPLAYERS * map.height] )
+				if ( side == 2 && !destmap.tiles[(MAPLAYERS - 1) + y * MAPLAYERS + (x - 1)*MAPLAYERS * destmap.height] )
 				{
 					noceiling = true;
 				}
-				if ( side == 3 && !map.tiles[(MAPLAYERS - 1) + (y - 1)*MAPLAYERS + x * MAPLAYERS * map.height] )
+				if ( side == 3 && !destmap.tiles[(MAPLAYERS - 1) + (y - 1)*MAPLAYERS + x * MAPLAYERS * destmap.height] )
 				{
 					noceiling = true;
 				}
@@ -2992,11 +3358,11 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 			}
 			else
 			{
-				if ( !strncmp(map.name, "Underworld", 10) )
+				if ( !strncmp(destmap.name, "Underworld", 10) )
 				{
 					arrowtrapspawn = true; // no boulders in underworld
 				}
-				else if ( map_rng.rand() % 2 && (arrowtrappotential) )
+				else if ( rng.rand() % 2 && (arrowtrappotential) )
 				{
 					arrowtrapspawn = true;
 				}
@@ -3005,7 +3371,7 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 			if ( customTrapsForMapInUse )
 			{
 				arrowtrapspawn = customTraps.arrows;
-				if ( customTraps.boulders && map_rng.rand() % 2 )
+				if ( customTraps.boulders && rng.rand() % 2 )
 				{
 					arrowtrapspawn = false;
 				}
@@ -3034,14 +3400,14 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 			if ( arrowtrapspawn || noceiling || (nofloor && arrowtrappotential) )
 			{
 				arrowtrap = true;
-				entity = newEntity(32, 1, map.entities, nullptr); // arrow trap
+				entity = newEntity(32, 1, destmap.entities, nullptr); // arrow trap
 				entity->behavior = &actArrowTrap;
-				map.tiles[OBSTACLELAYER + y * MAPLAYERS + x * MAPLAYERS * map.height] = 53; // trap wall
+				destmap.tiles[OBSTACLELAYER + y * MAPLAYERS + x * MAPLAYERS * destmap.height] = 53; // trap wall
 			}
 			else
 			{
 				//messagePlayer(0, "Included at x: %d, y: %d", x, y);
-				entity = newEntity(38, 1, map.entities, nullptr); // boulder trap
+				entity = newEntity(38, 1, destmap.entities, nullptr); // boulder trap
 				entity->behavior = &actBoulderTrap;
 
 				// delete ceiling tiles if need be
@@ -3068,15 +3434,15 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 			entity->x = x * 16;
 			entity->y = y * 16;
 			//printlog("2 Generated entity. Sprite: %d Uid: %d X: %.2f Y: %.2f\n",entity->sprite,entity->getUID(),entity->x,entity->y);
-			//entity = newEntity(18, 1, map.entities, nullptr); // electricity node
+			//entity = newEntity(18, 1, destmap.entities, nullptr); // electricity node
 			//entity->x = x * 16;
 			//entity->y = y * 16;
 			//printlog("4 Generated entity. Sprite: %d Uid: %d X: %.2f Y: %.2f\n",entity->sprite,entity->getUID(),entity->x,entity->y);
 			// make torches
 			if ( arrowtrap )
 			{
-				entity = newEntity(4 + side, 1, map.entities, nullptr);
-				Entity* entity2 = newEntity(4 + side, 1, map.entities, nullptr);
+				entity = newEntity(4 + side, 1, destmap.entities, nullptr);
+				Entity* entity2 = newEntity(4 + side, 1, destmap.entities, nullptr);
 				switch ( side )
 				{
 					case 0:
@@ -3116,7 +3482,7 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 					// get rid of extraneous torch
 					node_t* tempNode;
 					node_t* nextTempNode;
-					for ( tempNode = map.entities->first; tempNode != nullptr; tempNode = nextTempNode )
+					for ( tempNode = destmap.entities->first; tempNode != nullptr; tempNode = nextTempNode )
 					{
 						nextTempNode = tempNode->next;
 						Entity* tempEntity = (Entity*)tempNode->element;
@@ -3133,16 +3499,16 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 				{
 					if ( arrowtrap )
 					{
-						entity = newEntity(33, 1, map.entities, nullptr); // pressure plate
+						entity = newEntity(33, 1, destmap.entities, nullptr); // pressure plate
 					}
 					else
 					{
-						entity = newEntity(34, 1, map.entities, nullptr); // pressure plate
+						entity = newEntity(34, 1, destmap.entities, nullptr); // pressure plate
 					}
 					entity->x = x * 16;
 					entity->y = y * 16;
 					//printlog("7 Generated entity. Sprite: %d Uid: %d X: %.2f Y: %.2f\n",entity->sprite,entity->getUID(),entity->x,entity->y);
-					entity = newEntity(18, 1, map.entities, nullptr); // electricity node
+					entity = newEntity(18, 1, destmap.entities, nullptr); // electricity node
 					entity->x = x * 16;
 					entity->y = y * 16;
 					//printlog("8 Generated entity. Sprite: %d Uid: %d X: %.2f Y: %.2f\n",entity->sprite,entity->getUID(),entity->x,entity->y);
@@ -3162,69 +3528,69 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 						y--;
 						break;
 				}
-				testx = std::min(std::max<unsigned int>(0, x), map.width - 1); //TODO: Why are const int and unsigned int being compared?
-				testy = std::min(std::max<unsigned int>(0, y), map.height - 1); //TODO: Why are const int and unsigned int being compared?
+				testx = std::min(std::max<unsigned int>(0, x), destmap.width - 1); //TODO: Why are const int and unsigned int being compared?
+				testy = std::min(std::max<unsigned int>(0, y), destmap.height - 1); //TODO: Why are const int and unsigned int being compared?
 				i++;
 			}
-			while ( !map.tiles[OBSTACLELAYER + testy * MAPLAYERS + testx * MAPLAYERS * map.height] 
-				&& !trapexcludelocations[testx + testy * map.width]
-				&& !(!arrowtrap && !map.tiles[testy * MAPLAYERS + testx * MAPLAYERS * map.height]) // boulders stop wiring at pit edges
+			while ( !destmap.tiles[OBSTACLELAYER + testy * MAPLAYERS + testx * MAPLAYERS * destmap.height] 
+				&& !trapexcludelocations[testx + testy * destmap.width]
+				&& !(!arrowtrap && !destmap.tiles[testy * MAPLAYERS + testx * MAPLAYERS * destmap.height]) // boulders stop wiring at pit edges
 				&& i <= 10 );
 		}
 	}
 
 	// check start room for accessibility to rest of level
-	if ( strncmp(map.name, "Underworld", 10) )
+	if ( strncmp(destmap.name, "Underworld", 10) )
 	{
 		startRoomInfo.checkBorderAccessibility();
 	}
 
 	// monsters, decorations, and items
-	numpossiblelocations = map.width * map.height;
-	for ( y = 0; y < map.height; y++ )
+	numpossiblelocations = destmap.width * destmap.height;
+	for ( y = 0; y < destmap.height; y++ )
 	{
-		for ( x = 0; x < map.width; x++ )
+		for ( x = 0; x < destmap.width; x++ )
 		{
-			if ( checkObstacle( x * 16 + 8, y * 16 + 8, NULL, NULL ) || firstroomtile[y + x * map.height] )
+			if ( mapGenCheckObstacle(destmap, x * 16 + 8, y * 16 + 8, false) || firstroomtile[y + x * destmap.height] )
 			{
-				possiblelocations[y + x * map.height] = false;
+				possiblelocations[y + x * destmap.height] = false;
 				numpossiblelocations--;
 			}
-			else if ( lavatiles[map.tiles[y * MAPLAYERS + x * MAPLAYERS * map.height]] )
+			else if ( lavatiles[destmap.tiles[y * MAPLAYERS + x * MAPLAYERS * destmap.height]] )
 			{
-				possiblelocations[y + x * map.height] = false;
+				possiblelocations[y + x * destmap.height] = false;
 				numpossiblelocations--;
 			}
-			else if ( swimmingtiles[map.tiles[y * MAPLAYERS + x * MAPLAYERS * map.height]] )
+			else if ( swimmingtiles[destmap.tiles[y * MAPLAYERS + x * MAPLAYERS * destmap.height]] )
 			{
-				possiblelocations[y + x * map.height] = false;
+				possiblelocations[y + x * destmap.height] = false;
 				numpossiblelocations--;
 			}
 			else
 			{
-				if ( x < getMapPossibleLocationX1() || x >= getMapPossibleLocationX2()
-					|| y < getMapPossibleLocationY1() || y >= getMapPossibleLocationY2() )
+				if ( x < getMapPossibleLocationX1(destmap) || x >= getMapPossibleLocationX2(destmap)
+					|| y < getMapPossibleLocationY1(destmap) || y >= getMapPossibleLocationY2(destmap) )
 				{
-					possiblelocations[y + x * map.height] = false;
+					possiblelocations[y + x * destmap.height] = false;
 					--numpossiblelocations;
 				}
 				else
 				{
-					possiblelocations[y + x * map.height] = true;
+					possiblelocations[y + x * destmap.height] = true;
 				}
 			}
 		}
 	}
-	for ( node = map.entities->first; node != nullptr; node = node->next )
+	for ( node = destmap.entities->first; node != nullptr; node = node->next )
 	{
 		entity = (Entity*)node->element;
 		x = entity->x / 16;
 		y = entity->y / 16;
-		if ( x >= 0 && x < map.width && y >= 0 && y < map.height )
+		if ( x >= 0 && x < destmap.width && y >= 0 && y < destmap.height )
 		{
-			if ( possiblelocations[y + x * map.height] )
+			if ( possiblelocations[y + x * destmap.height] )
 			{
-				possiblelocations[y + x * map.height] = false;
+				possiblelocations[y + x * destmap.height] = false;
 				--numpossiblelocations;
 			}
 		}
@@ -3240,19 +3606,19 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 	int genDecorationMin = 0;
 	int genDecorationMax = 0;
 
-	if ( map.flags[MAP_FLAG_GENBYTES1] != 0 || map.flags[MAP_FLAG_GENBYTES2] != 0 )
+	if ( destmap.flags[MAP_FLAG_GENBYTES1] != 0 || destmap.flags[MAP_FLAG_GENBYTES2] != 0 )
 	{
-		genEntityMin = (map.flags[MAP_FLAG_GENBYTES1] >> 24) & 0xFF; // first leftmost byte
-		genEntityMax = (map.flags[MAP_FLAG_GENBYTES1] >> 16) & 0xFF; // second leftmost byte
+		genEntityMin = (destmap.flags[MAP_FLAG_GENBYTES1] >> 24) & 0xFF; // first leftmost byte
+		genEntityMax = (destmap.flags[MAP_FLAG_GENBYTES1] >> 16) & 0xFF; // second leftmost byte
 
-		genMonsterMin = (map.flags[MAP_FLAG_GENBYTES1] >> 8) & 0xFF; // third leftmost byte
-		genMonsterMax = (map.flags[MAP_FLAG_GENBYTES1] >> 0) & 0xFF; // fourth leftmost byte
+		genMonsterMin = (destmap.flags[MAP_FLAG_GENBYTES1] >> 8) & 0xFF; // third leftmost byte
+		genMonsterMax = (destmap.flags[MAP_FLAG_GENBYTES1] >> 0) & 0xFF; // fourth leftmost byte
 		
-		genLootMin = (map.flags[MAP_FLAG_GENBYTES2] >> 24) & 0xFF; // first leftmost byte
-		genLootMax = (map.flags[MAP_FLAG_GENBYTES2] >> 16) & 0xFF; // second leftmost byte
+		genLootMin = (destmap.flags[MAP_FLAG_GENBYTES2] >> 24) & 0xFF; // first leftmost byte
+		genLootMax = (destmap.flags[MAP_FLAG_GENBYTES2] >> 16) & 0xFF; // second leftmost byte
 
-		genDecorationMin = (map.flags[MAP_FLAG_GENBYTES2] >> 8) & 0xFF; // third leftmost byte
-		genDecorationMax = (map.flags[MAP_FLAG_GENBYTES2] >> 0) & 0xFF; // fourth leftmost byte
+		genDecorationMin = (destmap.flags[MAP_FLAG_GENBYTES2] >> 8) & 0xFF; // third leftmost byte
+		genDecorationMax = (destmap.flags[MAP_FLAG_GENBYTES2] >> 0) & 0xFF; // fourth leftmost byte
 	}
 
 	int entitiesToGenerate = 30;
@@ -3263,13 +3629,13 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 		genEntityMin = std::max(genEntityMin, 2); // make sure there's room for a ladder.
 		entitiesToGenerate = genEntityMin;
 		randomEntities = std::max(genEntityMax - genEntityMin, 1); // difference between min and max is the extra chances.
-		//Needs to be 1 for map_rng.rand() % to not divide by 0.
-		j = std::min<Uint32>(entitiesToGenerate + map_rng.rand() % randomEntities, numpossiblelocations); //TODO: Why are Uint32 and Sin32 being compared?
+		//Needs to be 1 for rng.rand() % to not divide by 0.
+		j = std::min<Uint32>(entitiesToGenerate + rng.rand() % randomEntities, numpossiblelocations); //TODO: Why are Uint32 and Sin32 being compared?
 	}
 	else
 	{
 		// revert to old mechanics.
-		j = std::min<Uint32>(30 + map_rng.rand() % 10, numpossiblelocations); //TODO: Why are Uint32 and Sin32 being compared?
+		j = std::min<Uint32>(30 + rng.rand() % 10, numpossiblelocations); //TODO: Why are Uint32 and Sin32 being compared?
 	}
 	int forcedMonsterSpawns = 0;
 	int forcedLootSpawns = 0;
@@ -3277,15 +3643,15 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 
 	if ( genMonsterMin > 0 || genMonsterMax > 0 )
 	{
-		forcedMonsterSpawns = genMonsterMin + map_rng.rand() % std::max(genMonsterMax - genMonsterMin, 1);
+		forcedMonsterSpawns = genMonsterMin + rng.rand() % std::max(genMonsterMax - genMonsterMin, 1);
 	}
 	if ( genLootMin > 0 || genLootMax > 0 )
 	{
-		forcedLootSpawns = genLootMin + map_rng.rand() % std::max(genLootMax - genLootMin, 1);
+		forcedLootSpawns = genLootMin + rng.rand() % std::max(genLootMax - genLootMin, 1);
 	}
 	if ( genDecorationMin > 0 || genDecorationMax > 0 )
 	{
-		forcedDecorationSpawns = genDecorationMin + map_rng.rand() % std::max(genDecorationMax - genDecorationMin, 1);
+		forcedDecorationSpawns = genDecorationMin + rng.rand() % std::max(genDecorationMax - genDecorationMin, 1);
 	}
 
 	//messagePlayer(0, "Num locations: %d of %d possible, force monsters: %d, force loot: %d, force decorations: %d", j, numpossiblelocations, forcedMonsterSpawns, forcedLootSpawns, forcedDecorationSpawns);
@@ -3301,7 +3667,7 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 	for ( c = 0; c < std::min(j, numpossiblelocations); ++c )
 	{
 		// choose a random location from those available
-		pickedlocation = map_rng.rand() % numpossiblelocations;
+		pickedlocation = rng.rand() % numpossiblelocations;
 		i = -1;
 		//printlog("pickedlocation: %d\n",pickedlocation);
 		//printlog("numpossiblelocations: %d\n",numpossiblelocations);
@@ -3310,7 +3676,7 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 		bool skipPossibleLocationsDecrement = false;
 		while ( 1 )
 		{
-			if ( possiblelocations[y + x * map.height] == true )
+			if ( possiblelocations[y + x * destmap.height] == true )
 			{
 				++i;
 				if ( i == pickedlocation )
@@ -3319,11 +3685,11 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 				}
 			}
 			++x;
-			if ( x >= map.width )
+			if ( x >= destmap.width )
 			{
 				x = 0;
 				++y;
-				if ( y >= map.height )
+				if ( y >= destmap.height )
 				{
 					y = 0;
 				}
@@ -3332,30 +3698,30 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 
 		// create entity
 		entity = nullptr;
-		if ( (c == 0 || (minotaurlevel && c < 2)) && (!secretlevel || currentlevel != 7) && (!secretlevel || currentlevel != 20)
+		if ( (c == 0 || (target.minotaurlevel && c < 2)) && (!secretlevel || currentlevel != 7) && (!secretlevel || currentlevel != 20)
 			&& std::get<LEVELPARAM_DISABLE_NORMAL_EXIT>(mapParameters) == 0 )
 		{
-			if ( strcmp(map.name, "Hell") )
+			if ( strcmp(destmap.name, "Hell") )
 			{
-				entity = newEntity(11, 1, map.entities, nullptr); // ladder
+				entity = newEntity(11, 1, destmap.entities, nullptr); // ladder
 				entity->behavior = &actLadder;
 			}
 			else
 			{
-				entity = newEntity(45, 1, map.entities, nullptr); // hell uses portals instead
+				entity = newEntity(45, 1, destmap.entities, nullptr); // hell uses portals instead
 				entity->behavior = &actPortal;
 				entity->skill[3] = 1; // not secret portals though
 			}
 
 			// determine if the ladder generated in a viable location
-			if ( strncmp(map.name, "Underworld", 10) )
+			if ( strncmp(destmap.name, "Underworld", 10) )
 			{
 				bool nopath = false;
-				bool hellLadderFix = !strncmp(map.name, "Hell", 4);
+				bool hellLadderFix = !strncmp(destmap.name, "Hell", 4);
 				std::vector<Entity*> tempPassableEntities;
 				if ( hellLadderFix )
 				{
-					for ( node = map.entities->first; node != NULL; node = node->next )
+					for ( node = destmap.entities->first; node != NULL; node = node->next )
 					{
 						if ( (entity2 = (Entity*)node->element) )
 						{
@@ -3377,22 +3743,15 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 						}
 					}
 				}
-				for ( node = map.entities->first; node != NULL; node = node->next )
+				for ( node = destmap.entities->first; node != NULL; node = node->next )
 				{
 					entity2 = (Entity*)node->element;
 					if ( entity2->sprite == 1 ) // note entity->behavior == nullptr at this point
 					{
-						list_t* path = generatePath(x, y, entity2->x / 16, entity2->y / 16, 
-							entity, entity2, GeneratePathTypes::GENERATE_PATH_CHECK_EXIT, hellLadderFix);
-						if ( path == NULL )
+						if ( !mapGenPathExists(destmap, x, y, entity2->x / 16, entity2->y / 16, entity, entity2) )
 						{
 							nopath = true;
 						}
-						else
-						{
-							list_FreeAll(path);
-							free(path);
-						}
 						break;
 					}
 				}
@@ -3409,26 +3768,26 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 				}
 			}
 		}
-		else if ( c == 1 && secretlevel && currentlevel == 7 && !strncmp(map.name, "Underworld", 10) )
+		else if ( c == 1 && secretlevel && currentlevel == 7 && !strncmp(destmap.name, "Underworld", 10) )
 		{
-			entity = newEntity(89, 1, map.entities, nullptr);
+			entity = newEntity(89, 1, destmap.entities, nullptr);
 			entity->monsterStoreType = 1;
-			entity->skill[5] = nummonsters;
-			++nummonsters;
-			//entity = newEntity(68, 1, map.entities, nullptr); // magic (artifact) bow
+			entity->skill[5] = target.nummonsters;
+			++target.nummonsters;
+			//entity = newEntity(68, 1, destmap.entities, nullptr); // magic (artifact) bow
 		}
-		else if ( *cvar_underworldshrinetest && !strncmp(map.name, "Underworld", 10) 
+		else if ( *cvar_underworldshrinetest && !strncmp(destmap.name, "Underworld", 10) 
 			&& ((c == 1 && !(secretlevel && currentlevel == 7)) || (c == 2 && secretlevel && currentlevel == 7)) )
 		{
 			std::set<int> walkableTiles;
-			for ( int isley = 1; isley < map.width - 1; ++isley )
+			for ( int isley = 1; isley < destmap.width - 1; ++isley )
 			{
-				for ( int islex = 1; islex < map.width - 1; ++islex )
+				for ( int islex = 1; islex < destmap.width - 1; ++islex )
 				{
-					if ( !map.tiles[OBSTACLELAYER + isley * MAPLAYERS + (islex) * MAPLAYERS * map.height]
-						&& map.tiles[isley * MAPLAYERS + (islex) * MAPLAYERS * map.height]
-						&& !swimmingtiles[map.tiles[isley * MAPLAYERS + islex * MAPLAYERS * map.height]]
-						&& !lavatiles[map.tiles[isley * MAPLAYERS + islex * MAPLAYERS * map.height]] )
+					if ( !destmap.tiles[OBSTACLELAYER + isley * MAPLAYERS + (islex) * MAPLAYERS * destmap.height]
+						&& destmap.tiles[isley * MAPLAYERS + (islex) * MAPLAYERS * destmap.height]
+						&& !swimmingtiles[destmap.tiles[isley * MAPLAYERS + islex * MAPLAYERS * destmap.height]]
+						&& !lavatiles[destmap.tiles[isley * MAPLAYERS + islex * MAPLAYERS * destmap.height]] )
 					{
 						walkableTiles.insert(islex + isley * 1000);
 					}
@@ -3566,9 +3925,9 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 
 				if ( !locations3x3.empty() )
 				{
-					int chosenKey = locations3x3.at(map_rng.rand() % locations3x3.size());
-					int dir = map_rng.rand() % 4;
-					entity = newEntity(177, 1, map.entities, nullptr);
+					int chosenKey = locations3x3.at(rng.rand() % locations3x3.size());
+					int dir = rng.rand() % 4;
+					entity = newEntity(177, 1, destmap.entities, nullptr);
 					setSpriteAttributes(entity, nullptr, nullptr);
 					int ix = (chosenKey) % 1000;
 					int iy = (chosenKey) / 1000;
@@ -3576,21 +3935,21 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 					if ( dir == 0 )
 					{
 						ix = ix - 1;
-						iy = iy - 1 + map_rng.rand() % 3;
+						iy = iy - 1 + rng.rand() % 3;
 					}
 					else if ( dir == 2 )
 					{
 						ix = ix + 1;
-						iy = iy - 1 + map_rng.rand() % 3;
+						iy = iy - 1 + rng.rand() % 3;
 					}
 					else if ( dir == 1 )
 					{
-						ix = ix - 1 + map_rng.rand() % 3;
+						ix = ix - 1 + rng.rand() % 3;
 						iy = iy - 1;
 					}
 					else if ( dir == 3 )
 					{
-						ix = ix - 1 + map_rng.rand() % 3;
+						ix = ix - 1 + rng.rand() % 3;
 						iy = iy + 1;
 					}
 					x = ix;
@@ -3598,7 +3957,7 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 					entity->x = x * 16.0;
 					entity->y = y * 16.0;
 					skipPossibleLocationsDecrement = true;
-					possiblelocations[iy + ix * map.height] = false;
+					possiblelocations[iy + ix * destmap.height] = false;
 					--numpossiblelocations;
 				}
 			}
@@ -3612,7 +3971,7 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 			{
 				for ( y2 = -1; y2 <= 1; y2++ )
 				{
-					if ( checkObstacle((x + x2) * 16, (y + y2) * 16, NULL, NULL, false) )
+					if ( mapGenCheckObstacle(destmap, (x + x2) * 16, (y + y2) * 16, true) )
 					{
 						obstacles++;
 						if ( obstacles > 1 )
@@ -3636,23 +3995,23 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 				if ( forcedMonsterSpawns > 0 )
 				{
 					--forcedMonsterSpawns;
-					if ( monsterexcludelocations[x + y * map.width] == false )
+					if ( monsterexcludelocations[x + y * destmap.width] == false )
 					{
 						bool doNPC = false;
-						if ( gameplayCustomManager.processedPropertyForFloor(currentlevel, secretlevel, map.name, GameplayCustomManager::PROPERTY_NPC, doNPC) )
+						if ( gameplayCustomManager.processedPropertyForFloor(currentlevel, secretlevel, destmap.name, GameplayCustomManager::PROPERTY_NPC, doNPC, rng) )
 						{
 							// doNPC processed by function
 						}
-						else if ( map_rng.rand() % 10 == 0 && currentlevel > 1 )
+						else if ( rng.rand() % 10 == 0 && currentlevel > 1 )
 						{
 							doNPC = true;
 						}
 
 						if ( doNPC )
 						{
-							if ( currentlevel > 15 && map_rng.rand() % 4 > 0 )
+							if ( currentlevel > 15 && rng.rand() % 4 > 0 )
 							{
-								entity = newEntity(93, 1, map.entities, map.creatures);  // automaton
+								entity = newEntity(93, 1, destmap.entities, destmap.creatures);  // automaton
 								if ( currentlevel < 25 )
 								{
 									entity->monsterStoreType = 1; // weaker version
@@ -3660,34 +4019,34 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 							}
 							else
 							{
-								entity = newEntity(27, 1, map.entities, map.creatures);  // human
+								entity = newEntity(27, 1, destmap.entities, destmap.creatures);  // human
 								if ( multiplayer != CLIENT && currentlevel > 5 )
 								{
-									entity->monsterStoreType = (currentlevel / 5) * 3 + (local_rng.rand() % 4); // scale humans with depth.  3 LVL each 5 floors, + 0-3.
+									entity->monsterStoreType = (currentlevel / 5) * 3 + (target.localRng->rand() % 4); // scale humans with depth.  3 LVL each 5 floors, + 0-3.
 								}
 							}
 						}
 						else
 						{
-							entity = newEntity(10, 1, map.entities, map.creatures);  // monster
+							entity = newEntity(10, 1, destmap.entities, destmap.creatures);  // monster
 						}
-						entity->skill[5] = nummonsters;
-						++nummonsters;
+						entity->skill[5] = target.nummonsters;
+						++target.nummonsters;
 					}
 				}
 				else if ( forcedLootSpawns > 0 )
 				{
 					--forcedLootSpawns;
-					if ( lootexcludelocations[x + y * map.width] == false )
+					if ( lootexcludelocations[x + y * destmap.width] == false )
 					{
-						if ( map_rng.rand() % 10 == 0 )   // 10% chance
+						if ( rng.rand() % 10 == 0 )   // 10% chance
 						{
-							entity = newEntity(9, 1, map.entities, nullptr);  // gold
+							entity = newEntity(9, 1, destmap.entities, nullptr);  // gold
 							numGenGold++;
 						}
 						else
 						{
-							entity = newEntity(8, 1, map.entities, nullptr);  // item
+							entity = newEntity(8, 1, destmap.entities, nullptr);  // item
 							setSpriteAttributes(entity, nullptr, nullptr);
 							numGenItems++;
 						}
@@ -3697,33 +4056,33 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 				{
 					--forcedDecorationSpawns;
 					// decorations
-					if ( (map_rng.rand() % 4 == 0 || (currentlevel <= 10 && !customTrapsForMapInUse)) && strcmp(map.name, "Hell") )
+					if ( (rng.rand() % 4 == 0 || (currentlevel <= 10 && !customTrapsForMapInUse)) && strcmp(destmap.name, "Hell") )
 					{
-						switch ( map_rng.rand() % 7 )
+						switch ( rng.rand() % 7 )
 						{
 							case 0:
-								entity = newEntity(12, 1, map.entities, nullptr); //Firecamp.
+								entity = newEntity(12, 1, destmap.entities, nullptr); //Firecamp.
 								break; //Firecamp
 							case 1:
-								entity = newEntity(14, 1, map.entities, nullptr); //Fountain.
+								entity = newEntity(14, 1, destmap.entities, nullptr); //Fountain.
 								break; //Fountain
 							case 2:
-								entity = newEntity(15, 1, map.entities, nullptr); //Sink.
+								entity = newEntity(15, 1, destmap.entities, nullptr); //Sink.
 								break; //Sink
 							case 3:
-								entity = newEntity(21, 1, map.entities, nullptr); //Chest.
+								entity = newEntity(21, 1, destmap.entities, nullptr); //Chest.
 								setSpriteAttributes(entity, nullptr, nullptr);
 								entity->chestLocked = -1;
 								break; //Chest
 							case 4:
-								entity = newEntity(39, 1, map.entities, nullptr); //Tomb.
+								entity = newEntity(39, 1, destmap.entities, nullptr); //Tomb.
 								break; //Tomb
 							case 5:
-								entity = newEntity(59, 1, map.entities, nullptr); //Table.
+								entity = newEntity(59, 1, destmap.entities, nullptr); //Table.
 								setSpriteAttributes(entity, nullptr, nullptr);
 								break; //Table
 							case 6:
-								entity = newEntity(60, 1, map.entities, nullptr); //Chair.
+								entity = newEntity(60, 1, destmap.entities, nullptr); //Chair.
 								setSpriteAttributes(entity, nullptr, nullptr);
 								break; //Chair
 						}
@@ -3736,36 +4095,36 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 							{
 								continue;
 							}
-							else if ( customTraps.verticalSpelltraps && map_rng.rand() % 2 == 0 )
+							else if ( customTraps.verticalSpelltraps && rng.rand() % 2 == 0 )
 							{
-								entity = newEntity(120, 1, map.entities, nullptr); // vertical spell trap.
+								entity = newEntity(120, 1, destmap.entities, nullptr); // vertical spell trap.
 								setSpriteAttributes(entity, nullptr, nullptr);
 							}
 							else if ( customTraps.spikes )
 							{
-								entity = newEntity(64, 1, map.entities, nullptr); // spear trap
+								entity = newEntity(64, 1, destmap.entities, nullptr); // spear trap
 							}
 						}
 						else
 						{
 							if ( currentlevel <= 25 )
 							{
-								entity = newEntity(64, 1, map.entities, nullptr); // spear trap
+								entity = newEntity(64, 1, destmap.entities, nullptr); // spear trap
 							}
 							else
 							{
-								if ( map_rng.rand() % 2 == 0 )
+								if ( rng.rand() % 2 == 0 )
 								{
-									entity = newEntity(120, 1, map.entities, nullptr); // vertical spell trap.
+									entity = newEntity(120, 1, destmap.entities, nullptr); // vertical spell trap.
 									setSpriteAttributes(entity, nullptr, nullptr);
 								}
 								else
 								{
-									entity = newEntity(64, 1, map.entities, nullptr); // spear trap
+									entity = newEntity(64, 1, destmap.entities, nullptr); // spear trap
 								}
 							}
 						}
-						Entity* also = newEntity(33, 1, map.entities, nullptr);
+						Entity* also = newEntity(33, 1, destmap.entities, nullptr);
 						also->x = x * 16;
 						also->y = y * 16;
 						//printlog("15 Generated entity. Sprite: %d Uid: %d X: %.2f Y: %.2f\n",also->sprite,also->getUID(),also->x,also->y);
@@ -3776,7 +4135,7 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 			else
 			{
 				// return to normal generation
-				if ( map_rng.rand() % 2 || nodecoration )
+				if ( rng.rand() % 2 || nodecoration )
 				{
 					// balance for total number of players
 					int balance = 0;
@@ -3809,18 +4168,18 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 					// monsters/items
 					if ( balance )
 					{
-						if ( map_rng.rand() % balance )
+						if ( rng.rand() % balance )
 						{
-							if ( lootexcludelocations[x + y * map.width] == false )
+							if ( lootexcludelocations[x + y * destmap.width] == false )
 							{
-								if ( map_rng.rand() % 10 == 0 )   // 10% chance
+								if ( rng.rand() % 10 == 0 )   // 10% chance
 								{
-									entity = newEntity(9, 1, map.entities, nullptr);  // gold
+									entity = newEntity(9, 1, destmap.entities, nullptr);  // gold
 									numGenGold++;
 								}
 								else
 								{
-									entity = newEntity(8, 1, map.entities, nullptr);  // item
+									entity = newEntity(8, 1, destmap.entities, nullptr);  // item
 									setSpriteAttributes(entity, nullptr, nullptr);
 									numGenItems++;
 								}
@@ -3828,23 +4187,23 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 						}
 						else
 						{
-							if ( monsterexcludelocations[x + y * map.width] == false )
+							if ( monsterexcludelocations[x + y * destmap.width] == false )
 							{
 								bool doNPC = false;
-								if ( gameplayCustomManager.processedPropertyForFloor(currentlevel, secretlevel, map.name, GameplayCustomManager::PROPERTY_NPC, doNPC) )
+								if ( gameplayCustomManager.processedPropertyForFloor(currentlevel, secretlevel, destmap.name, GameplayCustomManager::PROPERTY_NPC, doNPC, rng) )
 								{
 									// doNPC processed by function
 								}
-								else if ( map_rng.rand() % 10 == 0 && currentlevel > 1 )
+								else if ( rng.rand() % 10 == 0 && currentlevel > 1 )
 								{
 									doNPC = true;
 								}
 
 								if ( doNPC )
 								{
-									if ( currentlevel > 15 && map_rng.rand() % 4 > 0 )
+									if ( currentlevel > 15 && rng.rand() % 4 > 0 )
 									{
-										entity = newEntity(93, 1, map.entities, map.creatures);  // automaton
+										entity = newEntity(93, 1, destmap.entities, destmap.creatures);  // automaton
 										if ( currentlevel < 25 )
 										{
 											entity->monsterStoreType = 1; // weaker version
@@ -3852,19 +4211,19 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 									}
 									else
 									{
-										entity = newEntity(27, 1, map.entities, map.creatures);  // human
+										entity = newEntity(27, 1, destmap.entities, destmap.creatures);  // human
 										if ( multiplayer != CLIENT && currentlevel > 5 )
 										{
-											entity->monsterStoreType = (currentlevel / 5) * 3 + (local_rng.rand() % 4); // scale humans with depth. 3 LVL each 5 floors, + 0-3.
+											entity->monsterStoreType = (currentlevel / 5) * 3 + (target.localRng->rand() % 4); // scale humans with depth. 3 LVL each 5 floors, + 0-3.
 										}
 									}
 								}
 								else
 								{
-									entity = newEntity(10, 1, map.entities, map.creatures);  // monster
+									entity = newEntity(10, 1, destmap.entities, destmap.creatures);  // monster
 								}
-								entity->skill[5] = nummonsters;
-								nummonsters++;
+								entity->skill[5] = target.nummonsters;
+								target.nummonsters++;
 							}
 						}
 					}
@@ -3872,33 +4231,33 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 				else
 				{
 					// decorations
-					if ( (map_rng.rand() % 4 == 0 || (currentlevel <= 10 && !customTrapsForMapInUse)) && strcmp(map.name, "Hell") )
+					if ( (rng.rand() % 4 == 0 || (currentlevel <= 10 && !customTrapsForMapInUse)) && strcmp(destmap.name, "Hell") )
 					{
-						switch ( map_rng.rand() % 7 )
+						switch ( rng.rand() % 7 )
 						{
 							case 0:
-								entity = newEntity(12, 1, map.entities, nullptr); //Firecamp entity.
+								entity = newEntity(12, 1, destmap.entities, nullptr); //Firecamp entity.
 								break; //Firecamp
 							case 1:
-								entity = newEntity(14, 1, map.entities, nullptr); //Fountain entity.
+								entity = newEntity(14, 1, destmap.entities, nullptr); //Fountain entity.
 								break; //Fountain
 							case 2:
-								entity = newEntity(15, 1, map.entities, nullptr); //Sink entity.
+								entity = newEntity(15, 1, destmap.entities, nullptr); //Sink entity.
 								break; //Sink
 							case 3:
-								entity = newEntity(21, 1, map.entities, nullptr); //Chest entity.
+								entity = newEntity(21, 1, destmap.entities, nullptr); //Chest entity.
 								setSpriteAttributes(entity, nullptr, nullptr);
 								entity->chestLocked = -1;
 								break; //Chest
 							case 4:
-								entity = newEntity(39, 1, map.entities, nullptr); //Tomb entity.
+								entity = newEntity(39, 1, destmap.entities, nullptr); //Tomb entity.
 								break; //Tomb
 							case 5:
-								entity = newEntity(59, 1, map.entities, nullptr); //Table entity.
+								entity = newEntity(59, 1, destmap.entities, nullptr); //Table entity.
 								setSpriteAttributes(entity, nullptr, nullptr);
 								break; //Table
 							case 6:
-								entity = newEntity(60, 1, map.entities, nullptr); //Chair entity.
+								entity = newEntity(60, 1, destmap.entities, nullptr); //Chair entity.
 								setSpriteAttributes(entity, nullptr, nullptr);
 								break; //Chair
 						}
@@ -3911,36 +4270,36 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 							{
 								continue;
 							}
-							else if ( customTraps.verticalSpelltraps && map_rng.rand() % 2 == 0 )
+							else if ( customTraps.verticalSpelltraps && rng.rand() % 2 == 0 )
 							{
-								entity = newEntity(120, 1, map.entities, nullptr); // vertical spell trap.
+								entity = newEntity(120, 1, destmap.entities, nullptr); // vertical spell trap.
 								setSpriteAttributes(entity, nullptr, nullptr);
 							}
 							else if ( customTraps.spikes )
 							{
-								entity = newEntity(64, 1, map.entities, nullptr); // spear trap
+								entity = newEntity(64, 1, destmap.entities, nullptr); // spear trap
 							}
 						}
 						else
 						{
 							if ( currentlevel <= 25 )
 							{
-								entity = newEntity(64, 1, map.entities, nullptr); // spear trap
+								entity = newEntity(64, 1, destmap.entities, nullptr); // spear trap
 							}
 							else
 							{
-								if ( map_rng.rand() % 2 == 0 )
+								if ( rng.rand() % 2 == 0 )
 								{
-									entity = newEntity(120, 1, map.entities, nullptr); // vertical spell trap.
+									entity = newEntity(120, 1, destmap.entities, nullptr); // vertical spell trap.
 									setSpriteAttributes(entity, nullptr, nullptr);
 								}
 								else
 								{
-									entity = newEntity(64, 1, map.entities, nullptr); // spear trap
+									entity = newEntity(64, 1, destmap.entities, nullptr); // spear trap
 								}
 							}
 						}
-						Entity* also = newEntity(33, 1, map.entities, nullptr);
+						Entity* also = newEntity(33, 1, destmap.entities, nullptr);
 						also->x = x * 16;
 						also->y = y * 16;
 						//printlog("15 Generated entity. Sprite: %d Uid: %d X: %.2f Y: %.2f\n",also->sprite,also->getUID(),also->x,also->y);
@@ -3958,14 +4317,14 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 		// mark this location as inelligible for reselection
 		if ( !skipPossibleLocationsDecrement )
 		{
-			possiblelocations[y + x * map.height] = false;
+			possiblelocations[y + x * destmap.height] = false;
 			numpossiblelocations--;
 		}
 	}
 
 	// on hell levels, lava doesn't bubble. helps performance
-	/*if( !strcmp(map.name,"Hell") ) {
-		for( node=map.entities->first; node!=NULL; node=node->next ) {
+	/*if( !strcmp(destmap.name,"Hell") ) {
+		for( node=destmap.entities->first; node!=NULL; node=node->next ) {
 			Entity *entity = (Entity *)node->element;
 			if( entity->sprite == 41 ) { // lava.png
 				entity->skill[4] = 1; // LIQUID_LAVANOBUBBLE =
@@ -3983,11 +4342,270 @@ int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int>
 	list_FreeAll(&subRoomMapList);
 	list_FreeAll(&mapList);
 	list_FreeAll(&doorList);
-	printlog("successfully generated a dungeon with %d rooms, %d monsters, %d gold, %d items, %d decorations.\n", roomcount, nummonsters, numGenGold, numGenItems, numGenDecorations);
-	//messagePlayer(0, "successfully generated a dungeon with %d rooms, %d monsters, %d gold, %d items, %d decorations.", roomcount, nummonsters, numGenGold, numGenItems, numGenDecorations);
+	printlog("successfully generated a dungeon with %d rooms, %d monsters, %d gold, %d items, %d decorations.\n", roomcount, target.nummonsters, numGenGold, numGenItems, numGenDecorations);
+	//messagePlayer(0, "successfully generated a dungeon with %d rooms, %d monsters, %d gold, %d items, %d decorations.", roomcount, target.nummonsters, numGenGold, numGenItems, numGenDecorations);
 	return secretlevelexit;
 }
 
+/*-------------------------------------------------------------------------------
+
+	generateDungeon
+
+	generates a level into the current map, with the game's own rngs
+
+-------------------------------------------------------------------------------*/
+
+int generateDungeon(char* levelset, Uint32 seed, std::tuple<int, int, int, int> mapParameters)
+{
+	// a staged level shares the room templates, and wouldn't follow on from this one
+	discardStagedLevel();
+
+	MapGenTarget_t target;
+	target.map = &map;
+	target.rng = &map_rng;
+	target.localRng = &local_rng;
+	target.currentlevel = currentlevel;
+	target.secretlevel = secretlevel;
+	target.darkmap = darkmap;
+
+	// store this map's seed
+	mapseed = seed;
+
+	// generate a custom monster curve if file exists
+	monsterCurveCustomManager.readFromFile();
+
+	int result = generateDungeon(levelset, seed, mapParameters, target);
+	applyMapGenTarget(target);
+	return result;
+}
+
+/*-------------------------------------------------------------------------------
+
+	applyMapGenTarget
+
+	copies what generateDungeon decided about a level into the game, once
+	the level is in the current map
+
+-------------------------------------------------------------------------------*/
+
+void applyMapGenTarget(MapGenTarget_t& target)
+{
+	darkmap = target.darkmap;
+	minotaurlevel = target.minotaurlevel;
+	nummonsters = target.nummonsters;
+	if ( shoparea && target.shoparea.size() == (size_t)map.width * map.height )
+	{
+		for ( size_t c = 0; c < target.shoparea.size(); ++c )
+		{
+			shoparea[c] = target.shoparea[c];
+		}
+	}
+	if ( target.modded )
+	{
+		conductGameChallenges[CONDUCT_MODDED] = 1;
+		Mods::disableSteamAchievements = true;
+	}
+	if ( target.darkmapHint )
+	{
+		messageLocalPlayers(MESSAGE_HINT, Language::get(1108));
+	}
+	notifyMapTilesReplaced();
+}
+
+/*-------------------------------------------------------------------------------
+
+	stageNextLevel
+
+	starts generating the level after the current one on a worker thread,
+	into a map of its own with its own rngs, while the current one is
+	played. on descend takeStagedLevel() swaps it in if it's still the
+	level wanted: same level, seed, levels file entry, server flags and
+	players, which is everything generateDungeon reads besides the data
+	files. otherwise it's thrown away and the level is generated as usual.
+	clients only learn the seed when the level changes, so only the server
+	stages levels
+
+-------------------------------------------------------------------------------*/
+
+thread_local MapGenTarget_t* stagedMapGen = nullptr;
+
+static struct StagedLevel_t
+{
+	std::future<void> task;
+	map_t* map = nullptr;
+	MapGenTarget_t target;
+	BaronyRNG rng;
+	BaronyRNG localRng;
+	int result = -1;
+
+	// what the level was generated for
+	int level = 0;
+	bool secret = false;
+	Uint32 seed = 0;
+	std::string line;
+	Uint32 serverFlags = 0;
+	Uint32 connectedPlayers = 0;
+	Sint32 multiplayerMode = SINGLE;
+} stagedLevel;
+
+static Uint32 getConnectedPlayers()
+{
+	Uint32 connected = 0;
+	for ( int c = 0; c < MAXPLAYERS; ++c )
+	{
+		if ( !client_disconnected[c] )
+		{
+			connected |= 1 << c;
+		}
+	}
+	return connected;
+}
+
+void stageNextLevel()
+{
+	discardStagedLevel();
+	if ( multiplayer == CLIENT )
+	{
+		return;
+	}
+
+	const int level = currentlevel + 1;
+	std::string line = physfsGetLevelsFileLine(level, secretlevel);
+	std::string mapType;
+	std::string mapName;
+	std::tuple<int, int, int, int> mapParameters;
+	if ( !physfsParseLevelsFileLine(line, mapType, mapName, mapParameters) || mapType.compare("gen:") != 0 )
+	{
+		return; // fixed maps load quickly enough as they are
+	}
+
+	map_t* destmap = (map_t*) malloc(sizeof(map_t));
+	destmap->tiles = nullptr;
+	destmap->entities = (list_t*) malloc(sizeof(list_t));
+	destmap->entities->first = nullptr;
+	destmap->entities->last = nullptr;
+	destmap->creatures = new list_t;
+	destmap->creatures->first = nullptr;
+	destmap->creatures->last = nullptr;
+	destmap->worldUI = nullptr;
+
+	stagedLevel.map = destmap;
+	stagedLevel.result = -1;
+	stagedLevel.level = level;
+	stagedLevel.secret = secretlevel;
+	stagedLevel.seed = local_rng.rand();
+	stagedLevel.line = line;
+	stagedLevel.serverFlags = svFlags;
+	stagedLevel.connectedPlayers = getConnectedPlayers();
+	stagedLevel.multiplayerMode = multiplayer;
+
+	Uint32 localSeed = local_rng.rand();
+	stagedLevel.localRng.seedBytes(&localSeed, sizeof(localSeed));
+	stagedLevel.target = MapGenTarget_t();
+	stagedLevel.target.map = destmap;
+	stagedLevel.target.rng = &stagedLevel.rng;
+	stagedLevel.target.localRng = &stagedLevel.localRng;
+	stagedLevel.target.currentlevel = level;
+	stagedLevel.target.secretlevel = secretlevel;
+
+	stagedLevel.task = std::async(std::launch::async, [mapName, mapParameters]()
+	{
+		char levelset[1024];
+		snprintf(levelset, sizeof(levelset), "%s", mapName.c_str());
+		stagedMapGen = &stagedLevel.target;
+		stagedLevel.result = generateDungeon(levelset, stagedLevel.seed, mapParameters, stagedLevel.target);
+		stagedMapGen = nullptr;
+	});
+}
+
+Uint32 nextLevelSeed()
+{
+	if ( stagedLevel.map )
+	{
+		return stagedLevel.seed;
+	}
+	return local_rng.rand();
+}
+
+void discardStagedLevel()
+{
+	if ( stagedLevel.task.valid() )
+	{
+		stagedLevel.task.get();
+	}
+	if ( stagedLevel.map )
+	{
+		mapDeconstructor((void*)stagedLevel.map);
+		stagedLevel.map = nullptr;
+	}
+}
+
+bool takeStagedLevel(int levelToLoad, bool secret, Uint32 seed, int& result)
+{
+	if ( !stagedLevel.map )
+	{
+		return false;
+	}
+	if ( stagedLevel.task.valid() )
+	{
+		stagedLevel.task.get();
+	}
+
+	const char* mismatch = nullptr;
+	if ( stagedLevel.level != levelToLoad || stagedLevel.secret != secret )
+	{
+		mismatch = "different level";
+	}
+	else if ( stagedLevel.seed != seed )
+	{
+		mismatch = "different seed";
+	}
+	else if ( loadCustomNextMap.compare("") != 0 )
+	{
+		mismatch = "custom next map";
+	}
+	else if ( stagedLevel.serverFlags != svFlags || stagedLevel.multiplayerMode != multiplayer
+		|| stagedLevel.connectedPlayers != getConnectedPlayers() )
+	{
+		mismatch = "game settings changed";
+	}
+	else if ( stagedLevel.line != physfsGetLevelsFileLine(levelToLoad, secret) )
+	{
+		mismatch = "levels file changed";
+	}
+	else if ( stagedLevel.result < 0 )
+	{
+		mismatch = "generation failed";
+	}
+	if ( mismatch )
+	{
+		printlog("[MAP GENERATOR]: not using staged level %d (%s)", stagedLevel.level, mismatch);
+		discardStagedLevel();
+		return false;
+	}
+
+	monsterCurveCustomManager.readFromFile();
+
+	// number the entities from where the clients will, as if generated now
+	for ( node_t* node = stagedLevel.map->entities->first; node != nullptr; node = node->next )
+	{
+		Entity* entity = (Entity*)node->element;
+		entity->setUID(entity_uids + entity->getUID());
+	}
+	entity_uids += stagedLevel.target.uids;
+
+	adoptMainMap(*stagedLevel.map);
+	mapDeconstructor((void*)stagedLevel.map);
+	stagedLevel.map = nullptr;
+
+	mapseed = seed;
+	map_rng = stagedLevel.rng; // assignActions() carries on where generation left off
+	applyMapGenTarget(stagedLevel.target);
+	printlog("[MAP GENERATOR]: using staged level %d", levelToLoad);
+	result = stagedLevel.result;
+	return true;
+}
+
 /*-------------------------------------------------------------------------------
 
 	assignActions
@@ -7020,6 +7638,8 @@ void assignActions(map_t* map)
 	}
                             
     keepInventoryGlobal = svFlags & SV_FLAG_KEEPINVENTORY;
+
+	CircuitNetlist.invalidate(); // wiring is final, rebuild neighbors on first use
 }
 
 void mapLevel(int player)
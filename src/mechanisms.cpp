@@ -58,77 +58,110 @@ void Entity::circuitPowerOff()
 	}
 }
 
-void Entity::updateCircuitNeighbors()
+/*
+ * Sends power (or the lack of it) from source out through its network.
+ * Circuits that change state pass it on to their own neighbors, everything
+ * else (mechanisms, signal timers) just takes the new state. This walks the
+ * cached netlist depth-first with an explicit stack, descending into a circuit
+ * as soon as it changes, so entities are visited and powered in exactly the
+ * order the old recursive circuitPowerOn/Off -> updateCircuitNeighbors calls
+ * used. /test_circuits checks this against the recursive version.
+ * If onlyUnpowered, the source's direct neighbors that are already on are skipped.
+ * If trace is set, every entity handed the new state is appended to it.
+ */
+static void propagateCircuitPower(Entity* source, bool powered, bool onlyUnpowered, std::vector<Entity*>* trace = nullptr)
 {
-	//Send the power on or off signal to all neighboring circuits & mechanisms.
-	list_t* neighbors = getPowerableNeighbors(); //Grab a list of all neighboring circuits and mechanisms.
-
-	if (neighbors)
+	const Sint32 status = powered ? Entity::CIRCUIT_ON : Entity::CIRCUIT_OFF;
+	struct Frame
+	{
+		Entity* current;
+		std::vector<Entity*> neighbors; // copied, powering a mechanism may invalidate the netlist under us.
+		size_t next;
+	};
+	std::vector<Frame> stack;
+	stack.push_back(Frame{ source, CircuitNetlist.getNeighbors(*source), 0 });
+	while ( !stack.empty() )
 	{
-		node_t* node = NULL;
-		for (node = neighbors->first; node != NULL; node = node->next)
+		Frame& frame = stack.back();
+		if ( frame.next >= frame.neighbors.size() )
 		{
-			if (node->element)
-			{
-				Entity* powerable = (Entity*)(node->element);
+			stack.pop_back();
+			continue;
+		}
+		Entity* current = frame.current;
+		Entity* powerable = frame.neighbors[frame.next++];
+		if ( !powerable->circuit_status )
+		{
+			continue;
+		}
+		if ( onlyUnpowered && stack.size() == 1 && powerable->circuit_status == Entity::CIRCUIT_ON )
+		{
+			continue;
+		}
 
-				if (powerable)
+		if ( powerable->behavior == actCircuit )
+		{
+			if ( powerable->circuit_status != status )
+			{
+				powerable->circuit_status = status;
+				//TODO: Play a sound effect?
+				if ( trace )
 				{
-					if (powerable->behavior == actCircuit)
-					{
-						(circuit_status > 1) ? powerable->circuitPowerOn() : powerable->circuitPowerOff();
-					}
-					else if ( powerable->behavior == &::actSignalTimer )
-					{
-						int x1 = static_cast<int>(this->x / 16);
-						int x2 = static_cast<int>(powerable->x / 16);
-						int y1 = static_cast<int>(this->y / 16);
-						int y2 = static_cast<int>(powerable->y / 16);
-						//messagePlayer(0, "%d, %d, %d, %d", x1, x2, y1, y2);
-						switch ( powerable->signalInputDirection )
-						{
-							case 0: // west
-								if ( (x1 + 1) == x2 )
-								{
-									(circuit_status > 1) ? powerable->mechanismPowerOn() : powerable->mechanismPowerOff();
-								}
-								break;
-							case 1: // south
-								if ( (y1 - 1) == y2 )
-								{
-									(circuit_status > 1) ? powerable->mechanismPowerOn() : powerable->mechanismPowerOff();
-								}
-								break;
-							case 2: // east
-								if ( (x1 - 1) == x2 )
-								{
-									(circuit_status > 1) ? powerable->mechanismPowerOn() : powerable->mechanismPowerOff();
-								}
-								break;
-							case 3: // north
-								if ( (y1 + 1) == y2 )
-								{
-									(circuit_status > 1) ? powerable->mechanismPowerOn() : powerable->mechanismPowerOff();
-								}
-								break;
-							default:
-								break;
-						}
-					}
-					else
-					{
-						(circuit_status > 1) ? powerable->mechanismPowerOn() : powerable->mechanismPowerOff();
-					}
+					trace->push_back(powerable);
 				}
+				stack.push_back(Frame{ powerable, CircuitNetlist.getNeighbors(*powerable), 0 }); // frame is invalid past here
+			}
+		}
+		else if ( powerable->behavior == &::actSignalTimer )
+		{
+			int x1 = static_cast<int>(current->x / 16);
+			int x2 = static_cast<int>(powerable->x / 16);
+			int y1 = static_cast<int>(current->y / 16);
+			int y2 = static_cast<int>(powerable->y / 16);
+			bool connected = false;
+			switch ( powerable->signalInputDirection )
+			{
+				case 0: // west
+					connected = (x1 + 1) == x2;
+					break;
+				case 1: // south
+					connected = (y1 - 1) == y2;
+					break;
+				case 2: // east
+					connected = (x1 - 1) == x2;
+					break;
+				case 3: // north
+					connected = (y1 + 1) == y2;
+					break;
+				default:
+					break;
+			}
+			if ( connected )
+			{
+				powered ? powerable->mechanismPowerOn() : powerable->mechanismPowerOff();
+				if ( trace )
+				{
+					trace->push_back(powerable);
+				}
+			}
+		}
+		else
+		{
+			powered ? powerable->mechanismPowerOn() : powerable->mechanismPowerOff();
+			if ( trace )
+			{
+				trace->push_back(powerable);
 			}
 		}
-
-		//Free the list.
-		list_FreeAll(neighbors);
-		free(neighbors);
 	}
 }
 
+void Entity::updateCircuitNeighbors()
+{
+	//Send the power on or off signal to all neighboring circuits & mechanisms.
+	propagateCircuitPower(this, circuit_status > 1, false);
+}
+
 
 
 
@@ -566,143 +599,13 @@ void Entity::toggleSwitch(int skillIndexForPower)
 
 	//(my->skill[0]) ? my->sprite = 171 : my->sprite = 168;
 
-	list_t* neighbors = getPowerableNeighbors(); //Grab a list of all neighboring circuits and mechanisms.
-
-	if (neighbors)
-	{
-		node_t* node = NULL;
-		for (node = neighbors->first; node != NULL; node = node->next)
-		{
-			if (node->element)
-			{
-				Entity* powerable = (Entity*)(node->element);
-
-				if (powerable)
-				{
-					if (powerable->behavior == actCircuit)
-					{
-						(switchPower) ? powerable->circuitPowerOn() : powerable->circuitPowerOff();
-					}
-					else if ( powerable->behavior == &::actSignalTimer )
-					{
-						int x1 = static_cast<int>(this->x / 16);
-						int x2 = static_cast<int>(powerable->x / 16);
-						int y1 = static_cast<int>(this->y / 16);
-						int y2 = static_cast<int>(powerable->y / 16);
-						//messagePlayer(0, "%d, %d, %d, %d", x1, x2, y1, y2);
-						switch ( powerable->signalInputDirection )
-						{
-							case 0: // west
-								if ( (x1 + 1) == x2 )
-								{
-									(switchPower) ? powerable->mechanismPowerOn() : powerable->mechanismPowerOff();
-								}
-								break;
-							case 1: // south
-								if ( (y1 - 1) == y2 )
-								{
-									(switchPower) ? powerable->mechanismPowerOn() : powerable->mechanismPowerOff();
-								}
-								break;
-							case 2: // east
-								if ( (x1 - 1) == x2 )
-								{
-									(switchPower) ? powerable->mechanismPowerOn() : powerable->mechanismPowerOff();
-								}
-								break;
-							case 3: // north
-								if ( (y1 + 1) == y2 )
-								{
-									(switchPower) ? powerable->mechanismPowerOn() : powerable->mechanismPowerOff();
-								}
-								break;
-							default:
-								break;
-						}
-					}
-					else
-					{
-						(switchPower) ? powerable->mechanismPowerOn() : powerable->mechanismPowerOff();
-					}
-				}
-			}
-		}
-
-		list_FreeAll(neighbors); //Free the list.
-		free(neighbors);
-	}
+	propagateCircuitPower(this, switchPower, false);
 }
 
 void Entity::switchUpdateNeighbors()
 {
-	list_t* neighbors = getPowerableNeighbors(); //Grab a list of all neighboring circuits and mechanisms.
-
-	if (neighbors)
-	{
-		node_t* node = NULL;
-		for (node = neighbors->first; node != NULL; node = node->next)
-		{
-			if (node->element)
-			{
-				Entity* powerable = (Entity*)(node->element);
-
-				if (powerable)
-				{
-					if (powerable->circuit_status != CIRCUIT_ON)
-					{
-						if (powerable->behavior == actCircuit)
-						{
-							powerable->circuitPowerOn();
-						}
-						else if ( powerable->behavior == &::actSignalTimer )
-						{
-							int x1 = static_cast<int>(this->x / 16);
-							int x2 = static_cast<int>(powerable->x / 16);
-							int y1 = static_cast<int>(this->y / 16);
-							int y2 = static_cast<int>(powerable->y / 16);
-							//messagePlayer(0, "%d, %d, %d, %d", x1, x2, y1, y2);
-							switch ( powerable->signalInputDirection )
-							{
-								case 0: // west
-									if ( (x1 + 1) == x2 )
-									{
-										powerable->mechanismPowerOn();
-									}
-									break;
-								case 1: // south
-									if ( (y1 - 1) == y2 )
-									{
-										powerable->mechanismPowerOn();
-									}
-									break;
-								case 2: // east
-									if ( (x1 - 1) == x2 )
-									{
-										powerable->mechanismPowerOn();
-									}
-									break;
-								case 3: // north
-									if ( (y1 + 1) == y2 )
-									{
-										powerable->mechanismPowerOn();
-									}
-									break;
-								default:
-									break;
-							}
-						}
-						else
-						{
-							powerable->mechanismPowerOn();
-						}
-					}
-				}
-			}
-		}
-
-		list_FreeAll(neighbors); //Free the list.
-		free(neighbors);
-	}
+	//Power on any neighbors that don't have power.
+	propagateCircuitPower(this, true, true);
 }
 
 void getPowerablesOnTile(int x, int y, list_t** list)
@@ -757,25 +660,59 @@ void getPowerablesOnTile(int x, int y, list_t** list)
 	//return return_val;
 }
 
-list_t* Entity::getPowerableNeighbors()
+const std::vector<Entity*>& CircuitNetlist_t::getNeighbors(Entity& entity)
 {
-	list_t* return_val = NULL;
+	if ( dirty )
+	{
+		neighbors.clear();
+		dirty = false;
+	}
 
+	auto find = neighbors.find(&entity);
+	if ( find != neighbors.end() )
+	{
+		return find->second;
+	}
 
-	int tx = x / 16;
-	int ty = y / 16;
+	auto& result = neighbors[&entity];
+	const int tx = entity.x / 16;
+	const int ty = entity.y / 16;
+	const int tiles[5][2] = {
+		{ tx, ty }, // current tile
+		{ tx - 1, ty }, // left
+		{ tx + 1, ty }, // right
+		{ tx, ty - 1 }, // up
+		{ tx, ty + 1 }, // down
+	};
+	for ( auto& tile : tiles )
+	{
+		list_t* entities = checkTileForEntity(tile[0], tile[1]);
+		if ( !entities )
+		{
+			continue;
+		}
+		for ( node_t* node = entities->first; node != nullptr; node = node->next )
+		{
+			Entity* powerable = (Entity*)node->element;
+			if ( powerable && powerable->circuit_status ) // If skill 28 = 0, the entity is not a powerable.
+			{
+				result.push_back(powerable);
+			}
+		}
+	}
+	return result;
+}
 
-	getPowerablesOnTile(tx, ty, &return_val); //Check current tile
-	getPowerablesOnTile(tx - 1, ty, &return_val); //Check tile to the left.
-	getPowerablesOnTile(tx + 1, ty, &return_val); //Check tile to the right.
-	getPowerablesOnTile(tx, ty - 1, &return_val); //Check tile up.
-	getPowerablesOnTile(tx, ty + 1, &return_val); //Check tile down.
-	//getPowerablesOnTile(tx - 1, ty - 1, &return_val); //Check tile diagonal up left.
-	//getPowerablesOnTile(tx + 1, ty - 1, &return_val); //Check tile diagonal up right.
-	//getPowerablesOnTile(tx - 1, ty + 1, &return_val); //Check tile diagonal down left.
-	//getPowerablesOnTile(tx + 1, ty + 1, &return_val); //Check tile diagonal down right.
-
-	return return_val;
+void CircuitNetlist_t::removeEntity(Entity& entity)
+{
+	if ( entity.circuit_status )
+	{
+		dirty = true; // topology changed
+	}
+	else
+	{
+		neighbors.erase(&entity);
+	}
 }
 
 void actSoundSource(Entity* my)
@@ -1032,3 +969,178 @@ void Entity::actSignalTimer()
 		}
 	}
 }
+
+/*-------------------------------------------------------------------------------
+
+	/test_circuits
+
+	Replays every powerable on the current level as a power source through
+	both propagateCircuitPower() and the recursive tile-scanning propagation
+	it replaced, and checks that both power the same entities in the same
+	order and leave every powerable in the same state. Each source is run as
+	a wire update, a switch toggle in each direction and a switch refresh,
+	starting from the level's current state and from a scrambled one.
+
+-------------------------------------------------------------------------------*/
+
+// getPowerableNeighbors() as it was before the netlist
+static list_t* referencePowerableNeighbors(Entity& entity)
+{
+	list_t* neighbors = nullptr;
+	const int tx = entity.x / 16;
+	const int ty = entity.y / 16;
+	getPowerablesOnTile(tx, ty, &neighbors);
+	getPowerablesOnTile(tx - 1, ty, &neighbors);
+	getPowerablesOnTile(tx + 1, ty, &neighbors);
+	getPowerablesOnTile(tx, ty - 1, &neighbors);
+	getPowerablesOnTile(tx, ty + 1, &neighbors);
+	return neighbors;
+}
+
+// updateCircuitNeighbors/toggleSwitch/switchUpdateNeighbors as they were.
+// wires take their polarity from their own state, switches are given one
+static void referencePropagate(Entity& self, bool useOwnStatus, bool powered, bool onlyUnpowered, std::vector<Entity*>& trace)
+{
+	list_t* neighbors = referencePowerableNeighbors(self);
+	if ( !neighbors )
+	{
+		return;
+	}
+	for ( node_t* node = neighbors->first; node != nullptr; node = node->next )
+	{
+		Entity* powerable = (Entity*)node->element;
+		if ( !powerable )
+		{
+			continue;
+		}
+		if ( onlyUnpowered && powerable->circuit_status == Entity::CIRCUIT_ON )
+		{
+			continue;
+		}
+		const bool power = useOwnStatus ? self.circuit_status > 1 : powered;
+		if ( powerable->behavior == actCircuit )
+		{
+			// circuitPowerOn/Off
+			if ( power && powerable->circuit_status && powerable->circuit_status != Entity::CIRCUIT_ON )
+			{
+				powerable->circuit_status = Entity::CIRCUIT_ON;
+				trace.push_back(powerable);
+				referencePropagate(*powerable, true, true, false, trace);
+			}
+			else if ( !power && powerable->circuit_status != Entity::CIRCUIT_OFF )
+			{
+				powerable->circuit_status = Entity::CIRCUIT_OFF;
+				trace.push_back(powerable);
+				referencePropagate(*powerable, true, false, false, trace);
+			}
+		}
+		else if ( powerable->behavior == &::actSignalTimer )
+		{
+			int x1 = static_cast<int>(self.x / 16);
+			int x2 = static_cast<int>(powerable->x / 16);
+			int y1 = static_cast<int>(self.y / 16);
+			int y2 = static_cast<int>(powerable->y / 16);
+			if ( (powerable->signalInputDirection == 0 && (x1 + 1) == x2)
+				|| (powerable->signalInputDirection == 1 && (y1 - 1) == y2)
+				|| (powerable->signalInputDirection == 2 && (x1 - 1) == x2)
+				|| (powerable->signalInputDirection == 3 && (y1 + 1) == y2) )
+			{
+				power ? powerable->mechanismPowerOn() : powerable->mechanismPowerOff();
+				trace.push_back(powerable);
+			}
+		}
+		else
+		{
+			power ? powerable->mechanismPowerOn() : powerable->mechanismPowerOff();
+			trace.push_back(powerable);
+		}
+	}
+	list_FreeAll(neighbors);
+	free(neighbors);
+}
+
+static ConsoleCommand ccmd_test_circuits("/test_circuits", "compare circuit power propagation against the original recursive version on this level",
+	[](int argc, const char* argv[]){
+	std::vector<std::pair<Entity*, Sint32>> baseline;
+	for ( node_t* node = map.entities ? map.entities->first : nullptr; node != nullptr; node = node->next )
+	{
+		Entity* entity = (Entity*)node->element;
+		if ( entity && entity->circuit_status )
+		{
+			baseline.emplace_back(entity, entity->circuit_status);
+		}
+	}
+	auto restore = [](const std::vector<std::pair<Entity*, Sint32>>& state) {
+		for ( auto& it : state )
+		{
+			it.first->circuit_status = it.second;
+		}
+	};
+	auto capture = [&baseline]() {
+		std::vector<Sint32> state;
+		state.reserve(baseline.size());
+		for ( auto& it : baseline )
+		{
+			state.push_back(it.first->circuit_status);
+		}
+		return state;
+	};
+
+	// the level as it is, then with every powerable scrambled
+	std::vector<std::pair<Entity*, Sint32>> scrambled = baseline;
+	Uint32 seed = 0x9e3779b9;
+	for ( auto& it : scrambled )
+	{
+		seed = seed * 1664525 + 1013904223;
+		it.second = (seed >> 16) & 1 ? Entity::CIRCUIT_ON : Entity::CIRCUIT_OFF;
+	}
+
+	int runs = 0;
+	int mismatches = 0;
+	for ( auto start : { &baseline, &scrambled } )
+	{
+		for ( auto& it : baseline )
+		{
+			Entity* source = it.first;
+			for ( int mode = 0; mode < 5; ++mode )
+			{
+				// 0/1: wire update off/on, 2/3: switch toggle off/on, 4: switch refresh
+				const bool powered = mode == 4 || (mode & 1);
+				std::vector<Entity*> expectedTrace, actualTrace;
+
+				restore(*start);
+				if ( mode < 2 )
+				{
+					source->circuit_status = powered ? Entity::CIRCUIT_ON : Entity::CIRCUIT_OFF;
+					referencePropagate(*source, true, powered, false, expectedTrace);
+				}
+				else
+				{
+					referencePropagate(*source, false, powered, mode == 4, expectedTrace);
+				}
+				const std::vector<Sint32> expected = capture();
+
+				restore(*start);
+				if ( mode < 2 )
+				{
+					source->circuit_status = powered ? Entity::CIRCUIT_ON : Entity::CIRCUIT_OFF;
+				}
+				propagateCircuitPower(source, powered, mode == 4, &actualTrace);
+				const std::vector<Sint32> actual = capture();
+
+				++runs;
+				if ( expected != actual || expectedTrace != actualTrace )
+				{
+					++mismatches;
+					printlog("[circuits] mismatch: source uid %d (sprite %d) at %d, %d, mode %d, %d vs %d powered",
+						source->getUID(), source->sprite, (int)(source->x / 16), (int)(source->y / 16), mode,
+						(int)expectedTrace.size(), (int)actualTrace.size());
+				}
+			}
+		}
+	}
+	restore(baseline);
+
+	printlog("[circuits] %d powerables, %d propagations compared, %d mismatches", (int)baseline.size(), runs, mismatches);
+	messagePlayer(clientnum, MESSAGE_MISC, "Circuit test: %d propagations, %d mismatches", runs, mismatches);
+	});
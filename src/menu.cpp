@@ -841,6 +841,7 @@ static void handleMainMenu(bool mode)
 				stats[0]->playerRace = RACE_HUMAN;
 				initClass(0);
 				strcpy(stats[0]->name, "The Server");
+				stats[0]->updateAllegianceTags();
 				keystatus[SDLK_l] = 0;
 				keystatus[SDLK_LCTRL] = 0;
 				keystatus[SDLK_RCTRL] = 0;
@@ -860,6 +861,7 @@ static void handleMainMenu(bool mode)
 				stats[0]->playerRace = RACE_HUMAN;
 				initClass(0);
 				strcpy(stats[0]->name, "The Client");
+				stats[0]->updateAllegianceTags();
 				keystatus[SDLK_m] = 0;
 				keystatus[SDLK_LCTRL] = 0;
 				keystatus[SDLK_RCTRL] = 0;
@@ -8778,6 +8780,7 @@ void doNewGame(bool makeHighscore) {
 		generatePathMaps();
         clearChunks();
         createChunks();
+        stageNextLevel();
 
 		achievementObserver.updateData();
 
@@ -9729,6 +9732,7 @@ void doEndgame(bool saveHighscore) {
 		stats[c]->sex = static_cast<sex_t>(0);
 		stats[c]->appearance = 0;
 		strcpy(stats[c]->name, "");
+		stats[c]->updateAllegianceTags();
 		stats[c]->type = HUMAN;
 		stats[c]->playerRace = RACE_HUMAN;
 		stats[c]->clearStats();
@@ -11034,6 +11038,7 @@ void buttonOpenCharacterCreationWindow(button_t* my)
 	stats[0]->appearance = 0 + local_rng.rand() % NUMAPPEARANCES;
 	stats[0]->playerRace = RACE_HUMAN;
 	strcpy(stats[0]->name, "");
+	stats[0]->updateAllegianceTags();
 	stats[0]->type = HUMAN;
 	client_classes[0] = 0;
 	stats[0]->clearStats();
@@ -11310,6 +11315,7 @@ bool replayLastCharacter(const int index, int multiplayer)
 		len = std::min(sizeof(Stat::name) - 1, len);
 		memcpy(stats[index]->name, name, len);
 		stats[index]->name[len] = '\0';
+		stats[index]->updateAllegianceTags();
 		return true;
 	}
 	return false;
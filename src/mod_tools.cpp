@@ -986,6 +986,9 @@ void ItemTooltips_t::readItemsFromFile()
 	}
 
 	itemsJsonHashRead = hash;
+#ifndef EDITOR
+	itemCurveTablesInvalidate();
+#endif
 	if ( itemsJsonHashRead != kItemsJsonHash )
 	{
 		printlog("[JSON]: Notice: items.json unknown hash, achievements are disabled: %d", itemsJsonHashRead);
@@ -1257,8 +1260,262 @@ void ItemTooltips_t::readItemLocalizationsFromFile(bool forceLoadBaseDirectory)
 }
 
 #ifndef EDITOR
+void ItemTooltips_t::TooltipFormat_t::compile(const std::vector<std::string>& lines)
+{
+	text.clear();
+	for ( size_t line = 0; line < lines.size(); ++line )
+	{
+		if ( line > 0 )
+		{
+			text += '\n';
+		}
+		text += lines[line];
+	}
+
+	tokens.clear();
+	slots = 0;
+	Token_t literal;
+	for ( size_t c = 0; c < text.size(); )
+	{
+		if ( text[c] != '%' )
+		{
+			literal.text += text[c++];
+			continue;
+		}
+		if ( c + 1 < text.size() && text[c + 1] == '%' )
+		{
+			literal.text += '%';
+			c += 2;
+			continue;
+		}
+
+		// %[flags][width][.precision][length]conversion
+		size_t end = c + 1;
+		std::string spec = "%";
+		while ( end < text.size() && strchr("-+ #0", text[end]) )
+		{
+			spec += text[end++];
+		}
+		while ( end < text.size() && (isdigit((unsigned char)text[end]) || text[end] == '.') )
+		{
+			spec += text[end++];
+		}
+		while ( end < text.size() && strchr("hlLqjzt", text[end]) )
+		{
+			++end; // arguments are passed as int/double/string, so length modifiers don't apply
+		}
+		if ( end >= text.size() || !strchr("diucoxXeEfFgGaAs", text[end]) )
+		{
+			// not something snprintf would have formatted either, keep it as text
+			literal.text += text.substr(c, end - c);
+			c = end;
+			continue;
+		}
+		if ( !literal.text.empty() )
+		{
+			tokens.push_back(std::move(literal));
+			literal = Token_t();
+		}
+		Token_t conversion;
+		conversion.conversion = text[end];
+		conversion.text = spec + text[end];
+		conversion.slot = slots++;
+		tokens.push_back(std::move(conversion));
+		c = end + 1;
+	}
+	if ( !literal.text.empty() )
+	{
+		tokens.push_back(std::move(literal));
+	}
+}
+
+void ItemTooltips_t::TooltipFormat_t::render(char* out, size_t size, std::initializer_list<Arg_t> args) const
+{
+	if ( size == 0 )
+	{
+		return;
+	}
+	size_t len = 0;
+	out[0] = '\0';
+	auto append = [&](const char* str, size_t n)
+	{
+		n = std::min(n, size - 1 - len);
+		memcpy(out + len, str, n);
+		len += n;
+		out[len] = '\0';
+	};
+
+	char field[256];
+	for ( auto& token : tokens )
+	{
+		if ( token.slot < 0 )
+		{
+			append(token.text.c_str(), token.text.size());
+			continue;
+		}
+		if ( token.slot >= (int)args.size() )
+		{
+			// the template asks for more values than this tag provides
+			append(token.text.c_str(), token.text.size());
+			continue;
+		}
+		const Arg_t& arg = *(args.begin() + token.slot);
+		int n = 0;
+		if ( arg.kind == Arg_t::ARG_TEXT && token.conversion != 's' )
+		{
+			append(arg.s, strlen(arg.s));
+			continue;
+		}
+		switch ( token.conversion )
+		{
+			case 'd':
+			case 'i':
+			case 'c':
+				n = snprintf(field, sizeof(field), token.text.c_str(),
+					arg.kind == Arg_t::ARG_REAL ? (int)arg.r : (int)arg.i);
+				break;
+			case 'u':
+			case 'o':
+			case 'x':
+			case 'X':
+				n = snprintf(field, sizeof(field), token.text.c_str(),
+					arg.kind == Arg_t::ARG_REAL ? (unsigned int)arg.r : (unsigned int)arg.i);
+				break;
+			case 's':
+			{
+				std::string number;
+				if ( arg.kind == Arg_t::ARG_INT )
+				{
+					number = std::to_string(arg.i);
+				}
+				else if ( arg.kind == Arg_t::ARG_REAL )
+				{
+					number = std::to_string(arg.r);
+				}
+				n = snprintf(field, sizeof(field), token.text.c_str(),
+					arg.kind == Arg_t::ARG_TEXT ? arg.s : number.c_str());
+				break;
+			}
+			default: // floating point
+				n = snprintf(field, sizeof(field), token.text.c_str(),
+					arg.kind == Arg_t::ARG_REAL ? arg.r : (double)arg.i);
+				break;
+		}
+		if ( n > 0 )
+		{
+			append(field, std::min((size_t)n, sizeof(field) - 1));
+		}
+	}
+}
+
+void ItemTooltips_t::ItemTooltip_t::compile()
+{
+	// tooltip text is static once loaded, so tokenize it here rather than on every hover
+	descriptionFormat.compile(descriptionText);
+	detailsFormat.clear();
+	for ( auto& it : detailsText )
+	{
+		detailsFormat[it.first].compile(it.second);
+	}
+}
+
+const ItemTooltips_t::TooltipFormat_t& ItemTooltips_t::getTemplateFormat(const std::string& templateName)
+{
+	static const TooltipFormat_t noFormat;
+	auto find = templateFormats.find(templateName);
+	if ( find != templateFormats.end() )
+	{
+		return find->second;
+	}
+	return noFormat;
+}
+
+Uint32 ItemTooltips_t::hashItemState(const Item& item)
+{
+	const Sint32 state[] = {
+		(Sint32)item.type, (Sint32)item.status, item.beatitude, item.count,
+		(Sint32)item.appearance, (Sint32)item.identified
+	};
+	Uint32 hash = 2166136261u;
+	const Uint8* bytes = (const Uint8*)state;
+	for ( size_t c = 0; c < sizeof(state); ++c )
+	{
+		hash = (hash ^ bytes[c]) * 16777619u;
+	}
+	return hash;
+}
+
+void ItemTooltips_t::updateStatVersion(const int player)
+{
+	// stats are written all over the game, so rather than hooking every write this
+	// fingerprints what the formatters read and bumps the version when it moves
+	Stat* myStats = stats[player];
+	if ( !myStats )
+	{
+		return;
+	}
+	Entity* entity = players[player] ? players[player]->entity : nullptr;
+	Uint32 hash = 2166136261u;
+	auto mix = [&hash](const void* data, size_t len)
+	{
+		const Uint8* bytes = (const Uint8*)data;
+		for ( size_t c = 0; c < len; ++c )
+		{
+			hash = (hash ^ bytes[c]) * 16777619u;
+		}
+	};
+	const Sint32 values[] = {
+		(Sint32)myStats->type, (Sint32)myStats->sex, (Sint32)myStats->appearance, myStats->playerRace,
+		myStats->HP, myStats->MAXHP, myStats->MP, myStats->MAXMP, myStats->LVL, myStats->GOLD,
+		statGetSTR(myStats, entity), statGetDEX(myStats, entity), statGetCON(myStats, entity),
+		statGetINT(myStats, entity), statGetPER(myStats, entity), statGetCHR(myStats, entity),
+		(Sint32)list_Size(&myStats->inventory), // learned spells are inventory items
+		entity ? 1 : 0
+	};
+	mix(values, sizeof(values));
+	mix(myStats->PROFICIENCIES, sizeof(myStats->PROFICIENCIES));
+	mix(myStats->EFFECTS, sizeof(myStats->EFFECTS));
+	Item* equipment[] = {
+		myStats->helmet, myStats->breastplate, myStats->gloves, myStats->shoes, myStats->shield,
+		myStats->weapon, myStats->cloak, myStats->amulet, myStats->ring, myStats->mask
+	};
+	for ( Item* item : equipment )
+	{
+		const Uint32 itemHash = item ? hashItemState(*item) : 0;
+		mix(&itemHash, sizeof(itemHash));
+	}
+
+	if ( hash != statFingerprint[player] )
+	{
+		statFingerprint[player] = hash;
+		++statVersion[player];
+		formatCache[player].clear(); // nothing keyed on the old version can be hit again
+	}
+}
+
+void ItemTooltips_t::clearFormatCache()
+{
+	for ( int i = 0; i < MAXPLAYERS; ++i )
+	{
+		formatCache[i].clear();
+	}
+}
+
+const std::vector<std::string>& ItemTooltips_t::getTemplateLines(const std::string& templateName)
+{
+	static const std::vector<std::string> noLines;
+	auto find = templates.find(templateName);
+	if ( find != templates.end() )
+	{
+		return find->second;
+	}
+	return noLines;
+}
+
 void ItemTooltips_t::readTooltipsFromFile(bool forceLoadBaseDirectory)
 {
+	clearFormatCache(); // keyed on the template and tooltip formats reloaded below
+
 	if ( !PHYSFS_getRealDir("/items/item_tooltips.json") )
 	{
 		printlog("[JSON]: Error: Could not find file: items/items.json");
@@ -1414,6 +1671,12 @@ void ItemTooltips_t::readTooltipsFromFile(bool forceLoadBaseDirectory)
 		}
 	}
 
+	templateFormats.clear();
+	for ( auto& it : templates )
+	{
+		templateFormats[it.first].compile(it.second);
+	}
+
 	if ( forceLoadBaseDirectory )
 	{
 		tooltips.clear();
@@ -1590,6 +1853,7 @@ void ItemTooltips_t::readTooltipsFromFile(bool forceLoadBaseDirectory)
 				}
 			}
 
+			tooltip.compile();
 			tooltips[tooltipType_itr->name.GetString()] = tooltip;
 		}
 	}
@@ -1967,15 +2231,7 @@ std::string ItemTooltips_t::getSpellDescriptionText(const int player, Item& item
 	}
 
 	std::string str;
-	for ( auto it = templates[templateName].begin();
-		it != templates[templateName].end(); ++it )
-	{
-		str += *it;
-		if ( std::next(it) != ItemTooltips.templates[templateName].end() )
-		{
-			str += '\n';
-		}
-	}
+	str += getTemplateText(templateName);
 	return str;
 #endif
 }
@@ -2024,15 +2280,7 @@ std::string ItemTooltips_t::getSpellIconText(const int player, Item& item)
 	}
 
 	std::string str;
-	for ( auto it = templates[templateName].begin();
-		it != templates[templateName].end(); ++it )
-	{
-		str += *it;
-		if ( std::next(it) != ItemTooltips.templates[templateName].end() )
-		{
-			str += '\n';
-		}
-	}
+	str += getTemplateText(templateName);
 
 	if ( spellItems[spell->ID].internalName == "spell_summon" )
 	{
@@ -2140,33 +2388,11 @@ std::string ItemTooltips_t::getCostOfSpellString(const int player, Item& item)
 	memset(buf, 0, sizeof(buf));
 	if ( spell->ID == SPELL_DOMINATE )
 	{
-		std::string templateName = "template_spell_cost_dominate";
-		std::string str;
-		for ( auto it = templates[templateName].begin();
-			it != templates[templateName].end(); ++it )
-		{
-			str += *it;
-			if ( std::next(it) != ItemTooltips.templates[templateName].end() )
-			{
-				str += '\n';
-			}
-		}
-		snprintf(buf, sizeof(buf), str.c_str(), getCostOfSpell(spell));
+		getTemplateFormat("template_spell_cost_dominate").format(buf, sizeof(buf), getCostOfSpell(spell));
 	}
 	else if ( spell->ID == SPELL_DEMON_ILLUSION )
 	{
-		std::string templateName = "template_spell_cost_demon_illusion";
-		std::string str;
-		for ( auto it = templates[templateName].begin();
-			it != templates[templateName].end(); ++it )
-		{
-			str += *it;
-			if ( std::next(it) != ItemTooltips.templates[templateName].end() )
-			{
-				str += '\n';
-			}
-		}
-		snprintf(buf, sizeof(buf), str.c_str(), getCostOfSpell(spell));
+		getTemplateFormat("template_spell_cost_demon_illusion").format(buf, sizeof(buf), getCostOfSpell(spell));
 	}
 	else
 	{
@@ -2177,38 +2403,28 @@ std::string ItemTooltips_t::getCostOfSpellString(const int player, Item& item)
 			templateName = "template_spell_cost_sustained";
 		}
 
-		std::string str;
-		for ( auto it = templates[templateName].begin();
-			it != templates[templateName].end(); ++it )
-		{
-			str += *it;
-			if ( std::next(it) != ItemTooltips.templates[templateName].end() )
-			{
-				str += '\n';
-			}
-		}
-		snprintf(buf, sizeof(buf), str.c_str(), getCostOfSpell(spell));
+		const TooltipFormat_t& format = getTemplateFormat(templateName);
 		if ( players[player] && players[player]->entity )
 		{
 			if ( sustainCostPerSecond > 0.01 )
 			{
-				snprintf(buf, sizeof(buf), str.c_str(), 
+				format.format(buf, sizeof(buf),
 					getCostOfSpell(spell, players[player]->entity), sustainCostPerSecond);
 			}
 			else
 			{
-				snprintf(buf, sizeof(buf), str.c_str(), getCostOfSpell(spell, players[player]->entity));
+				format.format(buf, sizeof(buf), getCostOfSpell(spell, players[player]->entity));
 			}
 		}
 		else
 		{
 			if ( sustainCostPerSecond > 0.01 )
 			{
-				snprintf(buf, sizeof(buf), str.c_str(), getCostOfSpell(spell), sustainCostPerSecond);
+				format.format(buf, sizeof(buf), getCostOfSpell(spell), sustainCostPerSecond);
 			}
 			else
 			{
-				snprintf(buf, sizeof(buf), str.c_str(), getCostOfSpell(spell));
+				format.format(buf, sizeof(buf), getCostOfSpell(spell));
 			}
 		}
 	}
@@ -2512,10 +2728,9 @@ Sint32 getStatAttributeBonusFromItem(const int player, Item& item, std::string&
 #endif
 }
 
-void ItemTooltips_t::formatItemIcon(const int player, std::string tooltipType, Item& item, std::string& str, int iconIndex, std::string& conditionalAttribute)
+void ItemTooltips_t::formatItemIcon(const int player, const std::string& tooltipType, Item& item, std::string& str, int iconIndex, std::string& conditionalAttribute)
 {
 #ifndef EDITOR
-	auto itemTooltip = tooltips[tooltipType];
 	static Stat itemDummyStat(0);
 	char buf[128];
 	memset(buf, 0, sizeof(buf));
@@ -2572,54 +2787,22 @@ void ItemTooltips_t::formatItemIcon(const int player, std::string tooltipType, I
 			if ( spellItems[spellID].spellTags.find(SPELL_TAG_DAMAGE) != spellItems[spellID].spellTags.end() )
 			{
 				str = "";
-				for ( auto it = ItemTooltips.templates["template_spellbook_icon_damage_bonus"].begin();
-					it != ItemTooltips.templates["template_spellbook_icon_damage_bonus"].end(); ++it )
-				{
-					str += *it;
-					if ( std::next(it) != ItemTooltips.templates["template_spellbook_icon_damage_bonus"].end() )
-					{
-						str += '\n';
-					}
-				}
+				str += getTemplateText("template_spellbook_icon_damage_bonus");
 			}
 			else if ( spellItems[spellID].spellTags.find(SPELL_TAG_HEALING) != spellItems[spellID].spellTags.end() )
 			{
 				str = "";
-				for ( auto it = ItemTooltips.templates["template_spellbook_icon_heal_bonus"].begin();
-					it != ItemTooltips.templates["template_spellbook_icon_heal_bonus"].end(); ++it )
-				{
-					str += *it;
-					if ( std::next(it) != ItemTooltips.templates["template_spellbook_icon_heal_bonus"].end() )
-					{
-						str += '\n';
-					}
-				}
+				str += getTemplateText("template_spellbook_icon_heal_bonus");
 			}
 			else if ( spellItems[spellID].spellTags.find(SPELL_TAG_STATUS_EFFECT) != spellItems[spellID].spellTags.end() )
 			{
 				str = "";
-				for ( auto it = ItemTooltips.templates["template_spellbook_icon_duration_bonus"].begin();
-					it != ItemTooltips.templates["template_spellbook_icon_duration_bonus"].end(); ++it )
-				{
-					str += *it;
-					if ( std::next(it) != ItemTooltips.templates["template_spellbook_icon_duration_bonus"].end() )
-					{
-						str += '\n';
-					}
-				}
+				str += getTemplateText("template_spellbook_icon_duration_bonus");
 			}
 			else if ( spellItems[spellID].spellTags.find(SPELL_TAG_CURE) != spellItems[spellID].spellTags.end() )
 			{
 				str = "";
-				for ( auto it = ItemTooltips.templates["template_spellbook_icon_cureailment_bonus"].begin();
-					it != ItemTooltips.templates["template_spellbook_icon_cureailment_bonus"].end(); ++it )
-				{
-					str += *it;
-					if ( std::next(it) != ItemTooltips.templates["template_spellbook_icon_cureailment_bonus"].end() )
-					{
-						str += '\n';
-					}
-				}
+				str += getTemplateText("template_spellbook_icon_cureailment_bonus");
 				int bonusSeconds = 10 * ((spellBookBonusPercent * 4) / 100.0); // 25% = 10 seconds, 50% = 20 seconds.
 				snprintf(buf, sizeof(buf), str.c_str(), bonusSeconds);
 				str = buf;
@@ -2957,8 +3140,25 @@ void ItemTooltips_t::formatItemIcon(const int player, std::string tooltipType, I
 #endif
 }
 
-void ItemTooltips_t::formatItemDescription(const int player, std::string tooltipType, Item& item, std::string& str)
+void ItemTooltips_t::formatItemDescription(const int player, const std::string& tooltipType, Item& item, std::string& str)
 {
+#ifndef EDITOR
+	str = "";
+	auto tooltip = tooltips.find(tooltipType);
+	if ( tooltip == tooltips.end() )
+	{
+		return;
+	}
+	FormatCacheKey_t key{ &tooltip->second.descriptionFormat, item.uid, hashItemState(item), statVersion[player] };
+	auto& cache = formatCache[player];
+	auto cached = cache.find(key);
+	if ( cached != cache.end() )
+	{
+		str = cached->second;
+		return;
+	}
+	str = tooltip->second.descriptionFormat.text;
+#endif
 	if ( tooltipType.find("tooltip_spell_") != std::string::npos )
 	{
 		str = getSpellDescriptionText(player, item);
@@ -2969,37 +3169,56 @@ void ItemTooltips_t::formatItemDescription(const int player, std::string tooltip
 		if ( item.status == BROKEN )
 		{
 			str = "";
-			for ( auto it = ItemTooltips.templates["template_tinkerbot_broken_description"].begin();
-				it != ItemTooltips.templates["template_tinkerbot_broken_description"].end(); ++it )
-			{
-				str += *it;
-				if ( std::next(it) != ItemTooltips.templates["template_tinkerbot_broken_description"].end() )
-				{
-					str += '\n';
-				}
-			}
+			str += getTemplateText("template_tinkerbot_broken_description");
 		}
 	}
-	return;
+#ifndef EDITOR
+	cache.emplace(key, str);
+#endif
 }
 
-void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType, Item& item, std::string& str, std::string detailTag)
+void ItemTooltips_t::formatItemDetails(const int player, const std::string& tooltipType, Item& item, std::string& str, const std::string& detailTag)
 {
 #ifndef EDITOR
+	str = "";
 	if ( !stats[player] )
 	{
-		str = "";
 		return;
 	}
 	if ( players[player] && !players[player]->isLocalPlayer() )
 	{
-		str = "";
+		return;
+	}
+	auto tooltip = tooltips.find(tooltipType);
+	if ( tooltip == tooltips.end() )
+	{
+		return;
+	}
+	auto format = tooltip->second.detailsFormat.find(detailTag);
+	if ( format == tooltip->second.detailsFormat.end() )
+	{
 		return;
 	}
 
-	auto itemTooltip = ItemTooltips.tooltips[tooltipType];
+	FormatCacheKey_t key{ &format->second, item.uid, hashItemState(item), statVersion[player] };
+	auto& cache = formatCache[player];
+	auto cached = cache.find(key);
+	if ( cached != cache.end() )
+	{
+		str = cached->second;
+		return;
+	}
+	str = format->second.text;
+	formatItemDetailsText(player, tooltipType, item, format->second, str, detailTag);
+	cache.emplace(key, str);
+#endif
+}
 
+void ItemTooltips_t::formatItemDetailsText(const int player, const std::string& tooltipType, Item& item, const TooltipFormat_t& format, std::string& str, const std::string& detailTag)
+{
+#ifndef EDITOR
 	memset(buf, 0, sizeof(buf));
+	bool redLine = false;
 
 	if ( tooltipType.find("tooltip_armor") != std::string::npos 
 		|| tooltipType.find("tooltip_offhand") != std::string::npos
@@ -3008,20 +3227,20 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 	{
 		if ( detailTag.compare("armor_base_ac") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(),
+			format.format(buf, sizeof(buf),
 				items[item.type].hasAttribute("AC") ? items[item.type].attributes["AC"] : 0	);
 		}
 		else if ( detailTag.compare("armor_shield_bonus") == 0 )
 		{
 			if ( tooltipType.find("tooltip_offhand") != std::string::npos )
 			{
-				snprintf(buf, sizeof(buf), str.c_str(),
+				format.format(buf, sizeof(buf),
 					stats[player]->getActiveShieldBonus(false),
 					getItemProficiencyName(PRO_SHIELD).c_str());
 			}
 			else
 			{
-				snprintf(buf, sizeof(buf), str.c_str(), 
+				format.format(buf, sizeof(buf), 
 					stats[player]->getPassiveShieldBonus(false),
 					getItemProficiencyName(PRO_SHIELD).c_str(),
 					stats[player]->getActiveShieldBonus(false),
@@ -3030,7 +3249,7 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 		}
 		else if ( detailTag.compare("on_bless_or_curse") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(), 
+			format.format(buf, sizeof(buf), 
 				shouldInvertEquipmentBeatitude(stats[player]) ? abs(item.beatitude) : item.beatitude, 
 				getItemBeatitudeAdjective(item.beatitude).c_str());
 		}
@@ -3042,44 +3261,44 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 			{
 				durabilityBonus *= 2;
 			}
-			snprintf(buf, sizeof(buf), str.c_str(), durabilityBonus, getItemProficiencyName(PRO_SHIELD).c_str());
+			format.format(buf, sizeof(buf), durabilityBonus, getItemProficiencyName(PRO_SHIELD).c_str());
 		}
 		else if ( detailTag.compare("shield_legendary_durability") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(), getItemProficiencyName(PRO_SHIELD).c_str());
+			format.format(buf, sizeof(buf), getItemProficiencyName(PRO_SHIELD).c_str());
 		}
 		else if ( detailTag.compare("knuckle_skill_modifier") == 0 )
 		{
 			int atk = (stats[player]->PROFICIENCIES[PRO_UNARMED] / 20); // 0 - 5
-			snprintf(buf, sizeof(buf), str.c_str(), atk, getItemProficiencyName(PRO_UNARMED).c_str());
+			format.format(buf, sizeof(buf), atk, getItemProficiencyName(PRO_UNARMED).c_str());
 		}
 		else if ( detailTag.compare("knuckle_knockback_modifier") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(), 
+			format.format(buf, sizeof(buf), 
 				items[item.type].hasAttribute("KNOCKBACK") ? items[item.type].attributes["KNOCKBACK"] : 0);
 		}
 		else if ( detailTag.compare("weapon_atk_from_player_stat") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(), stats[player] ? statGetSTR(stats[player], players[player]->entity) : 0);
+			format.format(buf, sizeof(buf), stats[player] ? statGetSTR(stats[player], players[player]->entity) : 0);
 		}
 		else if ( detailTag.compare("ring_unarmed_atk") == 0 )
 		{
 			int atk = 1 + (shouldInvertEquipmentBeatitude(stats[player]) ? abs(item.beatitude) : item.beatitude);
-			snprintf(buf, sizeof(buf), str.c_str(), atk, getItemBeatitudeAdjective(item.beatitude).c_str());
+			format.format(buf, sizeof(buf), atk, getItemBeatitudeAdjective(item.beatitude).c_str());
 		}
 		else if ( detailTag.compare("weapon_durability") == 0 )
 		{
 			int skillLVL = stats[player]->PROFICIENCIES[PRO_UNARMED] / 20;
 			int durabilityBonus = skillLVL * 20;
-			snprintf(buf, sizeof(buf), str.c_str(), durabilityBonus, getItemProficiencyName(PRO_UNARMED).c_str());
+			format.format(buf, sizeof(buf), durabilityBonus, getItemProficiencyName(PRO_UNARMED).c_str());
 		}
 		else if ( detailTag.compare("weapon_legendary_durability") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(), getItemProficiencyName(PRO_UNARMED).c_str());
+			format.format(buf, sizeof(buf), getItemProficiencyName(PRO_UNARMED).c_str());
 		}
 		else if ( detailTag.compare("equipment_fragile_durability") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(),
+			format.format(buf, sizeof(buf),
 				items[item.type].hasAttribute("FRAGILE") ? -items[item.type].attributes["FRAGILE"] : 0);
 		}
 		else if ( detailTag.compare("equipment_stat_bonus") == 0 )
@@ -3096,7 +3315,7 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 					baseStatBonus = items[item.type].attributes[stat];
 					beatitudeStatBonus = getStatAttributeBonusFromItem(player, item, stat) - baseStatBonus;
 
-					snprintf(buf, sizeof(buf), str.c_str(), baseStatBonus, stat.c_str(),
+					format.format(buf, sizeof(buf), baseStatBonus, stat.c_str(),
 						beatitudeStatBonus, stat.c_str(), getItemBeatitudeAdjective(item.beatitude).c_str());
 					break;
 				}
@@ -3116,7 +3335,7 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 
 			if ( detailTag == "EFF_FEATHER" )
 			{
-				snprintf(buf, sizeof(buf), str.c_str(), 
+				format.format(buf, sizeof(buf), 
 					items[item.type].hasAttribute(detailTag) ? items[item.type].attributes["EFF_FEATHER"] : 0,
 					getItemEquipmentEffectsForAttributesText(detailTag).c_str());
 			}
@@ -3124,7 +3343,7 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 			{
 				int beatitude = shouldInvertEquipmentBeatitude(stats[player]) ? abs(item.beatitude) : item.beatitude;
 				int radius = std::max(3, 11 + 5 * beatitude);
-				snprintf(buf, sizeof(buf), str.c_str(), radius, getItemBeatitudeAdjective(item.beatitude).c_str());
+				format.format(buf, sizeof(buf), radius, getItemBeatitudeAdjective(item.beatitude).c_str());
 			}
 			else
 			{
@@ -3135,12 +3354,12 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 			|| detailTag.compare("ring_on_cursed_sideeffect") == 0 
 			|| detailTag.compare("armor_on_cursed_sideeffect") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(), getItemBeatitudeAdjective(item.beatitude).c_str());
+			format.format(buf, sizeof(buf), getItemBeatitudeAdjective(item.beatitude).c_str());
 		}
 		else if ( detailTag.compare("artifact_armor_on_degraded") == 0 )
 		{
 			int statusModifier = std::max(DECREPIT, item.status) - 3;
-			snprintf(buf, sizeof(buf), str.c_str(), statusModifier, getItemStatusAdjective(item.type, item.status).c_str());
+			format.format(buf, sizeof(buf), statusModifier, getItemStatusAdjective(item.type, item.status).c_str());
 		}
 		else
 		{
@@ -3152,28 +3371,28 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 		int proficiency = PRO_RANGED;
 		if ( detailTag.compare("weapon_base_atk") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(),
+			format.format(buf, sizeof(buf),
 				items[item.type].hasAttribute("ATK") ? items[item.type].attributes["ATK"] : 0);
 		}
 		else if ( detailTag.compare("on_bless_or_curse") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(),
+			format.format(buf, sizeof(buf),
 				shouldInvertEquipmentBeatitude(stats[player]) ? abs(item.beatitude) : item.beatitude,
 				getItemBeatitudeAdjective(item.beatitude).c_str());
 		}
 		else if ( detailTag.compare("thrown_atk_from_player_stat") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(), stats[player] ? (statGetDEX(stats[player], players[player]->entity) / 4) : 0);
+			format.format(buf, sizeof(buf), stats[player] ? (statGetDEX(stats[player], players[player]->entity) / 4) : 0);
 		}
 		else if ( detailTag.compare("thrown_skill_modifier") == 0 )
 		{
 			int skillLVL = stats[player]->PROFICIENCIES[proficiency] / 10;
-			snprintf(buf, sizeof(buf), str.c_str(), skillLVL,
+			format.format(buf, sizeof(buf), skillLVL,
 				getItemProficiencyName(proficiency).c_str());
 		}
 		else if ( detailTag == "EFF_FEATHER" )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(),
+			format.format(buf, sizeof(buf),
 				items[item.type].hasAttribute(detailTag) ? items[item.type].attributes["EFF_FEATHER"] : 0,
 				getItemEquipmentEffectsForAttributesText(detailTag).c_str());
 		}
@@ -3186,12 +3405,12 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 	{
 		if ( detailTag.compare("weapon_base_atk") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(),
+			format.format(buf, sizeof(buf),
 				items[item.type].hasAttribute("ATK") ? items[item.type].attributes["ATK"] : 0);
 		}
 		else if ( detailTag.compare("beartrap_degrade_on_use_cursed") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(), 100, getItemBeatitudeAdjective(item.beatitude).c_str());
+			format.format(buf, sizeof(buf), 100, getItemBeatitudeAdjective(item.beatitude).c_str());
 		}
 		else if ( detailTag.compare("beartrap_degrade_on_use") == 0 )
 		{
@@ -3210,18 +3429,18 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 				default:
 					break;
 			}
-			snprintf(buf, sizeof(buf), str.c_str(),	chanceDegrade, getItemStatusAdjective(item.type, item.status).c_str());
+			format.format(buf, sizeof(buf),	chanceDegrade, getItemStatusAdjective(item.type, item.status).c_str());
 		}
 		else if ( detailTag.compare("on_bless_or_curse") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(),
+			format.format(buf, sizeof(buf),
 				item.beatitude * 3,
 				getItemBeatitudeAdjective(item.beatitude).c_str());
 		}
 		else if ( detailTag.compare("on_degraded") == 0 )
 		{
 			int statusModifier = item.status * 3;
-			snprintf(buf, sizeof(buf), str.c_str(), statusModifier, getItemStatusAdjective(item.type, item.status).c_str());
+			format.format(buf, sizeof(buf), statusModifier, getItemStatusAdjective(item.type, item.status).c_str());
 		}
 		else
 		{
@@ -3234,23 +3453,23 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 		int proficiency = PRO_RANGED;
 		if ( detailTag.compare("weapon_base_atk") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(),
+			format.format(buf, sizeof(buf),
 				items[item.type].hasAttribute("ATK") ? items[item.type].attributes["ATK"] : 0);
 		}
 		else if ( detailTag.compare("on_bless_or_curse") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(),
+			format.format(buf, sizeof(buf),
 				shouldInvertEquipmentBeatitude(stats[player]) ? abs(item.beatitude) : item.beatitude,
 				getItemBeatitudeAdjective(item.beatitude).c_str());
 		}
 		else if ( detailTag.compare("thrown_atk_from_player_stat") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(), stats[player] ? (statGetDEX(stats[player], players[player]->entity) / 4) : 0);
+			format.format(buf, sizeof(buf), stats[player] ? (statGetDEX(stats[player], players[player]->entity) / 4) : 0);
 		}
 		else if ( detailTag.compare("thrown_skill_modifier") == 0 )
 		{
 			int skillLVL = stats[player]->PROFICIENCIES[proficiency] / 20;
-			snprintf(buf, sizeof(buf), str.c_str(), static_cast<int>(100 * thrownDamageSkillMultipliers[std::min(skillLVL, 5)] - 100),
+			format.format(buf, sizeof(buf), static_cast<int>(100 * thrownDamageSkillMultipliers[std::min(skillLVL, 5)] - 100),
 				getItemProficiencyName(proficiency).c_str());
 		}
 		else
@@ -3294,30 +3513,30 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 		{
 			if ( proficiency == PRO_AXE )
 			{
-				snprintf(buf, sizeof(buf), str.c_str(),
+				format.format(buf, sizeof(buf),
 					items[item.type].hasAttribute("ATK") ? items[item.type].attributes["ATK"] + 1 : 0);
 			}
 			else
 			{
-				snprintf(buf, sizeof(buf), str.c_str(),
+				format.format(buf, sizeof(buf),
 					items[item.type].hasAttribute("ATK") ? items[item.type].attributes["ATK"] : 0);
 			}
 		}
 		else if ( detailTag.compare("on_bless_or_curse") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(), 
+			format.format(buf, sizeof(buf), 
 				shouldInvertEquipmentBeatitude(stats[player]) ? abs(item.beatitude) : item.beatitude, 
 				getItemBeatitudeAdjective(item.beatitude).c_str());
 		}
 		else if ( detailTag.compare("on_degraded") == 0 )
 		{
 			int statusModifier = item.status - 3;
-			snprintf(buf, sizeof(buf), str.c_str(), statusModifier, getItemStatusAdjective(item.type, item.status).c_str());
+			format.format(buf, sizeof(buf), statusModifier, getItemStatusAdjective(item.type, item.status).c_str());
 		}
 		else if ( detailTag.compare("artifact_weapon_on_degraded") == 0 )
 		{
 			int statusModifier = (item.status - 3) * 2;
-			snprintf(buf, sizeof(buf), str.c_str(), statusModifier, getItemStatusAdjective(item.type, item.status).c_str());
+			format.format(buf, sizeof(buf), statusModifier, getItemStatusAdjective(item.type, item.status).c_str());
 		}
 		else if ( detailTag.compare("weapon_skill_modifier") == 0 )
 		{
@@ -3325,12 +3544,12 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 			{
 				//int weaponEffectiveness = -8 + (stats[player]->PROFICIENCIES[proficiency] / 3); // -8% to +25%
 				int weaponEffectiveness = -25 + (stats[player]->PROFICIENCIES[proficiency] / 2); // -25% to +25%
-				snprintf(buf, sizeof(buf), str.c_str(), weaponEffectiveness, getItemProficiencyName(proficiency).c_str());
+				format.format(buf, sizeof(buf), weaponEffectiveness, getItemProficiencyName(proficiency).c_str());
 			}
 			else
 			{
 				int weaponEffectiveness = -25 + (stats[player]->PROFICIENCIES[proficiency] / 2); // -25% to +25%
-				snprintf(buf, sizeof(buf), str.c_str(), weaponEffectiveness, getItemProficiencyName(proficiency).c_str());
+				format.format(buf, sizeof(buf), weaponEffectiveness, getItemProficiencyName(proficiency).c_str());
 			}
 		}
 		else if ( detailTag.compare("weapon_atk_from_player_stat") == 0 )
@@ -3340,47 +3559,47 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 				int atk = (stats[player] ? statGetDEX(stats[player], players[player]->entity) : 0);
 				atk += (stats[player] ? statGetSTR(stats[player], players[player]->entity) : 0);
 				atk = std::min(atk / 2, atk);
-				snprintf(buf, sizeof(buf), str.c_str(), atk);
+				format.format(buf, sizeof(buf), atk);
 			}
 			else if ( proficiency == PRO_RANGED )
 			{
-				snprintf(buf, sizeof(buf), str.c_str(), stats[player] ? statGetDEX(stats[player], players[player]->entity) : 0);
+				format.format(buf, sizeof(buf), stats[player] ? statGetDEX(stats[player], players[player]->entity) : 0);
 			}
 			else
 			{
-				snprintf(buf, sizeof(buf), str.c_str(), stats[player] ? statGetSTR(stats[player], players[player]->entity) : 0);
+				format.format(buf, sizeof(buf), stats[player] ? statGetSTR(stats[player], players[player]->entity) : 0);
 			}
 		}
 		else if ( detailTag.compare("weapon_durability") == 0 )
 		{
 			int skillLVL = stats[player]->PROFICIENCIES[proficiency] / 20;
 			int durabilityBonus = skillLVL * 20;
-			snprintf(buf, sizeof(buf), str.c_str(), durabilityBonus, getItemProficiencyName(proficiency).c_str());
+			format.format(buf, sizeof(buf), durabilityBonus, getItemProficiencyName(proficiency).c_str());
 		}
 		else if ( detailTag.compare("weapon_legendary_durability") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(), getItemProficiencyName(proficiency).c_str());
+			format.format(buf, sizeof(buf), getItemProficiencyName(proficiency).c_str());
 		}
 		else if ( detailTag.compare("weapon_bonus_exp") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(), 
+			format.format(buf, sizeof(buf), 
 				items[item.type].hasAttribute("BONUS_SKILL_EXP") ? items[item.type].attributes["BONUS_SKILL_EXP"] : 0,
 				getItemProficiencyName(proficiency).c_str());
 		}
 		else if ( detailTag.compare("equipment_fragile_durability") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(),
+			format.format(buf, sizeof(buf),
 				items[item.type].hasAttribute("FRAGILE") ? -items[item.type].attributes["FRAGILE"] : 0);
 		}
 		else if ( detailTag.compare("weapon_ranged_armor_pierce") == 0 )
 		{
 			int statChance = std::min(std::max((stats[player] ? statGetPER(stats[player], players[player]->entity) : 0) / 2, 0), 50); // 0 to 50 value.
 			statChance += (items[item.type].hasAttribute("ARMOR_PIERCE") ? items[item.type].attributes["ARMOR_PIERCE"] : 0);
-			snprintf(buf, sizeof(buf), str.c_str(), statChance);
+			format.format(buf, sizeof(buf), statChance);
 		}
 		else if ( detailTag.compare("weapon_ranged_quiver_augment") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(), getItemSlotName(ItemEquippableSlot::EQUIPPABLE_IN_SLOT_SHIELD).c_str());
+			format.format(buf, sizeof(buf), getItemSlotName(ItemEquippableSlot::EQUIPPABLE_IN_SLOT_SHIELD).c_str());
 		}
 		else if ( detailTag.compare("weapon_ranged_rate_of_fire") == 0 )
 		{
@@ -3389,7 +3608,7 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 			{
 				rof -= 100;
 				rof *= -1;
-				snprintf(buf, sizeof(buf), str.c_str(), rof);
+				format.format(buf, sizeof(buf), rof);
 			}
 		}
 		else
@@ -3405,52 +3624,52 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 		}
 		else if ( detailTag.compare("potion_polymorph_duration") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(), item.potionGetEffectDurationMinimum(players[player]->entity, stats[player]) / (60 * TICKS_PER_SECOND),
+			format.format(buf, sizeof(buf), item.potionGetEffectDurationMinimum(players[player]->entity, stats[player]) / (60 * TICKS_PER_SECOND),
 				item.potionGetEffectDurationMaximum(players[player]->entity, stats[player]) / (60 * TICKS_PER_SECOND) );
 		}
 		else if ( detailTag.compare("potion_restoremagic_bonus") == 0 )
 		{
 			if ( stats[player] && statGetINT(stats[player], players[player]->entity) > 0 )
 			{
-				snprintf(buf, sizeof(buf), str.c_str(), std::min(30, 2 * std::max(0, statGetINT(stats[player], players[player]->entity))));
+				format.format(buf, sizeof(buf), std::min(30, 2 * std::max(0, statGetINT(stats[player], players[player]->entity))));
 			}
 			else
 			{
-				snprintf(buf, sizeof(buf), str.c_str(), 0);
+				format.format(buf, sizeof(buf), 0);
 			}
 		}
 		else if ( detailTag.compare("potion_healing_bonus") == 0 )
 		{
 			if ( stats[player] && statGetCON(stats[player], players[player]->entity) > 0 )
 			{
-				snprintf(buf, sizeof(buf), str.c_str(), 2 * std::max(0, statGetCON(stats[player], players[player]->entity)));
+				format.format(buf, sizeof(buf), 2 * std::max(0, statGetCON(stats[player], players[player]->entity)));
 			}
 			else
 			{
-				snprintf(buf, sizeof(buf), str.c_str(), 0);
+				format.format(buf, sizeof(buf), 0);
 			}
 		}
 		else if ( detailTag.compare("potion_extrahealing_bonus") == 0 )
 		{
 			if ( stats[player] && statGetCON(stats[player], players[player]->entity) > 0 )
 			{
-				snprintf(buf, sizeof(buf), str.c_str(), 4 * std::max(0, statGetCON(stats[player], players[player]->entity)));
+				format.format(buf, sizeof(buf), 4 * std::max(0, statGetCON(stats[player], players[player]->entity)));
 			}
 			else
 			{
-				snprintf(buf, sizeof(buf), str.c_str(), 0);
+				format.format(buf, sizeof(buf), 0);
 			}
 		}
 		else if ( detailTag.compare("potion_on_blessed") == 0 )
 		{
 			if ( item.type == POTION_CUREAILMENT )
 			{
-				snprintf(buf, sizeof(buf), str.c_str(), 
+				format.format(buf, sizeof(buf), 
 					item.potionGetEffectDurationRandom(players[player]->entity, stats[player]) / TICKS_PER_SECOND, getItemBeatitudeAdjective(item.beatitude).c_str());
 			}
 			else if ( item.type == POTION_WATER )
 			{
-				snprintf(buf, sizeof(buf), str.c_str(), 20 * item.beatitude, getItemBeatitudeAdjective(item.beatitude).c_str());
+				format.format(buf, sizeof(buf), 20 * item.beatitude, getItemBeatitudeAdjective(item.beatitude).c_str());
 			}
 			else
 			{
@@ -3459,24 +3678,24 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 		}
 		else if ( detailTag.compare("potion_on_cursed") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(), getItemBeatitudeAdjective(item.beatitude).c_str());
+			format.format(buf, sizeof(buf), getItemBeatitudeAdjective(item.beatitude).c_str());
 		}
 		else if ( detailTag.compare("alchemy_details") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(), getItemPotionAlchemyAdjective(player, item.type).c_str());
+			format.format(buf, sizeof(buf), getItemPotionAlchemyAdjective(player, item.type).c_str());
 		}
 		else if ( detailTag.compare("on_bless_or_curse") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(), item.beatitude, getItemBeatitudeAdjective(item.beatitude).c_str());
+			format.format(buf, sizeof(buf), item.beatitude, getItemBeatitudeAdjective(item.beatitude).c_str());
 		}
 		else if ( detailTag.compare("potion_damage") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(), BASE_THROWN_DAMAGE);
+			format.format(buf, sizeof(buf), BASE_THROWN_DAMAGE);
 		}
 		else if ( detailTag.compare("potion_multiplier") == 0 )
 		{
 			int skillLVL = stats[player]->PROFICIENCIES[PRO_ALCHEMY] / 20;
-			snprintf(buf, sizeof(buf), str.c_str(), static_cast<int>(100 * potionDamageSkillMultipliers[std::min(skillLVL, 5)] - 100), 
+			format.format(buf, sizeof(buf), static_cast<int>(100 * potionDamageSkillMultipliers[std::min(skillLVL, 5)] - 100), 
 				getItemPotionHarmAllyAdjective(item).c_str());
 		}
 	}
@@ -3490,12 +3709,12 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 			{
 				chance = 100;
 			}
-			snprintf(buf, sizeof(buf), str.c_str(), chance);
+			format.format(buf, sizeof(buf), chance);
 		}
 		else if ( detailTag.compare("lockpick_chests_scrap_chance") == 0 )
 		{
 			int chance = std::min(100, stats[player]->PROFICIENCIES[PRO_LOCKPICKING] + 50);
-			snprintf(buf, sizeof(buf), str.c_str(), chance);
+			format.format(buf, sizeof(buf), chance);
 		}
 		else if ( detailTag.compare("lockpick_arrow_disarm") == 0 )
 		{
@@ -3504,7 +3723,7 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 			{
 				chance = 0;
 			}
-			snprintf(buf, sizeof(buf), str.c_str(), chance);
+			format.format(buf, sizeof(buf), chance);
 		}
 		else if ( detailTag.compare("lockpick_automaton_disarm") == 0 )
 		{
@@ -3517,7 +3736,7 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 			{
 				chance = (100 - 100 / (static_cast<int>(stats[player]->PROFICIENCIES[PRO_LOCKPICKING] / 20 + 1))); // lockpick automatons
 			}
-			snprintf(buf, sizeof(buf), str.c_str(), chance);
+			format.format(buf, sizeof(buf), chance);
 		}
 		else
 		{
@@ -3534,7 +3753,7 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 			{
 				chance = 0;
 			}
-			snprintf(buf, sizeof(buf), str.c_str(), chance);
+			format.format(buf, sizeof(buf), chance);
 		}
 		else
 		{
@@ -3545,7 +3764,7 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 	{
 		if ( detailTag.compare("tool_decoy_range") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(), decoyBoxRange);
+			format.format(buf, sizeof(buf), decoyBoxRange);
 		}
 		else
 		{
@@ -3570,12 +3789,12 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 			{
 				chance *= (1.0 / std::max(1, pukeChance));
 			}
-			snprintf(buf, sizeof(buf), str.c_str(), 
+			format.format(buf, sizeof(buf), 
 				static_cast<int>(chance), getItemStatusAdjective(item.type, item.status).c_str());
 		}
 		else if ( detailTag.compare("food_on_cursed_sideeffect") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(), getItemBeatitudeAdjective(item.beatitude).c_str());
+			format.format(buf, sizeof(buf), getItemBeatitudeAdjective(item.beatitude).c_str());
 		}
 		else
 		{
@@ -3612,7 +3831,7 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 			}
 
 			std::string attribute("INT");
-			snprintf(buf, sizeof(buf), str.c_str(),
+			format.format(buf, sizeof(buf),
 				intBonus, damageOrHealing.c_str(), getItemStatShortName(attribute).c_str(),
 				beatitudeBonus, damageOrHealing.c_str(), getItemBeatitudeAdjective(item.beatitude).c_str());
 		}
@@ -3623,7 +3842,7 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 
 			int spellcastingAbility = getSpellcastingAbilityFromUsingSpellbook(spell, players[player]->entity, stats[player]);
 			int chance = ((10 - (spellcastingAbility / 10)) * 20 / 3.0); // 33% after rolling to fizzle, 66% success
-			snprintf(buf, sizeof(buf), str.c_str(), chance);
+			format.format(buf, sizeof(buf), chance);
 		}
 		else if ( detailTag.compare("spellbook_extramana_chance") == 0 )
 		{
@@ -3632,7 +3851,7 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 
 			int spellcastingAbility = getSpellcastingAbilityFromUsingSpellbook(spell, players[player]->entity, stats[player]);
 			int chance = (10 - (spellcastingAbility / 10)) * 10;
-			snprintf(buf, sizeof(buf), str.c_str(), chance);
+			format.format(buf, sizeof(buf), chance);
 		}
 		else if ( detailTag.compare("spellbook_magic_requirement") == 0 )
 		{
@@ -3642,16 +3861,16 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 			int skillLVL = std::min(100, stats[player]->PROFICIENCIES[PRO_MAGIC] + statGetINT(stats[player], players[player]->entity));
 			if ( !playerLearnedSpellbook(player, &item) && (spell && spell->difficulty > skillLVL) )
 			{
-				str.insert((size_t)0, 1, '^'); // red line character
+				redLine = true; // red line character, prefixed once formatted
 			}
 
 			if ( spell )
 			{
-				snprintf(buf, sizeof(buf), str.c_str(), spell->difficulty, getProficiencyLevelName(spell->difficulty).c_str());
+				format.format(buf, sizeof(buf), spell->difficulty, getProficiencyLevelName(spell->difficulty).c_str());
 			}
 			else
 			{
-				snprintf(buf, sizeof(buf), str.c_str(), 0, getProficiencyLevelName(0).c_str());
+				format.format(buf, sizeof(buf), 0, getProficiencyLevelName(0).c_str());
 			}
 		}
 		else if ( detailTag.compare("spellbook_magic_current") == 0 )
@@ -3662,12 +3881,12 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 			int skillLVL = std::min(100, stats[player]->PROFICIENCIES[PRO_MAGIC] + statGetINT(stats[player], players[player]->entity));
 			if ( !playerLearnedSpellbook(player, &item) && (spell && spell->difficulty > skillLVL) )
 			{
-				str.insert((size_t)0, 1, '^'); // red line character
+				redLine = true; // red line character, prefixed once formatted
 			}
 			Sint32 INT = stats[player] ? statGetINT(stats[player], players[player]->entity) : 0;
 			Sint32 skill = stats[player] ? stats[player]->PROFICIENCIES[PRO_MAGIC] : 0;
 			Sint32 total = std::min(SKILL_LEVEL_LEGENDARY, INT + skill);
-			snprintf(buf, sizeof(buf), str.c_str(), INT + skill, getProficiencyLevelName(INT + skill).c_str());
+			format.format(buf, sizeof(buf), INT + skill, getProficiencyLevelName(INT + skill).c_str());
 		}
 		else
 		{
@@ -3697,7 +3916,7 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 				damageOrHealing = adjectives["spell_strings"]["healing"];
 			}
 			std::string attribute("INT");
-			snprintf(buf, sizeof(buf), str.c_str(), damageOrHealing.c_str(), baseDamage, damageOrHealing.c_str(), 
+			format.format(buf, sizeof(buf), damageOrHealing.c_str(), baseDamage, damageOrHealing.c_str(), 
 				bonusPercent, damageOrHealing.c_str(), getItemStatShortName(attribute).c_str());
 		}
 		else if ( detailTag.compare("spell_cast_success") == 0 )
@@ -3705,21 +3924,21 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 			int spellcastingAbility = std::min(std::max(0, stats[player]->PROFICIENCIES[PRO_SPELLCASTING]
 				+ statGetINT(stats[player], players[player]->entity)), 100);
 			int chance = ((10 - (spellcastingAbility / 10)) * 20 / 3.0); // 33% after rolling to fizzle, 66% success
-			snprintf(buf, sizeof(buf), str.c_str(), chance);
+			format.format(buf, sizeof(buf), chance);
 		}
 		else if ( detailTag.compare("spell_extramana_chance") == 0 )
 		{
 			int spellcastingAbility = std::min(std::max(0, stats[player]->PROFICIENCIES[PRO_SPELLCASTING]
 				+ statGetINT(stats[player], players[player]->entity)), 100);
 			int chance = (10 - (spellcastingAbility / 10)) * 10;
-			snprintf(buf, sizeof(buf), str.c_str(), chance);
+			format.format(buf, sizeof(buf), chance);
 		}
 		else if ( detailTag.compare("attribute_spell_charm") == 0 )
 		{
 			int leaderChance = ((statGetCHR(stats[player], players[player]->entity) + 
 				stats[player]->PROFICIENCIES[PRO_LEADERSHIP]) / 20) * 5;
 			int intChance = (statGetINT(stats[player], players[player]->entity) * 2);
-			snprintf(buf, sizeof(buf), str.c_str(), intChance, leaderChance);
+			format.format(buf, sizeof(buf), intChance, leaderChance);
 		}
 		else
 		{
@@ -3735,18 +3954,18 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 			{
 				degradeChance = 33;
 			}
-			snprintf(buf, sizeof(buf), str.c_str(), degradeChance, getItemStatusAdjective(item.type, item.status).c_str());
+			format.format(buf, sizeof(buf), degradeChance, getItemStatusAdjective(item.type, item.status).c_str());
 		}
 		else if ( detailTag.compare("magicstaff_degrade_chance") == 0 )
 		{
 			int degradeChance = 33;
-			snprintf(buf, sizeof(buf), str.c_str(), degradeChance);
+			format.format(buf, sizeof(buf), degradeChance);
 		}
 		else if ( detailTag.compare("attribute_spell_charm") == 0 )
 		{
 			int leaderChance = ((statGetCHR(stats[player], players[player]->entity) +
 				stats[player]->PROFICIENCIES[PRO_LEADERSHIP]) / 20) * 10;
-			snprintf(buf, sizeof(buf), str.c_str(), leaderChance);
+			format.format(buf, sizeof(buf), leaderChance);
 		}
 		else
 		{
@@ -3757,7 +3976,7 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 	{
 		if ( detailTag.compare("scroll_on_cursed_sideeffect") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(), getItemBeatitudeAdjective(item.beatitude).c_str());
+			format.format(buf, sizeof(buf), getItemBeatitudeAdjective(item.beatitude).c_str());
 		}
 		else
 		{
@@ -3778,13 +3997,13 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 			{
 				baseSpellDamage = getSpellDamageOrHealAmount(-1, getSpellFromID(SPELL_FIREBALL), nullptr);
 			}
-			snprintf(buf, sizeof(buf), str.c_str(), baseDmg + baseSpellDamage);
+			format.format(buf, sizeof(buf), baseDmg + baseSpellDamage);
 		}
 		else if ( detailTag.compare("tool_bomb_per_atk") == 0 )
 		{
 			int perMult = (items[item.type].hasAttribute("BOMB_DMG_PER_MULT") ? items[item.type].attributes["BOMB_DMG_PER_MULT"] : 0);
 			int perDmg = std::max(0, statGetPER(stats[player], players[player]->entity)) * perMult / 100.0;
-			snprintf(buf, sizeof(buf), str.c_str(), perDmg, perMult);
+			format.format(buf, sizeof(buf), perDmg, perMult);
 		}
 		else
 		{
@@ -3796,7 +4015,7 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 	{
 		if ( detailTag.compare("tinkerbot_status_bonus") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(), getItemStatusAdjective(item.type, item.status).c_str());
+			format.format(buf, sizeof(buf), getItemStatusAdjective(item.type, item.status).c_str());
 		}
 		else if ( detailTag.compare("spellbot_rate_of_fire") == 0 )
 		{
@@ -3821,7 +4040,7 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 				}
 			}
 			real_t rof = fabs((1.0 - (2 / bow)) * 100);
-			snprintf(buf, sizeof(buf), str.c_str(), (int)rof);
+			format.format(buf, sizeof(buf), (int)rof);
 		}
 		else if ( detailTag.compare("tinkerbot_turn_rate") == 0 )
 		{
@@ -3843,11 +4062,11 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 				ratio = 64.0;
 			}
 			real_t turnRate = (64.0 / ratio) - 1.0;
-			snprintf(buf, sizeof(buf), str.c_str(), (int)turnRate);
+			format.format(buf, sizeof(buf), (int)turnRate);
 		}
 		else if ( detailTag.compare("gyrobot_info_interact") == 0 )
 		{
-			snprintf(buf, sizeof(buf), str.c_str(), getItemStatusAdjective(item.type, item.status).c_str());
+			format.format(buf, sizeof(buf), getItemStatusAdjective(item.type, item.status).c_str());
 		}
 		else
 		{
@@ -3859,6 +4078,10 @@ void ItemTooltips_t::formatItemDetails(const int player, std::string tooltipType
 		return;
 	}
 	str = buf;
+	if ( redLine )
+	{
+		str.insert((size_t)0, 1, '^');
+	}
 #endif
 }
 
@@ -5798,6 +6021,22 @@ void MonsterData_t::loadMonsterDataJSON()
 			}
 		}
 
+		// special NPC names may have changed under existing creatures
+		for ( node_t* node = map.entities ? map.entities->first : nullptr; node != nullptr; node = node->next )
+		{
+			if ( Stat* entityStats = ((Entity*)node->element)->getStats() )
+			{
+				entityStats->updateAllegianceTags();
+			}
+		}
+		for ( int c = 0; c < MAXPLAYERS; ++c )
+		{
+			if ( stats[c] )
+			{
+				stats[c]->updateAllegianceTags();
+			}
+		}
+
 		printlog("[JSON]: Successfully read json file %s, processed %d monsters", inputPath.c_str(), monsterDataEntries.size());
 		return;
 	}
@@ -8483,6 +8722,7 @@ void Mods::loadModels(int start, int end) {
 void Mods::unloadMods(bool force)
 {
 #ifndef EDITOR
+	clearRoomTemplateCache(); // rooms may come from, or be remapped by, the mods being changed
 	isLoading = true;
 	loading = true;
 	createLoadingScreen(5);
@@ -8653,6 +8893,7 @@ void Mods::unloadMods(bool force)
 void Mods::loadMods()
 {
 #ifndef EDITOR
+	clearRoomTemplateCache(); // rooms may come from, or be remapped by, the mods being changed
 	Mods::disableSteamAchievements = false;
 	Mods::verifyAchievements(nullptr, false);
 
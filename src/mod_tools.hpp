@@ -2237,7 +2237,7 @@ public:
 		return false;
 	}
 
-	bool processedMinotaurSpawn(int level, bool secret, std::string mapName)
+	bool processedMinotaurSpawn(int level, bool secret, std::string mapName, int& minotaurLevel, BaronyRNG& rng)
 	{
 		if ( !inUse() )
 		{
@@ -2246,12 +2246,12 @@ public:
 
 		if ( CustomHelpers::isLevelPartOfSet(level, secret, minotaurForceEnableFloors) )
 		{
-			minotaurlevel = 1;
+			minotaurLevel = 1;
 			return true;
 		}
 		if ( CustomHelpers::isLevelPartOfSet(level, secret, minotaurForceDisableFloors) )
 		{
-			minotaurlevel = 0;
+			minotaurLevel = 0;
 			return true;
 		}
 
@@ -2267,24 +2267,24 @@ public:
 			if ( m->minoFloors.find(level) == m->minoFloors.end() )
 			{
 				// not found
-				minotaurlevel = 0;
+				minotaurLevel = 0;
 				return true;
 			}
 			// found, roll prng
-			if ( map_rng.rand() % 100 < m->minoPercent )
+			if ( rng.rand() % 100 < m->minoPercent )
 			{
-				minotaurlevel = 1;
+				minotaurLevel = 1;
 			}
 			else
 			{
-				minotaurlevel = 0;
+				minotaurLevel = 0;
 			}
 			return true;
 		}
 		return false;
 	}
 
-	bool processedDarkFloor(int level, bool secret, std::string mapName)
+	bool processedDarkFloor(int level, bool secret, std::string mapName, bool& darkLevel, BaronyRNG& rng)
 	{
 		if ( !inUse() )
 		{
@@ -2303,24 +2303,24 @@ public:
 			if ( m->darkFloors.find(level) == m->darkFloors.end() )
 			{
 				// not found
-				darkmap = false;
+				darkLevel = false;
 				return true;
 			}
 			// found, roll prng
-			if ( map_rng.rand() % 100 < m->darkPercent )
+			if ( rng.rand() % 100 < m->darkPercent )
 			{
-				darkmap = true;
+				darkLevel = true;
 			}
 			else
 			{
-				darkmap = false;
+				darkLevel = false;
 			}
 			return true;
 		}
 		return false;
 	}
 
-	bool processedShopFloor(int level, bool secret, std::string mapName, bool& shoplevel)
+	bool processedShopFloor(int level, bool secret, std::string mapName, bool& shoplevel, BaronyRNG& rng)
 	{
 		if ( !inUse() )
 		{
@@ -2343,7 +2343,7 @@ public:
 				return true;
 			}
 			// found, roll prng
-			if ( map_rng.rand() % 100 < m->shopPercent )
+			if ( rng.rand() % 100 < m->shopPercent )
 			{
 				shoplevel = true;
 			}
@@ -2361,7 +2361,7 @@ public:
 		PROPERTY_NPC
 	};
 
-	bool processedPropertyForFloor(int level, bool secret, std::string mapName, PropertyTypes propertyType, bool& bOut)
+	bool processedPropertyForFloor(int level, bool secret, std::string mapName, PropertyTypes propertyType, bool& bOut, BaronyRNG& rng)
 	{
 		if ( !inUse() )
 		{
@@ -2394,7 +2394,7 @@ public:
 			}
 
 			// found, roll prng
-			if ( map_rng.rand() % 100 < percentValue )
+			if ( rng.rand() % 100 < percentValue )
 			{
 				bOut = true;
 			}
@@ -2712,6 +2712,46 @@ class ItemTooltips_t
 	Uint32 defaultFaintTextColor = 0xFFFFFFFF;
 
 public:
+	// tooltip text split into literal runs and printf conversions once when it is
+	// loaded, each conversion already knows which argument it formats
+	struct TooltipFormat_t
+	{
+		struct Token_t
+		{
+			std::string text; // literal text, or the conversion spec without length modifiers
+			int slot = -1; // argument formatted by this conversion, -1 for literal text
+			char conversion = 0;
+		};
+		struct Arg_t
+		{
+			enum Kind
+			{
+				ARG_INT,
+				ARG_REAL,
+				ARG_TEXT
+			};
+			Kind kind;
+			long long i = 0;
+			double r = 0.0;
+			const char* s = "";
+			template<typename T, typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value, int>::type = 0>
+			Arg_t(T value) : kind(ARG_INT), i((long long)value) {}
+			Arg_t(double value) : kind(ARG_REAL), r(value) {}
+			Arg_t(float value) : kind(ARG_REAL), r(value) {}
+			Arg_t(const char* value) : kind(ARG_TEXT), s(value ? value : "") {}
+		};
+		std::string text; // the lines joined with newlines, as written
+		std::vector<Token_t> tokens;
+		int slots = 0;
+		void compile(const std::vector<std::string>& lines);
+		void render(char* out, size_t size, std::initializer_list<Arg_t> args) const;
+		template<typename... Args>
+		void format(char* out, size_t size, Args&&... args) const
+		{
+			render(out, size, { Arg_t(args)... });
+		}
+	};
+
 	struct ItemTooltip_t
 	{
 		Uint32 headingTextColor = 0;
@@ -2728,6 +2768,9 @@ public:
 		std::map<std::string, int> minWidths;
 		std::map<std::string, int> maxWidths;
 		std::map<std::string, int> headerMaxWidths;
+		TooltipFormat_t descriptionFormat;
+		std::map<std::string, TooltipFormat_t> detailsFormat;
+		void compile();
 		void setColorHeading(Uint32 color) { headingTextColor = color; }
 		void setColorDescription(Uint32 color) { descriptionTextColor = color; }
 		void setColorDetails(Uint32 color) { detailsTextColor = color; }
@@ -2746,6 +2789,10 @@ public:
 	std::map<std::string, ItemTooltip_t> tooltips;
 	std::map<std::string, std::map<std::string, std::string>> adjectives;
 	std::map<std::string, std::vector<std::string>> templates;
+	std::map<std::string, TooltipFormat_t> templateFormats;
+	const TooltipFormat_t& getTemplateFormat(const std::string& templateName);
+	const std::string& getTemplateText(const std::string& templateName) { return getTemplateFormat(templateName).text; }
+	const std::vector<std::string>& getTemplateLines(const std::string& templateName);
 	//std::vector<std::pair<int, Sint32>> itemValueTable;
 	//std::map<int, std::vector<std::pair<int, Sint32>>> itemValueTableByCategory;
 	struct ItemLocalization_t
@@ -2782,9 +2829,42 @@ public:
 	bool bIsSpellDamageOrHealingType(spell_t* spell);
 	bool bSpellHasBasicHitMessage(const int spellID);
 
-	void formatItemIcon(const int player, std::string tooltipType, Item& item, std::string& str, int iconIndex, std::string& conditionalAttribute);
-	void formatItemDescription(const int player, std::string tooltipType, Item& item, std::string& str);
-	void formatItemDetails(const int player, std::string tooltipType, Item& item, std::string& str, std::string detailTag);
+	void formatItemIcon(const int player, const std::string& tooltipType, Item& item, std::string& str, int iconIndex, std::string& conditionalAttribute);
+	void formatItemDescription(const int player, const std::string& tooltipType, Item& item, std::string& str);
+	void formatItemDetails(const int player, const std::string& tooltipType, Item& item, std::string& str, const std::string& detailTag);
+	void formatItemDetailsText(const int player, const std::string& tooltipType, Item& item, const TooltipFormat_t& format, std::string& str, const std::string& detailTag);
+
+	// formatted description/details, per player and keyed on (template, item uid,
+	// item state hash, stat version). statVersion is bumped by updateStatVersion()
+	// whenever anything the formatters read from the player's stats has changed
+	struct FormatCacheKey_t
+	{
+		const TooltipFormat_t* format;
+		Uint32 itemUid;
+		Uint32 itemHash;
+		Uint32 statVersion;
+		bool operator==(const FormatCacheKey_t& other) const
+		{
+			return format == other.format && itemUid == other.itemUid
+				&& itemHash == other.itemHash && statVersion == other.statVersion;
+		}
+	};
+	struct FormatCacheKeyHash_t
+	{
+		size_t operator()(const FormatCacheKey_t& key) const
+		{
+			size_t hash = std::hash<const void*>()(key.format);
+			hash = hash * 31 + key.itemUid;
+			hash = hash * 31 + key.itemHash;
+			return hash * 31 + key.statVersion;
+		}
+	};
+	std::unordered_map<FormatCacheKey_t, std::string, FormatCacheKeyHash_t> formatCache[MAXPLAYERS];
+	Uint32 statVersion[MAXPLAYERS] = {};
+	Uint32 statFingerprint[MAXPLAYERS] = {};
+	void updateStatVersion(const int player);
+	void clearFormatCache();
+	static Uint32 hashItemState(const Item& item);
 	void stripOutPositiveNegativeItemDetails(std::string& str, std::string& positiveValues, std::string& negativeValues);
 	void stripOutHighlightBracketText(std::string& str, std::string& bracketText);
 	void getWordIndexesItemDetails(void* field, std::string& str, std::string& highlightValues, std::string& positiveValues, std::string& negativeValues,
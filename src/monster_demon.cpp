@@ -641,6 +641,7 @@ void actDemonCeilingBuster(Entity* my)
 						return;
 					}
 					map.tiles[index] = 0;
+					notifyTileChanged((int)floor(x / 16), (int)floor(y / 16));
 					if ( multiplayer != CLIENT )
 					{
 						playSoundEntity(my, 67, 128);
@@ -206,6 +206,7 @@ void devilDie(Entity* my)
 			if ( !map.tiles[y * MAPLAYERS + x * MAPLAYERS * map.height] )
 			{
 				map.tiles[y * MAPLAYERS + x * MAPLAYERS * map.height] = 72;
+				notifyTileChanged(x, y);
 			}
 		}
 	}
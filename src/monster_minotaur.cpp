@@ -860,6 +860,7 @@ void actMinotaurCeilingBuster(Entity* my)
 						return;
 					}
 					map.tiles[index] = 0;
+					notifyTileChanged((int)floor(x / 16), (int)floor(y / 16));
 					if ( multiplayer != CLIENT )
 					{
 						playSoundEntity(my, 67, 128);
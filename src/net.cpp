@@ -56,6 +56,59 @@ bool disableFPSLimitOnNetworkMessages = true; // always process the messages, ot
 // uncomment this to have the game log packet info
 //#define PACKETINFO
 
+/*-------------------------------------------------------------------------------
+
+	NetPacketBinding
+
+	Points net_packet at a received buffer while its handler runs, so the
+	handler reads the bytes in place rather than from a copy. Receive buffers
+	are NET_PACKET_SIZE bytes, so handlers may also build replies in them.
+
+-------------------------------------------------------------------------------*/
+
+class NetPacketBinding
+{
+	UDPpacket* packet;
+	Uint8* ownData;
+	Uint8* boundData;
+	NetPacketBinding* outer;
+	static NetPacketBinding* active;
+public:
+	NetPacketBinding(Uint8* data, int len) :
+		packet(net_packet),
+		ownData(net_packet->data),
+		boundData(data),
+		outer(active)
+	{
+		net_packet->data = data;
+		net_packet->len = len;
+		active = this;
+	}
+	~NetPacketBinding()
+	{
+		unbind();
+		active = outer;
+	}
+	void unbind()
+	{
+		if ( ownData && packet == net_packet && packet->data == boundData )
+		{
+			packet->data = ownData;
+		}
+		ownData = nullptr;
+	}
+
+	// hand net_packet its own buffer back, eg before it gets freed
+	static void unbindAll()
+	{
+		for ( auto binding = active; binding; binding = binding->outer )
+		{
+			binding->unbind();
+		}
+	}
+};
+NetPacketBinding* NetPacketBinding::active = nullptr;
+
 void packetDeconstructor(void* data)
 {
 	packetsend_t* packetsend = (packetsend_t*)data;
@@ -76,6 +129,7 @@ void pollNetworkForShutdown() {
 			packetsend_t* packet = (packetsend_t*)node->element;
 			sendPacket(packet->sock, packet->channel, packet->packet, packet->hostnum);
 			packet->tries++;
+			NetTrafficStats.countSafeResend(*packet, packet->tries >= MAXTRIES);
 			if ( packet->tries >= MAXTRIES )
 			{
 				list_RemoveNode(node);
@@ -114,6 +168,8 @@ void pollNetworkForShutdown() {
 
 int sendPacket(UDPsocket sock, int channel, UDPpacket* packet, int hostnum, bool tryReliable)
 {
+	BENCHMARK_SCOPE(NET_SERIALIZE, "sendPacket");
+	NetTrafficStats.countOut(packet->data, packet->len, hostnum);
 	if ( directConnect )
 	{
 		return SDLNet_UDP_Send(sock, channel, packet);
@@ -162,6 +218,7 @@ int sendPacket(UDPsocket sock, int channel, UDPpacket* packet, int hostnum, bool
 Uint32 packetnum = 0;
 int sendPacketSafe(UDPsocket sock, int channel, UDPpacket* packet, int hostnum)
 {
+	BENCHMARK_SCOPE(NET_SERIALIZE, "sendPacketSafe");
 	if ( hostnum < 0 || hostnum >= MAXPLAYERS )
 	{
 		printlog("[NET]: Error - attempt to send to non-valid hostnum: %d", hostnum);
@@ -202,8 +259,10 @@ int sendPacketSafe(UDPsocket sock, int channel, UDPpacket* packet, int hostnum)
 	packetsend->sock = sock;
 	packetsend->channel = channel;
 	packetsend->packet->channel = channel;
-	memcpy(packetsend->packet->data + 9, packet->data, NET_PACKET_SIZE - 9);
-	packetsend->packet->len = packet->len + 9;
+	// copy only what was written; packet may be a small local buffer
+	const int len = std::min(std::max(packet->len, 0), NET_PACKET_SIZE - 9);
+	memcpy(packetsend->packet->data + 9, packet->data, len);
+	packetsend->packet->len = len + 9;
 	packetsend->packet->address.host = packet->address.host;
 	packetsend->packet->address.port = packet->address.port;
 	strcpy((char*)packetsend->packet->data, "SAFE");
@@ -218,8 +277,12 @@ int sendPacketSafe(UDPsocket sock, int channel, UDPpacket* packet, int hostnum)
 	SDLNet_Write32(packetnum, &packetsend->packet->data[5]);
 	packetsend->num = packetnum;
 	packetsend->tries = 0;
+	packetsend->sendtime = SDL_GetTicks();
 	packetnum++;
 
+	++NetTrafficStats.peer(hostnum).safeSent;
+	NetTrafficStats.countOut(packetsend->packet->data, packetsend->packet->len, hostnum);
+
 	node_t* node = list_AddNodeFirst(&safePacketsSent);
 	node->element = packetsend;
 	node->deconstructor = &packetDeconstructor;
@@ -470,6 +533,7 @@ void sendEntityTCP(Entity* entity, int c)
 
 void sendEntityUDP(Entity* entity, int c, bool guarantee)
 {
+	BENCHMARK_SCOPE(NET_SERIALIZE, "sendEntityUDP");
 	int j;
 
 	if ( entity == NULL )
@@ -485,50 +549,56 @@ void sendEntityUDP(Entity* entity, int c, bool guarantee)
 		return;
 	}
 
-	// send entity data to the client
-	strcpy((char*)net_packet->data, "ENTU");
-	SDLNet_Write32((Uint32)entity->getUID(), &net_packet->data[4]);
-	SDLNet_Write16((Uint16)entity->sprite, &net_packet->data[8]);
-	SDLNet_Write16((Sint16)(entity->x * 32), &net_packet->data[10]);
-	SDLNet_Write16((Sint16)(entity->y * 32), &net_packet->data[12]);
-	SDLNet_Write16((Sint16)(entity->z * 32), &net_packet->data[14]);
-	net_packet->data[16] = (Sint8)entity->sizex;
-	net_packet->data[17] = (Sint8)entity->sizey;
-	net_packet->data[18] = (Uint8)(entity->scalex * 128);
-	net_packet->data[19] = (Uint8)(entity->scaley * 128);
-	net_packet->data[20] = (Uint8)(entity->scalez * 128);
-	SDLNet_Write16((Sint16)(entity->yaw * 256), &net_packet->data[21]);
-	SDLNet_Write16((Sint16)(entity->pitch * 256), &net_packet->data[23]);
-	SDLNet_Write16((Sint16)(entity->roll * 256), &net_packet->data[25]);
-	net_packet->data[27] = (Sint8)(entity->focalx * 8);
-	net_packet->data[28] = (Sint8)(entity->focaly * 8);
-	net_packet->data[29] = (Sint8)(entity->focalz * 8);
-	SDLNet_Write32(entity->skill[2], &net_packet->data[30]);
-	net_packet->data[34] = 0;
-	net_packet->data[35] = 0;
-	for (j = 0; j < 16; j++)
+	// send entity data to the client. built in its own buffer so whatever
+	// the caller has staged in net_packet survives the update.
+	EntityUpdate_t update;
+	update.uid = (Uint32)entity->getUID();
+	update.sprite = (Uint16)entity->sprite;
+	update.x = (Sint16)(entity->x * 32);
+	update.y = (Sint16)(entity->y * 32);
+	update.z = (Sint16)(entity->z * 32);
+	update.sizex = (Sint8)entity->sizex;
+	update.sizey = (Sint8)entity->sizey;
+	update.scalex = (Uint8)(entity->scalex * 128);
+	update.scaley = (Uint8)(entity->scaley * 128);
+	update.scalez = (Uint8)(entity->scalez * 128);
+	update.yaw = (Sint16)(entity->yaw * 256);
+	update.pitch = (Sint16)(entity->pitch * 256);
+	update.roll = (Sint16)(entity->roll * 256);
+	update.focalx = (Sint8)(entity->focalx * 8);
+	update.focaly = (Sint8)(entity->focaly * 8);
+	update.focalz = (Sint8)(entity->focalz * 8);
+	update.skill2 = entity->skill[2];
+	for ( j = 0; j < 16; j++ )
 	{
 		if ( entity->flags[j] )
 		{
-			net_packet->data[34 + j / 8] |= power(2, j - (j / 8) * 8);
+			update.flags |= 1 << j;
 		}
 	}
-	SDLNet_Write32((Uint32)ticks, &net_packet->data[36]);
-	SDLNet_Write16((Sint16)(entity->vel_x * 32), &net_packet->data[40]);
-	SDLNet_Write16((Sint16)(entity->vel_y * 32), &net_packet->data[42]);
-	SDLNet_Write16((Sint16)(entity->vel_z * 32), &net_packet->data[44]);
-	net_packet->address.host = net_clients[c - 1].host;
-	net_packet->address.port = net_clients[c - 1].port;
-	net_packet->len = ENTITY_PACKET_LENGTH;
+	update.serverTicks = (Uint32)ticks;
+	update.vel_x = (Sint16)(entity->vel_x * 32);
+	update.vel_y = (Sint16)(entity->vel_y * 32);
+	update.vel_z = (Sint16)(entity->vel_z * 32);
+
+	Uint8 data[ENTITY_PACKET_LENGTH];
+	PacketWriter out(data, sizeof(data));
+	update.write(out);
+
+	UDPpacket packet = {};
+	packet.data = data;
+	packet.len = out.size();
+	packet.maxlen = sizeof(data);
+	packet.address = net_clients[c - 1];
 
 	// sometimes you want more insurance that the entity update arrives
 	if ( guarantee )
 	{
-		sendPacketSafe(net_sock, -1, net_packet, c - 1);
+		sendPacketSafe(net_sock, -1, &packet, c - 1);
 	}
 	else
 	{
-		sendPacket(net_sock, -1, net_packet, c - 1);
+		sendPacket(net_sock, -1, &packet, c - 1);
 	}
 	if ( entity->clientsHaveItsStats )
 	{
@@ -1619,7 +1689,7 @@ NetworkingLobbyJoinRequestResult lobbyPlayerJoinRequest(int& outResult, bool loc
 
 -------------------------------------------------------------------------------*/
 
-Entity* receiveEntity(Entity* entity)
+Entity* receiveEntity(Entity* entity, const EntityUpdate_t& update)
 {
 	bool newentity = false;
 	int c;
@@ -1646,12 +1716,12 @@ Entity* receiveEntity(Entity* entity)
 	if ( entity == nullptr )
 	{
 		newentity = true;
-		entity = newEntity((int)SDLNet_Read16(&net_packet->data[8]), 0, map.entities, nullptr);
+		entity = newEntity((int)update.sprite, 0, map.entities, nullptr);
 	}
 	else
 	{
 	    oldSprite = entity->sprite;
-		entity->sprite = (int)SDLNet_Read16(&net_packet->data[8]);
+		entity->sprite = (int)update.sprite;
 	}
 
     // for certain monsters, we don't want to use certain bytes,
@@ -1707,26 +1777,26 @@ Entity* receiveEntity(Entity* entity)
 	}
 
 	entity->lastupdate = ticks;
-	entity->lastupdateserver = (Uint32)SDLNet_Read32(&net_packet->data[36]);
-	entity->setUID((int)SDLNet_Read32(&net_packet->data[4])); // remember who I am
-	entity->new_x = ((Sint16)SDLNet_Read16(&net_packet->data[10])) / 32.0;
-	entity->new_y = ((Sint16)SDLNet_Read16(&net_packet->data[12])) / 32.0;
+	entity->lastupdateserver = update.serverTicks;
+	entity->setUID((int)update.uid); // remember who I am
+	entity->new_x = update.x / 32.0;
+	entity->new_y = update.y / 32.0;
 	if (!excludeForAnimation && (newentity || monsterType != SCARAB)) {
-	    entity->new_z = ((Sint16)SDLNet_Read16(&net_packet->data[14])) / 32.0;
+	    entity->new_z = update.z / 32.0;
 	}
-	entity->sizex = (Sint8)net_packet->data[16];
-	entity->sizey = (Sint8)net_packet->data[17];
+	entity->sizex = update.sizex;
+	entity->sizey = update.sizey;
 	if (newentity || monsterType != SLIME) {
-	    entity->scalex = ((Uint8)net_packet->data[18]) / 128.f;
-	    entity->scaley = ((Uint8)net_packet->data[19]) / 128.f;
-	    entity->scalez = ((Uint8)net_packet->data[20]) / 128.f;
+	    entity->scalex = update.scalex / 128.f;
+	    entity->scaley = update.scaley / 128.f;
+	    entity->scalez = update.scalez / 128.f;
 	}
 	if ( newentity || entity->behavior != &actMagiclightBall )
 	{
-		entity->new_yaw = ((Sint16)SDLNet_Read16(&net_packet->data[21])) / 256.0;
+		entity->new_yaw = update.yaw / 256.0;
 	}
-	entity->new_pitch = ((Sint16)SDLNet_Read16(&net_packet->data[23])) / 256.0;
-	entity->new_roll = ((Sint16)SDLNet_Read16(&net_packet->data[25])) / 256.0;
+	entity->new_pitch = update.pitch / 256.0;
+	entity->new_roll = update.roll / 256.0;
 	if ( newentity )
 	{
 		entity->x = entity->new_x;
@@ -1736,21 +1806,21 @@ Entity* receiveEntity(Entity* entity)
 		entity->pitch = entity->new_pitch;
 		entity->roll = entity->new_roll;
 	}
-	entity->focalx = ((Sint8)net_packet->data[27]) / 8.0;
-	entity->focaly = ((Sint8)net_packet->data[28]) / 8.0;
+	entity->focalx = update.focalx / 8.0;
+	entity->focaly = update.focaly / 8.0;
 	if (!excludeForAnimation) {
-	    entity->focalz = ((Sint8)net_packet->data[29]) / 8.0;
+	    entity->focalz = update.focalz / 8.0;
 	}
 	for (c = 0; c < 16; ++c)
 	{
-		if ( net_packet->data[34 + c / 8]&power(2, c - (c / 8) * 8) )
+		if ( update.flags & (1 << c) )
 		{
 			entity->flags[c] = true;
 		}
 	}
-	entity->vel_x = ((Sint16)SDLNet_Read16(&net_packet->data[40])) / 32.0;
-	entity->vel_y = ((Sint16)SDLNet_Read16(&net_packet->data[42])) / 32.0;
-	entity->vel_z = ((Sint16)SDLNet_Read16(&net_packet->data[44])) / 32.0;
+	entity->vel_x = update.vel_x / 32.0;
+	entity->vel_y = update.vel_y / 32.0;
+	entity->vel_z = update.vel_z / 32.0;
 
 	return entity;
 }
@@ -1763,7 +1833,7 @@ Entity* receiveEntity(Entity* entity)
 
 -------------------------------------------------------------------------------*/
 
-void clientActions(Entity* entity)
+void clientActions(Entity* entity, Sint32 serverSkill2)
 {
 	int playernum;
 
@@ -1801,11 +1871,11 @@ void clientActions(Entity* entity)
 			entity->flags[NOUPDATE] = true;
 			break;
 		case 163:
-			entity->skill[2] = (int)SDLNet_Read32(&net_packet->data[30]);
+			entity->skill[2] = serverSkill2;
 			entity->behavior = &actFountain;
 			break;
 		case 174:
-			if (SDLNet_Read32(&net_packet->data[30]) != 0)
+			if ( serverSkill2 != 0 )
 			{
 				entity->behavior = &actMagiclightBall; //TODO: Finish this here. I think this gets reassigned every time the entity is recieved? Make sure.
 			}
@@ -1881,7 +1951,7 @@ void clientActions(Entity* entity)
 		case Player::Ghost_t::GHOST_MODEL_P4:
 		case Player::Ghost_t::GHOST_MODEL_PX:
 			// player ghosts
-			playernum = SDLNet_Read32(&net_packet->data[30]);
+			playernum = serverSkill2;
 			if ( playernum >= 0 && playernum < MAXPLAYERS )
 			{
 				if ( players[playernum] )
@@ -1909,7 +1979,7 @@ void clientActions(Entity* entity)
 			if ( entity->isPlayerHeadSprite() )
 			{
 				// these are all player heads
-				playernum = SDLNet_Read32(&net_packet->data[30]);
+				playernum = serverSkill2;
 				if ( playernum >= 0 && playernum < MAXPLAYERS )
 				{
 					if ( players[playernum] && players[playernum]->entity )
@@ -1923,10 +1993,10 @@ void clientActions(Entity* entity)
 			break;
 	}
 
-	// if the above method failed, we check the value of skill[2] (stored in net_packet->data[30]) and assign an action based on that
+	// if the above method failed, we check the value of skill[2] (sent as EntityUpdate_t::skill2) and assign an action based on that
 	if ( entity->behavior == NULL )
 	{
-		int c = (int)SDLNet_Read32(&net_packet->data[30]);
+		int c = serverSkill2;
 		if ( c < 0 )
 		{
 			switch ( c )
@@ -2195,6 +2265,9 @@ static void changeLevel() {
     clearChunks();
     createChunks();
 
+    // start preparing the next floor while this one is played
+    prefetchLevelRoomTemplates(currentlevel + 1, secretlevel);
+
 	// (special) unlock temple achievement
 	if ( secretlevel && currentlevel == 8 )
 	{
@@ -2304,10 +2377,16 @@ static std::unordered_map<Uint32, void(*)()> clientPacketHandlers = {
 	// entity update
 	{'ENTU', [](){
 		client_keepalive[0] = ticks; // don't timeout
-		Entity *entity = uidToEntity((int)SDLNet_Read32(&net_packet->data[4]));
+		PacketReader in(net_packet, 4);
+		EntityUpdate_t update;
+		if ( !update.read(in) )
+		{
+			return; // truncated
+		}
+		Entity *entity = uidToEntity((int)update.uid);
 		if ( entity )
 		{
-			if ( (Uint32)SDLNet_Read32(&net_packet->data[36]) < (Uint32)entity->lastupdateserver )
+			if ( update.serverTicks < (Uint32)entity->lastupdateserver )
 			{
 				// old packet, not used
 			}
@@ -2322,20 +2401,21 @@ static std::unordered_map<Uint32, void(*)()> clientPacketHandlers = {
 			else if ( entity->flags[NOUPDATE] )
 			{
 				// inform the server that it tried to update a no-update entity
-				strcpy((char*)net_packet->data, "NOUP");
-				net_packet->data[4] = clientnum;
-				SDLNet_Write32(entity->getUID(), &net_packet->data[5]);
+				PacketWriter out(net_packet);
+				out.writeBytes("NOUP", 4);
+				out.write8(clientnum);
+				out.write32(entity->getUID());
 				net_packet->address.host = net_server.host;
 				net_packet->address.port = net_server.port;
-				net_packet->len = 9;
+				net_packet->len = out.size();
 				sendPacket(net_sock, -1, net_packet, 0);
 			}
 			else
 			{
 				// receive the entity
-				receiveEntity(entity);
+				receiveEntity(entity, update);
 				entity->behavior = NULL;
-				clientActions(entity);
+				clientActions(entity, update.skill2);
 			}
 			return;
 		}
@@ -2343,15 +2423,15 @@ static std::unordered_map<Uint32, void(*)()> clientPacketHandlers = {
 		for ( auto node = removedEntities.first; node != NULL; node = node->next )
 		{
 			auto entity2 = (Entity*)node->element;
-			if ( entity2->getUID() == (int)SDLNet_Read32(&net_packet->data[4]) )
+			if ( entity2->getUID() == (int)update.uid )
 			{
 				return;
 			}
 		}
 
-		entity = receiveEntity(NULL);
+		entity = receiveEntity(NULL, update);
 		// IMPORTANT! Assign actions to the objects the client has control over
-		clientActions(entity);
+		clientActions(entity, update.skill2);
 	}},
     
     // raise/lower shield
@@ -2394,7 +2474,13 @@ static std::unordered_map<Uint32, void(*)()> clientPacketHandlers = {
 		* [8][9][10][11]: Entity's effects.
 		*/
 
-		Uint32 uid = static_cast<int>(SDLNet_Read32(&net_packet->data[4]));
+		PacketReader in(net_packet, 4);
+		const Uint32 uid = in.read32();
+		Uint8 effects[(NUMEFFECTS + 7) / 8];
+		if ( !in.readBytes(effects, sizeof(effects)) )
+		{
+			return;
+		}
 
 		Entity* entity = uidToEntity(uid);
 
@@ -2419,7 +2505,7 @@ static std::unordered_map<Uint32, void(*)()> clientPacketHandlers = {
 
 			for ( int i = 0; i < NUMEFFECTS; ++i )
 			{
-				if ( net_packet->data[8 + i / 8] & power(2, i - (i / 8) * 8) )
+				if ( effects[i / 8] & (1 << (i % 8)) )
 				{
 					stats->EFFECTS[i] = true;
 				}
@@ -2433,34 +2519,59 @@ static std::unordered_map<Uint32, void(*)()> clientPacketHandlers = {
 
 	// update entity skill
 	{'ENTS', [](){
-		Entity *entity = uidToEntity((int)SDLNet_Read32(&net_packet->data[4]));
+		PacketReader in(net_packet, 4);
+		const Uint32 uid = in.read32();
+		const int skill = in.read8();
+		const Sint32 value = in.readS32();
+		if ( !in.ok() || skill >= NUMENTITYSKILLS )
+		{
+			return;
+		}
+		Entity *entity = uidToEntity((int)uid);
 		if ( entity )
 		{
-			entity->skill[net_packet->data[8]] = SDLNet_Read32(&net_packet->data[9]);
+			entity->skill[skill] = value;
 		}
 	}},
 
 	// update entity fskill
 	{'ENFS', [](){
-		Entity *entity = uidToEntity((int)SDLNet_Read32(&net_packet->data[4]));
+		PacketReader in(net_packet, 4);
+		const Uint32 uid = in.read32();
+		const int fskill = in.read8();
+		const Uint16 value = in.read16();
+		if ( !in.ok() || fskill >= NUMENTITYFSKILLS )
+		{
+			return;
+		}
+		Entity *entity = uidToEntity((int)uid);
 		if ( entity )
 		{
-			entity->fskill[net_packet->data[8]] = (SDLNet_Read16(&net_packet->data[9]) / 256.0);
+			entity->fskill[fskill] = (value / 256.0);
 		}
 	}},
 
 	// update entity bodypart
 	{'ENTB', [](){
-		Entity *entity = uidToEntity((int)SDLNet_Read32(&net_packet->data[4]));
+		PacketReader in(net_packet, 4);
+		const Uint32 uid = in.read32();
+		const int bodypart = in.read8();
+		const Sint32 sprite = in.readS32();
+		const bool invisible = in.read8();
+		if ( !in.ok() )
+		{
+			return;
+		}
+		Entity *entity = uidToEntity((int)uid);
 		if ( entity )
 		{
-			node_t* childNode = list_Node(&entity->children, net_packet->data[8]);
+			node_t* childNode = list_Node(&entity->children, bodypart);
 			if ( childNode )
 			{
 				Entity* tempEntity = (Entity*)childNode->element;
-				tempEntity->sprite = SDLNet_Read32(&net_packet->data[9]);
+				tempEntity->sprite = sprite;
 				tempEntity->skill[7] = tempEntity->sprite;
-				tempEntity->flags[INVISIBLE] = net_packet->data[13];
+				tempEntity->flags[INVISIBLE] = invisible;
 			}
 		}
 	}},
@@ -2545,9 +2656,16 @@ static std::unordered_map<Uint32, void(*)()> clientPacketHandlers = {
 
 	// update health
 	{'UPHP', [](){
-		if ( (Monster)SDLNet_Read32(&net_packet->data[8]) != NOTHING )
+		PacketReader in(net_packet, 4);
+		const Sint32 hp = in.readS32();
+		const Monster source = (Monster)in.read32();
+		if ( !in.ok() )
 		{
-			if ( SDLNet_Read32(&net_packet->data[4]) < stats[clientnum]->HP )
+			return;
+		}
+		if ( source != NOTHING )
+		{
+			if ( hp < stats[clientnum]->HP )
 			{
 				cameravars[clientnum].shakex += .1;
 				cameravars[clientnum].shakey += 10;
@@ -2558,7 +2676,7 @@ static std::unordered_map<Uint32, void(*)()> clientPacketHandlers = {
 				cameravars[clientnum].shakey += 5;
 			}
 		}
-		stats[clientnum]->HP = SDLNet_Read32(&net_packet->data[4]);
+		stats[clientnum]->HP = hp;
 		return;
 	}},
 
@@ -3265,6 +3383,20 @@ static std::unordered_map<Uint32, void(*)()> clientPacketHandlers = {
 		    (Uint8)net_packet->data[14]);
 	}},
 
+		// play batched sounds position
+	{'SNDB', [](){
+		const int num = net_packet->data[4];
+		for ( int i = 0; i < num && 5 + (i + 1) * 7 <= net_packet->len; ++i )
+		{
+			const Uint8* data = &net_packet->data[5 + i * 7];
+			playSoundPos(
+				SDLNet_Read16(&data[0]),
+				SDLNet_Read16(&data[2]),
+				SDLNet_Read16(&data[4]),
+				data[6]);
+		}
+	}},
+
 		// play sound global
 	{'SNDG', [](){
 		playSound(
@@ -3352,6 +3484,7 @@ static std::unordered_map<Uint32, void(*)()> clientPacketHandlers = {
 		if ( x >= 0 && x < map.width && y >= 0 && y < map.height )
 		{
 			map.tiles[OBSTACLELAYER + y * MAPLAYERS + x * MAPLAYERS * map.height] = map.tiles[y * MAPLAYERS + x * MAPLAYERS * map.height];
+			notifyTileChanged(x, y);
 		}
 
 		const real_t effectOffset = 2.0;
@@ -3368,6 +3501,7 @@ static std::unordered_map<Uint32, void(*)()> clientPacketHandlers = {
 		if ( x >= 0 && x < map.width && y >= 0 && y < map.height )
 		{
 			map.tiles[OBSTACLELAYER + y * MAPLAYERS + x * MAPLAYERS * map.height] = 0;
+			notifyTileChanged(x, y);
 		}
 	}},
 
@@ -3379,6 +3513,7 @@ static std::unordered_map<Uint32, void(*)()> clientPacketHandlers = {
 		{
 			map.tiles[OBSTACLELAYER + y * MAPLAYERS + x * MAPLAYERS * map.height] = 0;
 			map.tiles[(MAPLAYERS - 1) + y * MAPLAYERS + x * MAPLAYERS * map.height] = 0;
+			notifyTileChanged(x, y);
 		}
 	}},
 
@@ -3773,18 +3908,32 @@ static std::unordered_map<Uint32, void(*)()> clientPacketHandlers = {
 
 	// update magic
 	{'UPMP', [](){
-		stats[clientnum]->MP = SDLNet_Read32(&net_packet->data[4]);
+		PacketReader in(net_packet, 4);
+		const Sint32 mp = in.readS32();
+		if ( in.ok() )
+		{
+			stats[clientnum]->MP = mp;
+		}
 		return;
 	}},
 
 	// update effects flags
 	{'UPEF', [](){
+		PacketReader in(net_packet, 4);
+		Uint8 effects[(NUMEFFECTS + 7) / 8];
+		Uint8 effectsLow[(NUMEFFECTS + 7) / 8];
+		in.readBytes(effects, sizeof(effects));
+		in.readBytes(effectsLow, sizeof(effectsLow));
+		if ( !in.ok() )
+		{
+			return;
+		}
 		for (int c = 0; c < NUMEFFECTS; c++)
 		{
-			if ( net_packet->data[4 + c / 8]&power(2, c - (c / 8) * 8) )
+			if ( effects[c / 8] & (1 << (c % 8)) )
 			{
 				stats[clientnum]->EFFECTS[c] = true;
-				if ( net_packet->data[9 + c / 8] & power(2, c - (c / 8) * 8) ) // use these bits to denote if duration is low.
+				if ( effectsLow[c / 8] & (1 << (c % 8)) ) // use these bits to denote if duration is low.
 				{
 					stats[clientnum]->EFFECTS_TIMERS[c] = 1;
 				}
@@ -3802,30 +3951,55 @@ static std::unordered_map<Uint32, void(*)()> clientPacketHandlers = {
 
 	// update entity stat flag
 	{'ENSF', [](){
-		Entity *entity = uidToEntity((int)SDLNet_Read32(&net_packet->data[4]));
+		PacketReader in(net_packet, 4);
+		const Uint32 uid = in.read32();
+		const int flag = in.read8();
+		const Sint32 value = in.readS32();
+		if ( !in.ok() || flag >= (int)(sizeof(Stat::MISC_FLAGS) / sizeof(Stat::MISC_FLAGS[0])) )
+		{
+			return;
+		}
+		Entity *entity = uidToEntity((int)uid);
 		if ( entity )
 		{
 			if ( entity->getStats() )
 			{
-				entity->getStats()->MISC_FLAGS[net_packet->data[8]] = SDLNet_Read32(&net_packet->data[9]);
+				entity->getStats()->MISC_FLAGS[flag] = value;
 			}
 		}
 	}},
 
 	// update attributes
 	{'ATTR', [](){
-		stats[clientnum]->STR = (Sint8)net_packet->data[5];
-		stats[clientnum]->DEX = (Sint8)net_packet->data[6];
-		stats[clientnum]->CON = (Sint8)net_packet->data[7];
-		stats[clientnum]->INT = (Sint8)net_packet->data[8];
-		stats[clientnum]->PER = (Sint8)net_packet->data[9];
-		stats[clientnum]->CHR = (Sint8)net_packet->data[10];
-		stats[clientnum]->EXP = (Sint8)net_packet->data[11];
-		stats[clientnum]->LVL = (Sint8)net_packet->data[12];
-		stats[clientnum]->HP = (Sint16)SDLNet_Read16(&net_packet->data[13]);
-		stats[clientnum]->MAXHP = (Sint16)SDLNet_Read16(&net_packet->data[15]);
-		stats[clientnum]->MP = (Sint16)SDLNet_Read16(&net_packet->data[17]);
-		stats[clientnum]->MAXMP = (Sint16)SDLNet_Read16(&net_packet->data[19]);
+		PacketReader in(net_packet, 5); // [4] is the sender, unused here
+		const Sint8 str = in.readS8();
+		const Sint8 dex = in.readS8();
+		const Sint8 con = in.readS8();
+		const Sint8 intl = in.readS8();
+		const Sint8 per = in.readS8();
+		const Sint8 chr = in.readS8();
+		const Sint8 exp = in.readS8();
+		const Sint8 lvl = in.readS8();
+		const Sint16 hp = in.readS16();
+		const Sint16 maxhp = in.readS16();
+		const Sint16 mp = in.readS16();
+		const Sint16 maxmp = in.readS16();
+		if ( !in.ok() )
+		{
+			return;
+		}
+		stats[clientnum]->STR = str;
+		stats[clientnum]->DEX = dex;
+		stats[clientnum]->CON = con;
+		stats[clientnum]->INT = intl;
+		stats[clientnum]->PER = per;
+		stats[clientnum]->CHR = chr;
+		stats[clientnum]->EXP = exp;
+		stats[clientnum]->LVL = lvl;
+		stats[clientnum]->HP = hp;
+		stats[clientnum]->MAXHP = maxhp;
+		stats[clientnum]->MP = mp;
+		stats[clientnum]->MAXMP = maxmp;
 	}},
 
 	// level up icon timers, sets second row of icons if double stat gain is rolled.
@@ -4104,6 +4278,7 @@ static std::unordered_map<Uint32, void(*)()> clientPacketHandlers = {
 				{
 					strcpy(monster->clientStats->name, (char*)&net_packet->data[12]);
 				}
+				monster->clientStats->updateAllegianceTags();
                 if ( monster->clientStats->name[0] && !monsterNameIsGeneric(*monster->clientStats) ) {
                     Entity* nametag = newEntity(-1, 1, map.entities, nullptr);
                     nametag->x = monster->x;
@@ -4490,6 +4665,7 @@ static std::unordered_map<Uint32, void(*)()> clientPacketHandlers = {
 					if ( !map.tiles[y * MAPLAYERS + x * MAPLAYERS * map.height] )
 					{
 						map.tiles[y * MAPLAYERS + x * MAPLAYERS * map.height] = 72;
+						notifyTileChanged(x, y);
 					}
 				}
 			}
@@ -4859,12 +5035,13 @@ static std::unordered_map<Uint32, void(*)()> clientPacketHandlers = {
 
 void clientHandlePacket()
 {
+	NetTrafficStats.countIn(net_packet);
 	if (handleSafePacket())
 	{
 		return;
 	}
 
-	Uint32 packetId = SDLNet_Read32(&net_packet->data[0]);
+	Uint32 packetId = PacketReader(net_packet).read32();
 
 #ifdef PACKETINFO
 	char packetinfo[NET_PACKET_SIZE];
@@ -4937,6 +5114,8 @@ void clientHandlePacket()
 
 void clientHandleMessages(Uint32 framerateBreakInterval)
 {
+	PROFILE_ZONE("clientHandleMessages");
+	NetTrafficStats.update();
 #ifdef STEAMWORKS
 	if (!directConnect && !net_handler)
 	{
@@ -4982,10 +5161,10 @@ void clientHandleMessages(Uint32 framerateBreakInterval)
 
 		while (packet = net_handler->getGamePacket())
 		{
-			memcpy(net_packet->data, packet->data(), packet->len());
-			net_packet->len = packet->len();
-
-			clientHandlePacket(); //Uses net_packet.
+			{
+				NetPacketBinding binding(packet->data(), packet->len());
+				clientHandlePacket(); //Uses net_packet.
+			}
 
 			if ( logCheckMainLoopTimers )
 			{
@@ -5038,13 +5217,17 @@ void clientHandleMessages(Uint32 framerateBreakInterval)
 static std::unordered_map<Uint32, void(*)()> serverPacketHandlers = {
 	// keep alive
 	{'KPAL', [](){
-	    const int player = std::min(net_packet->data[4], (Uint8)(MAXPLAYERS - 1));
-		client_keepalive[player] = ticks;
+		PacketReader in(net_packet, 4);
+		const int player = std::min(in.read8(), (Uint8)(MAXPLAYERS - 1));
+		if ( in.ok() )
+		{
+			client_keepalive[player] = ticks;
+		}
 	}},
 
 	// ping
 	{'PING', [](){
-		const int j = net_packet->data[4];
+		const int j = PacketReader(net_packet, 4).read8();
 		if (j <= 0 || j >= MAXPLAYERS )
 		{
 			return;
@@ -5053,10 +5236,12 @@ static std::unordered_map<Uint32, void(*)()> serverPacketHandlers = {
 		{
 			return;
 		}
-		memcpy((char*)net_packet->data, "PING", 4);
+		PacketWriter out(net_packet);
+		out.writeBytes("PING", 4);
+		out.write8(j);
 		net_packet->address.host = net_clients[j - 1].host;
 		net_packet->address.port = net_clients[j - 1].port;
-		net_packet->len = 5;
+		net_packet->len = out.size();
 		sendPacketSafe(net_sock, -1, net_packet, j - 1);
 	}},
 
@@ -5091,8 +5276,10 @@ static std::unordered_map<Uint32, void(*)()> serverPacketHandlers = {
 
 	// check entity existence
 	{'ENTE', [](){
-		const int x = net_packet->data[4];
-		if ( x <= 0 || x >= MAXPLAYERS )
+		PacketReader in(net_packet, 4);
+		const int x = in.read8();
+		const Uint32 uid = in.read32();
+		if ( !in.ok() || x <= 0 || x >= MAXPLAYERS )
 		{
 			return;
 		}
@@ -5100,18 +5287,18 @@ static std::unordered_map<Uint32, void(*)()> serverPacketHandlers = {
 		{
 			return;
 		}
-		Uint32 uid = SDLNet_Read32(&net_packet->data[5]);
 		Entity* entity = uidToEntity(uid);
 		if ( entity )
 		{
 			return; // found entity.
 		}
 		// else reply with entity deleted.
-		strcpy((char*)net_packet->data, "ENTD");
-		SDLNet_Write32(uid, &net_packet->data[4]);
+		PacketWriter out(net_packet);
+		out.writeBytes("ENTD", 4);
+		out.write32(uid);
 		net_packet->address.host = net_clients[x - 1].host;
 		net_packet->address.port = net_clients[x - 1].port;
-		net_packet->len = 8;
+		net_packet->len = out.size();
 		sendPacketSafe(net_sock, -1, net_packet, x - 1);
 	}},
 
@@ -5156,8 +5343,17 @@ static std::unordered_map<Uint32, void(*)()> serverPacketHandlers = {
 
 	// player move
 	{'PMOV', [](){
-		const int player = net_packet->data[4];
-		if ( player < 0 || player >= MAXPLAYERS )
+		PacketReader in(net_packet, 4);
+		const int player = in.read8();
+		const int level = in.read8();
+		auto dx = in.readS16() / 32.0;
+		auto dy = in.readS16() / 32.0;
+		auto velx = in.readS16() / 128.0;
+		auto vely = in.readS16() / 128.0;
+		auto yaw = in.readS16() / 128.0;
+		auto pitch = in.readS16() / 128.0;
+		const int secret = in.read8();
+		if ( !in.ok() || player >= MAXPLAYERS )
 		{
 			return;
 		}
@@ -5168,19 +5364,11 @@ static std::unordered_map<Uint32, void(*)()> serverPacketHandlers = {
 		}
 
 		// check if the info is outdated
-		if ( net_packet->data[5] != currentlevel || net_packet->data[18] != secretlevel )
+		if ( level != currentlevel || secret != secretlevel )
 		{
 			return;
 		}
 
-		// get info from client
-		auto dx = ((Sint16)SDLNet_Read16(&net_packet->data[6])) / 32.0;
-		auto dy = ((Sint16)SDLNet_Read16(&net_packet->data[8])) / 32.0;
-		auto velx = ((Sint16)SDLNet_Read16(&net_packet->data[10])) / 128.0;
-		auto vely = ((Sint16)SDLNet_Read16(&net_packet->data[12])) / 128.0;
-		auto yaw = ((Sint16)SDLNet_Read16(&net_packet->data[14])) / 128.0;
-		auto pitch = ((Sint16)SDLNet_Read16(&net_packet->data[16])) / 128.0;
-
 		// update rotation
 		players[player]->entity->yaw = yaw;
 		players[player]->entity->pitch = pitch;
@@ -5207,15 +5395,16 @@ static std::unordered_map<Uint32, void(*)()> serverPacketHandlers = {
 		{
 			// player encountered obstacle on path
 			// stop updating position on server side and send client corrected position
-			const int j = net_packet->data[4];
+			const int j = player;
 			if ( j > 0 && j < MAXPLAYERS )
 			{
-				strcpy((char*)net_packet->data, "PMOV");
-				SDLNet_Write16((Sint16)(players[j]->entity->x * 32), &net_packet->data[4]);
-				SDLNet_Write16((Sint16)(players[j]->entity->y * 32), &net_packet->data[6]);
+				PacketWriter out(net_packet);
+				out.writeBytes("PMOV", 4);
+				out.write16((Sint16)(players[j]->entity->x * 32));
+				out.write16((Sint16)(players[j]->entity->y * 32));
 				net_packet->address.host = net_clients[j - 1].host;
 				net_packet->address.port = net_clients[j - 1].port;
-				net_packet->len = 8;
+				net_packet->len = out.size();
 				sendPacket(net_sock, -1, net_packet, j - 1);
 			}
 		}
@@ -6678,6 +6867,7 @@ static std::unordered_map<Uint32, void(*)()> serverPacketHandlers = {
 
 void serverHandlePacket()
 {
+	NetTrafficStats.countIn(net_packet);
 	if (handleSafePacket())
 	{
 		return;
@@ -6690,7 +6880,7 @@ void serverHandlePacket()
 	printlog("info: server packet: %s\n", packetinfo);
 #endif
 
-	Uint32 packetId = SDLNet_Read32(&net_packet->data[0]);
+	Uint32 packetId = PacketReader(net_packet).read32();
 
     auto find = serverPacketHandlers.find(packetId);
     if (find == serverPacketHandlers.end()) {
@@ -6715,6 +6905,8 @@ void serverHandlePacket()
 
 void serverHandleMessages(Uint32 framerateBreakInterval)
 {
+	PROFILE_ZONE("serverHandleMessages");
+	NetTrafficStats.update();
 #ifdef STEAMWORKS
 	if (!directConnect && !net_handler)
 	{
@@ -6760,10 +6952,10 @@ void serverHandleMessages(Uint32 framerateBreakInterval)
 
 		while ( packet = net_handler->getGamePacket() )
 		{
-			memcpy(net_packet->data, packet->data(), packet->len());
-			net_packet->len = packet->len();
-
-			serverHandlePacket(); //Uses net_packet;
+			{
+				NetPacketBinding binding(packet->data(), packet->len());
+				serverHandlePacket(); //Uses net_packet;
+			}
 
 			if ( logCheckMainLoopTimers )
 			{
@@ -6888,9 +7080,7 @@ bool handleSafePacket()
 				}
 			}
 			net_packet->len = c - 9;
-			Uint8 bytedata[NET_PACKET_SIZE];
-			memcpy(&bytedata, net_packet->data + 9, net_packet->len);
-			memcpy(net_packet->data, &bytedata, net_packet->len);
+			memmove(net_packet->data, net_packet->data + 9, net_packet->len);
 
 			/*int sprite = -9999;
 			char chr[5];
@@ -6930,6 +7120,7 @@ bool handleSafePacket()
 			packetsend_t* packet = (packetsend_t*)node->element;
 			if ( packet->num == SDLNet_Read32(&net_packet->data[5]) )
 			{
+				NetTrafficStats.countSafeAck(*packet);
 				list_RemoveNode(node);
 				break;
 			}
@@ -6962,6 +7153,7 @@ void closeNetworkInterfaces()
 
 	if (net_packet != nullptr)
 	{
+		NetPacketBinding::unbindAll();
 		SDLNet_FreePacket(net_packet);
 		net_packet = nullptr;
 	}
@@ -7011,6 +7203,249 @@ void closeNetworkInterfaces()
 
 
 
+/*-------------------------------------------------------------------------------
+
+	PacketReader / PacketWriter
+
+	Bounds-checked, big-endian access to packet buffers
+
+-------------------------------------------------------------------------------*/
+
+PacketReader::PacketReader(const Uint8* data, int len, int offset) :
+	_data(data),
+	_len(data ? std::max(0, len) : 0),
+	_pos(0)
+{
+	seek(offset);
+}
+
+PacketReader::PacketReader(const UDPpacket* packet, int offset) :
+	PacketReader(packet ? packet->data : nullptr, packet ? packet->len : 0, offset)
+{
+}
+
+void PacketReader::seek(int offset)
+{
+	if ( offset < 0 || offset > _len )
+	{
+		_ok = false;
+		_pos = _len;
+		return;
+	}
+	_pos = offset;
+}
+
+Uint8 PacketReader::read8()
+{
+	if ( remaining() < 1 )
+	{
+		_ok = false;
+		_pos = _len;
+		return 0;
+	}
+	return _data[_pos++];
+}
+
+Uint16 PacketReader::read16()
+{
+	if ( remaining() < 2 )
+	{
+		_ok = false;
+		_pos = _len;
+		return 0;
+	}
+	Uint16 result = SDLNet_Read16(&_data[_pos]);
+	_pos += 2;
+	return result;
+}
+
+Uint32 PacketReader::read32()
+{
+	if ( remaining() < 4 )
+	{
+		_ok = false;
+		_pos = _len;
+		return 0;
+	}
+	Uint32 result = SDLNet_Read32(&_data[_pos]);
+	_pos += 4;
+	return result;
+}
+
+bool PacketReader::readBytes(void* out, int count)
+{
+	if ( count < 0 || remaining() < count )
+	{
+		_ok = false;
+		_pos = _len;
+		memset(out, 0, std::max(0, count));
+		return false;
+	}
+	memcpy(out, &_data[_pos], count);
+	_pos += count;
+	return true;
+}
+
+bool PacketReader::readString(char* out, int size)
+{
+	if ( size <= 0 )
+	{
+		return false;
+	}
+	int c = 0;
+	for ( ; c < size - 1 && _pos < _len; ++c )
+	{
+		out[c] = (char)_data[_pos++];
+		if ( !out[c] )
+		{
+			return true;
+		}
+	}
+	out[c] = '\0';
+	if ( _pos < _len && !_data[_pos] )
+	{
+		++_pos; // consume the terminator
+		return true;
+	}
+	if ( _pos >= _len )
+	{
+		_ok = false;
+	}
+	return false;
+}
+
+PacketWriter::PacketWriter(Uint8* data, int capacity, int offset) :
+	_data(data),
+	_capacity(data ? std::max(0, capacity) : 0),
+	_pos(0)
+{
+	seek(offset);
+}
+
+PacketWriter::PacketWriter(UDPpacket* packet, int offset) :
+	PacketWriter(packet ? packet->data : nullptr, packet ? packet->maxlen : 0, offset)
+{
+}
+
+void PacketWriter::seek(int offset)
+{
+	if ( offset < 0 || offset > _capacity )
+	{
+		_ok = false;
+		_pos = _capacity;
+		return;
+	}
+	_pos = offset;
+}
+
+bool PacketWriter::write8(Uint8 value)
+{
+	if ( _capacity - _pos < 1 )
+	{
+		_ok = false;
+		return false;
+	}
+	_data[_pos++] = value;
+	return true;
+}
+
+bool PacketWriter::write16(Uint16 value)
+{
+	if ( _capacity - _pos < 2 )
+	{
+		_ok = false;
+		return false;
+	}
+	SDLNet_Write16(value, &_data[_pos]);
+	_pos += 2;
+	return true;
+}
+
+bool PacketWriter::write32(Uint32 value)
+{
+	if ( _capacity - _pos < 4 )
+	{
+		_ok = false;
+		return false;
+	}
+	SDLNet_Write32(value, &_data[_pos]);
+	_pos += 4;
+	return true;
+}
+
+bool PacketWriter::writeBytes(const void* in, int count)
+{
+	if ( count < 0 || _capacity - _pos < count )
+	{
+		_ok = false;
+		return false;
+	}
+	memcpy(&_data[_pos], in, count);
+	_pos += count;
+	return true;
+}
+
+bool PacketWriter::writeString(const char* str)
+{
+	return writeBytes(str, (int)strlen(str) + 1);
+}
+
+void EntityUpdate_t::write(PacketWriter& out) const
+{
+	out.writeBytes("ENTU", 4);
+	out.write32(uid);
+	out.write16(sprite);
+	out.write16(x);
+	out.write16(y);
+	out.write16(z);
+	out.write8(sizex);
+	out.write8(sizey);
+	out.write8(scalex);
+	out.write8(scaley);
+	out.write8(scalez);
+	out.write16(yaw);
+	out.write16(pitch);
+	out.write16(roll);
+	out.write8(focalx);
+	out.write8(focaly);
+	out.write8(focalz);
+	out.write32(skill2);
+	out.write8(flags & 0xFF);
+	out.write8(flags >> 8);
+	out.write32(serverTicks);
+	out.write16(vel_x);
+	out.write16(vel_y);
+	out.write16(vel_z);
+}
+
+bool EntityUpdate_t::read(PacketReader& in)
+{
+	uid = in.read32();
+	sprite = in.read16();
+	x = in.readS16();
+	y = in.readS16();
+	z = in.readS16();
+	sizex = in.readS8();
+	sizey = in.readS8();
+	scalex = in.read8();
+	scaley = in.read8();
+	scalez = in.read8();
+	yaw = in.readS16();
+	pitch = in.readS16();
+	roll = in.readS16();
+	focalx = in.readS8();
+	focaly = in.readS8();
+	focalz = in.readS8();
+	skill2 = in.readS32();
+	flags = in.read8();
+	flags |= in.read8() << 8;
+	serverTicks = in.read32();
+	vel_x = in.readS16();
+	vel_y = in.readS16();
+	vel_z = in.readS16();
+	return in.ok();
+}
+
 /* ***** MULTITHREADED STEAM PACKET HANDLING ***** */
 
 SteamPacketWrapper::SteamPacketWrapper(Uint8* data, int len)
@@ -7189,25 +7624,26 @@ int EOSPacketThread(void* data)
 		//2. Game not over. Grab/poll for packet.
 
 		//while (handler.getContinueMultithreadingSteamPackets() && SteamNetworking()->IsP2PPacketAvailable(&packetlen)) //Burst read in a bunch of packets.
-		while (EOS.HandleReceivedMessages(&remoteId) )
+		//Read packets straight into their own buffers, net_packet may be bound to a packet being handled.
+		//Buffers are full size so handlers can use them in place.
+		packet = static_cast<Uint8*>(malloc(NET_PACKET_SIZE));
+		while ( packet && EOS.HandleReceivedMessages(&remoteId, packet, NET_PACKET_SIZE - 1, &packetlen) )
 		{
-			packetlen = std::min<uint32_t>(net_packet->len, NET_PACKET_SIZE - 1);
-			//Read packets and push into queue.
-			packet = static_cast<Uint8*>(malloc(packetlen));
-			memcpy(packet, net_packet->data, packetlen);
-			if ( !EOSFuncs::Helpers_t::isMatchingProductIds(remoteId, EOS.CurrentUserInfo.getProductUserIdHandle())
-				&& net_packet->data[0] )
+			if ( packetlen > 0
+				&& !EOSFuncs::Helpers_t::isMatchingProductIds(remoteId, EOS.CurrentUserInfo.getProductUserIdHandle())
+				&& packet[0] )
 			{
 				//Push packet into queue.
 				//TODO: Use lock-free queues?
 				packets.push(new SteamPacketWrapper(packet, packetlen));
-				packet = nullptr;
-			}
-			if ( packet )
-			{
-				free(packet);
+				packet = static_cast<Uint8*>(malloc(NET_PACKET_SIZE));
 			}
 		}
+		if ( packet )
+		{
+			free(packet);
+			packet = nullptr;
+		}
 
 
 		//3. Now push our local packetstack onto the game's network stack.
@@ -7257,11 +7693,11 @@ int steamPacketThread(void* data)
 		while (SteamNetworking()->IsP2PPacketAvailable(&packetlen))
 		{
 			packetlen = std::min<uint32_t>(packetlen, NET_PACKET_SIZE - 1);
-			//Read packets and push into queue.
-			packet = static_cast<Uint8* >(malloc(packetlen));
+			//Read packets and push into queue. Buffers are full size so handlers can use them in place.
+			packet = static_cast<Uint8* >(malloc(NET_PACKET_SIZE));
 			if (SteamNetworking()->ReadP2PPacket(packet, packetlen, &bytes_read, &steam_id_remote, 0))
 			{
-				if (packetlen > sizeof(uint32_t) && mySteamID.ConvertToUint64() != steam_id_remote.ConvertToUint64() && net_packet->data[0])
+				if (packetlen > sizeof(uint32_t) && mySteamID.ConvertToUint64() != steam_id_remote.ConvertToUint64() && packet[0])
 				{
 					//Push packet into queue.
 					//TODO: Use lock-free queues?
@@ -7619,4 +8055,270 @@ void PingNetworkStatus_t::update()
 
 		p.saveDisplayMillis();
 	}
-}
\ No newline at end of file
+}
+/*-------------------------------------------------------------------------------
+
+	NetTrafficStats
+
+	Counts packets and bytes per message type and per peer, safe packet
+	resends and ack latency, and ENTU updates per sprite. /netstats prints
+	a report, /netstats_log_interval dumps one to the log periodically and
+	/netstats_overlay draws per-peer rates and the busiest message types.
+
+-------------------------------------------------------------------------------*/
+
+NetTrafficStats_t NetTrafficStats;
+
+static ConsoleVariable<int> cvar_netstats_log_interval("/netstats_log_interval", 0); // seconds, 0 disables
+
+Uint32 NetTrafficStats_t::packetType(const Uint8* data, int len)
+{
+	PacketReader in(data, len);
+	Uint32 type = in.read32();
+	if ( type == 'SAFE' )
+	{
+		in.seek(9);
+		const Uint32 inner = in.read32();
+		if ( in.ok() )
+		{
+			type = inner;
+		}
+	}
+	return type;
+}
+
+int NetTrafficStats_t::incomingPeer(const UDPpacket* packet) const
+{
+	if ( multiplayer == CLIENT )
+	{
+		return 0;
+	}
+	PacketReader in(packet);
+	if ( in.read32() == 'SAFE' )
+	{
+		const int player = in.read8();
+		if ( in.ok() && player > 0 && player < MAXPLAYERS )
+		{
+			return player - 1;
+		}
+	}
+	if ( directConnect && net_clients )
+	{
+		for ( int c = 0; c < MAXPLAYERS - 1; ++c )
+		{
+			if ( net_clients[c].host == packet->address.host && net_clients[c].port == packet->address.port )
+			{
+				return c;
+			}
+		}
+	}
+	return UNKNOWN_PEER;
+}
+
+void NetTrafficStats_t::countIn(const UDPpacket* packet)
+{
+	const Uint32 type = packetType(packet->data, packet->len);
+	typesIn[type].add(packet->len);
+	peers[incomingPeer(packet)].in.add(packet->len);
+	if ( type == 'ENTU' )
+	{
+		// uid follows the id, past the SAFE header if there is one
+		PacketReader in(packet, PacketReader(packet).read32() == 'SAFE' ? 13 : 4);
+		const Uint32 uid = in.read32();
+		Entity* entity = in.ok() ? uidToEntity(uid) : nullptr;
+		entityUpdates[entity ? entity->sprite : -1].add(packet->len);
+	}
+}
+
+void NetTrafficStats_t::countOut(const Uint8* data, int len, int hostnum)
+{
+	typesOut[packetType(data, len)].add(len);
+	peer(hostnum).out.add(len);
+}
+
+void NetTrafficStats_t::countSafeResend(const packetsend_t& packet, bool dropped)
+{
+	auto& p = peer(packet.hostnum);
+	++p.safeResent;
+	if ( dropped )
+	{
+		++p.safeDropped;
+	}
+}
+
+void NetTrafficStats_t::countSafeAck(const packetsend_t& packet)
+{
+	auto& p = peer(packet.hostnum);
+	const Uint32 latency = SDL_GetTicks() - packet.sendtime;
+	++p.safeAcked;
+	p.ackLatencyTotal += latency;
+	p.ackLatencyMax = std::max(p.ackLatencyMax, latency);
+}
+
+void NetTrafficStats_t::reset()
+{
+	for ( auto& peer : peers )
+	{
+		peer = Peer();
+	}
+	typesIn.clear();
+	typesOut.clear();
+	entityUpdates.clear();
+	sampleStart = SDL_GetTicks();
+	lastLogDump = sampleStart;
+}
+
+void NetTrafficStats_t::update()
+{
+	const Uint32 now = SDL_GetTicks();
+	const Uint32 elapsed = now - sampleStart;
+	if ( elapsed >= 1000 )
+	{
+		for ( auto& peer : peers )
+		{
+			peer.rateIn = (peer.in.bytes - peer.sampleBytesIn) * 1000.0 / elapsed;
+			peer.rateOut = (peer.out.bytes - peer.sampleBytesOut) * 1000.0 / elapsed;
+			peer.sampleBytesIn = peer.in.bytes;
+			peer.sampleBytesOut = peer.out.bytes;
+		}
+		sampleStart = now;
+	}
+	if ( *cvar_netstats_log_interval > 0 && now - lastLogDump >= (Uint32)*cvar_netstats_log_interval * 1000 )
+	{
+		lastLogDump = now;
+		print();
+	}
+}
+
+static void sortCounters(std::vector<std::pair<Uint32, NetTrafficStats_t::Counter>>& out,
+	const std::unordered_map<Uint32, NetTrafficStats_t::Counter>& counters)
+{
+	out.assign(counters.begin(), counters.end());
+	std::sort(out.begin(), out.end(), [](const std::pair<Uint32, NetTrafficStats_t::Counter>& a,
+		const std::pair<Uint32, NetTrafficStats_t::Counter>& b) {
+		return a.second.bytes > b.second.bytes;
+	});
+}
+
+static const char* packetTypeName(Uint32 type, char (&name)[5])
+{
+	for ( int c = 0; c < 4; ++c )
+	{
+		const char chr = (char)((type >> (24 - c * 8)) & 0xFF);
+		name[c] = (chr >= ' ' && chr <= '~') ? chr : '?';
+	}
+	name[4] = '\0';
+	return name;
+}
+
+static const char* peerName(int peer, char (&name)[16])
+{
+	if ( peer == NetTrafficStats_t::UNKNOWN_PEER )
+	{
+		snprintf(name, sizeof(name), "unknown");
+	}
+	else if ( multiplayer == CLIENT )
+	{
+		snprintf(name, sizeof(name), "server");
+	}
+	else
+	{
+		snprintf(name, sizeof(name), "player %d", peer + 1);
+	}
+	return name;
+}
+
+void NetTrafficStats_t::print() const
+{
+	char name[16];
+	char type[5];
+	printlog("[NETSTATS]: peer | in pkts/bytes/rate | out pkts/bytes/rate | safe sent/resent/acked/dropped | ack ms avg/max");
+	for ( int c = 0; c <= MAXPLAYERS; ++c )
+	{
+		auto& peer = peers[c];
+		if ( !peer.in.packets && !peer.out.packets )
+		{
+			continue;
+		}
+		printlog("[NETSTATS]: %-8s | %llu / %llu / %.0f B/s | %llu / %llu / %.0f B/s | %u / %u / %u / %u | %.1f / %u",
+			peerName(c, name),
+			(unsigned long long)peer.in.packets, (unsigned long long)peer.in.bytes, peer.rateIn,
+			(unsigned long long)peer.out.packets, (unsigned long long)peer.out.bytes, peer.rateOut,
+			peer.safeSent, peer.safeResent, peer.safeAcked, peer.safeDropped,
+			peer.safeAcked ? (double)peer.ackLatencyTotal / peer.safeAcked : 0.0, peer.ackLatencyMax);
+	}
+
+	std::vector<std::pair<Uint32, Counter>> sorted;
+	sortCounters(sorted, typesOut);
+	for ( auto& it : sorted )
+	{
+		printlog("[NETSTATS]: out %s | %llu packets | %llu bytes", packetTypeName(it.first, type),
+			(unsigned long long)it.second.packets, (unsigned long long)it.second.bytes);
+	}
+	sortCounters(sorted, typesIn);
+	for ( auto& it : sorted )
+	{
+		printlog("[NETSTATS]: in  %s | %llu packets | %llu bytes", packetTypeName(it.first, type),
+			(unsigned long long)it.second.packets, (unsigned long long)it.second.bytes);
+	}
+
+	std::vector<std::pair<int, Counter>> entities(entityUpdates.begin(), entityUpdates.end());
+	std::sort(entities.begin(), entities.end(), [](const std::pair<int, Counter>& a, const std::pair<int, Counter>& b) {
+		return a.second.packets > b.second.packets;
+	});
+	for ( auto& it : entities )
+	{
+		const Monster monster = it.first >= 0 ? Entity::getMonsterTypeFromSprite(it.first) : NOTHING;
+		printlog("[NETSTATS]: ENTU sprite %d%s%s | %llu updates | %llu bytes",
+			it.first, monster != NOTHING ? " " : "", monster != NOTHING ? monstertypename[monster] : "",
+			(unsigned long long)it.second.packets, (unsigned long long)it.second.bytes);
+	}
+}
+
+void NetTrafficStats_t::drawOverlay() const
+{
+	char name[16];
+	char type[5];
+	int y = 32;
+	printTextFormatted(font8x8_bmp, 8, y, "peer       in B/s  out B/s  resent  ack ms");
+	y += 12;
+	for ( int c = 0; c <= MAXPLAYERS; ++c )
+	{
+		auto& peer = peers[c];
+		if ( !peer.in.packets && !peer.out.packets )
+		{
+			continue;
+		}
+		printTextFormatted(font8x8_bmp, 8, y, "%-9s %8.0f %8.0f %7u %7.1f", peerName(c, name),
+			peer.rateIn, peer.rateOut, peer.safeResent,
+			peer.safeAcked ? (double)peer.ackLatencyTotal / peer.safeAcked : 0.0);
+		y += 10;
+	}
+
+	// the busiest message types since the last reset
+	static std::vector<std::pair<Uint32, Counter>> sorted;
+	static Uint32 lastSort = 0;
+	if ( sorted.empty() || SDL_GetTicks() - lastSort >= 500 )
+	{
+		lastSort = SDL_GetTicks();
+		sortCounters(sorted, typesOut);
+	}
+	y += 6;
+	printTextFormatted(font8x8_bmp, 8, y, "out type   packets      bytes");
+	y += 12;
+	for ( size_t c = 0; c < sorted.size() && c < 12; ++c )
+	{
+		printTextFormatted(font8x8_bmp, 8, y, "%-8s %9llu %10llu", packetTypeName(sorted[c].first, type),
+			(unsigned long long)sorted[c].second.packets, (unsigned long long)sorted[c].second.bytes);
+		y += 10;
+	}
+}
+
+static ConsoleCommand ccmd_netstats("/netstats", "print network traffic counters to the log", [](int argc, const char* argv[]){
+	NetTrafficStats.print();
+	messagePlayer(clientnum, MESSAGE_MISC, "Network stats written to log.");
+	});
+
+static ConsoleCommand ccmd_netstats_reset("/netstats_reset", "clear network traffic counters", [](int argc, const char* argv[]){
+	NetTrafficStats.reset();
+	});
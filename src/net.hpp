@@ -66,8 +66,6 @@ enum NetworkingLobbyJoinRequestResult : int
 	NET_LOBBY_JOIN_DIRECTIP_SUCCESS
 };
 NetworkingLobbyJoinRequestResult lobbyPlayerJoinRequest(int& outResult, bool lockedSlots[4]);
-Entity* receiveEntity(Entity* entity);
-void clientActions(Entity* entity);
 void clientHandleMessages(Uint32 framerateBreakInterval);
 void serverHandleMessages(Uint32 framerateBreakInterval);
 bool handleSafePacket();
@@ -91,6 +89,92 @@ const Uint32 NUM_SERVER_FLAGS =  9;
 
 extern bool keepInventoryGlobal;
 
+// Bounds-checked reader over a caller-owned packet buffer. Multi-byte fields
+// are big-endian, matching SDLNet_Read16/SDLNet_Read32. Reading past the end
+// returns zeros and clears ok(), so handlers can check once at the end.
+class PacketReader
+{
+	const Uint8* _data;
+	int _len;
+	int _pos;
+	bool _ok = true;
+public:
+	PacketReader(const Uint8* data, int len, int offset = 0);
+	explicit PacketReader(const UDPpacket* packet, int offset = 0);
+
+	Uint8 read8();
+	Uint16 read16();
+	Uint32 read32();
+	Sint8 readS8() { return (Sint8)read8(); }
+	Sint16 readS16() { return (Sint16)read16(); }
+	Sint32 readS32() { return (Sint32)read32(); }
+	bool readBytes(void* out, int count);
+
+	// copies a string of at most size - 1 chars, stopping at a terminator
+	// or the end of the packet. out is always terminated.
+	bool readString(char* out, int size);
+
+	void seek(int offset);
+	void skip(int count) { seek(_pos + count); }
+	int tell() const { return _pos; }
+	int size() const { return _len; }
+	int remaining() const { return _len - _pos; }
+	bool ok() const { return _ok; }
+	const Uint8* data() const { return _data; }
+};
+
+// Bounds-checked writer into a caller-owned buffer, so separate messages can
+// be built side by side instead of all going through net_packet. Writes that
+// don't fit are dropped and clear ok().
+class PacketWriter
+{
+	Uint8* _data;
+	int _capacity;
+	int _pos;
+	bool _ok = true;
+public:
+	PacketWriter(Uint8* data, int capacity, int offset = 0);
+	explicit PacketWriter(UDPpacket* packet, int offset = 0);
+
+	bool write8(Uint8 value);
+	bool write16(Uint16 value);
+	bool write32(Uint32 value);
+	bool writeBytes(const void* in, int count);
+	bool writeString(const char* str); // includes the terminator
+
+	void seek(int offset);
+	int size() const { return _pos; }
+	int capacity() const { return _capacity; }
+	bool ok() const { return _ok; }
+	Uint8* data() const { return _data; }
+};
+
+// An ENTU entity update as laid out by sendEntityUDP, in its wire units.
+// Decoded once on receipt so the client update path doesn't index into
+// net_packet at fixed offsets.
+struct EntityUpdate_t
+{
+	Uint32 uid = 0;
+	Uint16 sprite = 0;
+	Sint16 x = 0, y = 0, z = 0; // 1/32nds
+	Sint8 sizex = 0, sizey = 0;
+	Uint8 scalex = 0, scaley = 0, scalez = 0; // 1/128ths
+	Sint16 yaw = 0, pitch = 0, roll = 0; // 1/256ths
+	Sint8 focalx = 0, focaly = 0, focalz = 0; // 1/8ths
+	Sint32 skill2 = 0;
+	Uint16 flags = 0; // the first 16 entity flags, one bit each
+	Uint32 serverTicks = 0;
+	Sint16 vel_x = 0, vel_y = 0, vel_z = 0; // 1/32nds
+
+	// writes the whole packet including the "ENTU" id
+	void write(PacketWriter& out) const;
+	// reads everything after the id. false if the packet was short
+	bool read(PacketReader& in);
+};
+
+Entity* receiveEntity(Entity* entity, const EntityUpdate_t& update);
+void clientActions(Entity* entity, Sint32 serverSkill2);
+
 class SteamPacketWrapper
 {
 	Uint8* _data;
@@ -182,4 +266,57 @@ struct PingNetworkStatus_t
 	static void update();
 	static void reset();
 };
-extern PingNetworkStatus_t PingNetworkStatus[MAXPLAYERS];
\ No newline at end of file
+extern PingNetworkStatus_t PingNetworkStatus[MAXPLAYERS];
+// packet and byte counters for finding bandwidth hogs, see /netstats
+struct NetTrafficStats_t
+{
+	struct Counter
+	{
+		Uint64 packets = 0;
+		Uint64 bytes = 0;
+		void add(int len)
+		{
+			++packets;
+			bytes += len > 0 ? len : 0;
+		}
+	};
+	struct Peer
+	{
+		Counter in;
+		Counter out;
+		Uint32 safeSent = 0;      // reliable packets queued by sendPacketSafe
+		Uint32 safeResent = 0;    // resends of unacknowledged safe packets
+		Uint32 safeAcked = 0;
+		Uint32 safeDropped = 0;   // gave up after MAXTRIES resends
+		Uint64 ackLatencyTotal = 0; // ms, over safeAcked
+		Uint32 ackLatencyMax = 0;
+		real_t rateIn = 0.0;      // bytes per second over the last sample
+		real_t rateOut = 0.0;
+		Uint64 sampleBytesIn = 0;
+		Uint64 sampleBytesOut = 0;
+	};
+
+	static constexpr int UNKNOWN_PEER = MAXPLAYERS; // senders we can't attribute
+
+	Peer peers[MAXPLAYERS + 1];  // indexed by hostnum as passed to sendPacket
+	std::unordered_map<Uint32, Counter> typesIn;  // by packet id, SAFE unwrapped
+	std::unordered_map<Uint32, Counter> typesOut;
+	std::unordered_map<int, Counter> entityUpdates; // ENTU received, by sprite
+	Uint32 sampleStart = 0;
+	Uint32 lastLogDump = 0;
+
+	static Uint32 packetType(const Uint8* data, int len);
+	int incomingPeer(const UDPpacket* packet) const;
+
+	Peer& peer(int hostnum) { return peers[(hostnum >= 0 && hostnum < MAXPLAYERS) ? hostnum : UNKNOWN_PEER]; }
+
+	void countIn(const UDPpacket* packet);
+	void countOut(const Uint8* data, int len, int hostnum);
+	void countSafeResend(const packetsend_t& packet, bool dropped);
+	void countSafeAck(const packetsend_t& packet);
+	void reset();
+	void update(); // refresh rates and do the periodic log dump
+	void print() const;
+	void drawOverlay() const;
+};
+extern NetTrafficStats_t NetTrafficStats;
@@ -22,6 +22,13 @@
 #include "player.hpp"
 #include "ui/MainMenu.hpp"
 #include "init.hpp"
+#include "net.hpp"
+#include "profiler.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <limits>
 
 static real_t getLightAtModifier = 1.0;
 static real_t getLightAtAdder = 0.0;
@@ -671,9 +678,20 @@ static void loadLightmapTexture(int which) {
 }
 
 static void updateChunks();
+static void glFlushSpriteBatch();
+
+DrawStats drawStats;
+DrawStats drawStatsLastFrame;
 
 void beginGraphics() {
     // this runs exactly once each graphics frame.
+    static auto lastFrameTime = std::chrono::high_resolution_clock::now();
+    const auto now = std::chrono::high_resolution_clock::now();
+    drawStats.frameMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(now - lastFrameTime).count();
+    lastFrameTime = now;
+    drawStatsLastFrame = drawStats;
+    drawStats = DrawStats();
+    
     updateChunks();
 }
 
@@ -747,65 +765,94 @@ static vec4_t* HSVtoRGB(vec4_t* result, const vec4_t* hsv){
     return result;
 }
 
-static void uploadLightUniforms(view_t* camera, Shader& shader, Entity* entity, int mode, bool remap) {
-    const float cameraPos[4] = {(float)camera->x * 32.f, -(float)camera->z, (float)camera->y * 32.f, 1.f};
-    GL_CHECK_ERR(glUniform4fv(shader.uniform("uCameraPos"), 1, cameraPos));
+// which color remap matrix an entity is drawn with
+enum class ColorRemap {
+    Identity,
+    Grayscale,
+    Ally,       // certain allies use G/B/R color map
+    Rainbow,
+    Empty,      // entity uid pass
+};
+
+static mat4x4_t getColorRemap(ColorRemap kind) {
+    mat4x4_t remap(1.f);
+    switch (kind) {
+    default:
+    case ColorRemap::Identity:
+        break;
+    case ColorRemap::Grayscale:
+        remap.x.x = 1.f / 3.f;
+        remap.x.y = 1.f / 3.f;
+        remap.x.z = 1.f / 3.f;
+        remap.y.x = 1.f / 3.f;
+        remap.y.y = 1.f / 3.f;
+        remap.y.z = 1.f / 3.f;
+        remap.z.x = 1.f / 3.f;
+        remap.z.y = 1.f / 3.f;
+        remap.z.z = 1.f / 3.f;
+        break;
+    case ColorRemap::Ally:
+        remap = mat4x4_t(0.f);
+        remap.x.y = 1.f;
+        remap.y.z = 1.f;
+        remap.z.x = 1.f;
+        break;
+    case ColorRemap::Rainbow: {
+        remap = mat4x4_t(0.f);
+        
+        const auto period = TICKS_PER_SECOND * 3; // 3 seconds
+        const auto time = (ticks % period) / (real_t)period; // [0-1]
+        const auto amp = 360.0;
+        
+        vec4_t hsv;
+        hsv.y = 100.f; // saturation
+        hsv.z = 100.f; // value
+        hsv.w = 0.f;   // unused
+        
+        hsv.x = time * amp;
+        HSVtoRGB(&remap.x, &hsv); // red
+        
+        hsv.x = time * amp + 120;
+        HSVtoRGB(&remap.y, &hsv); // green
+        
+        hsv.x = time * amp + 240;
+        HSVtoRGB(&remap.z, &hsv); // blue
+        break;
+    }
+    case ColorRemap::Empty:
+        remap = mat4x4_t(0.f);
+        break;
+    }
+    return remap;
+}
+
+// shading inputs for one entity. shared by the immediate and
+// instanced voxel paths so that both of them look the same
+struct EntityLighting {
+    ColorRemap remap = ColorRemap::Identity;
+    vec4_t lightFactor{0.f};
+    vec4_t lightColor{0.f};
+    vec4_t colorAdd{0.f};
+};
+
+static void getEntityLighting(view_t* camera, Entity* entity, int mode, EntityLighting& result) {
     if (mode == REALCOLORS) {
-        if (remap) {
-            bool doGrayScale = false;
-            real_t grayScaleFactor = 0.0;
-            if (entity->grayscaleGLRender > 0.001) {
-                doGrayScale = true;
-                grayScaleFactor = entity->grayscaleGLRender;
-            }
-            
-            mat4x4_t remap(1.f);
-            if (doGrayScale) {
-                remap.x.x = 1.f / 3.f;
-                remap.x.y = 1.f / 3.f;
-                remap.x.z = 1.f / 3.f;
-                remap.y.x = 1.f / 3.f;
-                remap.y.y = 1.f / 3.f;
-                remap.y.z = 1.f / 3.f;
-                remap.z.x = 1.f / 3.f;
-                remap.z.y = 1.f / 3.f;
-                remap.z.z = 1.f / 3.f;
-            }
-            else if (entity->flags[USERFLAG2]) {
-                if (entity->behavior != &actMonster || monsterChangesColorWhenAlly(nullptr, entity)) {
-                    // certain allies use G/B/R color map
-                    remap = mat4x4_t(0.f);
-                    remap.x.y = 1.f;
-                    remap.y.z = 1.f;
-                    remap.z.x = 1.f;
-                }
-            }
+        if (entity->grayscaleGLRender > 0.001) {
+            result.remap = ColorRemap::Grayscale;
+        }
+        else if (entity->flags[USERFLAG2] &&
+            (entity->behavior != &actMonster || monsterChangesColorWhenAlly(nullptr, entity))) {
+            result.remap = ColorRemap::Ally;
+        }
+        else {
+            result.remap = ColorRemap::Identity;
+        }
 #ifndef EDITOR
-            static ConsoleVariable<bool> cvar_rainbowTest("/rainbowtest", false);
-            if (*cvar_rainbowTest) {
-                remap = mat4x4_t(0.f);
-                
-                const auto period = TICKS_PER_SECOND * 3; // 3 seconds
-                const auto time = (ticks % period) / (real_t)period; // [0-1]
-                const auto amp = 360.0;
-                
-                vec4_t hsv;
-                hsv.y = 100.f; // saturation
-                hsv.z = 100.f; // value
-                hsv.w = 0.f;   // unused
-                
-                hsv.x = time * amp;
-                HSVtoRGB(&remap.x, &hsv); // red
-                
-                hsv.x = time * amp + 120;
-                HSVtoRGB(&remap.y, &hsv); // green
-                
-                hsv.x = time * amp + 240;
-                HSVtoRGB(&remap.z, &hsv); // blue
-            }
-#endif
-            GL_CHECK_ERR(glUniformMatrix4fv(shader.uniform("uColorRemap"), 1, false, (float*)&remap));
+        static ConsoleVariable<bool> cvar_rainbowTest("/rainbowtest", false);
+        if (*cvar_rainbowTest) {
+            result.remap = ColorRemap::Rainbow;
         }
+#endif
 
         int player = -1;
         for ( player = 0; player < MAXPLAYERS; ++player ) {
@@ -823,8 +870,7 @@ static void uploadLightUniforms(view_t* camera, Shader& shader, Entity* entity,
             && stats[player]->mask&& stats[player]->mask->type == TOOL_BLINDFOLD_TELEPATHY;
 #endif
         if ( telepathy ) {
-            const GLfloat factor[4] = { 1.f, 1.f, 1.f, 1.f, };
-            GL_CHECK_ERR(glUniform4fv(shader.uniform("uLightFactor"), 1, factor));
+            result.lightFactor = vec4_t(1.f);
 
             Vector4 defaultLight{ 0.1f, 0.1f, 0.25f, 1.f };
 #ifndef EDITOR
@@ -833,16 +879,14 @@ static void uploadLightUniforms(view_t* camera, Shader& shader, Entity* entity,
 #else
             const auto& light = defaultLight;
 #endif
-            GL_CHECK_ERR(glUniform4fv(shader.uniform("uLightColor"), 1, (float*)&light));
+            result.lightColor = vec4_t(light.x, light.y, light.z, light.w);
         } else {
-            const GLfloat light[4] = {
+            result.lightFactor = vec4_t(
                 (float)getLightAtModifier,
                 (float)getLightAtModifier,
                 (float)getLightAtModifier,
-                1.f,
-            };
-            GL_CHECK_ERR(glUniform4fv(shader.uniform("uLightFactor"), 1, light));
-            GL_CHECK_ERR(glUniform4fv(shader.uniform("uLightColor"), 1, (float*)&entity->lightBonus));
+                1.f);
+            result.lightColor = entity->lightBonus;
         }
 
         // highlighting
@@ -865,34 +909,41 @@ static void uploadLightUniforms(view_t* camera, Shader& shader, Entity* entity,
             if (highlight > 1.f) {
                 highlight = 1.f - (highlight - 1.f);
             }
-            const GLfloat add[4] = {
+            result.colorAdd = vec4_t(
                 (highlight - .5f) * .05f,
                 (highlight - .5f) * .05f,
                 (highlight - .5f) * .05f,
-                0.f };
-            GL_CHECK_ERR(glUniform4fv(shader.uniform("uColorAdd"), 1, add));
+                0.f);
         } else {
-            constexpr GLfloat add[4] = { 0.f, 0.f, 0.f, 0.f };
-            GL_CHECK_ERR(glUniform4fv(shader.uniform("uColorAdd"), 1, add));
+            result.colorAdd = vec4_t(0.f);
         }
     } else {
-        if (remap) {
-            mat4x4_t empty(0.f);
-            GL_CHECK_ERR(glUniformMatrix4fv(shader.uniform("uColorRemap"), 1, false, (float*)&empty));
-        }
+        result.remap = ColorRemap::Empty;
+        result.lightFactor = vec4_t(0.f);
+        result.lightColor = vec4_t(0.f);
         
-        constexpr GLfloat light[4] = { 0.f, 0.f, 0.f, 0.f };
-        GL_CHECK_ERR(glUniform4fv(shader.uniform("uLightFactor"), 1, light));
-        GL_CHECK_ERR(glUniform4fv(shader.uniform("uLightColor"), 1, light));
-        
-        GLfloat uidcolors[4];
         Uint32 uid = entity->getUID();
-        uidcolors[0] = ((Uint8)(uid)) / 255.f;
-        uidcolors[1] = ((Uint8)(uid >> 8)) / 255.f;
-        uidcolors[2] = ((Uint8)(uid >> 16)) / 255.f;
-        uidcolors[3] = ((Uint8)(uid >> 24)) / 255.f;
-        GL_CHECK_ERR(glUniform4fv(shader.uniform("uColorAdd"), 1, uidcolors));
+        result.colorAdd = vec4_t(
+            ((Uint8)(uid)) / 255.f,
+            ((Uint8)(uid >> 8)) / 255.f,
+            ((Uint8)(uid >> 16)) / 255.f,
+            ((Uint8)(uid >> 24)) / 255.f);
+    }
+}
+
+static void uploadLightUniforms(view_t* camera, Shader& shader, Entity* entity, int mode, bool remap) {
+    const float cameraPos[4] = {(float)camera->x * 32.f, -(float)camera->z, (float)camera->y * 32.f, 1.f};
+    GL_CHECK_ERR(glUniform4fv(shader.uniform("uCameraPos"), 1, cameraPos));
+    
+    EntityLighting lighting;
+    getEntityLighting(camera, entity, mode, lighting);
+    if (remap) {
+        const mat4x4_t remapMatrix = getColorRemap(lighting.remap);
+        GL_CHECK_ERR(glUniformMatrix4fv(shader.uniform("uColorRemap"), 1, false, (float*)&remapMatrix));
     }
+    GL_CHECK_ERR(glUniform4fv(shader.uniform("uLightFactor"), 1, (float*)&lighting.lightFactor));
+    GL_CHECK_ERR(glUniform4fv(shader.uniform("uLightColor"), 1, (float*)&lighting.lightColor));
+    GL_CHECK_ERR(glUniform4fv(shader.uniform("uColorAdd"), 1, (float*)&lighting.colorAdd));
 }
 
 constexpr Vector4 defaultBrightness = {1.f, 1.f, 1.f, 1.f};
@@ -1010,6 +1061,9 @@ void glBeginCamera(view_t* camera, bool useHDR)
     uploadUniforms(voxelShader, (float*)&proj, (float*)&view, (float*)&mapDims);
     uploadUniforms(voxelBrightShader, (float*)&proj, (float*)&view, nullptr);
     uploadUniforms(voxelDitheredShader, (float*)&proj, (float*)&view, (float*)&mapDims);
+    if (voxelInstancingSupported) {
+        uploadUniforms(voxelInstancedShader, (float*)&proj, (float*)&view, (float*)&mapDims);
+    }
     uploadUniforms(worldShader, (float*)&proj, (float*)&view, (float*)&mapDims);
     uploadUniforms(worldDitheredShader, (float*)&proj, (float*)&view, (float*)&mapDims);
     uploadUniforms(worldDarkShader, (float*)&proj, (float*)&view, nullptr);
@@ -1018,6 +1072,9 @@ void glBeginCamera(view_t* camera, bool useHDR)
     uploadUniforms(spriteDitheredShader, (float*)&proj, (float*)&view, (float*)&mapDims);
     uploadUniforms(spriteBrightShader, (float*)&proj, (float*)&view, nullptr);
     uploadUniforms(spriteUIShader, (float*)&proj, (float*)&view, nullptr);
+    if (spriteInstancingSupported) {
+        uploadUniforms(spriteInstancedShader, (float*)&proj, (float*)&view, (float*)&mapDims);
+    }
 }
 
 #include <thread>
@@ -1154,13 +1211,31 @@ void glEndCamera(view_t* camera, bool useHDR)
     ++camera->drawnFrames;
 }
 
-void glDrawVoxel(view_t* camera, Entity* entity, int mode) {
-	if (!camera || !entity) {
-		return;
-	}
+// voxel models sharing a model index and color remap are collected while
+// drawEntities3D() walks the entity list, then submitted with one instanced
+// draw per bucket. models that need special GL state (hud models, telepathy,
+// dithering, bright models) are still drawn immediately.
+static constexpr int VOXEL_INSTANCES_PER_DRAW = 32; // must match voxelInstancedShader
+
+struct VoxelInstance {
+    mat4x4_t model;
+    vec4_t lightFactor;
+    vec4_t lightColor;
+    vec4_t colorAdd;
+};
 
-	// select model
-    voxel_t* model = nullptr;
+static struct VoxelBatch {
+    bool active = false;
+    view_t* camera = nullptr;
+    int mode = REALCOLORS;
+    std::unordered_map<Uint32, std::vector<VoxelInstance>> buckets; // key = (model index << 3) | color remap
+} voxelBatch;
+
+#ifndef EDITOR
+static ConsoleVariable<bool> cvar_voxelInstancing("/voxel_instancing", true, "draw repeated voxel models with instanced draws");
+#endif
+
+static int getVoxelModelIndex(Entity* entity) {
     int modelindex = -1;
 #ifndef EDITOR
 	static ConsoleVariable<int> cvar_forceModel("/forcemodel", -1, "force all voxel models to use a specific index");
@@ -1169,25 +1244,148 @@ void glDrawVoxel(view_t* camera, Entity* entity, int mode) {
 	if (modelindex < 0) {
 		modelindex = entity->sprite;
 	}
-	if (modelindex >= 0 && modelindex < nummodels) {
-		if (models[modelindex] != NULL) {
-			model = models[modelindex];
-		} else {
-			model = models[0];
-		}
-	} else {
-		model = models[0];
-		modelindex = 0;
+	if (modelindex < 0 || modelindex >= nummodels) {
+		return -1;
 	}
-	if (!model || model == models[0]) {
-		return; // don't draw green balls
+	if (models[modelindex] == nullptr || models[modelindex] == models[0]) {
+		return -1; // don't draw green balls
 	}
+	return modelindex;
+}
+
+static void getVoxelModelMatrix(view_t* camera, Entity* entity, mat4x4_t& m) {
+    mat4x4_t t, i;
+    vec4_t v;
     
-    // set GL state
-	if (mode == REALCOLORS) {
+    float rotx, roty, rotz;
+    if (entity->flags[OVERDRAW]) {
+        v = vec4(camera->x * 32, -camera->z, camera->y * 32, 0);
+        (void)translate_mat(&m, &t, &v); t = m;
+        rotx = 0; // roll
+        roty = 360.0 - camera->ang * 180.0 / PI; // yaw
+        rotz = 360.0 - camera->vang * 180.0 / PI; // pitch
+        (void)rotate_mat(&m, &t, roty, &i.y); t = m; // yaw
+        (void)rotate_mat(&m, &t, rotz, &i.z); t = m; // pitch
+        (void)rotate_mat(&m, &t, rotx, &i.x); t = m; // roll
+    }
+    rotx = entity->roll * 180.0 / PI; // roll
+    roty = 360.0 - entity->yaw * 180.0 / PI; // yaw
+    rotz = 360.0 - entity->pitch * 180.0 / PI; // pitch
+    v = vec4(entity->x * 2.f, -entity->z * 2.f - 1, entity->y * 2.f, 0.f);
+    (void)translate_mat(&m, &t, &v); t = m;
+    (void)rotate_mat(&m, &t, roty, &i.y); t = m; // yaw
+    (void)rotate_mat(&m, &t, rotz, &i.z); t = m; // pitch
+    (void)rotate_mat(&m, &t, rotx, &i.x); t = m; // roll
+    v = vec4(entity->focalx * 2.f, -entity->focalz * 2.f, entity->focaly * 2.f, 0.f);
+    (void)translate_mat(&m, &t, &v); t = m;
+    v = vec4(entity->scalex, entity->scaley, entity->scalez, 0.f);
+    (void)scale_mat(&m, &t, &v); t = m;
+}
+
+static void bindPolyModel(int modelindex) {
+#ifdef VERTEX_ARRAYS_ENABLED
+    GL_CHECK_ERR(glBindVertexArray(polymodels[modelindex].vao));
+#else
+    GL_CHECK_ERR(glBindBuffer(GL_ARRAY_BUFFER, polymodels[modelindex].vbo));
+    GL_CHECK_ERR(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr));
+    GL_CHECK_ERR(glEnableVertexAttribArray(0));
+    
+    GL_CHECK_ERR(glBindBuffer(GL_ARRAY_BUFFER, polymodels[modelindex].colors));
+    GL_CHECK_ERR(glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, nullptr));
+    GL_CHECK_ERR(glEnableVertexAttribArray(1));
+    
+    GL_CHECK_ERR(glBindBuffer(GL_ARRAY_BUFFER, polymodels[modelindex].normals));
+    GL_CHECK_ERR(glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, nullptr));
+    GL_CHECK_ERR(glEnableVertexAttribArray(2));
+#endif
+}
+
+static void unbindPolyModel() {
+#ifndef VERTEX_ARRAYS_ENABLED
+    GL_CHECK_ERR(glDisableVertexAttribArray(0));
+    GL_CHECK_ERR(glDisableVertexAttribArray(1));
+    GL_CHECK_ERR(glDisableVertexAttribArray(2));
+#endif
+}
+
+void glBeginVoxelBatch(view_t* camera, int mode) {
+#ifdef EDITOR
+    const bool instancing = true;
+#else
+    const bool instancing = *cvar_voxelInstancing;
+#endif
+    voxelBatch.active = camera && instancing && voxelInstancingSupported;
+    voxelBatch.camera = camera;
+    voxelBatch.mode = mode;
+}
+
+void glEndVoxelBatch() {
+    if (!voxelBatch.active) {
+        return;
+    }
+    voxelBatch.active = false;
+    view_t* camera = voxelBatch.camera;
+    
+    auto& shader = voxelInstancedShader;
+    shader.bind();
+    if (voxelBatch.mode == REALCOLORS) {
         GL_CHECK_ERR(glEnable(GL_BLEND));
+    }
+    const float cameraPos[4] = {(float)camera->x * 32.f, -(float)camera->z, (float)camera->y * 32.f, 1.f};
+    GL_CHECK_ERR(glUniform4fv(shader.uniform("uCameraPos"), 1, cameraPos));
+    
+    mat4x4_t models[VOXEL_INSTANCES_PER_DRAW];
+    vec4_t lightFactors[VOXEL_INSTANCES_PER_DRAW];
+    vec4_t lightColors[VOXEL_INSTANCES_PER_DRAW];
+    vec4_t colorAdds[VOXEL_INSTANCES_PER_DRAW];
+    for (auto& pair : voxelBatch.buckets) {
+        auto& instances = pair.second;
+        if (instances.empty()) {
+            continue;
+        }
+        const int modelindex = (int)(pair.first >> 3);
+        const mat4x4_t remap = getColorRemap((ColorRemap)(pair.first & 7));
+        GL_CHECK_ERR(glUniformMatrix4fv(shader.uniform("uColorRemap"), 1, false, (float*)&remap));
+        
+        bindPolyModel(modelindex);
+        const int numVertices = (int)(3 * polymodels[modelindex].numfaces);
+        for (size_t start = 0; start < instances.size(); start += VOXEL_INSTANCES_PER_DRAW) {
+            const int count = (int)std::min(instances.size() - start, (size_t)VOXEL_INSTANCES_PER_DRAW);
+            for (int c = 0; c < count; ++c) {
+                const auto& instance = instances[start + c];
+                models[c] = instance.model;
+                lightFactors[c] = instance.lightFactor;
+                lightColors[c] = instance.lightColor;
+                colorAdds[c] = instance.colorAdd;
+            }
+            GL_CHECK_ERR(glUniformMatrix4fv(shader.uniform("uModels"), count, false, (float*)models));
+            GL_CHECK_ERR(glUniform4fv(shader.uniform("uLightFactors"), count, (float*)lightFactors));
+            GL_CHECK_ERR(glUniform4fv(shader.uniform("uLightColors"), count, (float*)lightColors));
+            GL_CHECK_ERR(glUniform4fv(shader.uniform("uColorAdds"), count, (float*)colorAdds));
+            GL_CHECK_ERR(glDrawArraysInstanced(GL_TRIANGLES, 0, numVertices, count));
+            ++drawStats.voxelBatchDrawCalls;
+            drawStats.voxelInstances += count;
+        }
+        unbindPolyModel();
+        instances.clear(); // keep the capacity for next frame
+    }
+    
+    if (voxelBatch.mode == REALCOLORS) {
+        GL_CHECK_ERR(glDisable(GL_BLEND));
+    }
+}
+
+void glDrawVoxel(view_t* camera, Entity* entity, int mode) {
+	if (!camera || !entity) {
+		return;
 	}
 
+	// select model
+    const int modelindex = getVoxelModelIndex(entity);
+    if (modelindex < 0) {
+        return;
+    }
+
     int player = -1;
     for ( player = 0; player < MAXPLAYERS; ++player ) {
         if ( &cameras[player] == camera ) {
@@ -1204,17 +1402,37 @@ void glDrawVoxel(view_t* camera, Entity* entity, int mode) {
             && stats[player]->mask && stats[player]->mask->type == TOOL_BLINDFOLD_TELEPATHY);
 #endif
 
-    bool changedDepthRange = false;
-	if (entity->flags[OVERDRAW] 
+    const bool changeDepthRange = entity->flags[OVERDRAW]
         || telepath
-		|| modelindex == FOLLOWER_SELECTED_PARTICLE
-		|| modelindex == FOLLOWER_TARGET_PARTICLE ) {
-        changedDepthRange = true;
+        || modelindex == FOLLOWER_SELECTED_PARTICLE
+        || modelindex == FOLLOWER_TARGET_PARTICLE;
+    
+    // queue plain models for instanced drawing
+    auto& dither = entity->dithering[camera];
+    if (voxelBatch.active && voxelBatch.camera == camera && voxelBatch.mode == mode
+        && !changeDepthRange && !entity->flags[BRIGHT]
+        && dither.value >= Entity::Dither::MAX) {
+        EntityLighting lighting;
+        getEntityLighting(camera, entity, mode, lighting);
+        auto& bucket = voxelBatch.buckets[((Uint32)modelindex << 3) | (Uint32)lighting.remap];
+        bucket.emplace_back();
+        auto& instance = bucket.back();
+        getVoxelModelMatrix(camera, entity, instance.model);
+        instance.lightFactor = lighting.lightFactor;
+        instance.lightColor = lighting.lightColor;
+        instance.colorAdd = lighting.colorAdd;
+        return;
+    }
+    
+    // set GL state
+	if (mode == REALCOLORS) {
+        GL_CHECK_ERR(glEnable(GL_BLEND));
+	}
+	if (changeDepthRange) {
         GL_CHECK_ERR(glDepthRange(0, 0.1));
 	}
     
     // bind shader
-    auto& dither = entity->dithering[camera];
     auto& shader = !entity->flags[BRIGHT] && !telepath ?
         (dither.value < Entity::Dither::MAX ? voxelDitheredShader : voxelShader):
         voxelBrightShader;
@@ -1226,34 +1444,12 @@ void glDrawVoxel(view_t* camera, Entity* entity, int mode) {
             (float)((uint32_t)1 << (dither.value - 1)) / (1 << (Entity::Dither::MAX / 2 - 1))));
     }
     
-    mat4x4_t m, t, i;
-    vec4_t v;
-    
     // model matrix
-    float rotx, roty, rotz;
+    mat4x4_t m;
+    getVoxelModelMatrix(camera, entity, m);
     if (entity->flags[OVERDRAW]) {
-        v = vec4(camera->x * 32, -camera->z, camera->y * 32, 0);
-        (void)translate_mat(&m, &t, &v); t = m;
-        rotx = 0; // roll
-        roty = 360.0 - camera->ang * 180.0 / PI; // yaw
-        rotz = 360.0 - camera->vang * 180.0 / PI; // pitch
-        (void)rotate_mat(&m, &t, roty, &i.y); t = m; // yaw
-        (void)rotate_mat(&m, &t, rotz, &i.z); t = m; // pitch
-        (void)rotate_mat(&m, &t, rotx, &i.x); t = m; // roll
         GL_CHECK_ERR(glUniformMatrix4fv(shader.uniform("uProj"), 1, false, (float*)&camera->proj_hud));
     }
-    rotx = entity->roll * 180.0 / PI; // roll
-    roty = 360.0 - entity->yaw * 180.0 / PI; // yaw
-    rotz = 360.0 - entity->pitch * 180.0 / PI; // pitch
-    v = vec4(entity->x * 2.f, -entity->z * 2.f - 1, entity->y * 2.f, 0.f);
-    (void)translate_mat(&m, &t, &v); t = m;
-    (void)rotate_mat(&m, &t, roty, &i.y); t = m; // yaw
-    (void)rotate_mat(&m, &t, rotz, &i.z); t = m; // pitch
-    (void)rotate_mat(&m, &t, rotx, &i.x); t = m; // roll
-    v = vec4(entity->focalx * 2.f, -entity->focalz * 2.f, entity->focaly * 2.f, 0.f);
-    (void)translate_mat(&m, &t, &v); t = m;
-    v = vec4(entity->scalex, entity->scaley, entity->scalez, 0.f);
-    (void)scale_mat(&m, &t, &v); t = m;
     GL_CHECK_ERR(glUniformMatrix4fv(shader.uniform("uModel"), 1, false, (float*)&m)); // model matrix
     
     // upload light variables
@@ -1274,37 +1470,16 @@ void glDrawVoxel(view_t* camera, Entity* entity, int mode) {
     }
     
     // draw mesh
-#ifdef VERTEX_ARRAYS_ENABLED
-    GL_CHECK_ERR(glBindVertexArray(polymodels[modelindex].vao));
-#else
-    GL_CHECK_ERR(glBindBuffer(GL_ARRAY_BUFFER, polymodels[modelindex].vbo));
-    GL_CHECK_ERR(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr));
-    GL_CHECK_ERR(glEnableVertexAttribArray(0));
-    
-    GL_CHECK_ERR(glBindBuffer(GL_ARRAY_BUFFER, polymodels[modelindex].colors));
-    GL_CHECK_ERR(glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, nullptr));
-    GL_CHECK_ERR(glEnableVertexAttribArray(1));
-    
-    GL_CHECK_ERR(glBindBuffer(GL_ARRAY_BUFFER, polymodels[modelindex].normals));
-    GL_CHECK_ERR(glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, nullptr));
-    GL_CHECK_ERR(glEnableVertexAttribArray(2));
-#endif
-    
+    bindPolyModel(modelindex);
     GL_CHECK_ERR(glDrawArrays(GL_TRIANGLES, 0, (int)(3 * polymodels[modelindex].numfaces)));
-    
-#ifdef VERTEX_ARRAYS_ENABLED
-    GL_CHECK_ERR(glBindVertexArray(polymodels[modelindex].vao));
-#else
-    GL_CHECK_ERR(glDisableVertexAttribArray(0));
-    GL_CHECK_ERR(glDisableVertexAttribArray(1));
-    GL_CHECK_ERR(glDisableVertexAttribArray(2));
-#endif
+    unbindPolyModel();
+    ++drawStats.voxelDrawCalls;
     
     // reset GL state
     if (entity->flags[OVERDRAW]) {
         GL_CHECK_ERR(glUniformMatrix4fv(shader.uniform("uProj"), 1, false, (float*)&camera->proj));
     }
-    if (changedDepthRange) {
+    if (changeDepthRange) {
         GL_CHECK_ERR(glDepthRange(0, 1));
     }
     if (mode == REALCOLORS) {
@@ -1348,6 +1523,7 @@ static ConsoleVariable<float> cvar_ulight_factor_mult("/sprite_ulight_factor_mul
 
 void glDrawEnemyBarSprite(view_t* camera, int mode, int playerViewport, void* enemyHPBarDetails)
 {
+    glFlushSpriteBatch();
 #ifndef EDITOR
     if (!camera || mode != REALCOLORS || !enemyHPBarDetails) {
 		return;
@@ -1446,6 +1622,7 @@ void glDrawEnemyBarSprite(view_t* camera, int mode, int playerViewport, void* en
 
 void glDrawWorldDialogueSprite(view_t* camera, void* worldDialogue, int mode)
 {
+    glFlushSpriteBatch();
 #ifndef EDITOR
 	if (!camera || !worldDialogue || mode != REALCOLORS) {
 		return;
@@ -1554,6 +1731,7 @@ void glDrawWorldDialogueSprite(view_t* camera, void* worldDialogue, int mode)
 
 void glDrawWorldUISprite(view_t* camera, Entity* entity, int mode)
 {
+    glFlushSpriteBatch();
 #ifndef EDITOR
 	if (!camera || !entity || intro) {
 		return;
@@ -1691,9 +1869,107 @@ void glDrawWorldUISprite(view_t* camera, Entity* entity, int mode)
 #endif
 }
 
+// consecutive sprites in the back-to-front sprite pass that share a texture
+// are collected here and submitted as one instanced draw, so draw order is
+// unchanged. sprites needing their own GL state are drawn immediately, and
+// every other sprite-pass draw flushes the pending run first.
+static constexpr int SPRITE_INSTANCES_PER_DRAW = 32; // must match spriteInstancedShader
+
+static struct SpriteBatch {
+    bool active = false;
+    view_t* camera = nullptr;
+    int mode = REALCOLORS;
+    GLuint texture = 0;
+    float lightmapWeight = 1.f;
+    int count = 0;
+    mat4x4_t models[SPRITE_INSTANCES_PER_DRAW];
+    vec4_t lightFactors[SPRITE_INSTANCES_PER_DRAW];
+    vec4_t lightColors[SPRITE_INSTANCES_PER_DRAW];
+    vec4_t colorAdds[SPRITE_INSTANCES_PER_DRAW];
+} spriteBatch;
+
+#ifndef EDITOR
+static ConsoleVariable<bool> cvar_spriteInstancing("/sprite_instancing", true, "draw runs of sprites sharing a texture with instanced draws");
+#endif
+
+static void glFlushSpriteBatch() {
+    if (!spriteBatch.count) {
+        return;
+    }
+    view_t* camera = spriteBatch.camera;
+    auto& shader = spriteInstancedShader;
+    shader.bind();
+    GL_CHECK_ERR(glBindTexture(GL_TEXTURE_2D, spriteBatch.texture));
+    if (spriteBatch.mode == REALCOLORS) {
+        GL_CHECK_ERR(glEnable(GL_BLEND));
+    }
+    const float cameraPos[4] = {(float)camera->x * 32.f, -(float)camera->z, (float)camera->y * 32.f, 1.f};
+    GL_CHECK_ERR(glUniform4fv(shader.uniform("uCameraPos"), 1, cameraPos));
+    GL_CHECK_ERR(glUniform1f(shader.uniform("uLightmapWeight"), spriteBatch.lightmapWeight));
+    const int count = spriteBatch.count;
+    GL_CHECK_ERR(glUniformMatrix4fv(shader.uniform("uModels"), count, false, (float*)spriteBatch.models));
+    GL_CHECK_ERR(glUniform4fv(shader.uniform("uLightFactors"), count, (float*)spriteBatch.lightFactors));
+    GL_CHECK_ERR(glUniform4fv(shader.uniform("uLightColors"), count, (float*)spriteBatch.lightColors));
+    GL_CHECK_ERR(glUniform4fv(shader.uniform("uColorAdds"), count, (float*)spriteBatch.colorAdds));
+    spriteMesh.draw(GL_TRIANGLES, 0, count);
+    drawStats.spriteInstances += count;
+    if (spriteBatch.mode == REALCOLORS) {
+        GL_CHECK_ERR(glDisable(GL_BLEND));
+    }
+    spriteBatch.count = 0;
+}
+
+void glBeginSpriteBatch(view_t* camera, int mode) {
+    glFlushSpriteBatch();
+#ifdef EDITOR
+    const bool instancing = true;
+#else
+    const bool instancing = *cvar_spriteInstancing;
+#endif
+    spriteBatch.active = camera && instancing && spriteInstancingSupported;
+    spriteBatch.camera = camera;
+    spriteBatch.mode = mode;
+}
+
+void glEndSpriteBatch() {
+    glFlushSpriteBatch();
+    spriteBatch.active = false;
+}
+
+static void getSpriteModelMatrix(view_t* camera, Entity* entity, float w, float h, mat4x4_t& m) {
+    vec4_t v;
+    mat4x4_t t, i;
+    if (entity->flags[OVERDRAW]) {
+        v = vec4(camera->x * 32, -camera->z, camera->y * 32, 0);
+        (void)translate_mat(&m, &t, &v); t = m;
+        const float rotx = 0; // roll
+        const float roty = 360.0 - camera->ang * 180.0 / PI; // yaw
+        const float rotz = 360.0 - camera->vang * 180.0 / PI; // pitch
+        (void)rotate_mat(&m, &t, roty, &i.y); t = m; // yaw
+        (void)rotate_mat(&m, &t, rotz, &i.z); t = m; // pitch
+        (void)rotate_mat(&m, &t, rotx, &i.x); t = m; // roll
+    }
+    v = vec4(entity->x * 2.f, -entity->z * 2.f - 1, entity->y * 2.f, 0.f);
+    (void)translate_mat(&m, &t, &v); t = m;
+    (void)rotate_mat(&m, &t, entity->flags[OVERDRAW] ? -90.f :
+        -90.f - camera->ang * (180.f / PI), &i.y); t = m;
+    v = vec4(entity->focalx * 2.f, -entity->focalz * 2.f, entity->focaly * 2.f, 0.f);
+    (void)translate_mat(&m, &t, &v); t = m;
+    v = vec4(entity->scalex * w, entity->scaley * h, entity->scalez, 0.f);
+    (void)scale_mat(&m, &t, &v); t = m;
+}
+
+static float getBrightSpriteLevel(view_t* camera) {
+#ifndef EDITOR
+    return std::max(*MainMenu::cvar_hdrEnabled ? *cvar_ulight_factor_min : 1.f, camera->luminance * *cvar_ulight_factor_mult);
+#else
+    return std::max(0.5f, camera->luminance * 4.f);
+#endif
+}
+
 void glDrawSprite(view_t* camera, Entity* entity, int mode)
 {
-    // bind texture
+    // select texture
     SDL_Surface* sprite;
     if (entity->sprite >= 0 && entity->sprite < numsprites) {
         if (sprites[entity->sprite] != nullptr) {
@@ -1704,7 +1980,41 @@ void glDrawSprite(view_t* camera, Entity* entity, int mode)
     } else {
         sprite = sprites[0];
     }
-    GL_CHECK_ERR(glBindTexture(GL_TEXTURE_2D, texid[(long int)sprite->userdata]));
+    const GLuint texture = texid[(long int)sprite->userdata];
+    auto& dither = entity->dithering[camera];
+    
+    // add to the current run of instanced sprites
+    if (spriteBatch.active && spriteBatch.camera == camera && spriteBatch.mode == mode
+        && !entity->flags[OVERDRAW] && dither.value >= Entity::Dither::MAX) {
+        const float lightmapWeight = entity->flags[BRIGHT] ? 0.f : 1.f;
+        if (spriteBatch.texture != texture || spriteBatch.lightmapWeight != lightmapWeight) {
+            glFlushSpriteBatch();
+            spriteBatch.texture = texture;
+            spriteBatch.lightmapWeight = lightmapWeight;
+        }
+        const int index = spriteBatch.count++;
+        getSpriteModelMatrix(camera, entity, sprite->w, sprite->h, spriteBatch.models[index]);
+        if (entity->flags[BRIGHT]) {
+            const float b = getBrightSpriteLevel(camera);
+            spriteBatch.lightFactors[index] = vec4_t(1.f);
+            spriteBatch.lightColors[index] = vec4_t(b, b, b, 1.f);
+            spriteBatch.colorAdds[index] = vec4_t(0.f);
+        } else {
+            EntityLighting lighting;
+            getEntityLighting(camera, entity, mode, lighting);
+            spriteBatch.lightFactors[index] = lighting.lightFactor;
+            spriteBatch.lightColors[index] = lighting.lightColor;
+            spriteBatch.colorAdds[index] = lighting.colorAdd;
+        }
+        if (spriteBatch.count == SPRITE_INSTANCES_PER_DRAW) {
+            glFlushSpriteBatch();
+        }
+        return;
+    }
+    glFlushSpriteBatch();
+    
+    // bind texture
+    GL_CHECK_ERR(glBindTexture(GL_TEXTURE_2D, texture));
     
     // set GL state
     if (mode == REALCOLORS) {
@@ -1715,7 +2025,6 @@ void glDrawSprite(view_t* camera, Entity* entity, int mode)
     }
     
     // bind shader
-    auto& dither = entity->dithering[camera];
     auto& shader = !entity->flags[BRIGHT] ?
         (dither.value < Entity::Dither::MAX ? spriteDitheredShader : spriteShader):
         spriteBrightShader;
@@ -1727,38 +2036,17 @@ void glDrawSprite(view_t* camera, Entity* entity, int mode)
             (float)((uint32_t)1 << (dither.value - 1)) / (1 << (Entity::Dither::MAX / 2 - 1))));
     }
     
-    vec4_t v;
-    mat4x4_t m, t, i;
-    
     // model matrix
+    mat4x4_t m;
+    getSpriteModelMatrix(camera, entity, sprite->w, sprite->h, m);
     if (entity->flags[OVERDRAW]) {
-        v = vec4(camera->x * 32, -camera->z, camera->y * 32, 0);
-        (void)translate_mat(&m, &t, &v); t = m;
-        const float rotx = 0; // roll
-        const float roty = 360.0 - camera->ang * 180.0 / PI; // yaw
-        const float rotz = 360.0 - camera->vang * 180.0 / PI; // pitch
-        (void)rotate_mat(&m, &t, roty, &i.y); t = m; // yaw
-        (void)rotate_mat(&m, &t, rotz, &i.z); t = m; // pitch
-        (void)rotate_mat(&m, &t, rotx, &i.x); t = m; // roll
         GL_CHECK_ERR(glUniformMatrix4fv(shader.uniform("uProj"), 1, false, (float*)&camera->proj_hud));
     }
-    v = vec4(entity->x * 2.f, -entity->z * 2.f - 1, entity->y * 2.f, 0.f);
-    (void)translate_mat(&m, &t, &v); t = m;
-    (void)rotate_mat(&m, &t, entity->flags[OVERDRAW] ? -90.f :
-        -90.f - camera->ang * (180.f / PI), &i.y); t = m;
-    v = vec4(entity->focalx * 2.f, -entity->focalz * 2.f, entity->focaly * 2.f, 0.f);
-    (void)translate_mat(&m, &t, &v); t = m;
-    v = vec4(entity->scalex * sprite->w, entity->scaley * sprite->h, entity->scalez, 0.f);
-    (void)scale_mat(&m, &t, &v); t = m;
     GL_CHECK_ERR(glUniformMatrix4fv(shader.uniform("uModel"), 1, false, (float*)&m)); // model matrix
     
     // upload light variables
     if (entity->flags[BRIGHT]) {
-#ifndef EDITOR
-        const float b = std::max(*MainMenu::cvar_hdrEnabled ? *cvar_ulight_factor_min : 1.f, camera->luminance * *cvar_ulight_factor_mult);
-#else
-        const float b = std::max(0.5f, camera->luminance * 4.f);
-#endif
+        const float b = getBrightSpriteLevel(camera);
         const GLfloat factor[4] = { 1.f, 1.f, 1.f, 1.f };
         GL_CHECK_ERR(glUniform4fv(shader.uniform("uLightFactor"), 1, factor));
         const GLfloat light[4] = { b, b, b, 1.f };
@@ -1792,6 +2080,7 @@ static ConsoleVariable<GLfloat> cvar_dmgSpriteDepthRange("/dmg_sprite_depth_rang
 
 void glDrawSpriteFromImage(view_t* camera, Entity* entity, std::string text, int mode)
 {
+    glFlushSpriteBatch();
 	if (!camera || !entity || text.empty()) {
 		return;
 	}
@@ -1989,6 +2278,7 @@ static ConsoleVariable<bool> cvar_allowChunkRebuild("/allow_chunk_rebuild", true
 
 void glDrawWorld(view_t* camera, int mode)
 {
+    PROFILE_ZONE("glDrawWorld");
 #ifndef EDITOR
     static ConsoleVariable<bool> cvar_skipDrawWorld("/skipdrawworld", false);
     if (*cvar_skipDrawWorld) {
@@ -2029,10 +2319,8 @@ void glDrawWorld(view_t* camera, int mode)
     
     const bool ditheringDisabled = ticks - ditherDisabledTime < TICKS_PER_SECOND;
     
-    // update chunk dithering & mark chunks for rebuilding
-    std::set<std::pair<int, Chunk*>> chunksToBuild;
-    for (int index = 0; index < chunks.size(); ++index) {
-        auto& chunk = chunks[index];
+    // update chunk dithering
+    for (auto& chunk : chunks) {
         auto& dither = chunk.dithering[camera];
         if (ticks != dither.lastUpdateTick) {
             dither.lastUpdateTick = ticks;
@@ -2055,58 +2343,6 @@ void glDrawWorld(view_t* camera, int mode)
             }
         end:;
         }
-        if (dither.value) {
-            if (chunk.isDirty(map)) {
-                chunksToBuild.emplace(0, &chunk);
-            }
-        }
-    }
-    
-    // mark chunk neighbors for building (in-case of shared walls)
-    const int dim = 4; // size of chunk in tiles
-    const int yoff = 1;
-    const int xoff = (map.height / dim) + ((map.height % dim) ? 1 : 0);
-    for (auto it = chunksToBuild.begin(); it != chunksToBuild.end();) {
-        const int index = it->first;
-        bool foundDirtyNeighbor = false; // call the police
-        for (int x = -xoff; x <= xoff; x += xoff) {
-            for (int y = -yoff; y <= yoff; y += yoff) {
-                if ((x && y) || (!x && !y)) {
-                    continue;
-                }
-                const int off = index + x + y;
-                if (off < 0 || off >= chunks.size()) {
-                    continue;
-                }
-                auto& neighbor = chunks[off];
-                if (chunksToBuild.emplace(off, &neighbor).second) {
-                    if (neighbor.isDirty(map)) {
-                        // if this neighbor chunk needs rebuilding,
-                        // it's possible _its_ neighbors need rebuilding too.
-                        // therefore, restart the search for adjacent chunks.
-                        it = chunksToBuild.begin();
-                        foundDirtyNeighbor = true;
-                    }
-                }
-            }
-        }
-        if (!foundDirtyNeighbor) {
-            ++it;
-        }
-    }
-    
-#ifdef EDITOR
-    constexpr bool allowChunkRebuild = true;
-#else
-    const bool allowChunkRebuild = *cvar_allowChunkRebuild;
-#endif
-    
-    // build chunks
-    if (allowChunkRebuild) {
-        for (auto& pair : chunksToBuild) {
-            auto& chunk = *pair.second;
-            chunk.build(map, !clouds, chunk.x, chunk.y, chunk.w, chunk.h);
-        }
     }
     
     // draw chunks
@@ -2257,7 +2493,7 @@ void GO_SwapBuffers(SDL_Window* screen)
     }
 }
 
-static float chunkTexCoords[3];
+static thread_local float chunkTexCoords[3]; // chunk meshes are built on worker threads
 static inline void makeTexCoords(float x, float y, float tile) {
 #define fdivf(A, B) A / B
     constexpr float dim = 32.f;
@@ -2265,10 +2501,10 @@ static inline void makeTexCoords(float x, float y, float tile) {
     chunkTexCoords[1] = floorf(fdivf(tile, dim) + y) / dim;
 }
 
-void Chunk::build(const map_t& map, bool ceiling, int startX, int startY, int w, int h) {
-    std::vector<float> positions;
-    std::vector<float> texcoords;
-    std::vector<float> colors;
+static void buildChunkMesh(const ChunkMapSnapshot& map, bool ceiling, int startX, int startY, int w, int h, ChunkMesh& mesh) {
+    auto& positions = mesh.positions;
+    auto& texcoords = mesh.texcoords;
+    auto& colors = mesh.colors;
     
     positions.reserve(1200);
     texcoords.reserve(800);
@@ -2285,13 +2521,13 @@ void Chunk::build(const map_t& map, bool ceiling, int startX, int startY, int w,
     const int endY = std::min((int)map.height, startY + h);
     
     // copy tiles
-    this->x = startX;
-    this->y = startY;
-    this->w = endX - startX;
-    this->h = endY - startY;
-    const int sizeOfTiles = this->w * this->h * MAPLAYERS;
-    this->tiles.clear();
-    this->tiles.resize(sizeOfTiles);
+    mesh.x = startX;
+    mesh.y = startY;
+    mesh.w = endX - startX;
+    mesh.h = endY - startY;
+    const int sizeOfTiles = mesh.w * mesh.h * MAPLAYERS;
+    mesh.tiles.clear();
+    mesh.tiles.resize(sizeOfTiles);
     
     for (int x = startX; x < endX; ++x) {
         for (int y = startY; y < endY; ++y) {
@@ -2301,7 +2537,7 @@ void Chunk::build(const map_t& map, bool ceiling, int startX, int startY, int w,
                 // build walls
                 if (z >= 0 && z < MAPLAYERS) {
                     assert(index2 < sizeOfTiles);
-                    this->tiles[index2] = map.tiles[index];
+                    mesh.tiles[index2] = map.tiles[index];
                     ++index2;
                     
                     // skip empty tiles
@@ -2724,8 +2960,32 @@ void Chunk::build(const map_t& map, bool ceiling, int startX, int startY, int w,
             }
         }
     }
-    indices = (int)texcoords.size() / 2;
-    buildBuffers(positions, texcoords, colors);
+}
+
+ChunkMapSnapshot::ChunkMapSnapshot(const map_t& map) {
+    const size_t size = (size_t)map.width * map.height * MAPLAYERS;
+    data.assign(map.tiles, map.tiles + size);
+    tiles = data.data();
+    width = map.width;
+    height = map.height;
+    memcpy(flags, map.flags, sizeof(flags));
+}
+
+void Chunk::build(const map_t& map, bool ceiling, int startX, int startY, int w, int h) {
+    ChunkMapSnapshot snapshot(map);
+    ChunkMesh mesh;
+    buildChunkMesh(snapshot, ceiling, startX, startY, w, h, mesh);
+    apply(mesh);
+}
+
+void Chunk::apply(ChunkMesh& mesh) {
+    x = mesh.x;
+    y = mesh.y;
+    w = mesh.w;
+    h = mesh.h;
+    tiles.swap(mesh.tiles);
+    indices = (int)mesh.texcoords.size() / 2;
+    buildBuffers(mesh.positions, mesh.texcoords, mesh.colors);
     //printlog("built chunk with %d tris", indices);
 }
 
@@ -2818,6 +3078,7 @@ void Chunk::draw() {
 #endif
     
     GL_CHECK_ERR(glDrawArrays(GL_TRIANGLES, 0, indices));
+    ++drawStats.chunkDrawCalls;
     
 #ifndef VERTEX_ARRAYS_ENABLED
     GL_CHECK_ERR(glDisableVertexAttribArray(0));
@@ -2844,30 +3105,224 @@ bool Chunk::isDirty(const map_t& map) {
     return false;
 }
 
+static constexpr int chunkSize = 4; // size of chunk in tiles
+static std::atomic<Uint32> mapTilesGeneration{0};
+
+// chunk meshes are built by jobs running on worker threads, then uploaded by
+// the main thread a few at a time. results from before the chunk list was
+// last recreated are thrown away (see chunkEpoch).
+struct ChunkJobResult {
+    Uint32 epoch = 0;
+    std::vector<std::pair<int, ChunkMesh>> meshes; // chunk index, mesh
+};
+static std::vector<std::future<std::unique_ptr<ChunkJobResult>>> chunkJobs;
+static std::deque<std::pair<int, ChunkMesh>> chunkUploads;
+static Uint32 chunkEpoch = 0;
+static int chunkAuditIndex = 0;
+
+#ifndef EDITOR
+static ConsoleVariable<float> cvar_chunkUploadBudget("/chunk_upload_budget", 2.f, "milliseconds per frame spent uploading rebuilt chunks");
+static ConsoleVariable<int> cvar_chunkAudit("/chunk_audit", 4, "chunks per frame compared against the map to catch unreported tile changes");
+#endif
+
+static int getChunkRows() {
+    return (map.height / chunkSize) + ((map.height % chunkSize) ? 1 : 0);
+}
+
+static int getChunkIndex(int x, int y) {
+    if (x < 0 || y < 0 || x >= (int)map.width || y >= (int)map.height) {
+        return -1;
+    }
+    const int index = (x / chunkSize) * getChunkRows() + (y / chunkSize);
+    return index < (int)chunks.size() ? index : -1;
+}
+
+static void markChunkDirty(int index) {
+    // mark chunk neighbors too (in-case of shared walls)
+    const int yoff = 1;
+    const int xoff = getChunkRows();
+    for (int off : {0, -xoff, xoff, -yoff, yoff}) {
+        const int neighbor = index + off;
+        if (neighbor >= 0 && neighbor < (int)chunks.size()) {
+            chunks[neighbor].dirty = true;
+        }
+    }
+}
+
+void notifyTileChanged(int x, int y) {
+    // walls are shared with the surrounding tiles
+    for (int u = x - 1; u <= x + 1; ++u) {
+        for (int v = y - 1; v <= y + 1; ++v) {
+            const int index = getChunkIndex(u, v);
+            if (index >= 0) {
+                chunks[index].dirty = true;
+            }
+        }
+    }
+}
+
+void notifyMapTilesReplaced() {
+    ++mapTilesGeneration;
+}
+
+static std::unique_ptr<ChunkJobResult> runChunkJob(
+    std::shared_ptr<const ChunkMapSnapshot> snapshot, bool ceiling, Uint32 epoch,
+    std::vector<std::pair<int, ChunkMesh>> meshes)
+{
+    PROFILE_ZONE("runChunkJob");
+    auto result = std::unique_ptr<ChunkJobResult>(new ChunkJobResult);
+    result->epoch = epoch;
+    result->meshes.swap(meshes);
+    for (auto& pair : result->meshes) {
+        auto& mesh = pair.second;
+        buildChunkMesh(*snapshot, ceiling, mesh.x, mesh.y, mesh.w, mesh.h, mesh);
+    }
+    return result;
+}
+
+// splits the given chunks into one job per core
+static void startChunkJobs(const std::vector<int>& indices, bool ceiling) {
+    if (indices.empty()) {
+        return;
+    }
+    auto snapshot = std::make_shared<const ChunkMapSnapshot>(map);
+    const int cores = std::max(1, std::min((int)std::thread::hardware_concurrency(), (int)indices.size()));
+    const int perJob = ((int)indices.size() + cores - 1) / cores;
+    for (int start = 0; start < (int)indices.size(); start += perJob) {
+        std::vector<std::pair<int, ChunkMesh>> meshes;
+        for (int c = start; c < std::min(start + perJob, (int)indices.size()); ++c) {
+            auto& chunk = chunks[indices[c]];
+            meshes.emplace_back();
+            meshes.back().first = indices[c];
+            meshes.back().second.x = chunk.x;
+            meshes.back().second.y = chunk.y;
+            meshes.back().second.w = chunk.w;
+            meshes.back().second.h = chunk.h;
+            chunk.dirty = false;
+            chunk.building = true;
+        }
+        chunkJobs.emplace_back(std::async(std::launch::async, runChunkJob,
+            snapshot, ceiling, chunkEpoch, std::move(meshes)));
+    }
+}
+
+static void collectChunkJobs(bool wait) {
+    for (auto it = chunkJobs.begin(); it != chunkJobs.end();) {
+        auto& job = *it;
+        if (!wait && job.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            ++it;
+            continue;
+        }
+        auto result = job.get();
+        if (result->epoch == chunkEpoch) {
+            for (auto& pair : result->meshes) {
+                chunkUploads.emplace_back(std::move(pair));
+            }
+        }
+        it = chunkJobs.erase(it);
+    }
+}
+
+static void uploadChunkMeshes(float budgetMs) {
+    const auto start = std::chrono::high_resolution_clock::now();
+    while (!chunkUploads.empty()) {
+        auto& pair = chunkUploads.front();
+        if (pair.first < (int)chunks.size()) {
+            auto& chunk = chunks[pair.first];
+            chunk.apply(pair.second);
+            chunk.building = false;
+        }
+        chunkUploads.pop_front();
+        const auto elapsed = std::chrono::high_resolution_clock::now() - start;
+        if (std::chrono::duration<float, std::milli>(elapsed).count() >= budgetMs) {
+            break;
+        }
+    }
+}
+
+// compares a few chunks per frame against the map, in case something
+// changed tiles without calling notifyTileChanged(). the editor changes
+// tiles all over the place, so there every chunk is checked.
+static void auditChunks() {
+    if (chunks.empty()) {
+        return;
+    }
+#ifdef EDITOR
+    const int count = (int)chunks.size();
+#else
+    const int count = std::min((int)chunks.size(), std::max(0, *cvar_chunkAudit));
+#endif
+    for (int c = 0; c < count; ++c) {
+        chunkAuditIndex = (chunkAuditIndex + 1) % (int)chunks.size();
+        auto& chunk = chunks[chunkAuditIndex];
+        if (!chunk.dirty && !chunk.building && chunk.isDirty(map)) {
+            markChunkDirty(chunkAuditIndex);
+        }
+    }
+}
+
 void clearChunks() {
     chunks.clear();
+    chunkUploads.clear();
+    ++chunkEpoch; // drop results of jobs still running
 }
 
 void createChunks() {
-    constexpr int chunkSize = 4;
     chunks.reserve((map.width / chunkSize + 1) * (map.height / chunkSize + 1));
     for (int x = 0; x < map.width; x += chunkSize) {
         for (int y = 0; y < map.height; y += chunkSize) {
             chunks.emplace_back();
             auto& chunk = chunks.back();
-            chunk.build(map, !shouldDrawClouds(map), x, y, chunkSize, chunkSize);
+            chunk.x = x;
+            chunk.y = y;
+            chunk.w = chunkSize;
+            chunk.h = chunkSize;
         }
     }
+    
+    // build every chunk in parallel and wait for them
+    std::vector<int> indices(chunks.size());
+    for (int c = 0; c < (int)chunks.size(); ++c) {
+        indices[c] = c;
+    }
+    startChunkJobs(indices, !shouldDrawClouds(map));
+    collectChunkJobs(true);
+    uploadChunkMeshes(std::numeric_limits<float>::max());
 }
 
-void updateChunks() {
+static void updateChunks() {
     static int cachedW = -1;
     static int cachedH = -1;
-    if (cachedW != map.width || cachedH != map.height) {
+    static Uint32 cachedGeneration = 0;
+    const Uint32 generation = mapTilesGeneration;
+    if (cachedW != map.width || cachedH != map.height || cachedGeneration != generation) {
         cachedW = map.width;
         cachedH = map.height;
+        cachedGeneration = generation;
         clearChunks();
         createChunks();
+        return;
+    }
+    
+#ifdef EDITOR
+    constexpr bool allowChunkRebuild = true;
+    constexpr float uploadBudget = 2.f;
+#else
+    const bool allowChunkRebuild = *cvar_allowChunkRebuild;
+    const float uploadBudget = *cvar_chunkUploadBudget;
+#endif
+    
+    collectChunkJobs(false);
+    uploadChunkMeshes(uploadBudget);
+    if (allowChunkRebuild) {
+        auditChunks();
+        std::vector<int> indices;
+        for (int c = 0; c < (int)chunks.size(); ++c) {
+            if (chunks[c].dirty && !chunks[c].building) {
+                indices.push_back(c);
+            }
+        }
+        startChunkJobs(indices, !shouldDrawClouds(map, nullptr, false));
     }
 }
 
@@ -2884,4 +3339,15 @@ static ConsoleCommand ccmd_update_chunks("/updatechunks", "rebuilds all chunks",
     clearChunks();
     createChunks();
     });
+
+static ConsoleCommand ccmd_drawstats("/drawstats", "print draw calls and CPU time of the last frame",
+    [](int argc, const char* argv[]){
+    const auto& stats = drawStatsLastFrame;
+    messagePlayer(clientnum, MESSAGE_MISC, "voxels: %u draws, %u instanced draws (%u models)",
+        stats.voxelDrawCalls, stats.voxelBatchDrawCalls, stats.voxelInstances);
+    messagePlayer(clientnum, MESSAGE_MISC, "chunks: %u draws, meshes: %u draws (%u instanced sprites)",
+        stats.chunkDrawCalls, stats.meshDrawCalls, stats.spriteInstances);
+    messagePlayer(clientnum, MESSAGE_MISC, "entities: %.2f ms, frame: %.2f ms",
+        stats.entitiesMicroseconds / 1000.0, stats.frameMicroseconds / 1000.0);
+    });
 #endif
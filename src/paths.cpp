@@ -319,17 +319,22 @@ Uint32 heuristic(int x1, int y1, int x2, int y2)
 
 int pathCheckObstacle(int x, int y, Entity* my, Entity* target)
 {
-	const int u = std::min(std::max(0, x >> 4), (int)map.width - 1);
-	const int v = std::min(std::max(0, y >> 4), (int)map.height - 1);
-	const int index = v * MAPLAYERS + u * MAPLAYERS * map.height;
+	return pathCheckObstacle(map, x, y, my, target);
+}
+
+int pathCheckObstacle(const map_t& destmap, int x, int y, Entity* my, Entity* target)
+{
+	const int u = std::min(std::max(0, x >> 4), (int)destmap.width - 1);
+	const int v = std::min(std::max(0, y >> 4), (int)destmap.height - 1);
+	const int index = v * MAPLAYERS + u * MAPLAYERS * destmap.height;
 
-	if ( map.tiles[OBSTACLELAYER + index] || !map.tiles[index] || lavatiles[map.tiles[index]] )
+	if ( destmap.tiles[OBSTACLELAYER + index] || !destmap.tiles[index] || lavatiles[destmap.tiles[index]] )
 	{
 		return 1;
 	}
 
 	// entities not passable during this stage normally, hell generation makes entry gates passable
-	for ( node_t* node = map.entities->first; node != nullptr; node = node->next )
+	for ( node_t* node = destmap.entities->first; node != nullptr; node = node->next )
 	{
 		Entity* entity = (Entity*)node->element;
 		if (entity == my || entity == target)
@@ -395,6 +400,7 @@ static ConsoleVariable<bool> cvar_pathing_debug("/pathing_debug", false);
 int lastGeneratePathTries = 0;
 list_t* generatePath(int x1, int y1, int x2, int y2, Entity* my, Entity* target, GeneratePathTypes pathingType, bool lavaIsPassable)
 {
+	BENCHMARK_SCOPE(PATHING, "generatePath");
 	if ( *cvar_pathing_debug )
 	{
 		pathtime = std::chrono::high_resolution_clock::now();
@@ -850,6 +856,115 @@ list_t* generatePath(int x1, int y1, int x2, int y2, Entity* my, Entity* target,
 	return NULL;
 }
 
+/*-------------------------------------------------------------------------------
+
+	mapGenPathExists
+
+	the search generatePath() runs while a level is loading, for the map
+	generator: whether my could walk from x1, y1 to x2, y2 on destmap, which
+	needn't be the current map. same order of expansion and the same 10000
+	step limit, so it agrees with what generatePath() would have found
+
+-------------------------------------------------------------------------------*/
+
+bool mapGenPathExists(const map_t& destmap, int x1, int y1, int x2, int y2, Entity* my, Entity* target)
+{
+	x1 = std::min(std::max(0, x1), (int)destmap.width - 1);
+	y1 = std::min(std::max(0, y1), (int)destmap.height - 1);
+	x2 = std::min(std::max(0, x2), (int)destmap.width - 1);
+	y2 = std::min(std::max(0, y2), (int)destmap.height - 1);
+
+    struct queue_type {
+        int x, y;
+        std::unordered_map<pairtype, pathnode_t, pair_hash>& openSet;
+        bool operator>(const queue_type& rhs) const {
+            const auto find1 = openSet.find({x, y});
+            assert(find1 != openSet.end());
+            const auto& lhs_node = find1->second;
+            const auto find2 = rhs.openSet.find({rhs.x, rhs.y});
+            assert(find2 != openSet.end());
+            const auto& rhs_node = find2->second;
+            return lhs_node.g + lhs_node.h > rhs_node.g + rhs_node.h;
+        }
+        queue_type& operator=(const queue_type& rhs) {
+            x = rhs.x;
+            y = rhs.y;
+            return *this;
+        }
+    };
+    std::priority_queue<queue_type, std::vector<queue_type>, std::greater<queue_type>> queue;
+	std::unordered_map<pairtype, pathnode_t, pair_hash> openSet, closedSet;
+
+    const auto firstNode = pathnode_t{x1, y1, 0, heuristic(x1, y1, x2, y2), -1, -1};
+    openSet.insert({pairtype{firstNode.x, firstNode.y}, firstNode});
+	queue.push({x1, y1, openSet});
+	for ( int tries = 0; !openSet.empty() && tries < 10000; ++tries ) {
+        const auto key = queue.top(); queue.pop();
+		const auto find = openSet.find({key.x, key.y});
+        assert(find != openSet.end());
+        const auto pathnode = find->second;
+        openSet.erase({key.x, key.y});
+        closedSet.insert({{key.x, key.y}, pathnode});
+
+		if (pathnode.x == x2 && pathnode.y == y2) {
+			return true;
+		}
+
+		// expand search
+		for (int y = -1; y <= 1; y++) {
+			for (int x = -1; x <= 1; x++) {
+                const int newx = pathnode.x + x;
+                const int newy = pathnode.y + y;
+				if (x == 0 && y == 0) {
+					continue;
+				}
+				int z = 0;
+				if (pathCheckObstacle(destmap, (newx << 4) + 8, (newy << 4) + 8, my, target)) {
+					z++;
+				}
+				if (x && y) {
+					if (pathCheckObstacle(destmap, (pathnode.x << 4) + 8, (newy << 4) + 8, my, target)) {
+						z++;
+					}
+					if (pathCheckObstacle(destmap, (newx << 4) + 8, (pathnode.y << 4) + 8, my, target)) {
+						z++;
+					}
+				}
+				if (!z) {
+                    const auto key = pairtype{newx, newy};
+					bool alreadyadded = closedSet.find(key) != closedSet.end();
+                    auto find = openSet.find(key);
+					if (find != openSet.end()) {
+                        alreadyadded = true;
+						auto& childnode = find->second;
+                        if (x && y) {
+                            if (childnode.g > pathnode.g + DIAGONALCOST) {
+                                childnode.px = pathnode.x;
+                                childnode.py = pathnode.y;
+                                childnode.g = pathnode.g + DIAGONALCOST;
+                            }
+                        } else {
+                            if (childnode.g > pathnode.g + STRAIGHTCOST) {
+                                childnode.px = pathnode.x;
+                                childnode.py = pathnode.y;
+                                childnode.g = pathnode.g + STRAIGHTCOST;
+                            }
+                        }
+					}
+					if (alreadyadded == false) {
+                        const auto newNode = pathnode_t{newx, newy,
+                            (x && y) ? (pathnode.g + DIAGONALCOST) : (pathnode.g + STRAIGHTCOST),
+                            heuristic(newx, newy, x2, y2), pathnode.x, pathnode.y};
+                        openSet.insert({pairtype{newx, newy}, newNode});
+                        queue.push({newx, newy, openSet});
+					}
+				}
+			}
+		}
+	}
+	return false;
+}
+
 /*-------------------------------------------------------------------------------
 
 	generatePathMaps
@@ -49,4 +49,6 @@ void generatePathMaps();
 // return true if an entity is blocks pathing
 bool isPathObstacle(Entity* entity);
 int pathCheckObstacle(int x, int y, Entity* my, Entity* target);
+int pathCheckObstacle(const map_t& destmap, int x, int y, Entity* my, Entity* target);
+bool mapGenPathExists(const map_t& destmap, int x1, int y1, int x2, int y2, Entity* my, Entity* target); // for generating levels, see generateDungeon()
 void updateGatePath(Entity& entity);
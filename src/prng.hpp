@@ -21,6 +21,7 @@ public:
     BaronyRNG() = default;
     BaronyRNG(const BaronyRNG&) = default;
     BaronyRNG(BaronyRNG&&) = default;
+    BaronyRNG& operator=(const BaronyRNG&) = default;
     ~BaronyRNG() = default;
 
     void seedTime();                      // seed according to a 32-bit time value
@@ -0,0 +1,244 @@
+/*-------------------------------------------------------------------------------
+
+	BARONY
+	File: profiler.cpp
+	Desc: scoped-zone profiler with per-thread ring buffers
+
+	Copyright 2013-2016 (c) Turning Wheel LLC, all rights reserved.
+	See LICENSE for details.
+
+-------------------------------------------------------------------------------*/
+
+#include "main.hpp"
+#include "files.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace Profiler
+{
+	std::atomic<bool> recording{false};
+	std::atomic<uint32_t> generation{0};
+
+	static const auto epoch = std::chrono::steady_clock::now();
+	static constexpr uint64_t bufferSize = 1 << 17; // events kept per thread, oldest are overwritten
+
+	// each thread that records gets its own ring buffer, so recording
+	// never takes a lock. Buffers of threads that exit are handed to
+	// the next thread that starts recording (worker threads come and go).
+	struct ThreadBuffer
+	{
+		std::vector<Event> events;
+		std::atomic<uint64_t> written{0}; // total events ever written
+		uint32_t tid = 0;
+		bool main = false;
+		bool inUse = false;
+	};
+
+	static std::mutex buffersMutex;
+	static std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+	static const std::thread::id mainThread = std::this_thread::get_id();
+
+	struct ThreadSlot
+	{
+		ThreadBuffer* buffer = nullptr;
+		uint32_t depth = 0;
+		~ThreadSlot()
+		{
+			if (buffer)
+			{
+				std::lock_guard<std::mutex> lock(buffersMutex);
+				buffer->inUse = false;
+			}
+		}
+	};
+	static thread_local ThreadSlot slot;
+
+	static ThreadBuffer* acquireBuffer()
+	{
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		ThreadBuffer* result = nullptr;
+		for (auto& buffer : buffers)
+		{
+			if (!buffer->inUse)
+			{
+				result = buffer.get();
+				break;
+			}
+		}
+		if (!result)
+		{
+			buffers.emplace_back(new ThreadBuffer);
+			result = buffers.back().get();
+			result->events.resize(bufferSize);
+			result->tid = (uint32_t)buffers.size();
+		}
+		result->main = std::this_thread::get_id() == mainThread;
+		result->inUse = true;
+		return result;
+	}
+
+	uint64_t now()
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - epoch).count();
+	}
+
+	uint32_t& threadDepth()
+	{
+		return slot.depth;
+	}
+
+	void record(const char* name, uint64_t start, uint32_t depth)
+	{
+		if (!slot.buffer)
+		{
+			slot.buffer = acquireBuffer();
+		}
+		auto buffer = slot.buffer;
+		const uint64_t index = buffer->written.load(std::memory_order_relaxed);
+		buffer->events[index % bufferSize] = Event{name, start, now() - start, depth};
+		buffer->written.store(index + 1, std::memory_order_release);
+	}
+
+	void start()
+	{
+		recording = false;
+		++generation;
+		{
+			std::lock_guard<std::mutex> lock(buffersMutex);
+			for (auto& buffer : buffers)
+			{
+				buffer->written.store(0, std::memory_order_relaxed);
+			}
+		}
+		recording = true;
+	}
+
+	void stop()
+	{
+		recording = false;
+		++generation;
+	}
+
+	bool exportChromeTrace(const char* path)
+	{
+		File* fp = FileIO::open(path, "wb");
+		if (!fp)
+		{
+			return false;
+		}
+
+		// don't let new events overwrite the ones being written out
+		const bool wasRecording = recording.exchange(false);
+		++generation;
+
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		fp->printf("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+		bool first = true;
+		for (auto& buffer : buffers)
+		{
+			const uint64_t written = buffer->written.load(std::memory_order_acquire);
+			if (!written)
+			{
+				continue;
+			}
+			fp->printf("%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s %u\"}}",
+				first ? "" : ",\n", buffer->tid, buffer->main ? "main" : "worker", buffer->tid);
+			first = false;
+			const uint64_t begin = written > bufferSize ? written - bufferSize : 0;
+			for (uint64_t c = begin; c < written; ++c)
+			{
+				const Event& event = buffer->events[c % bufferSize];
+				fp->printf(",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+					event.name, buffer->tid, event.start / 1000.0, event.duration / 1000.0);
+			}
+		}
+		fp->printf("\n]}\n");
+		FileIO::close(fp);
+
+		recording = wasRecording;
+		return true;
+	}
+
+	void getTopZones(std::vector<std::pair<const char*, double>>& out, size_t count)
+	{
+		out.clear();
+		const uint64_t cutoff = now() - std::min(now(), (uint64_t)1000000000);
+
+		// names are string literals, so the same zone can have several
+		// addresses across translation units. Sum by address first, then by text.
+		std::unordered_map<const char*, uint64_t> byAddress;
+		{
+			std::lock_guard<std::mutex> lock(buffersMutex);
+			for (auto& buffer : buffers)
+			{
+				if (!buffer->main)
+				{
+					continue;
+				}
+				const uint64_t written = buffer->written.load(std::memory_order_acquire);
+				const uint64_t begin = written > bufferSize ? written - bufferSize : 0;
+				for (uint64_t c = written; c > begin; --c)
+				{
+					const Event& event = buffer->events[(c - 1) % bufferSize];
+					if (event.start < cutoff)
+					{
+						break;
+					}
+					byAddress[event.name] += event.duration;
+				}
+			}
+		}
+		std::unordered_map<std::string, std::pair<const char*, uint64_t>> byName;
+		for (auto& it : byAddress)
+		{
+			auto& entry = byName[it.first];
+			entry.first = it.first;
+			entry.second += it.second;
+		}
+		for (auto& it : byName)
+		{
+			out.emplace_back(it.second.first, it.second.second / 1000000.0);
+		}
+		std::sort(out.begin(), out.end(), [](const std::pair<const char*, double>& a, const std::pair<const char*, double>& b){
+			return a.second > b.second;
+		});
+		if (out.size() > count)
+		{
+			out.resize(count);
+		}
+	}
+}
+
+#ifndef EDITOR
+#include "interface/consolecommand.hpp"
+
+static ConsoleCommand ccmd_profiler_start("/profiler_start", "start recording profiler zones",
+	[](int argc, const char* argv[]){
+	Profiler::start();
+	printlog("profiler: recording");
+	});
+
+static ConsoleCommand ccmd_profiler_stop("/profiler_stop", "stop recording profiler zones",
+	[](int argc, const char* argv[]){
+	Profiler::stop();
+	printlog("profiler: stopped");
+	});
+
+static ConsoleCommand ccmd_profiler_export("/profiler_export", "write recorded profiler zones as Chrome trace JSON (default profile.json)",
+	[](int argc, const char* argv[]){
+	char path[PATH_MAX];
+	completePath(path, argc >= 2 ? argv[1] : "profile.json", outputdir);
+	if (Profiler::exportChromeTrace(path)) {
+		printlog("profiler: wrote trace to '%s'", path);
+	} else {
+		printlog("profiler: failed to open '%s'", path);
+	}
+	});
+#endif
@@ -0,0 +1,105 @@
+/*-------------------------------------------------------------------------------
+
+	BARONY
+	File: profiler.hpp
+	Desc: scoped-zone profiler with per-thread ring buffers
+
+	Copyright 2013-2016 (c) Turning Wheel LLC, all rights reserved.
+	See LICENSE for details.
+
+-------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// define BARONY_PROFILER to 0 to compile every PROFILE_ZONE out of the build
+#ifndef BARONY_PROFILER
+#define BARONY_PROFILER 1
+#endif
+
+namespace Profiler
+{
+	// one completed zone
+	struct Event
+	{
+		const char* name;       // must point to static storage (string literal)
+		uint64_t start;         // nanoseconds since the profiler epoch
+		uint64_t duration;      // nanoseconds
+		uint32_t depth;         // nesting depth on its thread
+	};
+
+	extern std::atomic<bool> recording;
+	extern std::atomic<uint32_t> generation;     // bumped whenever recording starts, stops or is exported
+
+	uint64_t now();                                 // nanoseconds since the profiler epoch
+	void record(const char* name, uint64_t start, uint32_t depth); // close a zone on the calling thread
+	uint32_t& threadDepth();                        // zone nesting depth of the calling thread
+
+	void start();                                   // begin recording (clears old events)
+	void stop();                                    // stop recording
+	bool exportChromeTrace(const char* path);       // write recorded events as Chrome trace JSON
+
+	// main thread zones of the last second, sorted by total time (ms)
+	void getTopZones(std::vector<std::pair<const char*, double>>& out, size_t count);
+
+	class Scope
+	{
+#if BARONY_PROFILER
+		const char* name = nullptr;
+		uint64_t start = 0;
+		uint32_t depth = 0;
+		uint32_t recordingGeneration = 0;
+#endif
+	public:
+		Scope() = default;
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+		explicit Scope(const char* _name) { begin(_name); }
+		~Scope() { end(); }
+
+		void begin(const char* _name)
+		{
+#if BARONY_PROFILER
+			if (_name && recording.load(std::memory_order_relaxed))
+			{
+				name = _name;
+				recordingGeneration = generation.load(std::memory_order_acquire);
+				depth = threadDepth()++;
+				start = now();
+			}
+#endif
+		}
+
+		void end()
+		{
+#if BARONY_PROFILER
+			if (name)
+			{
+				--threadDepth();
+				// zones opened before the buffers were reset or written out are dropped
+				if (recording.load(std::memory_order_acquire)
+					&& generation.load(std::memory_order_acquire) == recordingGeneration)
+				{
+					record(name, start, depth);
+				}
+				name = nullptr;
+			}
+#endif
+		}
+	};
+}
+
+#if BARONY_PROFILER
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// times the enclosing scope under a string literal name
+#define PROFILE_ZONE(name) Profiler::Scope PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name)
+#endif
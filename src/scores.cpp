@@ -2576,6 +2576,7 @@ int loadGameOld(int player, int saveIndex)
 		stats[player]->appearance = (stats[player]->appearance & 0xFF);
 	}
 	fp->read(&stats[player]->name, sizeof(char), 32);
+	stats[player]->updateAllegianceTags();
 	fp->read(&stats[player]->HP, sizeof(Sint32), 1);
 	fp->read(&stats[player]->MAXHP, sizeof(Sint32), 1);
 	fp->read(&stats[player]->MP, sizeof(Sint32), 1);
@@ -2990,6 +2991,7 @@ list_t* loadGameFollowersOld(int saveIndex)
 			fp->read(&followerStats->sex, sizeof(sex_t), 1);
 			fp->read(&followerStats->appearance, sizeof(Uint32), 1);
 			fp->read(&followerStats->name, sizeof(char), 32);
+			followerStats->updateAllegianceTags();
 			fp->read(&followerStats->HP, sizeof(Sint32), 1);
 			fp->read(&followerStats->MAXHP, sizeof(Sint32), 1);
 			fp->read(&followerStats->MP, sizeof(Sint32), 1);
@@ -6530,6 +6532,7 @@ list_t* loadGameFollowers(const SaveGameInfo& info) {
 			// read follower stats
 			stringCopy(stats->name, follower.name.c_str(),
 				sizeof(Stat::name), follower.name.size());
+			stats->updateAllegianceTags();
 			stats->type = (Monster)follower.type;
 			stats->sex = (sex_t)follower.sex;
 			stats->appearance = follower.appearance;
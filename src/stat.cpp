@@ -19,6 +19,7 @@
 #include "net.hpp"
 #include "player.hpp"
 #include "prng.hpp"
+#include "monster.hpp"
 
 Stat* stats[MAXPLAYERS];
 
@@ -398,6 +399,7 @@ Stat* Stat::copyStats()
 	newStat->sex = this->sex;
 	newStat->appearance = this->appearance;
 	strcpy(newStat->name, this->name);
+	newStat->allegianceTags = this->allegianceTags;
 	strcpy(newStat->obituary, this->obituary);
 
 	newStat->HP = this->HP;
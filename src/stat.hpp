@@ -334,6 +334,18 @@ public:
 		}
 	}
 	void setAttribute(std::string key, std::string value);
+
+	// special NPCs that checkEnemy/checkFriend single out by name. the tags
+	// only describe the name, callers still check the type they apply to
+	enum AllegianceTags : Uint8
+	{
+		ALLEGIANCE_TAG_CORRUPTED_AUTOMATON = 1 << 0,
+		ALLEGIANCE_TAG_INNER_DEMON = 1 << 1,
+		ALLEGIANCE_TAG_BRAM_KINDLY = 1 << 2
+	};
+	Uint8 allegianceTags = 0;
+	void updateAllegianceTags(); // call whenever name is assigned
+	Uint8 getAllegianceTags() const { return allegianceTags; }
 	bool statusEffectRemovedByCureAilment(const int effect, Entity* my);
 	void addItemToLootingBag(const int player, const real_t x, const real_t y, Item& item);
 	Uint32 getLootingBagKey(const int player);
@@ -17,6 +17,19 @@ See LICENSE for details.
 #include "items.hpp"
 #include "prng.hpp"
 
+// monsters made while staging a level roll on that level's generator
+// instead of local_rng, which belongs to the main thread
+static BaronyRNG& statRng()
+{
+#ifndef EDITOR
+	if ( stagedMapGen )
+	{
+		return *stagedMapGen->localRng;
+	}
+#endif
+	return local_rng;
+}
+
 // Constructor
 Stat::Stat(Sint32 sprite) :
 	sneaking(MISC_FLAGS[1]),
@@ -50,7 +63,7 @@ Stat::Stat(Sint32 sprite) :
 	this->killer_monster = NOTHING;
 	this->killer_item = WOODEN_SHIELD;
 	this->killer_name = "";
-	this->sex = static_cast<sex_t>(local_rng.rand() % 2);
+	this->sex = static_cast<sex_t>(statRng().rand() % 2);
 	this->appearance = 0;
 	this->HP = 10;
 	this->MAXHP = 10;
@@ -162,7 +175,7 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 		case 70:
 		case (1000 + GNOME):
 			stats->type = GNOME;
-			stats->sex = static_cast<sex_t>(local_rng.rand() % 2);
+			stats->sex = static_cast<sex_t>(statRng().rand() % 2);
 			stats->appearance = 0;
 			stats->HP = 50;
 			stats->MAXHP = 50;
@@ -204,8 +217,8 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 		case 71:
 		case (1000 + DEVIL):
 			stats->type = DEVIL;
-			stats->sex = static_cast<sex_t>(local_rng.rand() % 2);
-			stats->appearance = local_rng.rand();
+			stats->sex = static_cast<sex_t>(statRng().rand() % 2);
+			stats->appearance = statRng().rand();
 			strcpy(stats->name, "Baphomet");
 			stats->inventory.first = nullptr;
 			stats->inventory.last = nullptr;
@@ -235,7 +248,7 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 		case (1000 + LICH):
 			stats->type = LICH;
 			stats->sex = MALE;
-			stats->appearance = local_rng.rand();
+			stats->appearance = statRng().rand();
 			strcpy(stats->name, "Baron Herx");
 			stats->inventory.first = NULL;
 			stats->inventory.last = NULL;
@@ -260,8 +273,8 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 		case 48:
 		case (1000 + SPIDER):
 			stats->type = SPIDER;
-			stats->sex = static_cast<sex_t>(local_rng.rand() % 2);
-			stats->appearance = local_rng.rand();
+			stats->sex = static_cast<sex_t>(statRng().rand() % 2);
+			stats->appearance = statRng().rand();
 			stats->inventory.first = NULL;
 			stats->inventory.last = NULL;
 			stats->HP = 50;
@@ -284,8 +297,8 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 		case 36:
 		case (1000 + GOBLIN):
 			stats->type = GOBLIN;
-			stats->sex = static_cast<sex_t>(local_rng.rand() % 2);
-			stats->appearance = local_rng.rand();
+			stats->sex = static_cast<sex_t>(statRng().rand() % 2);
+			stats->appearance = statRng().rand();
 			stats->inventory.first = NULL;
 			stats->inventory.last = NULL;
 			stats->HP = 60;
@@ -301,7 +314,7 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 			stats->CHR = -1;
 			stats->EXP = 0;
 			stats->LVL = 6;
-			if ( local_rng.rand() % 3 == 0 )
+			if ( statRng().rand() % 3 == 0 )
 			{
 				stats->GOLD = 10;
 				stats->RANDOM_GOLD = 20;
@@ -331,7 +344,7 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 		case (1000 + SHOPKEEPER):
 			stats->type = SHOPKEEPER;
 			stats->sex = MALE;
-			stats->appearance = local_rng.rand();
+			stats->appearance = statRng().rand();
 			stats->inventory.first = NULL;
 			stats->inventory.last = NULL;
 			stats->HP = 300;
@@ -365,8 +378,8 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 		case 30:
 		case (1000 + TROLL):
 			stats->type = TROLL;
-			stats->sex = static_cast<sex_t>(local_rng.rand() % 2);
-			stats->appearance = local_rng.rand();
+			stats->sex = static_cast<sex_t>(statRng().rand() % 2);
+			stats->appearance = statRng().rand();
 			stats->inventory.first = NULL;
 			stats->inventory.last = NULL;
 			stats->HP = 100;
@@ -395,8 +408,8 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 		case 27:
 		case (1000 + HUMAN):
 			stats->type = HUMAN;
-			stats->sex = static_cast<sex_t>(local_rng.rand() % 2);
-			stats->appearance = local_rng.rand() % 18; //NUMAPPEARANCES = 18
+			stats->sex = static_cast<sex_t>(statRng().rand() % 2);
+			stats->appearance = statRng().rand() % 18; //NUMAPPEARANCES = 18
 			stats->inventory.first = NULL;
 			stats->inventory.last = NULL;
 			stats->HP = 30;
@@ -422,7 +435,7 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 			stats->RANDOM_CHR = 3;
 			stats->EXP = 0;
 			stats->LVL = 3;
-			if ( local_rng.rand() % 2 == 0 )
+			if ( statRng().rand() % 2 == 0 )
 			{
 				stats->GOLD = 20;
 				stats->RANDOM_GOLD = 20;
@@ -452,7 +465,7 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 		case 84:
 		case (1000 + KOBOLD):
 			stats->type = KOBOLD;
-			stats->sex = static_cast<sex_t>(local_rng.rand() % 2);
+			stats->sex = static_cast<sex_t>(statRng().rand() % 2);
 			stats->appearance = 0;
 
 			stats->HP = 100;
@@ -500,8 +513,8 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 		case 85:
 		case (1000 + SCARAB):
 			stats->type = SCARAB;
-			stats->sex = static_cast<sex_t>(local_rng.rand() % 2);
-			stats->appearance = local_rng.rand();
+			stats->sex = static_cast<sex_t>(statRng().rand() % 2);
+			stats->appearance = statRng().rand();
 			stats->inventory.first = NULL;
 			stats->inventory.last = NULL;
 			stats->HP = 60;
@@ -530,7 +543,7 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 		case 86:
 		case (1000 + CRYSTALGOLEM):
 			stats->type = CRYSTALGOLEM;
-			stats->sex = static_cast<sex_t>(local_rng.rand() % 2);
+			stats->sex = static_cast<sex_t>(statRng().rand() % 2);
 			stats->appearance = 0;
 
 			stats->HP = 200;
@@ -570,7 +583,7 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 		case (1000 + INCUBUS):
 			stats->type = INCUBUS;
 			stats->sex = sex_t::MALE;
-			stats->appearance = local_rng.rand();
+			stats->appearance = statRng().rand();
 			stats->inventory.first = nullptr;
 			stats->inventory.last = nullptr;
 			stats->MAXHP = 280;
@@ -621,8 +634,8 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 		case 88:
 		case (1000 + VAMPIRE):
 			stats->type = VAMPIRE;
-			stats->sex = static_cast<sex_t>(local_rng.rand() % 2);
-			stats->appearance = local_rng.rand();
+			stats->sex = static_cast<sex_t>(statRng().rand() % 2);
+			stats->appearance = statRng().rand();
 			stats->inventory.first = nullptr;
 			stats->inventory.last = nullptr;
 			stats->HP = 400;
@@ -679,10 +692,10 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 			stats->type = SHADOW;
 			stats->RANDOM_MAXHP = stats->RANDOM_HP;
 			stats->RANDOM_MAXMP = stats->RANDOM_MP;
-			stats->appearance = local_rng.rand();
+			stats->appearance = statRng().rand();
 			stats->inventory.first = nullptr;
 			stats->inventory.last = nullptr;
-			stats->sex = static_cast<sex_t>(local_rng.rand() % 2);
+			stats->sex = static_cast<sex_t>(statRng().rand() % 2);
 			stats->MAXHP = 170;
 			stats->HP = stats->MAXHP;
 			stats->MAXMP = 500;
@@ -717,7 +730,7 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 		case 90:
 		case (1000 + COCKATRICE):
 			stats->type = COCKATRICE;
-			stats->sex = static_cast<sex_t>(local_rng.rand() % 2);
+			stats->sex = static_cast<sex_t>(statRng().rand() % 2);
 			stats->appearance = 0;
 
 			stats->HP = 500;
@@ -758,8 +771,8 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 		case 91:
 		case (1000 + INSECTOID):
 			stats->type = INSECTOID;
-			stats->sex = static_cast<sex_t>(local_rng.rand() % 2);
-			stats->appearance = local_rng.rand();
+			stats->sex = static_cast<sex_t>(statRng().rand() % 2);
+			stats->appearance = statRng().rand();
 			stats->inventory.first = nullptr;
 			stats->inventory.last = nullptr;
 			stats->MAXHP = 130;
@@ -813,8 +826,8 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 		case 92:
 		case (1000 + GOATMAN):
 			stats->type = GOATMAN;
-			stats->sex = static_cast<sex_t>(local_rng.rand() % 2);
-			stats->appearance = local_rng.rand();
+			stats->sex = static_cast<sex_t>(statRng().rand() % 2);
+			stats->appearance = statRng().rand();
 			stats->inventory.first = nullptr;
 			stats->inventory.last = nullptr;
 			stats->MAXHP = 220;
@@ -835,7 +848,7 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 			stats->CHR = -1;
 			stats->EXP = 0;
 			stats->LVL = 25;
-			if ( local_rng.rand() % 3 > 0 )
+			if ( statRng().rand() % 3 > 0 )
 			{
 				stats->GOLD = 100;
 				stats->RANDOM_GOLD = 50;
@@ -869,8 +882,8 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 		case 93:
 		case (1000 + AUTOMATON):
 			stats->type = AUTOMATON;
-			stats->sex = static_cast<sex_t>(local_rng.rand() % 2);
-			stats->appearance = local_rng.rand();
+			stats->sex = static_cast<sex_t>(statRng().rand() % 2);
+			stats->appearance = statRng().rand();
 			stats->inventory.first = nullptr;
 			stats->inventory.last = nullptr;
 			stats->MAXHP = 115;
@@ -903,7 +916,7 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 		case (1000 + LICH_ICE):
 			stats->type = LICH_ICE;
 			stats->sex = FEMALE;
-			stats->appearance = local_rng.rand();
+			stats->appearance = statRng().rand();
 			strcpy(stats->name, "Erudyce");
 			stats->inventory.first = nullptr;
 			stats->inventory.last = nullptr;
@@ -931,7 +944,7 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 		case (1000 + LICH_FIRE):
 			stats->type = LICH_FIRE;
 			stats->sex = MALE;
-			stats->appearance = local_rng.rand();
+			stats->appearance = statRng().rand();
 			strcpy(stats->name, "Orpheus");
 			stats->inventory.first = nullptr;
 			stats->inventory.last = nullptr;
@@ -958,8 +971,8 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 		case 83:
 		case (1000 + SKELETON):
 			stats->type = SKELETON;
-			stats->sex = static_cast<sex_t>(local_rng.rand() % 2);
-			stats->appearance = local_rng.rand();
+			stats->sex = static_cast<sex_t>(statRng().rand() % 2);
+			stats->appearance = statRng().rand();
 			stats->HP = 40;
 			stats->MAXHP = 40;
 			stats->MP = 30;
@@ -992,8 +1005,8 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 		case 75:
 		case (1000 + DEMON):
 			stats->type = DEMON;
-			stats->sex = static_cast<sex_t>(local_rng.rand() % 2);
-			stats->appearance = local_rng.rand();
+			stats->sex = static_cast<sex_t>(statRng().rand() % 2);
+			stats->appearance = statRng().rand();
 			stats->inventory.first = NULL;
 			stats->inventory.last = NULL;
 			stats->HP = 120;
@@ -1018,8 +1031,8 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 		case 76:
 		case (1000 + CREATURE_IMP):
 			stats->type = CREATURE_IMP;
-			stats->sex = static_cast<sex_t>(local_rng.rand() % 2);
-			stats->appearance = local_rng.rand();
+			stats->sex = static_cast<sex_t>(statRng().rand() % 2);
+			stats->appearance = statRng().rand();
 			stats->inventory.first = NULL;
 			stats->inventory.last = NULL;
 			stats->HP = 80;
@@ -1035,7 +1048,7 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 			stats->CHR = -3;
 			stats->EXP = 0;
 			stats->LVL = 14;
-			if ( local_rng.rand() % 10 )
+			if ( statRng().rand() % 10 )
 			{
 				stats->GOLD = 0;
 				stats->RANDOM_GOLD = 0;
@@ -1056,8 +1069,8 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 		//case 37:
 		case (1000 + MINOTAUR):
 			stats->type = MINOTAUR;
-			stats->sex = static_cast<sex_t>(local_rng.rand() % 2);
-			stats->appearance = local_rng.rand();
+			stats->sex = static_cast<sex_t>(statRng().rand() % 2);
+			stats->appearance = statRng().rand();
 			stats->inventory.first = NULL;
 			stats->inventory.last = NULL;
 			stats->HP = 400;
@@ -1082,8 +1095,8 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 		case 78:
 		case (1000 + SCORPION):
 			stats->type = SCORPION;
-			stats->sex = static_cast<sex_t>(local_rng.rand() % 2);
-			stats->appearance = local_rng.rand();
+			stats->sex = static_cast<sex_t>(statRng().rand() % 2);
+			stats->appearance = statRng().rand();
 			stats->inventory.first = NULL;
 			stats->inventory.last = NULL;
 			stats->HP = 70;
@@ -1105,8 +1118,8 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 		case 79:
 		case (1000 + SLIME):
 			stats->type = SLIME;
-			stats->sex = static_cast<sex_t>(local_rng.rand() % 2);
-			stats->appearance = local_rng.rand();
+			stats->sex = static_cast<sex_t>(statRng().rand() % 2);
+			stats->appearance = statRng().rand();
 			stats->inventory.first = NULL;
 			stats->inventory.last = NULL;
 			if ( stats->LVL >= 7 )   // blue slime
@@ -1139,7 +1152,7 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 		case (1000 + SUCCUBUS):
 			stats->type = SUCCUBUS;
 			stats->sex = FEMALE;
-			stats->appearance = local_rng.rand();
+			stats->appearance = statRng().rand();
 			stats->HP = 60;
 			stats->MAXHP = 60;
 			stats->MP = 40;
@@ -1165,8 +1178,8 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 		case 81:
 		case (1000 + RAT):
 			stats->type = RAT;
-			stats->sex = static_cast<sex_t>(local_rng.rand() % 2);
-			stats->appearance = local_rng.rand();
+			stats->sex = static_cast<sex_t>(statRng().rand() % 2);
+			stats->appearance = statRng().rand();
 			stats->inventory.first = NULL;
 			stats->inventory.last = NULL;
 			stats->HP = 30;
@@ -1191,8 +1204,8 @@ void setDefaultMonsterStats(Stat* stats, int sprite)
 		case 82:
 		case (1000 + GHOUL):
 			stats->type = GHOUL;
-			stats->sex = static_cast<sex_t>(local_rng.rand() % 2);
-			stats->appearance = local_rng.rand();
+			stats->sex = static_cast<sex_t>(statRng().rand() % 2);
+			stats->appearance = statRng().rand();
 			stats->inventory.first = NULL;
 			stats->inventory.last = NULL;
 			stats->HP = 90;
@@ -1324,4 +1337,36 @@ bool isMonsterStatsDefault(Stat& myStats)
 void Stat::setAttribute(std::string key, std::string value)
 {
 	attributes[key] = value;
+}
+
+/*-------------------------------------------------------------------------------
+
+updateAllegianceTags
+
+Works out the special NPC tags checkEnemy/checkFriend test for from the
+current name, so they don't compare names on every call.
+
+-------------------------------------------------------------------------------*/
+
+void Stat::updateAllegianceTags()
+{
+	allegianceTags = 0;
+	if ( !strncmp(name, "corrupted automaton", 19) )
+	{
+		allegianceTags |= ALLEGIANCE_TAG_CORRUPTED_AUTOMATON;
+	}
+	if ( !strncmp(name, "inner demon", strlen("inner demon")) )
+	{
+		allegianceTags |= ALLEGIANCE_TAG_INNER_DEMON;
+	}
+	auto find = MonsterData_t::monsterDataEntries.find(VAMPIRE);
+	if ( find != MonsterData_t::monsterDataEntries.end() )
+	{
+		auto& specialNPCs = find->second.specialNPCs;
+		auto npc = specialNPCs.find("bram kindly");
+		if ( npc != specialNPCs.end() && npc->second.name == name )
+		{
+			allegianceTags |= ALLEGIANCE_TAG_BRAM_KINDLY;
+		}
+	}
 }
\ No newline at end of file
@@ -435,6 +435,15 @@ Button::result_t Button::process(SDL_Rect _size, SDL_Rect _actualSize, const boo
 	return result;
 }
 
+bool Button::isIdle() const {
+	if (style == STYLE_NORMAL || style == STYLE_DROPDOWN) {
+		if (pressed) {
+			return false;
+		}
+	}
+	return Widget::isIdle();
+}
+
 void Button::scrollParent() {
 	Frame* fparent = static_cast<Frame*>(parent);
 	auto fActualSize = fparent->getActualSize();
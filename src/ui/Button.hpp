@@ -83,6 +83,8 @@ public:
 	//! activates the button
 	virtual void activate() override;
 
+	virtual bool isIdle() const override;
+
 	virtual type_t              getType() const override { return WIDGET_BUTTON; }
 	const char*					getText() const { return text.c_str(); }
 	const char*					getFont() const { return font.c_str(); }
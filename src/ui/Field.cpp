@@ -95,6 +95,10 @@ void Field::activate() {
 #endif
 }
 
+bool Field::isIdle() const {
+	return !dirty && !activated && Widget::isIdle();
+}
+
 void Field::deselect() {
 	Widget::deselect();
 }
@@ -601,6 +605,7 @@ void Field::setText(const char* _text) {
 	if ( stringCmp(text, _text, textlen, len) ) {
 		stringCopy(text, _text, textlen, len);
 		dirty = true;
+		markForProcess();
 	}
 }
 
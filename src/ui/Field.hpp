@@ -54,6 +54,8 @@ public:
 	//! deselects the field
 	virtual void deselect() override;
 
+	virtual bool isIdle() const override;
+
 	//! draws the field
 	//! @param _size size and position of field's parent frame
 	//! @param _actualSize offset into the parent frame space (scroll)
@@ -143,8 +145,8 @@ public:
 	void	setPos(const int x, const int y) { size.x = x; size.y = y; }
 	void	setSize(const SDL_Rect _size) { size = _size; }
 	void	setColor(const Uint32 _color) { color = _color; }
-	void	setTextColor(const Uint32 _color) { if (textColor != _color) { textColor = _color; dirty = true; } }
-	void	setOutlineColor(const Uint32 _color) { if (outlineColor != _color) { outlineColor = _color; dirty = true; } }
+	void	setTextColor(const Uint32 _color) { if (textColor != _color) { textColor = _color; dirty = true; markForProcess(); } }
+	void	setOutlineColor(const Uint32 _color) { if (outlineColor != _color) { outlineColor = _color; dirty = true; markForProcess(); } }
 	void	setBackgroundColor(const Uint32 _color) { backgroundColor = _color; }
 	void	setBackgroundActivatedColor(const Uint32 _color) { backgroundActivatedColor = _color; }
 	void	setBackgroundSelectAllColor(const Uint32 _color) { backgroundSelectAllColor = _color; }
@@ -155,7 +157,7 @@ public:
 	void	setVJustify(const int _justify) { vjustify = static_cast<justify_t>(_justify); }
 	void	setScroll(const bool _scroll) { scroll = _scroll; }
 	void	setCallback(void (*const fn)(Field&)) { callback = fn; }
-	void	setFont(const char* _font) { if (font != _font) { font = _font; dirty = true; } }
+	void	setFont(const char* _font) { if (font != _font) { font = _font; dirty = true; markForProcess(); } }
 	void	setGuide(const char* _guide) { guide = _guide; }
 	void	setTooltip(const char* _tooltip) { tooltip = _tooltip; }
 	void    reflowTextToFit(const int characterOffset, bool check = true);
@@ -235,7 +235,7 @@ Frame::Frame(const char* _name) {
 	color = 0;
 	borderColor = 0;
 
-	name = _name;
+	setName(_name);
 }
 
 Frame::Frame(Frame& _parent, const char* _name) : Frame(_name) {
@@ -1012,6 +1012,37 @@ Frame::result_t Frame::process() {
 	return result;
 }
 
+#ifndef EDITOR
+static ConsoleVariable<bool> cvar_ui_idle_culling("/ui_idle_culling", true, "skip processing idle frames the mouse isn't over");
+#endif
+
+// brings a subtree that was skipped for a while up to date,
+// as if it had been processed the whole time
+static void catchUpIdleSubtree(Frame& frame, Uint32 skippedTicks) {
+	const Uint32 now = SDL_GetTicks();
+	for (auto button : frame.getButtons()) {
+		button->setHighlightTime(now);
+	}
+	for (auto field : frame.getFields()) {
+		field->setHighlightTime(now);
+	}
+	for (auto child : frame.getFrames()) {
+		if (!child->isDisabled()) {
+			child->addTicks(skippedTicks);
+			catchUpIdleSubtree(*child, skippedTicks);
+		}
+	}
+}
+
+Uint32 Frame::getTicks() const {
+	// ticks skipped by idle ancestors haven't been handed down yet
+	Uint32 result = ticks;
+	for (auto widget = parent; widget; widget = widget->getParent()) {
+		result += static_cast<const Frame*>(widget)->skippedTicks;
+	}
+	return result;
+}
+
 Frame::result_t Frame::process(SDL_Rect _size, SDL_Rect _actualSize, bool usable) {
 	result_t result;
 	result.removed = toBeDeleted;
@@ -1083,6 +1114,23 @@ Frame::result_t Frame::process(SDL_Rect _size, SDL_Rect _actualSize, bool usable
 	//Sint32 mouseyrel = (inputs.getMouse(mouseowner, Inputs::YREL) / (float)yres) * (float)Frame::virtualScreenY;
 #endif
 
+#ifndef EDITOR
+	// nothing in an idle subtree reacts unless the mouse is over it, so skip it.
+	// children can't extend past our clipped rect, so testing it is enough.
+	if (parent && idle && !processDirty && *cvar_ui_idle_culling &&
+		!rectContainsPoint(fullSize, omousex, omousey) &&
+		!rectContainsPoint(fullSize, mousex, mousey)) {
+		++ticks;
+		++skippedTicks;
+		return result;
+	}
+#endif
+	processDirty = false;
+	if (skippedTicks) {
+		catchUpIdleSubtree(*this, skippedTicks);
+		skippedTicks = 0;
+	}
+
 	Input& input = Input::inputs[owner];
 
 	// widget to move to after processing inputs
@@ -1106,6 +1154,7 @@ Frame::result_t Frame::process(SDL_Rect _size, SDL_Rect _actualSize, bool usable
 			}
 			if (dropDown) {
 				toBeDeleted = true;
+				++treeVersion; // hides the whole subtree from lookups
 			}
 			// this special case is necessary for settings menu dropdowns...
 			auto fparent = static_cast<Frame*>(parent);
@@ -1622,6 +1671,21 @@ Frame::result_t Frame::process(SDL_Rect _size, SDL_Rect _actualSize, bool usable
 		}
 	}
 
+	// work out whether we can be skipped next frame
+	idle = !toBeDeleted && !selected && !activated && !dropDown &&
+		!allowScrolling && !draggingHSlider && !draggingVSlider &&
+		list.empty() && !processDirty;
+	for (int c = 0; idle && c < frames.size(); ++c) {
+		idle = frames[c]->isDisabled() || frames[c]->isIdle();
+	}
+	for (int c = 0; idle && c < buttons.size(); ++c) {
+		idle = buttons[c]->isIdle();
+	}
+	for (int c = 0; idle && c < fields.size(); ++c) {
+		idle = fields[c]->isIdle();
+	}
+	idle = idle && sliders.empty();
+
 	return result;
 }
 
@@ -1758,6 +1822,7 @@ void Frame::postprocess() {
 			}
 			if (!dropDownClicked && ticks > 0) {
 				toBeDeleted = true;
+				++treeVersion;
 			}
 		}
 	}
@@ -1842,6 +1907,7 @@ Frame::entry_t* Frame::addEntry(const char* name, bool resizeFrame) {
 	entry->name = name;
 	entry->color = 0xffffffff;
 	list.push_back(entry);
+	markForProcess();
 
 	if (resizeFrame) {
 		resizeForEntries();
@@ -1913,7 +1979,38 @@ bool Frame::removeEntry(const char* name, bool resizeFrame) {
 
 int Frame::numFindFrameCalls = 0;
 
+// returns the cached result of a lookup by name, or runs the search and caches it
+template <typename T, typename Cache, typename Search>
+static T* findCached(Cache& cache, const char* name, Search&& search) {
+	auto& record = WidgetName::intern(name);
+	auto emplaced = cache.emplace(&record, typename Cache::mapped_type());
+	auto& entry = emplaced.first->second;
+	if (!emplaced.second &&
+		entry.nameVersion == record.version &&
+		entry.treeVersion == Widget::treeVersion) {
+		if (!entry.found) {
+			return nullptr;
+		}
+		if (auto widget = entry.result.get()) {
+			return static_cast<T*>(widget);
+		}
+	}
+	T* result = search();
+	entry.nameVersion = record.version;
+	entry.treeVersion = Widget::treeVersion;
+	entry.found = result != nullptr;
+	entry.result = WidgetHandle<Widget>(result);
+	return result;
+}
+
 Frame* Frame::findFrame(const char* name, const FrameSearchType frameSearchType) {
+	auto& cache = findFrameCache[frameSearchType == FRAME_SEARCH_DEPTH_FIRST ? 0 : 1];
+	return findCached<Frame>(cache, name, [&](){
+		return findFrameImpl(name, frameSearchType);
+		});
+}
+
+Frame* Frame::findFrameImpl(const char* name, const FrameSearchType frameSearchType) {
 
 	if ( frameSearchType == FRAME_SEARCH_DEPTH_FIRST )
 	{
@@ -1984,30 +2081,46 @@ Frame* Frame::findFrame(const char* name, const FrameSearchType frameSearchType)
 }
 
 Button* Frame::findButton(const char* name) {
-	for (auto button : buttons) {
-		if ( button->isToBeDeleted() )
-		{
-			continue;
-		}
-		if (strcmp(button->getName(), name) == 0) {
-			return button;
+	return findCached<Button>(findButtonCache, name, [&]() -> Button* {
+		for (auto button : buttons) {
+			if ( button->isToBeDeleted() )
+			{
+				continue;
+			}
+			if (strcmp(button->getName(), name) == 0) {
+				return button;
+			}
 		}
-	}
-	return nullptr;
+		return nullptr;
+		});
 }
 
 Field* Frame::findField(const char* name) {
-	for (auto field : fields) {
-		if (strcmp(field->getName(), name) == 0) {
-			return field;
+	return findCached<Field>(findFieldCache, name, [&]() -> Field* {
+		for (auto field : fields) {
+			if (strcmp(field->getName(), name) == 0) {
+				return field;
+			}
 		}
-	}
-	return nullptr;
+		return nullptr;
+		});
 }
 
 Frame::image_t* Frame::findImage(const char* name) {
-	for (auto image : images) {
+	auto& record = WidgetName::intern(name);
+	auto find = findImageCache.find(&record);
+	if (find != findImageCache.end()) {
+		auto& cached = find->second;
+		if (cached.index < images.size() &&
+			images[cached.index] == cached.image &&
+			cached.image->name == name) {
+			return cached.image;
+		}
+	}
+	for (size_t c = 0; c < images.size(); ++c) {
+		auto image = images[c];
 		if (image->name == name) {
+			findImageCache[&record] = image_cache_t{c, image};
 			return image;
 		}
 	}
@@ -2024,12 +2137,14 @@ Frame::entry_t* Frame::findEntry(const char* name) {
 }
 
 Slider* Frame::findSlider(const char* name) {
-	for (auto slider : sliders) {
-		if (strcmp(slider->getName(), name) == 0) {
-			return slider;
+	return findCached<Slider>(findSliderCache, name, [&]() -> Slider* {
+		for (auto slider : sliders) {
+			if (strcmp(slider->getName(), name) == 0) {
+				return slider;
+			}
 		}
-	}
-	return nullptr;
+		return nullptr;
+		});
 }
 
 void Frame::resizeForEntries() {
@@ -2301,6 +2416,7 @@ void Frame::activateEntry(entry_t& entry) {
 	}
 	if (dropDown) {
 		toBeDeleted = true;
+		++treeVersion;
 	}
 }
 
@@ -2622,6 +2738,7 @@ void Frame::bringToTop() {
         if (*it == this) {
             frames.erase(it);
             frames.push_back(this);
+            ++treeVersion; // search order changed
 			return;
         }
     }
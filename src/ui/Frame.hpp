@@ -8,6 +8,7 @@
 #include "Widget.hpp"
 
 #include <memory>
+#include <unordered_map>
 
 class Field;
 class Button;
@@ -218,7 +219,9 @@ public:
 		FRAME_SEARCH_BREADTH_FIRST
 	};
 	static FrameSearchType findFrameDefaultSearchType;
-	//! recursively searches all embedded frames for a specific frame
+	//! recursively searches all embedded frames for a specific frame.
+	//! results are cached per frame, so repeated lookups are a single hash.
+	//! to skip even that, keep a WidgetHandle<Frame> to the result.
 	//! @param name the name of the frame to find
 	//! @param use depth or breadth-first search
 	//! @return the frame with the given name, or nullptr if the frame could not be found
@@ -259,6 +262,10 @@ public:
 	//! deselect all frame elements recursively
 	virtual void deselect() override;
 
+	//! @return true if nothing in this frame's subtree needed processing last frame
+	//! (apart from reacting to the mouse), so the subtree can be skipped
+	virtual bool isIdle() const override { return idle; }
+
 	//! activates the frame so we can select and activate list entries
 	virtual void activate() override;
 
@@ -341,7 +348,8 @@ public:
 	void							setBlitToParent(bool _bBlitParent) { bBlitToParent = _bBlitParent; }
 	const bool						bIsDirtyBlit() const { return bBlitDirty; }
 	const bool						isBlitToParent() const { return bBlitToParent; }
-	const Uint32					getTicks() const { return ticks; }
+	Uint32							getTicks() const;
+	void							addTicks(Uint32 _ticks) { ticks += _ticks; }
 
 	void	setFont(const char* _font) { font = _font; }
 	void	setBorder(const int _border) { border = _border; }
@@ -354,14 +362,14 @@ public:
 	void    setActivatedEntryColor(const Uint32& _color) { activatedEntryColor = _color; }
 	void	setBorderColor(const Uint32& _color) { borderColor = _color; }
 	void    setSliderColor(const Uint32& _color) { sliderColor = _color; }
-	void	setDisabled(const bool _disabled) { disabled = _disabled; }
+	void	setDisabled(const bool _disabled) { if (disabled != _disabled) { disabled = _disabled; markForProcess(); } }
 	void	setHollow(const bool _hollow) { hollow = _hollow; }
 	void	setDropDown(const bool _dropDown) { dropDown = _dropDown; }
 	void	setScrollBarsEnabled(const bool _scrollbars) { scrollbars = _scrollbars; }
 	void	setAllowScrollBinds(const bool _allow) { allowScrollBinds = _allow; }
 	void	setListOffset(SDL_Rect _size) { listOffset = _size; }
 	void	setInheritParentFrameOpacity(const bool _inherit) { inheritParentFrameOpacity = _inherit; }
-	void	setOpacity(const real_t _opacity) { opacity = _opacity; }
+	void	setOpacity(const real_t _opacity) { if (opacity != _opacity) { opacity = _opacity; markForProcess(); } }
 	void	setListJustify(justify_t _justify) { justify = _justify; }
 	void	setClickable(const bool _clickable) { clickable = _clickable; }
 	void    setDontTickChildren(const bool b) { dontTickChildren = b; }
@@ -386,6 +394,8 @@ public:
 
 private:
 	Uint32 ticks = 0;									//!< number of engine ticks this frame has persisted
+	Uint32 skippedTicks = 0;							//!< ticks the children missed while this subtree was idle
+	bool idle = false;									//!< see isIdle()
 	std::string font = Font::defaultFont;				//!< name of the font to use for frame entries
 	int border = 2;										//!< size of the frame's border
     SDL_Rect size{0, 0, 0, 0};							//!< size and position of the frame in its parent frame
@@ -470,6 +480,31 @@ private:
 	SDL_Rect getRelativeMousePositionImpl(SDL_Rect& _size, SDL_Rect& _actualSize, bool realtime) const;
 
 	void processField(const SDL_Rect& _size, Field& field, Widget*& destWidget, result_t& result);
+
+	//! cached result of a widget lookup by name. valid while neither the
+	//! name's version nor Widget::treeVersion have changed. a null handle
+	//! means the widget wasn't found.
+	struct find_cache_t {
+		Uint32 nameVersion = 0;
+		Uint32 treeVersion = 0;
+		bool found = false;
+		WidgetHandle<Widget> result;
+	};
+	typedef std::unordered_map<const WidgetName*, find_cache_t> find_cache_map_t;
+	find_cache_map_t findFrameCache[2];					//!< per search type
+	find_cache_map_t findButtonCache;
+	find_cache_map_t findFieldCache;
+	find_cache_map_t findSliderCache;
+
+	//! cached position of a named image. checked against the vector before use,
+	//! since the image list is edited directly by callers.
+	struct image_cache_t {
+		size_t index = 0;
+		image_t* image = nullptr;
+	};
+	std::unordered_map<const WidgetName*, image_cache_t> findImageCache;
+
+	Frame* findFrameImpl(const char* name, const FrameSearchType frameSearchType);
 	void processButton(const SDL_Rect& _size, Button& button, Widget*& destWidget, result_t& result);
 	void processSlider(const SDL_Rect& _size, Slider& slider, Widget*& destWidget, result_t& result);
 };
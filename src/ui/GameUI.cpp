@@ -30295,6 +30295,7 @@ static void drawConsoleCommandBuffer() {
 
 static Uint32 gui_ticks = 0u;
 Frame::result_t doFrames() {
+    PROFILE_ZONE("doFrames");
     Frame::result_t result;
     result.usable = false;
     result.highlightTime = 0;
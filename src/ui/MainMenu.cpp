@@ -9461,6 +9461,7 @@ bind_failed:
 			}
 
 	        stringCopy(stats[player]->name, (char*)(&net_packet->data[5]), sizeof(Stat::name), 32);
+	        stats[player]->updateAllegianceTags();
 	        client_classes[player] = (int)SDLNet_Read32(&net_packet->data[37]);
 	        stats[player]->sex = static_cast<sex_t>((int)SDLNet_Read32(&net_packet->data[41]));
 	        Uint32 raceAndAppearance = SDLNet_Read32(&net_packet->data[45]);
@@ -9816,6 +9817,7 @@ bind_failed:
 		    stats[player]->appearance = net_packet->data[7];
 		    stats[player]->playerRace = net_packet->data[8];
 		    stringCopy(stats[player]->name, (char*)(&net_packet->data[9]), sizeof(Stat::name), 32);
+		    stats[player]->updateAllegianceTags();
 
 		    /*char buf[1024];
 		    snprintf(buf, sizeof(buf), "*** %s has joined the game ***", players[player]->getAccountName());
@@ -9850,6 +9852,7 @@ bind_failed:
 					stats[player]->clearStats();
 				}
                 stringCopy(stats[player]->name, (char*)(&net_packet->data[5]), sizeof(Stat::name), 32);
+                stats[player]->updateAllegianceTags();
                 client_classes[player] = (int)SDLNet_Read32(&net_packet->data[37]);
                 stats[player]->sex = static_cast<sex_t>((int)SDLNet_Read32(&net_packet->data[41]));
                 Uint32 raceAndAppearance = SDLNet_Read32(&net_packet->data[45]);
@@ -10130,6 +10133,7 @@ bind_failed:
 						stats[c]->appearance = net_packet->data[8 + c * chunk_size + 4]; // appearance
 						stats[c]->playerRace = net_packet->data[8 + c * chunk_size + 5]; // player race
 						stringCopy(stats[c]->name, (char*)(net_packet->data + 8 + c * chunk_size + 6), sizeof(Stat::name), 32); // name
+						stats[c]->updateAllegianceTags();
 
 						if (loadingsavegame) {
 							Item** player_slots[] = {
@@ -14468,6 +14472,7 @@ failed:
 			size_t shortest_len = std::min(old_len, new_len);
 			if (new_len != old_len || memcmp(stats[index]->name, text, shortest_len)) {
 			    memcpy(stats[index]->name, text, new_len);
+			    stats[index]->updateAllegianceTags();
 			    sendPlayerOverNet();
 				saveLastCharacter(index, multiplayer);
 			}
@@ -15400,6 +15405,16 @@ failed:
                 }
             }
 		}
+		if (headless && allReady) {
+		    // a headless host is always ready, so wait for a remote player
+		    atLeastOnePlayer = false;
+		    for (int c = 1; c < MAXPLAYERS; ++c) {
+		        if (playersInLobby[c] && !client_disconnected[c]) {
+		            atLeastOnePlayer = true;
+		            break;
+		        }
+		    }
+		}
 		if (allReady && atLeastOnePlayer) {
 		    createCountdownTimer();
 		} else {
@@ -15829,6 +15844,7 @@ failed:
 						len = std::min(sizeof(Stat::name) - 1, len);
 						memcpy(stats[c]->name, name, len);
 						stats[c]->name[len] = '\0';
+						stats[c]->updateAllegianceTags();
 					}
 			    }
 			}
@@ -19343,6 +19359,29 @@ failed:
 #endif
 	}
 
+	bool hostHeadlessLobby() {
+		closeNetworkInterfaces();
+		randomizeHostname();
+		directConnect = true;
+
+		// resolve localhost address
+		Uint16 port = ::portnumber ? ::portnumber : DEFAULT_PORT;
+		int resolve = SDLNet_ResolveHost(&net_server, NULL, port);
+		assert(resolve != -1);
+
+		// open socket
+		if (!(net_sock = SDLNet_UDP_Open(port))) {
+			return false;
+		}
+		printlog("[headless] hosting direct-connect lobby on port %d", (int)port);
+
+		// create lobby. the host has nobody at the keyboard,
+		// so its slot is readied up straight away
+		createLobby(LobbyType::LobbyLAN);
+		createReadyStone(0, true, true);
+		return true;
+	}
+
 	static void createLocalOrNetworkMenu() {
 		allSettings.classic_mode_enabled = svFlags & SV_FLAG_CLASSIC;
 		allSettings.hardcore_mode_enabled = svFlags & SV_FLAG_HARDCORE;
@@ -107,6 +107,7 @@ namespace MainMenu {
 	void destroyMainMenu();                 // destroys the main menu tree
 	void createDummyMainMenu();             // creates a main menu devoid of widgets
 	void closeMainMenu();                   // closes the menu and unpauses the game
+	bool hostHeadlessLobby();               // opens a direct-connect lobby for -headless (false if the port can't be opened)
 
 	// special events:
 
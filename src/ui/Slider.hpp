@@ -74,6 +74,9 @@ public:
     //! deselect the slider
     virtual void deselect() override;
 
+    //! sliders clamp their value and place their handle every frame
+    virtual bool isIdle() const override { return false; }
+
     virtual type_t              getType() const override { return WIDGET_SLIDER; }
     orientation_t               getOrientation() const { return orientation; }
     float                       getValue() const { return value; }
@@ -10,6 +10,8 @@
 #include "../mod_tools.hpp"
 
 #include <queue>
+#include <string_view>
+#include <unordered_map>
 
 static Widget* _selectedWidgets[MAXPLAYERS] = { nullptr };
 
@@ -17,7 +19,26 @@ static Widget* _selectedWidgets[MAXPLAYERS] = { nullptr };
 ConsoleVariable<bool> cvar_hideGlyphs("/hideprompts", false, "hide button glyphs and prompts");
 #endif
 
+Uint32 Widget::treeVersion = 0;
+
+WidgetName& WidgetName::intern(const char* name) {
+    // records are never freed, so the string_view keys stay valid
+    static std::unordered_map<std::string_view, std::unique_ptr<WidgetName>> names;
+    const std::string_view key(name ? name : "");
+    auto find = names.find(key);
+    if (find != names.end()) {
+        return *find->second;
+    }
+    auto record = std::unique_ptr<WidgetName>(new WidgetName);
+    record->str = key;
+    auto& result = *record;
+    names.emplace(std::string_view(result.str), std::move(record));
+    return result;
+}
+
 Widget::~Widget() {
+    *anchor = nullptr;
+    ++internedName->version;
 	if (parent) {
 		for (auto node = parent->widgets.begin(); node != parent->widgets.end(); ++node) {
 			if (*node == this) {
@@ -39,8 +60,16 @@ bool Widget::remove(const char* name) {
     return false;
 }
 
+void Widget::setName(const char* _name) {
+    ++internedName->version;
+    name = _name;
+    internedName = &WidgetName::intern(_name);
+    ++internedName->version;
+}
+
 void Widget::removeSelf() {
     toBeDeleted = true;
+    ++internedName->version;
     
     // also mark children deleted so they don't get processed.
     for (auto widget : widgets) {
@@ -48,6 +77,16 @@ void Widget::removeSelf() {
     }
 }
 
+bool Widget::isIdle() const {
+    return !selected && !highlighted && !tickCallback && pressed == reallyPressed;
+}
+
+void Widget::markForProcess() {
+    for (Widget* widget = this; widget; widget = widget->parent) {
+        widget->processDirty = true;
+    }
+}
+
 void Widget::select() {
 	if (selected) {
 		return;
@@ -61,6 +100,7 @@ void Widget::select() {
 	    _selectedWidgets[owner] = this;
 	}
 	selected = true;
+	markForProcess();
 }
 
 void Widget::deselect() {
@@ -349,6 +389,10 @@ bool Widget::isChildOf(const Widget& widget) const {
 }
 
 void Widget::adoptWidget(Widget& widget) {
+	if (widget.parent && widget.parent != this) {
+		++treeVersion; // a whole subtree is moving
+	}
+	++widget.internedName->version;
 	if (widget.parent) {
 		for (auto node = widget.parent->widgets.begin(); node != widget.parent->widgets.end(); ++node) {
 			if (*node == &widget) {
@@ -361,6 +405,7 @@ void Widget::adoptWidget(Widget& widget) {
 	widget.parent = this;
 	widget.setOwner(this->getOwner());
 	widgets.push_back(&widget);
+	widget.markForProcess();
 }
 
 void Widget::drawPost(const SDL_Rect size,
@@ -4,7 +4,37 @@
 
 #include "../main.hpp"
 
+#include <memory>
+
 class Frame;
+class Widget;
+
+//! an interned widget name. every widget with the same name shares one of these,
+//! so lookups hash the string once and compare pointers after that.
+struct WidgetName {
+    std::string str;
+    Uint32 version = 0; //!< changes whenever a widget with this name is added, removed or renamed
+
+    //! find or create the interned record for the given name
+    static WidgetName& intern(const char* name);
+};
+
+//! a reference to a widget that can be cached across frames. it resolves to
+//! nullptr once the widget is deleted or marked for deletion.
+template <typename T>
+class WidgetHandle {
+public:
+    WidgetHandle() = default;
+    WidgetHandle(T* widget);
+
+    T* get() const;
+    T* operator->() const { return get(); }
+    explicit operator bool() const { return get() != nullptr; }
+    void reset() { anchor.reset(); }
+
+private:
+    std::shared_ptr<Widget*> anchor;
+};
 
 class Widget {
 public:
@@ -65,15 +95,16 @@ public:
     SDL_Rect            getSelectorOffset() const { return selectorOffset; }
     glyph_position_t    getGlyphPosition() const { return glyphPosition; }
 
-    void	setName(const char* _name) { name = _name; }
+    void	setName(const char* _name);
     void	setPressed(bool _pressed) { reallyPressed = pressed = _pressed; }
-    void	setDisabled(bool _disabled) { disabled = _disabled; }
+    void	setDisabled(bool _disabled) { if (disabled != _disabled) { disabled = _disabled; markForProcess(); } }
     void    setInvisible(bool _invisible) { invisible = _invisible; }
     void    setHideGlyphs(bool _hideGlyphs) { hideGlyphs = _hideGlyphs; }
     void    setHideKeyboardGlyphs(bool _hideGlyphs) { hideKeyboardGlyphs = _hideGlyphs; }
     void    setHideSelectors(bool _hideSelectors) { hideSelectors = _hideSelectors; }
     void    setOwner(Sint32 _owner) { owner = _owner; }
-    void	setTickCallback(void (*const fn)(Widget&)) { tickCallback = fn; }
+    void	setTickCallback(void (*const fn)(Widget&)) { tickCallback = fn; markForProcess(); }
+    void    setHighlightTime(Uint32 _highlightTime) { highlightTime = _highlightTime; }
     void	setDrawCallback(void (*const fn)(const Widget&, const SDL_Rect)) { drawCallback = fn; }
     void    setWidgetRight(const char* s) { widgetMovements["MenuRight"] = s; widgetMovements["AltMenuRight"] = s; }
     void    setWidgetDown(const char* s) { widgetMovements["MenuDown"] = s; widgetMovements["AltMenuDown"] = s; }
@@ -95,6 +126,16 @@ public:
     
     //! removes the widget safely
     void removeSelf();
+
+    //! @return true if processing this widget changes nothing while the mouse isn't over it
+    virtual bool isIdle() const;
+
+    //! flags this widget and its ancestors to be processed next frame, even if they are idle
+    void markForProcess();
+
+    //! bumped when widgets are reordered, moved or hidden in ways the per-name
+    //! versions in WidgetName don't capture. frame lookup caches check both.
+    static Uint32 treeVersion;
     
     //! remove an object from the widget
     //! @param name the name of the object to remove
@@ -174,9 +215,14 @@ public:
     Widget* findSelectedWidget();
 
 protected:
+    template <typename T> friend class WidgetHandle;
+
     Widget* parent = nullptr;                                       //!< parent widget
     std::list<Widget*> widgets;                                     //!< widget children
     std::string name;                                               //!< widget name
+    WidgetName* internedName = &WidgetName::intern("");             //!< interned copy of the widget name
+    std::shared_ptr<Widget*> anchor =                               //!< shared with handles, cleared on destruction
+        std::make_shared<Widget*>(this);
     bool pressed = false;							                //!< pressed state
     bool reallyPressed = false;						                //!< the "actual" pressed state, pre-mouse process
     bool highlighted = false;                                       //!< if true, this widget has the mouse over it
@@ -184,6 +230,7 @@ protected:
     bool disabled = false;							                //!< if true, the widget is unusable and grayed out
     bool invisible = false;                                         //!< if true, widget is both unusable and invisible
 	bool toBeDeleted = false;						                //!< if true, the widget will be removed at the end of its process
+    bool processDirty = true;                                       //!< set by markForProcess(), cleared when the widget's frame is processed
     bool hideGlyphs = false;                                        //!< true if you don't want to see controller button glyphs on the widget
     bool hideKeyboardGlyphs = true;                                 //!< true if you don't want to see keyboard glyphs on the widget
     bool hideSelectors = false;                                     //!< true if you don't want to see selectors on the borders of this widget
@@ -212,6 +259,21 @@ protected:
         const std::vector<const Widget*>& searchParents) const;
 };
 
+template <typename T>
+WidgetHandle<T>::WidgetHandle(T* widget) {
+    if (widget) {
+        anchor = widget->anchor;
+    }
+}
+
+template <typename T>
+T* WidgetHandle<T>::get() const {
+    if (!anchor || !*anchor || (*anchor)->isToBeDeleted()) {
+        return nullptr;
+    }
+    return static_cast<T*>(*anchor);
+}
+
 #ifndef EDITOR
 #include "../interface/consolecommand.hpp"
 extern ConsoleVariable<bool> cvar_hideGlyphs;